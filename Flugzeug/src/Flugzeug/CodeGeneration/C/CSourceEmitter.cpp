@@ -0,0 +1,468 @@
+#include "CSourceEmitter.hpp"
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionVisitor.hpp>
+#include <Flugzeug/IR/Module.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string>
+
+using namespace flugzeug;
+
+static bool is_c_identifier(std::string_view name) {
+  const auto is_valid = [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+  };
+
+  return !name.empty() && !(name[0] >= '0' && name[0] <= '9') &&
+         std::all_of(name.begin(), name.end(), is_valid);
+}
+
+static std::string function_name(const Function* function) {
+  verify(is_c_identifier(function->name()), "`{}` is not a valid C identifier", function->name());
+
+  if (function->is_extern()) {
+    return std::string(function->name());
+  }
+
+  return fmt::format("f_{}", function->name());
+}
+
+/// i1 values are stored in memory as a single byte.
+static std::string c_type(const Type* type) {
+  if (const auto pointer = cast<PointerType>(type)) {
+    return c_type(pointer->deref()) + "*";
+  }
+
+  switch (type->kind()) {
+    // clang-format off
+    case Type::Kind::I1:
+    case Type::Kind::I8:   return "uint8_t";
+    case Type::Kind::I16:  return "uint16_t";
+    case Type::Kind::I32:  return "uint32_t";
+    case Type::Kind::I64:  return "uint64_t";
+    case Type::Kind::Void: return "void";
+    default: unreachable();
+      // clang-format on
+  }
+}
+
+/// Signed division and arithmetic shift on i1 are evaluated on i8 (like in the interpreter).
+static std::string_view signed_c_type(const Type* type) {
+  switch (type->bit_size()) {
+    // clang-format off
+    case 1:
+    case 8:  return "int8_t";
+    case 16: return "int16_t";
+    case 32: return "int32_t";
+    case 64: return "int64_t";
+    default: unreachable();
+      // clang-format on
+  }
+}
+
+/// Values up to 32 bits are evaluated on `uint32_t` so integer promotion to `int` can't cause
+/// signed overflow.
+static std::string_view wide_c_type(const Type* type) {
+  return type->bit_size() <= 32 ? "uint32_t" : "uint64_t";
+}
+
+static std::string_view binary_op_symbol(BinaryOp op) {
+  switch (op) {
+    // clang-format off
+    case BinaryOp::Add:  return "+";
+    case BinaryOp::Sub:  return "-";
+    case BinaryOp::Mul:  return "*";
+    case BinaryOp::ModU:
+    case BinaryOp::ModS: return "%";
+    case BinaryOp::DivU:
+    case BinaryOp::DivS: return "/";
+    case BinaryOp::Shr:
+    case BinaryOp::Sar:  return ">>";
+    case BinaryOp::Shl:  return "<<";
+    case BinaryOp::And:  return "&";
+    case BinaryOp::Or:   return "|";
+    case BinaryOp::Xor:  return "^";
+    default: unreachable();
+      // clang-format on
+  }
+}
+
+static std::string_view int_predicate_symbol(IntPredicate predicate) {
+  switch (predicate) {
+    // clang-format off
+    case IntPredicate::Equal:    return "==";
+    case IntPredicate::NotEqual: return "!=";
+    case IntPredicate::GtU:
+    case IntPredicate::GtS:      return ">";
+    case IntPredicate::GteU:
+    case IntPredicate::GteS:     return ">=";
+    case IntPredicate::LtU:
+    case IntPredicate::LtS:      return "<";
+    case IntPredicate::LteU:
+    case IntPredicate::LteS:     return "<=";
+    default: unreachable();
+      // clang-format on
+  }
+}
+
+static bool is_signed_predicate(IntPredicate predicate) {
+  return predicate == IntPredicate::GtS || predicate == IntPredicate::GteS ||
+         predicate == IntPredicate::LtS || predicate == IntPredicate::LteS;
+}
+
+class CFunctionEmitter : public ConstInstructionVisitor {
+  IRPrinter& printer;
+  const Function* function;
+
+  /// Block that is emitted right after the current one, branches to it fall through.
+  const Block* next_block = nullptr;
+
+  size_t indentation = 1;
+
+  template <typename... Args>
+  void line(fmt::format_string<Args...> format, Args&&... args) {
+    for (size_t i = 0; i < indentation; ++i) {
+      printer.tab();
+    }
+
+    printer.raw_write(fmt::format(format, std::forward<Args>(args)...));
+    printer.newline();
+  }
+
+  static std::string name(const Value* value) {
+    verify(value->has_dense_index(), "Emitted value is not part of the function");
+    return fmt::format("v{}", value->dense_index());
+  }
+
+  static std::string value(const Value* value) {
+    switch (value->kind()) {
+      case Value::Kind::Constant:
+      case Value::Kind::Undef: {
+        const auto type = value->type();
+        const auto constant = value->is_undef() ? 0 : cast<Constant>(value)->value_u();
+
+        if (type->is_pointer()) {
+          return fmt::format("(({}){}ull)", c_type(type), constant);
+        }
+
+        return fmt::format("{}{}", constant, type->bit_size() <= 32 ? "u" : "ull");
+      }
+
+      default:
+        return name(value);
+    }
+  }
+
+  /// Sign extended value. Signed i1 values are 0 and -1.
+  static std::string sign_extended(const Value* value) {
+    const auto type = value->type();
+    if (type->is_i1()) {
+      return fmt::format("(-(int8_t){})", CFunctionEmitter::value(value));
+    }
+
+    return fmt::format("(({}){})", signed_c_type(type), CFunctionEmitter::value(value));
+  }
+
+  /// Converts result of an expression evaluated on a wider type back to `type`.
+  static std::string truncated(const Type* type, std::string_view expression) {
+    if (type->is_i1()) {
+      return fmt::format("(uint8_t)(({}) & 1u)", expression);
+    }
+
+    return fmt::format("({})({})", c_type(type), expression);
+  }
+
+  void assign(const Instruction* instruction, std::string_view expression) {
+    line("{} = {};", name(instruction), expression);
+  }
+
+  /// Phis aren't required to be at the beginning of the block, so the whole block is scanned.
+  void emit_phi_copies(const Block* from, const Block* to) {
+    for (const Phi& phi : to->instructions<Phi>()) {
+      line("{}_in = {};", name(&phi), value(phi.incoming_for_block(from)));
+    }
+  }
+
+  static bool has_phis(const Block* block) {
+    const auto phis = block->instructions<Phi>();
+    return phis.begin() != phis.end();
+  }
+
+  void jump_to(const Block* from, const Block* to) {
+    emit_phi_copies(from, to);
+
+    if (to != next_block) {
+      line("goto b{};", to->dense_index());
+    }
+  }
+
+  void emit_declarations() {
+    for (const Block& block : *function) {
+      for (const Instruction& instruction : block) {
+        if (const auto stackalloc = cast<StackAlloc>(instruction)) {
+          line("{} s{}[{}];", c_type(stackalloc->allocated_type()), stackalloc->dense_index(),
+               stackalloc->size());
+        }
+
+        if (instruction.is_void()) {
+          continue;
+        }
+
+        line("{} {};", c_type(instruction.type()), name(&instruction));
+
+        if (cast<Phi>(instruction)) {
+          line("{} {}_in;", c_type(instruction.type()), name(&instruction));
+        }
+      }
+    }
+  }
+
+ public:
+  CFunctionEmitter(const Function* function, IRPrinter& printer)
+      : printer(printer), function(function) {}
+
+  void emit() {
+    emit_declarations();
+
+    for (const Block& block : *function) {
+      next_block = block.next();
+
+      if (!block.is_entry_block()) {
+        printer.raw_write(fmt::format("b{}:", block.dense_index()));
+        printer.newline();
+      }
+
+      for (const Instruction& instruction : block) {
+        visitor::visit_instruction(&instruction, *this);
+      }
+    }
+  }
+
+  void visit_unary_instr(Argument<UnaryInstr> unary) {
+    const auto type = unary->type();
+    const auto operand = fmt::format("({}){}", wide_c_type(type), value(unary->value()));
+
+    switch (unary->op()) {
+      case UnaryOp::Neg:
+        assign(unary, truncated(type, fmt::format("0u - {}", operand)));
+        break;
+      case UnaryOp::Not:
+        assign(unary, truncated(type, fmt::format("~{}", operand)));
+        break;
+      default:
+        unreachable();
+    }
+  }
+
+  void visit_binary_instr(Argument<BinaryInstr> binary) {
+    const auto type = binary->type();
+    const auto lhs = value(binary->lhs());
+    const auto rhs = value(binary->rhs());
+    const auto symbol = binary_op_symbol(binary->op());
+
+    std::string expression;
+
+    switch (binary->op()) {
+      case BinaryOp::Add:
+      case BinaryOp::Sub:
+      case BinaryOp::Mul:
+      case BinaryOp::And:
+      case BinaryOp::Or:
+      case BinaryOp::Xor: {
+        const auto wide = wide_c_type(type);
+        expression = fmt::format("({}){} {} ({}){}", wide, lhs, symbol, wide, rhs);
+        break;
+      }
+
+      case BinaryOp::Shl:
+        expression = fmt::format("({}){} {} {}", wide_c_type(type), lhs, symbol, rhs);
+        break;
+
+      case BinaryOp::DivU:
+      case BinaryOp::ModU:
+      case BinaryOp::Shr:
+        expression = fmt::format("{} {} {}", lhs, symbol, rhs);
+        break;
+
+      case BinaryOp::DivS:
+      case BinaryOp::ModS: {
+        const auto signed_type = signed_c_type(type);
+        expression = fmt::format("({}){} {} ({}){}", signed_type, lhs, symbol, signed_type, rhs);
+        break;
+      }
+
+      case BinaryOp::Sar:
+        expression = fmt::format("({}){} {} {}", signed_c_type(type), lhs, symbol, rhs);
+        break;
+
+      default:
+        unreachable();
+    }
+
+    assign(binary, truncated(type, expression));
+  }
+
+  void visit_int_compare(Argument<IntCompare> int_compare) {
+    const auto predicate = int_compare->predicate();
+    const auto symbol = int_predicate_symbol(predicate);
+
+    if (is_signed_predicate(predicate)) {
+      assign(int_compare, fmt::format("{} {} {}", sign_extended(int_compare->lhs()), symbol,
+                                      sign_extended(int_compare->rhs())));
+    } else {
+      assign(int_compare,
+             fmt::format("{} {} {}", value(int_compare->lhs()), symbol, value(int_compare->rhs())));
+    }
+  }
+
+  void visit_load(Argument<Load> load) { assign(load, fmt::format("*{}", value(load->address()))); }
+
+  void visit_store(Argument<Store> store) {
+    line("*{} = {};", value(store->address()), value(store->value()));
+  }
+
+  void visit_call(Argument<Call> call) {
+    std::string arguments;
+    for (size_t i = 0; i < call->argument_count(); ++i) {
+      if (i > 0) {
+        arguments += ", ";
+      }
+      arguments += value(call->argument(i));
+    }
+
+    const auto expression = fmt::format("{}({})", function_name(call->callee()), arguments);
+    if (call->is_void()) {
+      line("{};", expression);
+    } else {
+      assign(call, expression);
+    }
+  }
+
+  void visit_branch(Argument<Branch> branch) { jump_to(branch->block(), branch->target()); }
+
+  void visit_cond_branch(Argument<CondBranch> cond_branch) {
+    const auto block = cond_branch->block();
+    const auto true_target = cond_branch->true_target();
+    const auto false_target = cond_branch->false_target();
+
+    if (true_target == false_target) {
+      jump_to(block, true_target);
+      return;
+    }
+
+    const auto condition = value(cond_branch->condition());
+
+    if (has_phis(true_target)) {
+      line("if ({}) {{", condition);
+      indentation++;
+      emit_phi_copies(block, true_target);
+      line("goto b{};", true_target->dense_index());
+      indentation--;
+      line("}}");
+    } else {
+      line("if ({}) goto b{};", condition, true_target->dense_index());
+    }
+
+    jump_to(block, false_target);
+  }
+
+  void visit_stackalloc(Argument<StackAlloc> stackalloc) {
+    assign(stackalloc, fmt::format("s{}", stackalloc->dense_index()));
+  }
+
+  void visit_ret(Argument<Ret> ret) {
+    if (ret->returns_void()) {
+      line("return;");
+    } else {
+      line("return {};", value(ret->return_value()));
+    }
+  }
+
+  void visit_offset(Argument<Offset> offset) {
+    assign(offset, fmt::format("{} + {}", value(offset->base()), sign_extended(offset->index())));
+  }
+
+  void visit_cast(Argument<Cast> cast) {
+    const auto type = cast->type();
+    const auto casted_value = cast->casted_value();
+
+    switch (cast->cast_kind()) {
+      case CastKind::ZeroExtend:
+      case CastKind::Bitcast:
+        assign(cast, fmt::format("({}){}", c_type(type), value(casted_value)));
+        break;
+      case CastKind::Truncate:
+        assign(cast, truncated(type, value(casted_value)));
+        break;
+      case CastKind::SignExtend:
+        assign(cast, fmt::format("({}){}", c_type(type), sign_extended(casted_value)));
+        break;
+      default:
+        unreachable();
+    }
+  }
+
+  void visit_select(Argument<Select> select) {
+    assign(select, fmt::format("{} ? {} : {}", value(select->condition()),
+                               value(select->true_value()), value(select->false_value())));
+  }
+
+  void visit_phi(Argument<Phi> phi) { assign(phi, fmt::format("{}_in", name(phi))); }
+};
+
+static std::string function_signature(const Function* function, bool parameter_names) {
+  std::string parameters;
+  for (size_t i = 0; i < function->parameter_count(); ++i) {
+    const auto parameter = function->parameter(i);
+
+    if (i > 0) {
+      parameters += ", ";
+    }
+    parameters += c_type(parameter->type());
+    if (parameter_names) {
+      parameters += fmt::format(" v{}", parameter->dense_index());
+    }
+  }
+
+  if (parameters.empty()) {
+    parameters = "void";
+  }
+
+  return fmt::format("{}{} {}({})", function->is_local() ? "static " : "",
+                     c_type(function->return_type()), function_name(function), parameters);
+}
+
+void flugzeug::emit_c_source(const Module* module, IRPrinter& printer) {
+  printer.raw_write("#include <stdint.h>\n\n");
+
+  for (const Function& function : module->extern_functions()) {
+    printer.raw_write(fmt::format("{};\n", function_signature(&function, false)));
+  }
+  printer.newline();
+
+  for (const Function& function : module->local_functions()) {
+    printer.raw_write(fmt::format("{};\n", function_signature(&function, false)));
+  }
+
+  const Function* main_function = nullptr;
+
+  for (const Function& function : module->local_functions()) {
+    printer.newline();
+    printer.raw_write(fmt::format("{} {{\n", function_signature(&function, true)));
+    CFunctionEmitter(&function, printer).emit();
+    printer.raw_write("}\n");
+
+    if (function.name() == "main" && function.parameter_count() == 0) {
+      main_function = &function;
+    }
+  }
+
+  if (main_function) {
+    printer.raw_write(fmt::format("\nint main(void) {{\n  {}();\n  return 0;\n}}\n",
+                                  function_name(main_function)));
+  }
+}
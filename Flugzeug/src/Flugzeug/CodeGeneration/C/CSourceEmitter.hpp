@@ -0,0 +1,19 @@
+#pragma once
+#include <Flugzeug/IR/IRPrinter.hpp>
+
+namespace flugzeug {
+
+class Module;
+
+/// Emits the module as a single C99 translation unit. Every instruction becomes one statement
+/// assigning to its own local variable, blocks become labels and `StackAlloc`s become local
+/// arrays. Phis are destructed into copies at the end of predecessors (through a temporary per
+/// Phi, so all Phis of a block are assigned in parallel).
+///
+/// Local functions are static and prefixed with `f_`, extern functions are declared with their
+/// IR names. If the module has a local `main` without parameters, C `main` which calls it and
+/// returns 0 is emitted too. Memory is accessed using pointer types from the IR, so the output
+/// must be compiled with strict aliasing disabled.
+void emit_c_source(const Module* module, IRPrinter& printer);
+
+}  // namespace flugzeug
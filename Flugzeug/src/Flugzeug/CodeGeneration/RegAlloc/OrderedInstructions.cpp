@@ -89,18 +89,21 @@ bool OrderedInstruction::join_to(OrderedInstruction* other) {
 
   other_i->live_interval_ = LiveInterval::merge(this_i->live_interval(), other_i->live_interval());
   this_i->live_interval_.clear();
-  representative_ = other_i;
+
+  // Redirect the whole set, not just this instruction, as other members still point to `this_i`.
+  this_i->representative_ = other_i;
 
   return true;
 }
 
-OrderedInstructions::OrderedInstructions(const std::vector<Block*>& toposort) {
+OrderedInstructions::OrderedInstructions(const Function* function,
+                                         const std::vector<Block*>& toposort)
+    : map(function) {
   {
     for (Block* block : toposort) {
       instruction_count += block->instruction_count();
     }
     order = std::make_unique<OrderedInstruction[]>(instruction_count);
-    map.reserve(instruction_count);
   }
 
   {
@@ -110,19 +113,15 @@ OrderedInstructions::OrderedInstructions(const std::vector<Block*>& toposort) {
         const size_t current_index = index++;
 
         order[current_index] = OrderedInstruction{current_index, &instruction};
-        map.insert({&instruction, &order[current_index]});
+        map.insert(&instruction, &order[current_index]);
       }
     }
   }
 }
 
 OrderedInstruction* OrderedInstructions::get(Instruction* instruction) {
-  const auto it = map.find(instruction);
-  if (it == map.end()) {
-    return nullptr;
-  }
-
-  return it->second;
+  const auto ordered_instruction = map.find(instruction);
+  return ordered_instruction ? *ordered_instruction : nullptr;
 }
 
 void OrderedInstructions::debug_print() {
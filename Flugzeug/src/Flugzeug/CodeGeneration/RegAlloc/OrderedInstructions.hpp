@@ -1,6 +1,8 @@
 #pragma once
 #include "LiveInterval.hpp"
 
+#include <Flugzeug/IR/ValueMap.hpp>
+
 #include <memory>
 #include <span>
 #include <string>
@@ -63,15 +65,17 @@ class OrderedInstructions {
   std::unique_ptr<OrderedInstruction[]> order;
   size_t instruction_count = 0;
 
-  std::unordered_map<Instruction*, OrderedInstruction*> map;
+  ValueMap<OrderedInstruction*> map;
 
  public:
-  explicit OrderedInstructions(const std::vector<Block*>& toposort);
+  OrderedInstructions(const Function* function, const std::vector<Block*>& toposort);
 
   std::span<OrderedInstruction> instructions() {
     return {order.get(), order.get() + instruction_count};
   }
 
+  OrderedInstruction* get(size_t index) { return &order[index]; }
+
   OrderedInstruction* get(Instruction* instruction);
 
   void debug_print();
@@ -8,12 +8,21 @@
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
 
+#include <Flugzeug/Passes/Analysis/Liveness.hpp>
+#include <Flugzeug/Passes/Analysis/Loops.hpp>
 #include <Flugzeug/Passes/CFGSimplification.hpp>
 
+#include <algorithm>
+#include <unordered_set>
+
 // https://link.springer.com/content/pdf/10.1007%2F3-540-45937-5_17.pdf
 
 using namespace flugzeug;
 
+/// Uses inside loops are weighted by `loop_weight ^ depth` when choosing values to spill.
+constexpr uint64_t loop_weight = 8;
+constexpr uint64_t max_use_weight = uint64_t(1) << 40;
+
 template <typename Container, typename Fn>
 void for_each_erase(Container& container, Fn callback) {
   auto iterator = begin(container);
@@ -107,17 +116,75 @@ static bool split_critical_edges(Function* function) {
   return did_something;
 }
 
+/// Creates an instruction which copies the value. It isn't inserted anywhere.
+static Instruction* create_copy(Value* value) {
+  const auto context = value->context();
+
+  // Arithmetic on pointers isn't allowed.
+  if (value->type()->is_pointer()) {
+    return new Offset(context, value, context->i64_ty()->zero());
+  }
+
+  return new BinaryInstr(context, value, BinaryOp::Add, value->type()->zero());
+}
+
+/// Moves at the end of a predecessor behave like a parallel copy: every Phi incoming value must be
+/// read before any Phi register is overwritten. Moves are ordered so that a Phi is overwritten
+/// only when no other move needs its old value, cycles are broken with a temporary copy.
 static bool generate_phi_moves(Function* function) {
+  struct PhiCopy {
+    Phi* phi;
+    Value* value;
+  };
+
   bool did_something = false;
+  std::vector<PhiCopy> pending;
 
   for (Block& block : *function) {
-    for (Phi& phi : advance_early(block.instructions<Phi>())) {
-      for (const auto incoming : phi) {
-        const auto move = new BinaryInstr(function->context(), incoming.value, BinaryOp::Add,
-                                          incoming.value->type()->zero());
-        move->insert_before(incoming.block->last_instruction());
+    const auto first_instruction = block.first_instruction();
+    if (!first_instruction || !cast<Phi>(first_instruction)) {
+      continue;
+    }
+
+    for (Block* predecessor : block.predecessors()) {
+      pending.clear();
+      for (Phi& phi : block.instructions<Phi>()) {
+        pending.push_back(PhiCopy{&phi, phi.incoming_for_block(predecessor)});
+      }
+
+      const auto insertion_point = predecessor->last_instruction();
+      const auto is_needed_by_others = [&](const PhiCopy& copy) {
+        return any_of(pending, [&](const PhiCopy& other) {
+          return &other != &copy && other.value == copy.phi;
+        });
+      };
+
+      while (!pending.empty()) {
+        const auto ready = std::find_if(pending.begin(), pending.end(), [&](const PhiCopy& copy) {
+          return !is_needed_by_others(copy);
+        });
+
+        if (ready == pending.end()) {
+          // All remaining moves form cycles. Save the old value of one Phi so it can be
+          // overwritten.
+          const auto phi = pending.front().phi;
+          const auto temporary = create_copy(phi);
+          temporary->insert_before(insertion_point);
+
+          for (auto& copy : pending) {
+            if (copy.value == phi) {
+              copy.value = temporary;
+            }
+          }
 
-        phi.replace_incoming_for_block(incoming.block, move);
+          continue;
+        }
+
+        const auto move = create_copy(ready->value);
+        move->insert_before(insertion_point);
+
+        ready->phi->replace_incoming_for_block(predecessor, move);
+        pending.erase(ready);
 
         did_something = true;
       }
@@ -127,7 +194,25 @@ static bool generate_phi_moves(Function* function) {
   return did_something;
 }
 
-static void prepare_function_for_regalloc(Function* function) {
+/// Parameters aren't allocated so they are copied to instructions at the function entry. This way
+/// they can be kept in registers too.
+static void copy_parameters(Function* function) {
+  const auto insertion_point = function->entry_block()->first_instruction();
+
+  for (size_t i = 0; i < function->parameter_count(); ++i) {
+    const auto parameter = function->parameter(i);
+    if (!parameter->is_used()) {
+      continue;
+    }
+
+    const auto copy = create_copy(parameter);
+    copy->insert_before(insertion_point);
+
+    parameter->replace_uses_with_predicated(copy, [&](User* user) { return user != copy; });
+  }
+}
+
+static void prepare_function_for_regalloc(Function* function, const RegisterFile& register_file) {
   order_phis(function);
 
   const bool splitted = split_critical_edges(function);
@@ -137,8 +222,209 @@ static void prepare_function_for_regalloc(Function* function) {
   if (splitted) {
     opt::CFGSimplification::run(function);
   }
+
+  if (register_file.is_bounded()) {
+    copy_parameters(function);
+  }
 }
 
+static void assign_loop_weights(const analysis::Loop* loop,
+                                uint64_t weight,
+                                std::vector<uint64_t>& block_weights) {
+  weight = std::min(weight * loop_weight, max_use_weight);
+
+  for (Block* block : loop->blocks_without_sub_loops()) {
+    block_weights[block->dense_index()] = weight;
+  }
+
+  for (const auto& sub_loop : loop->sub_loops()) {
+    assign_loop_weights(sub_loop.get(), weight, block_weights);
+  }
+}
+
+/// Maximal number of values which are live at the same time inside the block.
+static size_t block_register_pressure(const Block* block,
+                                      const analysis::Liveness& liveness,
+                                      DenseBitSet& live) {
+  live.clear();
+  live.merge(liveness.live_out(block));
+
+  size_t pressure = live.size();
+  size_t max_pressure = pressure;
+
+  for (const Instruction& instruction : reversed(*block)) {
+    if (cast<Phi>(instruction)) {
+      continue;
+    }
+
+    if (live.erase(instruction.dense_index())) {
+      pressure--;
+    }
+
+    for (const Value& operand : instruction.operands()) {
+      if (cast<Instruction>(operand) && live.insert(operand.dense_index())) {
+        pressure++;
+      }
+    }
+
+    max_pressure = std::max(max_pressure, pressure);
+  }
+
+  return max_pressure;
+}
+
+class LiveRangeSplitter {
+  Function* function;
+  const RegisterFile& register_file;
+  const DominatorTree& dominator_tree;
+
+  analysis::Liveness liveness;
+  std::vector<size_t> block_pressure;
+
+  /// Values whose live range was already split around some loop.
+  std::unordered_set<const Instruction*> split_values;
+  std::unordered_set<const Instruction*> copies;
+
+  static Block* find_preheader(const analysis::Loop* loop) {
+    Block* preheader = nullptr;
+
+    for (Block* predecessor : loop->header()->predecessors()) {
+      if (!loop->contains_block(predecessor)) {
+        if (preheader) {
+          return nullptr;
+        }
+        preheader = predecessor;
+      }
+    }
+
+    if (!preheader || preheader->successors().size() != 1) {
+      return nullptr;
+    }
+
+    return preheader;
+  }
+
+  static bool is_used_in_loop(Instruction* value, const analysis::Loop* loop) {
+    return any_of(value->users(), [&](User& user) {
+      const auto user_instruction = cast<Instruction>(user);
+      return user_instruction && loop->contains_block(user_instruction->block());
+    });
+  }
+
+  void split_around_loop(const analysis::Loop* loop) {
+    size_t max_pressure = 0;
+    for (const Block* block : loop->blocks()) {
+      max_pressure = std::max(max_pressure, block_pressure[block->dense_index()]);
+    }
+
+    // Values which are live through the loop without being used inside of it.
+    std::vector<Instruction*> candidates;
+    size_t already_split = 0;
+
+    for (const size_t index : liveness.live_in(loop->header())) {
+      const auto value = cast<Instruction>(function->value_by_index(index));
+      if (!value || is_used_in_loop(value, loop)) {
+        continue;
+      }
+
+      if (split_values.contains(value)) {
+        already_split++;
+      } else {
+        candidates.push_back(value);
+      }
+    }
+
+    const auto preheader = find_preheader(loop);
+    const auto exit = loop->single_exit_target();
+
+    if (preheader && exit && exit->predecessors().size() == 1 &&
+        max_pressure > register_file.register_count + already_split) {
+      size_t excess = max_pressure - already_split - register_file.register_count;
+
+      const auto reachable_from_loop = loop->header()->reachable_blocks_set(IncludeStart::Yes);
+
+      Instruction* exit_insertion_point = exit->first_instruction();
+      while (cast<Phi>(exit_insertion_point)) {
+        exit_insertion_point = exit_insertion_point->next();
+      }
+
+      for (Instruction* value : candidates) {
+        if (excess == 0) {
+          break;
+        }
+
+        // After the split the value must not be used on any path going through the loop except
+        // after the exit.
+        const auto can_split = all_of(value->users(), [&](User& user) {
+          const auto user_instruction = cast<Instruction>(user);
+          if (!user_instruction || cast<Phi>(user_instruction)) {
+            return false;
+          }
+
+          const auto block = user_instruction->block();
+          return exit->dominates(block, dominator_tree) || !reachable_from_loop.contains(block);
+        });
+        if (!can_split) {
+          continue;
+        }
+
+        // value -> [spilled copy live through the loop] -> copy used after the loop.
+        const auto before_loop = create_copy(value);
+        before_loop->insert_before(preheader->last_instruction());
+
+        const auto after_loop = create_copy(before_loop);
+        after_loop->insert_before(exit_insertion_point);
+
+        value->replace_uses_with_predicated(after_loop, [&](User* user) {
+          const auto user_instruction = cast<Instruction>(user);
+          return user_instruction != before_loop &&
+                 exit->dominates(user_instruction->block(), dominator_tree);
+        });
+
+        split_values.insert(value);
+        copies.insert(before_loop);
+        copies.insert(after_loop);
+
+        excess--;
+      }
+    }
+
+    for (const auto& sub_loop : loop->sub_loops()) {
+      split_around_loop(sub_loop.get());
+    }
+  }
+
+ public:
+  LiveRangeSplitter(Function* function,
+                    const RegisterFile& register_file,
+                    const DominatorTree& dominator_tree)
+      : function(function),
+        register_file(register_file),
+        dominator_tree(dominator_tree),
+        liveness(function),
+        block_pressure(function->block_index_capacity(), 0) {
+    DenseBitSet live(function->value_index_capacity());
+
+    for (const Block& block : *function) {
+      block_pressure[block.dense_index()] = block_register_pressure(&block, liveness, live);
+    }
+  }
+
+  /// Splits live ranges of values which are live through loops that need more registers than
+  /// available: the value is copied before the loop and the copy is copied again after the loop.
+  /// The first copy has no uses inside the loop so it will be spilled instead of values used by
+  /// the loop. Returns all inserted copies (they must not be coalesced with their operands).
+  /// Liveness is computed once so splits of outer loops are only approximated for inner loops.
+  std::unordered_set<const Instruction*> split(
+    const std::vector<std::unique_ptr<analysis::Loop>>& loops) {
+    for (const auto& loop : loops) {
+      split_around_loop(loop.get());
+    }
+
+    return std::move(copies);
+  }
+};
+
 static std::vector<Block*> toposort_blocks(Function* function, const BackEdges& back_edges) {
   // A topological sort of a directed graph is a linear ordering of its vertices such that for every
   // directed edge uv from vertex u to vertex v, u comes before v in the ordering.
@@ -148,11 +434,10 @@ static std::vector<Block*> toposort_blocks(Function* function, const BackEdges&
 
   std::vector<Block*> stack;
   std::vector<Block*> sorted;
-  std::unordered_set<Block*> visited;
+  BlockSet visited(function);
 
   stack.reserve(function->block_count() / 4);
   sorted.reserve(function->block_count());
-  visited.reserve(function->block_count());
 
   const auto are_predecessors_processed = [&](Block* block) {
     return all_of(block->predecessors(), [&](Block* predecessor) {
@@ -179,7 +464,7 @@ static std::vector<Block*> toposort_blocks(Function* function, const BackEdges&
     const auto block = stack.back();
     stack.pop_back();
 
-    if (!visited.insert(block).second) {
+    if (!visited.insert(block)) {
       continue;
     }
 
@@ -198,76 +483,12 @@ static std::vector<Block*> toposort_blocks(Function* function, const BackEdges&
   return sorted;
 }
 
-static void build_live_intervals(OrderedInstructions& ordered_instructions,
+static void build_live_intervals(Function* function,
+                                 OrderedInstructions& ordered_instructions,
                                  const std::vector<Block*>& toposort,
-                                 const BackEdges& back_edges) {
-  // Map: block -> values which are live at the beginning of the block
-  std::unordered_map<Block*, std::unordered_set<OrderedInstruction*>> live_in_blocks;
-  live_in_blocks.reserve(toposort.size());
-
-  const auto process_successors_phis = [&](Block* block, Block* successor,
-                                           std::unordered_set<OrderedInstruction*>& live) {
-    for (Phi& phi : successor->instructions<Phi>()) {
-      const auto incoming = cast<Instruction>(phi.incoming_for_block(block));
-      verify(incoming, "Incoming value should be an instruction");
-
-      // Make sure that successor's Phi isn't in the live set.
-      live.erase(ordered_instructions.get(&phi));
-
-      // Incoming value must live till the end of this block.
-      live.insert(ordered_instructions.get(incoming));
-    }
-  };
-
-  // Compute values which are live at the beginning of every block. We do this by iterating over
-  // topological order in reverse. This means that when we process a given block all its successors
-  // are already processed. The only exceptions are back edges but it's fine as values from back
-  // edges need to be accessed via Phi instructions.
-  for (Block* block : reversed(toposort)) {
-    // Set of live values in the block.
-    std::unordered_set<OrderedInstruction*> live;
-
-    for (Block* successor : block->successors()) {
-      // Everything that is live at the beginning of a successor needs to be live in this block too.
-      if (const auto it = live_in_blocks.find(successor); it != live_in_blocks.end()) {
-        live.insert(begin(it->second), end(it->second));
-      } else {
-        // If we haven't visited a successor yet then it must be a back edge.
-        verify(back_edges.is_back_edge(block, successor),
-               "Successor block wasn't visited yet and it's not a back edge");
-      }
-
-      process_successors_phis(block, successor, live);
-    }
-
-    // Add operands of the instructions in the block to the live list.
-    // Remove instructions created in this block from the live set as these values aren't live
-    // at the beginning of the block.
-    for (Instruction& instruction : reversed(*block)) {
-      // Skip Phis as they are treated specially.
-      if (cast<Phi>(instruction)) {
-        continue;
-      }
-
-      // This value was created in this block so it isn't live at the beginning of it.
-      live.erase(ordered_instructions.get(&instruction));
-
-      // All operands used in this instruction are live.
-      for (Value& operand_v : instruction.operands()) {
-        const auto operand = cast<Instruction>(operand_v);
-        if (!operand) {
-          continue;
-        }
-
-        live.insert(ordered_instructions.get(operand));
-      }
-    }
-
-    // We have finished gathering all live values at the beginning of the block.
-    live_in_blocks.insert({block, std::move(live)});
-  }
-
-  std::unordered_set<OrderedInstruction*> live;
+                                 const analysis::Liveness& liveness) {
+  // Live set contains dense indices of values (like sets computed by liveness analysis).
+  DenseBitSet live(function->value_index_capacity());
 
   // Build the intervals.
   for (Block* block : toposort) {
@@ -287,28 +508,17 @@ static void build_live_intervals(OrderedInstructions& ordered_instructions,
                                                    : Range{instructions_range.first, last_use});
     };
 
+    // Values live at the end of the block already include incoming values for Phis of the
+    // successors (and exclude these Phis).
     live.clear();
+    live.merge(liveness.live_out(block));
 
-    // Gether values which are live at the beginning of the successors.
-    for (Block* successor : block->successors()) {
-      // Everything that is live at the beginning of a successor needs to be live in this block too.
-      {
-        const auto it = live_in_blocks.find(successor);
-        verify(it != live_in_blocks.end(), "Map of live values in blocks is incomplete");
-        live.insert(begin(it->second), end(it->second));
-      }
-
-      process_successors_phis(block, successor, live);
-    }
-
-    // All values which are live at the beginning of the successors must live till the end of this
-    // block.
-    for (OrderedInstruction* instruction : live) {
-      if (cast<Phi>(instruction->get())) {
-        continue;
+    // All values which are live at the end of the block must live till the end of this block.
+    // This includes Phis used after their block.
+    for (const size_t index : live) {
+      if (const auto instruction = cast<Instruction>(function->value_by_index(index))) {
+        add_last_use_in_block(ordered_instructions.get(instruction), instructions_range.last + 1);
       }
-
-      add_last_use_in_block(instruction, instructions_range.last + 1);
     }
 
     // Add operands of the instructions in the block to the live list.
@@ -321,7 +531,7 @@ static void build_live_intervals(OrderedInstructions& ordered_instructions,
       // As we are iterating in reverse order as soon as we encounter this instruction it isn't live
       // anymore.
       const auto instruction_o = ordered_instructions.get(&instruction);
-      live.erase(instruction_o);
+      live.erase(instruction.dense_index());
 
       for (Value& operand_v : instruction.operands()) {
         const auto operand = cast<Instruction>(operand_v);
@@ -329,18 +539,17 @@ static void build_live_intervals(OrderedInstructions& ordered_instructions,
           continue;
         }
 
-        const auto operand_o = ordered_instructions.get(operand);
-
         // If this operand isn't in the live set yet then it's the last use of this operand so far.
-        if (live.insert(operand_o).second) {
-          add_last_use_in_block(operand_o, instruction_o->index());
+        if (live.insert(operand->dense_index())) {
+          add_last_use_in_block(ordered_instructions.get(operand), instruction_o->index());
         }
       }
     }
   }
 }
 
-static void coalesce(OrderedInstructions& ordered_instructions) {
+static void coalesce(OrderedInstructions& ordered_instructions,
+                     const std::unordered_set<const Instruction*>& split_copies) {
   // Make sure that all incoming values and Phis are mapped to the same register. It is required for
   // correctness.
   for (OrderedInstruction& instruction : ordered_instructions.instructions()) {
@@ -357,10 +566,11 @@ static void coalesce(OrderedInstructions& ordered_instructions) {
     }
   }
 
-  // Try to coalesce instruction result with first argument. This is done for speed.
+  // Try to coalesce instruction result with first argument. This is done for speed. Copies which
+  // split live ranges are skipped as coalescing them would undo the split.
   for (OrderedInstruction& instruction : ordered_instructions.instructions()) {
     if (!instruction.has_value() || cast<Phi>(instruction.get()) ||
-        instruction.get()->operand_count() == 0) {
+        instruction.get()->operand_count() == 0 || split_copies.contains(instruction.get())) {
       continue;
     }
 
@@ -375,8 +585,70 @@ static void coalesce(OrderedInstructions& ordered_instructions) {
   }
 }
 
-static std::unordered_map<OrderedInstruction*, uint32_t> linear_scan_allocation(
-  OrderedInstructions& ordered_instructions) {
+/// Spill weight of every representative instruction (indexed by ordered instruction index): uses
+/// and definitions weighted by loop depth divided by the length of the live interval. Values with
+/// the lowest weight are spilled first.
+static std::vector<double> calculate_spill_weights(
+  Function* function,
+  OrderedInstructions& ordered_instructions,
+  const std::vector<std::unique_ptr<analysis::Loop>>& loops) {
+  std::vector<uint64_t> block_weights(function->block_index_capacity(), 1);
+  for (const auto& loop : loops) {
+    assign_loop_weights(loop.get(), 1, block_weights);
+  }
+
+  std::vector<double> weights(ordered_instructions.instructions().size(), 0.0);
+
+  const auto add_weight = [&](Instruction* instruction, uint64_t weight) {
+    const auto representative = ordered_instructions.get(instruction)->representative();
+    weights[representative->index()] += double(weight);
+  };
+
+  for (Block& block : *function) {
+    const auto block_weight = block_weights[block.dense_index()];
+
+    for (Instruction& instruction : block) {
+      // Phis don't generate any code.
+      if (cast<Phi>(instruction)) {
+        continue;
+      }
+
+      if (!instruction.is_void()) {
+        add_weight(&instruction, block_weight);
+      }
+
+      for (Value& operand_v : instruction.operands()) {
+        if (const auto operand = cast<Instruction>(operand_v)) {
+          add_weight(operand, block_weight);
+        }
+      }
+    }
+  }
+
+  for (OrderedInstruction& instruction : ordered_instructions.instructions()) {
+    if (!instruction.has_value() || instruction.is_joined()) {
+      continue;
+    }
+
+    size_t length = 1;
+    for (const Range& range : instruction.live_interval().ranges()) {
+      length += range.end - range.start;
+    }
+
+    weights[instruction.index()] /= double(length);
+  }
+
+  return weights;
+}
+
+struct LinearScanResult {
+  std::unordered_map<OrderedInstruction*, uint32_t> registers;
+  std::vector<OrderedInstruction*> spilled;
+};
+
+static LinearScanResult linear_scan_allocation(OrderedInstructions& ordered_instructions,
+                                               const RegisterFile& register_file,
+                                               const std::vector<double>& spill_weights) {
   // Intervals which aren't processed yet.
   std::vector<OrderedInstruction*> unhandled;
 
@@ -386,13 +658,19 @@ static std::unordered_map<OrderedInstruction*, uint32_t> linear_scan_allocation(
   // Intervals which have holes and `current.start` falls into one of them.
   std::vector<OrderedInstruction*> inactive;
 
-  std::unordered_map<OrderedInstruction*, uint32_t> registers;
+  LinearScanResult result;
+
+  auto& registers = result.registers;
   const auto get_register = [&](OrderedInstruction* instruction) {
     const auto it = registers.find(instruction);
     verify(it != registers.end(), "Register is not assigned yet (?)");
     return it->second;
   };
 
+  const auto spill_weight = [&](OrderedInstruction* instruction) {
+    return spill_weights[instruction->index()];
+  };
+
   std::unordered_set<uint32_t> free;
   std::unordered_set<uint32_t> tmp_free;
 
@@ -416,12 +694,30 @@ static std::unordered_map<OrderedInstruction*, uint32_t> linear_scan_allocation(
     });
   }
 
+  // Returns the register which is cheapest to free for `current` by spilling intervals which
+  // occupy it (and the sum of their spill weights).
+  const auto find_cheapest_register = [&](const LiveInterval& current_li) {
+    std::vector<double> costs(register_file.register_count, 0.0);
+
+    for (const auto instruction : active) {
+      costs[get_register(instruction)] += spill_weight(instruction);
+    }
+
+    for (const auto instruction : inactive) {
+      if (LiveInterval::are_overlapping(instruction->live_interval(), current_li)) {
+        costs[get_register(instruction)] += spill_weight(instruction);
+      }
+    }
+
+    const auto cheapest = std::min_element(costs.begin(), costs.end());
+    return std::pair{uint32_t(cheapest - costs.begin()), *cheapest};
+  };
+
   while (!unhandled.empty()) {
     // Get unhandled instruction with the lowest starting point.
     const auto current = unhandled.back();
     const auto& current_li = current->live_interval();
     unhandled.pop_back();
-
     // Check for active intervals that expired.
     for_each_erase(active, [&](OrderedInstruction* instruction) {
       const auto& instruction_li = instruction->live_interval();
@@ -478,13 +774,41 @@ static std::unordered_map<OrderedInstruction*, uint32_t> linear_scan_allocation(
       }
     }
 
-    // Assign register to `current`. If there isn't any free register we will create a new one. If
-    // there is one we will take the first one.
+    // Assign register to `current`. If there isn't any free register we will create a new one
+    // (if the register file allows it). If there is one we will take the first one.
     uint32_t assigned_reg = 0;
-    if (tmp_free.empty()) {
+    if (!tmp_free.empty()) {
+      assigned_reg = *tmp_free.begin();
+      free.erase(assigned_reg);
+    } else if (next_register_id < register_file.register_count) {
       assigned_reg = next_register_id++;
     } else {
-      assigned_reg = *tmp_free.begin();
+      // All registers are taken. Either spill `current` or all intervals which occupy the register
+      // that is cheapest to free.
+      const auto [cheapest_reg, cost] = find_cheapest_register(current_li);
+      if (cost >= spill_weight(current)) {
+        result.spilled.push_back(current);
+        continue;
+      }
+
+      const auto spill_occupants = [&](OrderedInstruction* instruction) {
+        if (get_register(instruction) != cheapest_reg) {
+          return false;
+        }
+
+        registers.erase(instruction);
+        result.spilled.push_back(instruction);
+
+        return true;
+      };
+
+      for_each_erase(active, spill_occupants);
+      for_each_erase(inactive, [&](OrderedInstruction* instruction) {
+        return LiveInterval::are_overlapping(instruction->live_interval(), current_li) &&
+               spill_occupants(instruction);
+      });
+
+      assigned_reg = cheapest_reg;
       free.erase(assigned_reg);
     }
 
@@ -494,65 +818,114 @@ static std::unordered_map<OrderedInstruction*, uint32_t> linear_scan_allocation(
     active.push_back(current);
   }
 
-  return registers;
+  return result;
 }
 
-static void debug_print_allocation(
-  OrderedInstructions& ordered_instructions,
-  const std::unordered_map<OrderedInstruction*, uint32_t>& allocation) {
+/// Spilled intervals which don't overlap share the spill slot.
+static std::unordered_map<OrderedInstruction*, uint32_t> assign_spill_slots(
+  std::vector<OrderedInstruction*> spilled) {
+  std::sort(begin(spilled), end(spilled), [&](OrderedInstruction* a, OrderedInstruction* b) {
+    return a->live_interval().first_range_start() < b->live_interval().first_range_start();
+  });
+
+  // Union of live intervals of values in every slot.
+  std::vector<LiveInterval> slots;
+  std::unordered_map<OrderedInstruction*, uint32_t> spill_slots;
+
+  for (const auto instruction : spilled) {
+    const auto& interval = instruction->live_interval();
+
+    const auto slot = std::find_if(slots.begin(), slots.end(), [&](const LiveInterval& slot) {
+      return !LiveInterval::are_overlapping(slot, interval);
+    });
+
+    if (slot == slots.end()) {
+      spill_slots[instruction] = uint32_t(slots.size());
+      slots.push_back(interval);
+    } else {
+      spill_slots[instruction] = uint32_t(slot - slots.begin());
+      *slot = LiveInterval::merge(*slot, interval);
+    }
+  }
+
+  return spill_slots;
+}
+
+static void debug_print_allocation(OrderedInstructions& ordered_instructions,
+                                   const LinearScanResult& allocation) {
   DebugRepresentation dbg_repr(ordered_instructions);
 
   log_debug("Register allocation:");
 
-  for (const auto [instruction, reg] : allocation) {
+  for (const auto [instruction, reg] : allocation.registers) {
     log_debug("{}: R{}", dbg_repr.format(instruction), reg);
   }
 
+  for (const auto instruction : allocation.spilled) {
+    log_debug("{}: spilled", dbg_repr.format(instruction));
+  }
+
   log_debug("");
 }
 
-static void debug_verify_allocation(
-  OrderedInstructions& ordered_instructions,
-  const std::unordered_map<OrderedInstruction*, uint32_t>& allocation) {
+static void debug_verify_allocation(OrderedInstructions& ordered_instructions,
+                                    const LinearScanResult& allocation) {
+  const auto& registers = allocation.registers;
+
   for (OrderedInstruction& a : ordered_instructions.instructions()) {
-    if (!a.has_value() || a.is_joined()) {
+    if (!a.has_value() || a.is_joined() || !registers.contains(&a)) {
       continue;
     }
 
     for (OrderedInstruction& b : ordered_instructions.instructions()) {
-      if (&a == &b || &a > &b || !b.has_value() || b.is_joined()) {
+      if (&a == &b || &a > &b || !b.has_value() || b.is_joined() || !registers.contains(&b)) {
         continue;
       }
 
       const auto overlap = LiveInterval::are_overlapping(a.live_interval(), b.live_interval());
       if (overlap) {
-        verify(allocation.find(&a)->second != allocation.find(&b)->second,
+        verify(registers.find(&a)->second != registers.find(&b)->second,
                "Instructions have overlapping intervals but the have assigned the same register");
       }
     }
   }
 }
 
-AllocatedRegisters flugzeug::allocate_registers(Function* function) {
-  prepare_function_for_regalloc(function);
+AllocatedRegisters flugzeug::allocate_registers(Function* function,
+                                                const RegisterFile& register_file) {
+  verify(register_file.register_count > 0, "Register file must have at least one register");
+
+  prepare_function_for_regalloc(function, register_file);
 
   const DominatorTree dominator_tree(function);
   const BackEdges back_edges(dominator_tree);
 
+  const auto loops = analysis::analyze_function_loops(function, dominator_tree);
+
+  std::unordered_set<const Instruction*> split_copies;
+  if (register_file.is_bounded()) {
+    split_copies = LiveRangeSplitter(function, register_file, dominator_tree).split(loops);
+  }
+
   const auto toposort = toposort_blocks(function, back_edges);
 
-  OrderedInstructions ordered_instructions(toposort);
+  OrderedInstructions ordered_instructions(function, toposort);
+
+  const analysis::Liveness liveness(function);
 
-  build_live_intervals(ordered_instructions, toposort, back_edges);
-  coalesce(ordered_instructions);
+  build_live_intervals(function, ordered_instructions, toposort, liveness);
+  coalesce(ordered_instructions, split_copies);
 
-  const auto allocation = linear_scan_allocation(ordered_instructions);
+  const auto spill_weights = calculate_spill_weights(function, ordered_instructions, loops);
+  const auto allocation = linear_scan_allocation(ordered_instructions, register_file,
+                                                 spill_weights);
+  const auto spill_slots = assign_spill_slots(allocation.spilled);
 
   if (false) {
     debug_verify_allocation(ordered_instructions, allocation);
   }
 
-  if (true) {
+  if (false) {
     ordered_instructions.debug_print();
     ordered_instructions.debug_print_intervals();
     ordered_instructions.debug_print_interference();
@@ -561,25 +934,90 @@ AllocatedRegisters flugzeug::allocate_registers(Function* function) {
   }
 
   std::unordered_map<const Instruction*, uint32_t> registers;
-  registers.reserve(allocation.size());
+  std::unordered_map<const Instruction*, uint32_t> instruction_spill_slots;
+  registers.reserve(allocation.registers.size());
 
   for (OrderedInstruction& instruction : ordered_instructions.instructions()) {
     if (!instruction.has_value()) {
       continue;
     }
 
-    const auto it = allocation.find(instruction.representative());
-    verify(it != allocation.end(), "Not all registers were assigned during register allocation");
+    const auto representative = instruction.representative();
+
+    if (const auto it = allocation.registers.find(representative);
+        it != allocation.registers.end()) {
+      registers.insert({instruction.get(), it->second});
+    } else {
+      const auto slot = spill_slots.find(representative);
+      verify(slot != spill_slots.end(),
+             "Not all registers were assigned during register allocation");
+
+      instruction_spill_slots.insert({instruction.get(), slot->second});
+    }
+  }
+
+  // Every spilled value is stored once when it's created and loaded by every user. Phis don't
+  // generate code, their incoming values are stored to the shared slot instead.
+  SpillStatistics statistics;
+
+  for (const Block& block : *function) {
+    for (const Instruction& instruction : block) {
+      if (cast<Phi>(instruction)) {
+        continue;
+      }
+
+      if (instruction_spill_slots.contains(&instruction)) {
+        statistics.spill_stores++;
+      }
+
+      for (const Value& operand_v : instruction.operands()) {
+        const auto operand = cast<Instruction>(operand_v);
+        if (operand && instruction_spill_slots.contains(operand)) {
+          statistics.reloads++;
+        }
+      }
+    }
+  }
+
+  statistics.spilled_values = uint32_t(instruction_spill_slots.size());
+
+  return AllocatedRegisters(std::move(registers), std::move(instruction_spill_slots), statistics);
+}
+
+AllocatedRegisters::AllocatedRegisters(
+  std::unordered_map<const Instruction*, uint32_t> registers,
+  std::unordered_map<const Instruction*, uint32_t> spill_slots,
+  SpillStatistics spill_statistics)
+    : registers(std::move(registers)),
+      spill_slots(std::move(spill_slots)),
+      spill_statistics_(spill_statistics) {
+  for (const auto& [_, reg] : this->registers) {
+    register_count_ = std::max(register_count_, reg + 1);
+  }
 
-    registers.insert({instruction.get(), it->second});
+  for (const auto& [_, slot] : this->spill_slots) {
+    spill_slot_count_ = std::max(spill_slot_count_, slot + 1);
   }
+}
 
-  return AllocatedRegisters(std::move(registers));
+bool AllocatedRegisters::has_register(const Instruction* instruction) const {
+  return registers.contains(instruction);
 }
 
 uint32_t AllocatedRegisters::register_for_instruction(const Instruction* instruction) const {
   const auto it = registers.find(instruction);
-  verify(it == registers.end(), "No register was assigned to a given instruction");
+  verify(it != registers.end(), "No register was assigned to a given instruction");
+
+  return it->second;
+}
+
+bool AllocatedRegisters::is_spilled(const Instruction* instruction) const {
+  return spill_slots.contains(instruction);
+}
+
+uint32_t AllocatedRegisters::spill_slot_for_instruction(const Instruction* instruction) const {
+  const auto it = spill_slots.find(instruction);
+  verify(it != spill_slots.end(), "Given instruction wasn't spilled");
 
   return it->second;
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <limits>
 #include <unordered_map>
 
 namespace flugzeug {
@@ -7,16 +8,64 @@ namespace flugzeug {
 class Function;
 class Instruction;
 
+/// Registers of the target available to the allocator. All IR values are integers or pointers so
+/// there is a single register class.
+struct RegisterFile {
+  constexpr static uint32_t unlimited = std::numeric_limits<uint32_t>::max();
+
+  uint32_t register_count = unlimited;
+
+  bool is_bounded() const { return register_count != unlimited; }
+};
+
+/// Spill code which consumers of the allocation need to emit (static counts, not weighted by
+/// execution frequency).
+struct SpillStatistics {
+  /// Values which live in spill slots instead of registers.
+  uint32_t spilled_values = 0;
+  /// Instructions which write their result to a spill slot.
+  uint32_t spill_stores = 0;
+  /// Operands which need to be loaded from a spill slot.
+  uint32_t reloads = 0;
+};
+
 class AllocatedRegisters {
   std::unordered_map<const Instruction*, uint32_t> registers;
+  std::unordered_map<const Instruction*, uint32_t> spill_slots;
+  uint32_t register_count_ = 0;
+  uint32_t spill_slot_count_ = 0;
+
+  SpillStatistics spill_statistics_;
 
  public:
-  explicit AllocatedRegisters(std::unordered_map<const Instruction*, uint32_t> registers)
-      : registers(std::move(registers)) {}
+  AllocatedRegisters(std::unordered_map<const Instruction*, uint32_t> registers,
+                     std::unordered_map<const Instruction*, uint32_t> spill_slots,
+                     SpillStatistics spill_statistics);
+
+  /// Registers are numbered from 0 to `register_count() - 1`.
+  uint32_t register_count() const { return register_count_; }
+  /// Spill slots are numbered from 0 to `spill_slot_count() - 1`.
+  uint32_t spill_slot_count() const { return spill_slot_count_; }
 
+  const SpillStatistics& spill_statistics() const { return spill_statistics_; }
+
+  /// Only instructions which produce a value have a register or a spill slot assigned.
+  bool has_register(const Instruction* instruction) const;
   uint32_t register_for_instruction(const Instruction* instruction) const;
+
+  /// Spilled values live in their spill slot for their whole lifetime.
+  bool is_spilled(const Instruction* instruction) const;
+  uint32_t spill_slot_for_instruction(const Instruction* instruction) const;
 };
 
-AllocatedRegisters allocate_registers(Function* function);
+/// Prepares the function for register allocation first: Phis are moved to the beginning of the
+/// blocks, critical edges are split and every Phi incoming value is copied to the Phi register
+/// at the end of the incoming block.
+///
+/// If the register file is bounded parameters are copied to instructions at the function entry,
+/// live ranges of values which are live through loops that need more registers than available
+/// are split around these loops and values which don't fit in registers are spilled. Spilled
+/// values are chosen by the number of uses weighted by loop depth.
+AllocatedRegisters allocate_registers(Function* function, const RegisterFile& register_file = {});
 
-}  // namespace flugzeug
\ No newline at end of file
+}  // namespace flugzeug
@@ -0,0 +1,223 @@
+#include "ElfObject.hpp"
+
+#include <Flugzeug/Core/Error.hpp>
+
+#include <algorithm>
+#include <string_view>
+
+using namespace flugzeug;
+
+namespace elf {
+
+constexpr uint16_t et_rel = 1;
+constexpr uint16_t em_x86_64 = 62;
+
+constexpr uint32_t sht_progbits = 1;
+constexpr uint32_t sht_symtab = 2;
+constexpr uint32_t sht_strtab = 3;
+constexpr uint32_t sht_rela = 4;
+
+constexpr uint64_t shf_alloc = 0x2;
+constexpr uint64_t shf_execinstr = 0x4;
+constexpr uint64_t shf_info_link = 0x40;
+
+constexpr uint8_t stb_global = 1;
+constexpr uint8_t stt_notype = 0;
+constexpr uint8_t stt_func = 2;
+
+constexpr uint32_t r_x86_64_plt32 = 4;
+
+constexpr size_t header_size = 64;
+constexpr size_t section_header_size = 64;
+constexpr size_t symbol_size = 24;
+constexpr size_t rela_size = 24;
+
+/// Section indices in the order in which section headers are written.
+enum Section : uint16_t {
+  Null,
+  Text,
+  RelaText,
+  Symtab,
+  Strtab,
+  Shstrtab,
+  NoteGnuStack,
+  Count,
+};
+
+}  // namespace elf
+
+template <typename T>
+static void append(std::vector<uint8_t>& bytes, T value) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bytes.push_back(uint8_t(uint64_t(value) >> (i * 8)));
+  }
+}
+
+static void align(std::vector<uint8_t>& bytes, size_t alignment) {
+  while (bytes.size() % alignment != 0) {
+    bytes.push_back(0);
+  }
+}
+
+/// Appends null terminated string to the string table and returns its offset.
+static uint32_t add_string(std::vector<uint8_t>& table, std::string_view string) {
+  const auto offset = uint32_t(table.size());
+  table.insert(table.end(), string.begin(), string.end());
+  table.push_back(0);
+  return offset;
+}
+
+static void append_symbol(std::vector<uint8_t>& bytes,
+                          uint32_t name,
+                          uint8_t info,
+                          uint16_t section,
+                          uint64_t value,
+                          uint64_t size) {
+  append<uint32_t>(bytes, name);
+  append<uint8_t>(bytes, info);
+  append<uint8_t>(bytes, 0);
+  append<uint16_t>(bytes, section);
+  append<uint64_t>(bytes, value);
+  append<uint64_t>(bytes, size);
+}
+
+struct SectionHeader {
+  uint32_t name = 0;
+  uint32_t type = 0;
+  uint64_t flags = 0;
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  uint32_t link = 0;
+  uint32_t info = 0;
+  uint64_t alignment = 1;
+  uint64_t entry_size = 0;
+};
+
+std::vector<uint8_t> flugzeug::create_elf_object(const X86Code& code) {
+  std::vector<uint8_t> strtab{0};
+  std::vector<uint8_t> shstrtab{0};
+  std::vector<uint8_t> symtab;
+  std::vector<uint8_t> rela_text;
+
+  constexpr uint8_t function_info = (elf::stb_global << 4) | elf::stt_func;
+  constexpr uint8_t extern_info = (elf::stb_global << 4) | elf::stt_notype;
+
+  // Symbol 0 is reserved. There are no local symbols so all other symbols are global.
+  append_symbol(symtab, 0, 0, 0, 0, 0);
+
+  for (const auto& function : code.functions) {
+    append_symbol(symtab, add_string(strtab, function.name), function_info, elf::Text,
+                  function.offset, function.size);
+  }
+
+  const auto extern_symbol_base = uint64_t(1 + code.functions.size());
+
+  for (const auto& name : code.extern_functions) {
+    append_symbol(symtab, add_string(strtab, name), extern_info, 0, 0, 0);
+  }
+
+  // Displacement is relative to the end of the call instruction.
+  for (const auto& call : code.extern_calls) {
+    verify(call.extern_index < code.extern_functions.size(), "Invalid extern function index");
+
+    append<uint64_t>(rela_text, call.offset);
+    append<uint64_t>(rela_text,
+                     ((extern_symbol_base + call.extern_index) << 32) | elf::r_x86_64_plt32);
+    append<int64_t>(rela_text, -4);
+  }
+
+  std::vector<SectionHeader> sections(elf::Count);
+
+  sections[elf::Text] = SectionHeader{
+    .name = add_string(shstrtab, ".text"),
+    .type = elf::sht_progbits,
+    .flags = elf::shf_alloc | elf::shf_execinstr,
+    .size = code.code.size(),
+    .alignment = 16,
+  };
+  sections[elf::RelaText] = SectionHeader{
+    .name = add_string(shstrtab, ".rela.text"),
+    .type = elf::sht_rela,
+    .flags = elf::shf_info_link,
+    .size = rela_text.size(),
+    .link = elf::Symtab,
+    .info = elf::Text,
+    .alignment = 8,
+    .entry_size = elf::rela_size,
+  };
+  sections[elf::Symtab] = SectionHeader{
+    .name = add_string(shstrtab, ".symtab"),
+    .type = elf::sht_symtab,
+    .size = symtab.size(),
+    .link = elf::Strtab,
+    .info = 1,
+    .alignment = 8,
+    .entry_size = elf::symbol_size,
+  };
+  sections[elf::Strtab] = SectionHeader{
+    .name = add_string(shstrtab, ".strtab"),
+    .type = elf::sht_strtab,
+    .size = strtab.size(),
+  };
+  // Without this section linkers assume that the object needs executable stack.
+  sections[elf::NoteGnuStack] = SectionHeader{
+    .name = add_string(shstrtab, ".note.GNU-stack"),
+    .type = elf::sht_progbits,
+  };
+  sections[elf::Shstrtab] = SectionHeader{
+    .name = add_string(shstrtab, ".shstrtab"),
+    .type = elf::sht_strtab,
+    .size = shstrtab.size(),
+  };
+
+  std::vector<uint8_t> object(elf::header_size);
+
+  const auto append_section_data = [&](elf::Section section, const std::vector<uint8_t>& data) {
+    align(object, sections[section].alignment);
+    sections[section].offset = object.size();
+    object.insert(object.end(), data.begin(), data.end());
+  };
+
+  append_section_data(elf::Text, code.code);
+  append_section_data(elf::RelaText, rela_text);
+  append_section_data(elf::Symtab, symtab);
+  append_section_data(elf::Strtab, strtab);
+  append_section_data(elf::Shstrtab, shstrtab);
+  sections[elf::NoteGnuStack].offset = object.size();
+
+  align(object, 8);
+  const auto section_headers_offset = object.size();
+
+  for (const auto& section : sections) {
+    append<uint32_t>(object, section.name);
+    append<uint32_t>(object, section.type);
+    append<uint64_t>(object, section.flags);
+    append<uint64_t>(object, 0);
+    append<uint64_t>(object, section.offset);
+    append<uint64_t>(object, section.size);
+    append<uint32_t>(object, section.link);
+    append<uint32_t>(object, section.info);
+    append<uint64_t>(object, section.alignment);
+    append<uint64_t>(object, section.entry_size);
+  }
+
+  std::vector<uint8_t> header{0x7f, 'E', 'L', 'F', 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  append<uint16_t>(header, elf::et_rel);
+  append<uint16_t>(header, elf::em_x86_64);
+  append<uint32_t>(header, 1);
+  append<uint64_t>(header, 0);
+  append<uint64_t>(header, 0);
+  append<uint64_t>(header, section_headers_offset);
+  append<uint32_t>(header, 0);
+  append<uint16_t>(header, elf::header_size);
+  append<uint16_t>(header, 0);
+  append<uint16_t>(header, 0);
+  append<uint16_t>(header, elf::section_header_size);
+  append<uint16_t>(header, elf::Count);
+  append<uint16_t>(header, elf::Shstrtab);
+
+  verify(header.size() == elf::header_size, "Invalid ELF header size");
+  std::copy(header.begin(), header.end(), object.begin());
+
+  return object;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "X86CodeGenerator.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace flugzeug {
+
+/// Packs the generated code into an ELF64 relocatable object which can be passed to the system
+/// linker. Local functions are exported as global symbols and calls to extern functions are
+/// relocated against undefined symbols of the same name.
+std::vector<uint8_t> create_elf_object(const X86Code& code);
+
+}  // namespace flugzeug
@@ -0,0 +1,384 @@
+#include "X86Assembler.hpp"
+
+#include <Flugzeug/Core/Error.hpp>
+
+#include <limits>
+
+using namespace flugzeug;
+
+static uint8_t register_code(X86Register reg) {
+  return uint8_t(reg);
+}
+
+static bool fits_i8(int64_t value) {
+  return value >= std::numeric_limits<int8_t>::min() &&
+         value <= std::numeric_limits<int8_t>::max();
+}
+
+static bool fits_i32(int64_t value) {
+  return value >= std::numeric_limits<int32_t>::min() &&
+         value <= std::numeric_limits<int32_t>::max();
+}
+
+X86Condition flugzeug::invert_x86_condition(X86Condition condition) {
+  // Conditions come in pairs which differ only in the lowest bit.
+  return X86Condition(uint8_t(condition) ^ 1);
+}
+
+X86Operand X86Operand::reg(X86Register reg) {
+  X86Operand operand;
+  operand.register_ = reg;
+  return operand;
+}
+
+X86Operand X86Operand::memory(X86Register base, int32_t displacement) {
+  X86Operand operand;
+  operand.register_ = base;
+  operand.is_memory_ = true;
+  operand.displacement_ = displacement;
+  return operand;
+}
+
+X86Operand X86Operand::memory(X86Register base,
+                              X86Register index,
+                              uint8_t scale,
+                              int32_t displacement) {
+  verify(index != X86Register::Rsp, "RSP cannot be used as an index register");
+  verify(scale == 1 || scale == 2 || scale == 4 || scale == 8, "Invalid scale {}", scale);
+
+  X86Operand operand = memory(base, displacement);
+  operand.index_ = index;
+  operand.scale_ = scale;
+  operand.has_index_ = true;
+  return operand;
+}
+
+void X86Assembler::emit16(uint16_t value) {
+  for (size_t i = 0; i < 2; ++i) {
+    emit8(uint8_t(value >> (i * 8)));
+  }
+}
+
+void X86Assembler::emit32(uint32_t value) {
+  for (size_t i = 0; i < 4; ++i) {
+    emit8(uint8_t(value >> (i * 8)));
+  }
+}
+
+void X86Assembler::emit64(uint64_t value) {
+  for (size_t i = 0; i < 8; ++i) {
+    emit8(uint8_t(value >> (i * 8)));
+  }
+}
+
+void X86Assembler::emit_modrm_instruction(uint32_t size,
+                                          std::initializer_list<uint8_t> opcode,
+                                          uint8_t reg_field,
+                                          const X86Operand& rm,
+                                          bool byte_registers) {
+  verify(size == 8 || size == 16 || size == 32 || size == 64, "Invalid operand size {}", size);
+
+  if (size == 16) {
+    emit8(0x66);
+  }
+
+  uint8_t rex = 0;
+  if (size == 64) {
+    rex |= 0b1000;
+  }
+  if (reg_field & 0b1000) {
+    rex |= 0b0100;
+  }
+  if (rm.is_memory() && rm.has_index() && (register_code(rm.index()) & 0b1000)) {
+    rex |= 0b0010;
+  }
+  if (register_code(rm.reg()) & 0b1000) {
+    rex |= 0b0001;
+  }
+
+  // Without REX prefix, 8 bit register codes 4-7 select AH, CH, DH and BH instead of SPL, BPL,
+  // SIL and DIL.
+  const auto is_legacy_high_byte = [](uint8_t code) { return code >= 4 && code <= 7; };
+  const bool force_rex = byte_registers && (is_legacy_high_byte(reg_field) ||
+                                            (rm.is_register() &&
+                                             is_legacy_high_byte(register_code(rm.reg()))));
+
+  if (rex != 0 || force_rex) {
+    emit8(0x40 | rex);
+  }
+
+  for (const auto byte : opcode) {
+    emit8(byte);
+  }
+
+  const uint8_t reg_bits = (reg_field & 0b111) << 3;
+
+  if (rm.is_register()) {
+    emit8(0b11000000 | reg_bits | (register_code(rm.reg()) & 0b111));
+    return;
+  }
+
+  const auto base = uint8_t(register_code(rm.reg()) & 0b111);
+  const auto displacement = rm.displacement();
+
+  // RBP and R13 bases can't be encoded without displacement.
+  uint8_t mod;
+  if (displacement == 0 && base != 0b101) {
+    mod = 0b00;
+  } else if (fits_i8(displacement)) {
+    mod = 0b01;
+  } else {
+    mod = 0b10;
+  }
+
+  if (rm.has_index()) {
+    uint8_t scale_bits = 0;
+    switch (rm.scale()) {
+      // clang-format off
+      case 1: scale_bits = 0; break;
+      case 2: scale_bits = 1; break;
+      case 4: scale_bits = 2; break;
+      case 8: scale_bits = 3; break;
+      default: unreachable();
+        // clang-format on
+    }
+
+    emit8((mod << 6) | reg_bits | 0b100);
+    emit8((scale_bits << 6) | ((register_code(rm.index()) & 0b111) << 3) | base);
+  } else if (base == 0b100) {
+    // RSP and R12 bases require SIB byte.
+    emit8((mod << 6) | reg_bits | 0b100);
+    emit8(0b00100100);
+  } else {
+    emit8((mod << 6) | reg_bits | base);
+  }
+
+  if (mod == 0b01) {
+    emit8(uint8_t(int8_t(displacement)));
+  } else if (mod == 0b10) {
+    emit32(uint32_t(displacement));
+  }
+}
+
+void X86Assembler::emit_label_displacement(X86Label label) {
+  label_uses.push_back(LabelUse{offset(), label});
+  emit32(0);
+}
+
+X86Label X86Assembler::create_label() {
+  label_offsets.push_back(size_t(-1));
+  return X86Label(label_offsets.size() - 1);
+}
+
+void X86Assembler::bind_label(X86Label label) {
+  verify(!is_label_bound(label), "Label is already bound");
+  label_offsets[label] = offset();
+}
+
+bool X86Assembler::is_label_bound(X86Label label) const {
+  return label_offsets[label] != size_t(-1);
+}
+
+size_t X86Assembler::label_offset(X86Label label) const {
+  verify(is_label_bound(label), "Label is not bound");
+  return label_offsets[label];
+}
+
+std::vector<uint8_t> X86Assembler::finish() {
+  for (const auto& use : label_uses) {
+    const auto target = int64_t(label_offset(use.label));
+    const auto displacement = target - int64_t(use.offset + 4);
+    verify(fits_i32(displacement), "Label displacement doesn't fit in 32 bits");
+
+    for (size_t i = 0; i < 4; ++i) {
+      code_[use.offset + i] = uint8_t(uint32_t(displacement) >> (i * 8));
+    }
+  }
+
+  label_uses.clear();
+
+  return std::move(code_);
+}
+
+void X86Assembler::mov(uint32_t size, const X86Operand& destination, X86Register source) {
+  emit_modrm_instruction(size, {uint8_t(size == 8 ? 0x88 : 0x89)}, register_code(source),
+                         destination, size == 8);
+}
+
+void X86Assembler::mov(uint32_t size, X86Register destination, const X86Operand& source) {
+  emit_modrm_instruction(size, {uint8_t(size == 8 ? 0x8a : 0x8b)}, register_code(destination),
+                         source, size == 8);
+}
+
+void X86Assembler::mov(X86Register destination, uint64_t immediate) {
+  const auto code = register_code(destination);
+
+  if (immediate <= std::numeric_limits<uint32_t>::max()) {
+    // 32 bit moves zero extend the result.
+    if (code & 0b1000) {
+      emit8(0x41);
+    }
+    emit8(0xb8 + (code & 0b111));
+    emit32(uint32_t(immediate));
+  } else if (fits_i32(int64_t(immediate))) {
+    emit_modrm_instruction(64, {0xc7}, 0, X86Operand::reg(destination));
+    emit32(uint32_t(immediate));
+  } else {
+    emit8(0x48 | ((code & 0b1000) ? 1 : 0));
+    emit8(0xb8 + (code & 0b111));
+    emit64(immediate);
+  }
+}
+
+void X86Assembler::movzx(uint32_t source_size, X86Register destination, const X86Operand& source) {
+  verify(source_size == 8 || source_size == 16, "Invalid movzx source size {}", source_size);
+  emit_modrm_instruction(32, {0x0f, uint8_t(source_size == 8 ? 0xb6 : 0xb7)},
+                         register_code(destination), source, source_size == 8);
+}
+
+void X86Assembler::movsx(uint32_t size,
+                         uint32_t source_size,
+                         X86Register destination,
+                         const X86Operand& source) {
+  switch (source_size) {
+    case 8:
+      emit_modrm_instruction(size, {0x0f, 0xbe}, register_code(destination), source, true);
+      break;
+    case 16:
+      emit_modrm_instruction(size, {0x0f, 0xbf}, register_code(destination), source);
+      break;
+    case 32:
+      verify(size == 64, "movsxd must produce 64 bit value");
+      emit_modrm_instruction(size, {0x63}, register_code(destination), source);
+      break;
+    default:
+      fatal_error("Invalid movsx source size {}.", source_size);
+  }
+}
+
+void X86Assembler::lea(X86Register destination, const X86Operand& address) {
+  verify(address.is_memory(), "lea requires memory operand");
+  emit_modrm_instruction(64, {0x8d}, register_code(destination), address);
+}
+
+void X86Assembler::alu(X86AluOp op, uint32_t size, X86Register destination,
+                       const X86Operand& source) {
+  verify(size == 32 || size == 64, "Unsupported ALU operand size {}", size);
+  emit_modrm_instruction(size, {uint8_t(uint8_t(op) * 8 + 3)}, register_code(destination), source);
+}
+
+void X86Assembler::alu(X86AluOp op, uint32_t size, const X86Operand& destination,
+                       int32_t immediate) {
+  verify(size == 32 || size == 64, "Unsupported ALU operand size {}", size);
+
+  if (fits_i8(immediate)) {
+    emit_modrm_instruction(size, {0x83}, uint8_t(op), destination);
+    emit8(uint8_t(int8_t(immediate)));
+  } else {
+    emit_modrm_instruction(size, {0x81}, uint8_t(op), destination);
+    emit32(uint32_t(immediate));
+  }
+}
+
+void X86Assembler::test(uint32_t size, X86Register a, X86Register b) {
+  emit_modrm_instruction(size, {uint8_t(size == 8 ? 0x84 : 0x85)}, register_code(b),
+                         X86Operand::reg(a), size == 8);
+}
+
+void X86Assembler::imul(uint32_t size, X86Register destination, const X86Operand& source) {
+  emit_modrm_instruction(size, {0x0f, 0xaf}, register_code(destination), source);
+}
+
+void X86Assembler::imul(uint32_t size,
+                        X86Register destination,
+                        const X86Operand& source,
+                        int32_t immediate) {
+  if (fits_i8(immediate)) {
+    emit_modrm_instruction(size, {0x6b}, register_code(destination), source);
+    emit8(uint8_t(int8_t(immediate)));
+  } else {
+    emit_modrm_instruction(size, {0x69}, register_code(destination), source);
+    emit32(uint32_t(immediate));
+  }
+}
+
+void X86Assembler::unary(X86UnaryOp op, uint32_t size, const X86Operand& operand) {
+  emit_modrm_instruction(size, {uint8_t(size == 8 ? 0xf6 : 0xf7)}, uint8_t(op), operand, size == 8);
+}
+
+void X86Assembler::shift(X86ShiftOp op, uint32_t size, X86Register destination) {
+  emit_modrm_instruction(size, {uint8_t(size == 8 ? 0xd2 : 0xd3)}, uint8_t(op),
+                         X86Operand::reg(destination), size == 8);
+}
+
+void X86Assembler::sign_extend_rax(uint32_t size) {
+  verify(size == 32 || size == 64, "Invalid sign extension size {}", size);
+  if (size == 64) {
+    emit8(0x48);
+  }
+  emit8(0x99);
+}
+
+void X86Assembler::setcc(X86Condition condition, X86Register destination) {
+  emit_modrm_instruction(8, {0x0f, uint8_t(0x90 + uint8_t(condition))}, 0,
+                         X86Operand::reg(destination), true);
+}
+
+void X86Assembler::cmov(X86Condition condition,
+                        uint32_t size,
+                        X86Register destination,
+                        const X86Operand& source) {
+  verify(size == 32 || size == 64, "Unsupported cmov operand size {}", size);
+  emit_modrm_instruction(size, {0x0f, uint8_t(0x40 + uint8_t(condition))},
+                         register_code(destination), source);
+}
+
+void X86Assembler::push(X86Register reg) {
+  const auto code = register_code(reg);
+  if (code & 0b1000) {
+    emit8(0x41);
+  }
+  emit8(0x50 + (code & 0b111));
+}
+
+void X86Assembler::pop(X86Register reg) {
+  const auto code = register_code(reg);
+  if (code & 0b1000) {
+    emit8(0x41);
+  }
+  emit8(0x58 + (code & 0b111));
+}
+
+void X86Assembler::jmp(X86Label label) {
+  emit8(0xe9);
+  emit_label_displacement(label);
+}
+
+void X86Assembler::jmp(X86Register target) {
+  // Near indirect jumps always use 64 bit operand.
+  emit_modrm_instruction(32, {0xff}, 4, X86Operand::reg(target));
+}
+
+void X86Assembler::jcc(X86Condition condition, X86Label label) {
+  emit8(0x0f);
+  emit8(0x80 + uint8_t(condition));
+  emit_label_displacement(label);
+}
+
+void X86Assembler::call(X86Label label) {
+  emit8(0xe8);
+  emit_label_displacement(label);
+}
+
+size_t X86Assembler::call_external() {
+  emit8(0xe8);
+
+  const auto displacement_offset = offset();
+  emit32(0);
+
+  return displacement_offset;
+}
+
+void X86Assembler::ret() {
+  emit8(0xc3);
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace flugzeug {
+
+enum class X86Register : uint8_t {
+  Rax,
+  Rcx,
+  Rdx,
+  Rbx,
+  Rsp,
+  Rbp,
+  Rsi,
+  Rdi,
+  R8,
+  R9,
+  R10,
+  R11,
+  R12,
+  R13,
+  R14,
+  R15,
+};
+
+/// Values match the condition encoding of Jcc, SETcc and CMOVcc instructions.
+enum class X86Condition : uint8_t {
+  Below = 0x2,
+  AboveOrEqual = 0x3,
+  Equal = 0x4,
+  NotEqual = 0x5,
+  BelowOrEqual = 0x6,
+  Above = 0x7,
+  Less = 0xc,
+  GreaterOrEqual = 0xd,
+  LessOrEqual = 0xe,
+  Greater = 0xf,
+};
+
+/// Values match the `/digit` opcode extension of group 1 instructions.
+enum class X86AluOp : uint8_t {
+  Add = 0,
+  Or = 1,
+  And = 4,
+  Sub = 5,
+  Xor = 6,
+  Cmp = 7,
+};
+
+/// Values match the `/digit` opcode extension of group 3 instructions (operand is r/m).
+enum class X86UnaryOp : uint8_t {
+  Not = 2,
+  Neg = 3,
+  Div = 6,
+  Idiv = 7,
+};
+
+/// Values match the `/digit` opcode extension of group 2 instructions (shift count is in CL).
+enum class X86ShiftOp : uint8_t {
+  Shl = 4,
+  Shr = 5,
+  Sar = 7,
+};
+
+X86Condition invert_x86_condition(X86Condition condition);
+
+/// Register or memory operand `[base + index * scale + displacement]`.
+class X86Operand {
+  X86Register register_ = X86Register::Rax;
+  X86Register index_ = X86Register::Rsp;
+  uint8_t scale_ = 1;
+  bool is_memory_ = false;
+  bool has_index_ = false;
+  int32_t displacement_ = 0;
+
+ public:
+  static X86Operand reg(X86Register reg);
+  static X86Operand memory(X86Register base, int32_t displacement = 0);
+  static X86Operand memory(X86Register base,
+                           X86Register index,
+                           uint8_t scale,
+                           int32_t displacement = 0);
+
+  bool is_memory() const { return is_memory_; }
+  bool is_register() const { return !is_memory_; }
+  bool has_index() const { return has_index_; }
+
+  /// Register of a register operand or base register of a memory operand.
+  X86Register reg() const { return register_; }
+  X86Register index() const { return index_; }
+  uint8_t scale() const { return scale_; }
+  int32_t displacement() const { return displacement_; }
+
+  bool operator==(const X86Operand& other) const = default;
+};
+
+/// Index of a label created by `X86Assembler::create_label`.
+using X86Label = uint32_t;
+
+/// Encodes x86-64 instructions into a single code buffer. Operand sizes are given in bits
+/// (8, 16, 32 or 64). Jumps and calls always use 32 bit displacements.
+class X86Assembler {
+  struct LabelUse {
+    size_t offset;
+    X86Label label;
+  };
+
+  std::vector<uint8_t> code_;
+  std::vector<size_t> label_offsets;
+  std::vector<LabelUse> label_uses;
+
+  void emit8(uint8_t value) { code_.push_back(value); }
+  void emit16(uint16_t value);
+  void emit32(uint32_t value);
+  void emit64(uint64_t value);
+
+  /// Emits prefixes, `opcode` and ModRM (with SIB and displacement if needed). `byte_registers`
+  /// means that registers of the ModRM byte are accessed as 8 bit registers.
+  void emit_modrm_instruction(uint32_t size,
+                              std::initializer_list<uint8_t> opcode,
+                              uint8_t reg_field,
+                              const X86Operand& rm,
+                              bool byte_registers = false);
+
+  void emit_label_displacement(X86Label label);
+
+ public:
+  size_t offset() const { return code_.size(); }
+
+  X86Label create_label();
+  void bind_label(X86Label label);
+  bool is_label_bound(X86Label label) const;
+  size_t label_offset(X86Label label) const;
+
+  /// Resolves all label references and returns the machine code. All used labels must be bound.
+  std::vector<uint8_t> finish();
+
+  void mov(uint32_t size, const X86Operand& destination, X86Register source);
+  void mov(uint32_t size, X86Register destination, const X86Operand& source);
+  void mov(X86Register destination, uint64_t immediate);
+
+  /// Zero extends 8 or 16 bit `source` to 64 bits.
+  void movzx(uint32_t source_size, X86Register destination, const X86Operand& source);
+
+  /// Sign extends 8, 16 or 32 bit `source` to `size` bits.
+  void movsx(uint32_t size, uint32_t source_size, X86Register destination,
+             const X86Operand& source);
+
+  void lea(X86Register destination, const X86Operand& address);
+
+  /// Only 32 and 64 bit sizes are supported by ALU instructions.
+  void alu(X86AluOp op, uint32_t size, X86Register destination, const X86Operand& source);
+  void alu(X86AluOp op, uint32_t size, const X86Operand& destination, int32_t immediate);
+  void test(uint32_t size, X86Register a, X86Register b);
+  void imul(uint32_t size, X86Register destination, const X86Operand& source);
+  void imul(uint32_t size, X86Register destination, const X86Operand& source, int32_t immediate);
+  void unary(X86UnaryOp op, uint32_t size, const X86Operand& operand);
+  void shift(X86ShiftOp op, uint32_t size, X86Register destination);
+
+  /// Sign extends RAX (EAX) into RDX:RAX (EDX:EAX) before signed division (CQO or CDQ).
+  void sign_extend_rax(uint32_t size);
+
+  void setcc(X86Condition condition, X86Register destination);
+  void cmov(X86Condition condition, uint32_t size, X86Register destination,
+            const X86Operand& source);
+
+  void push(X86Register reg);
+  void pop(X86Register reg);
+
+  void jmp(X86Label label);
+  void jmp(X86Register target);
+  void jcc(X86Condition condition, X86Label label);
+  void call(X86Label label);
+
+  /// Emits `call` with zero displacement and returns the offset of the displacement field which
+  /// must be relocated by the caller.
+  size_t call_external();
+
+  void ret();
+};
+
+}  // namespace flugzeug
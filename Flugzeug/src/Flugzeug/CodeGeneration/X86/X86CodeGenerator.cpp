@@ -0,0 +1,817 @@
+#include "X86CodeGenerator.hpp"
+#include "X86Assembler.hpp"
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionVisitor.hpp>
+#include <Flugzeug/IR/Module.hpp>
+
+#include <Flugzeug/CodeGeneration/RegAlloc/RegisterAllocation.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <span>
+#include <unordered_map>
+
+using namespace flugzeug;
+
+using Reg = X86Register;
+using Operand = X86Operand;
+
+constexpr Reg argument_registers[] = {Reg::Rdi, Reg::Rsi, Reg::Rdx, Reg::Rcx, Reg::R8, Reg::R9};
+
+/// Values of functions which make calls can be kept only in registers preserved across calls.
+constexpr Reg callee_saved_registers[] = {Reg::Rbx, Reg::R12, Reg::R13, Reg::R14, Reg::R15};
+
+/// Leaf functions can use caller saved registers too. RAX, RCX and RDX are never allocated as
+/// they are scratch registers of instruction selection (division and shifts need them anyway).
+constexpr Reg leaf_registers[] = {Reg::Rsi, Reg::Rdi, Reg::R8,  Reg::R9,  Reg::R10, Reg::R11,
+                                  Reg::Rbx, Reg::R12, Reg::R13, Reg::R14, Reg::R15};
+
+/// i1 values are stored in memory as a single byte.
+static size_t memory_size(const Type* type) {
+  return type->is_i1() ? 1 : type->byte_size();
+}
+
+static uint32_t memory_bit_size(const Type* type) {
+  return uint32_t(memory_size(type) * 8);
+}
+
+/// Values up to 32 bits are processed by 32 bit instructions which zero extend their results.
+static uint32_t operation_size(const Type* type) {
+  return type->bit_size() <= 32 ? 32 : 64;
+}
+
+static bool is_callee_saved(Reg reg) {
+  return std::find(std::begin(callee_saved_registers), std::end(callee_saved_registers), reg) !=
+         std::end(callee_saved_registers);
+}
+
+static int32_t to_i32(int64_t value) {
+  verify(value >= std::numeric_limits<int32_t>::min() &&
+           value <= std::numeric_limits<int32_t>::max(),
+         "Value doesn't fit in 32 bits");
+  return int32_t(value);
+}
+
+/// Registers available to the register allocator. Incoming arguments of leaf functions occupy
+/// some of them until they are moved to their homes.
+static std::vector<Reg> allocatable_registers(const Function* function) {
+  bool is_leaf = true;
+  for (const Block& block : *function) {
+    for (const Instruction& instruction : block) {
+      if (cast<Call>(instruction)) {
+        is_leaf = false;
+      }
+    }
+  }
+
+  if (!is_leaf) {
+    return std::vector<Reg>(std::begin(callee_saved_registers), std::end(callee_saved_registers));
+  }
+
+  const auto incoming_count = std::min(function->parameter_count(), std::size(argument_registers));
+  const auto incoming = std::span(argument_registers).first(incoming_count);
+
+  std::vector<Reg> registers;
+  for (const auto reg : leaf_registers) {
+    if (std::find(incoming.begin(), incoming.end(), reg) == incoming.end()) {
+      registers.push_back(reg);
+    }
+  }
+
+  return registers;
+}
+
+class X86FunctionLowering : public ConstInstructionVisitor {
+  X86Assembler& assembler;
+  const AllocatedRegisters& registers;
+  const std::unordered_map<const Function*, X86Label>& function_labels;
+  const std::unordered_map<const Function*, uint32_t>& extern_indices;
+  std::vector<X86ExternCall>& extern_calls;
+
+  const Function* function;
+
+  /// Homes of allocated registers followed by homes of spill slots and parameters.
+  std::vector<Operand> homes;
+  std::vector<Reg> saved_registers;
+
+  std::unordered_map<const StackAlloc*, int32_t> stackalloc_offsets;
+
+  int32_t frame_size = 0;
+
+  std::vector<X86Label> block_labels;
+
+  /// Block that is emitted right after the current one, branches to it fall through.
+  const Block* next_block = nullptr;
+
+  /// Compare whose result is consumed directly from flags by the following `CondBranch`.
+  const IntCompare* fused_compare = nullptr;
+  X86Condition fused_condition = X86Condition::NotEqual;
+
+  size_t home_index(const Value* value) const {
+    if (const auto parameter = cast<Parameter>(value)) {
+      for (size_t i = 0; i < function->parameter_count(); ++i) {
+        if (function->parameter(i) == parameter) {
+          return registers.register_count() + registers.spill_slot_count() + i;
+        }
+      }
+
+      unreachable();
+    }
+
+    const auto instruction = cast<Instruction>(value);
+    verify(instruction, "Unexpected x86 operand");
+
+    if (registers.is_spilled(instruction)) {
+      return registers.register_count() + registers.spill_slot_for_instruction(instruction);
+    }
+
+    return registers.register_for_instruction(instruction);
+  }
+
+  const Operand& home(const Value* value) const { return homes[home_index(value)]; }
+
+  bool has_home(const Value* value) const {
+    if (cast<Parameter>(value)) {
+      return true;
+    }
+
+    const auto instruction = cast<Instruction>(value);
+    return instruction &&
+           (registers.has_register(instruction) || registers.is_spilled(instruction));
+  }
+
+  void load(Reg destination, const Value* value) {
+    switch (value->kind()) {
+      case Value::Kind::Constant:
+        assembler.mov(destination, cast<Constant>(value)->value_u());
+        break;
+      case Value::Kind::Undef:
+        assembler.mov(destination, 0);
+        break;
+      default: {
+        const auto& source = home(value);
+        if (source != Operand::reg(destination)) {
+          assembler.mov(64, destination, source);
+        }
+        break;
+      }
+    }
+  }
+
+  /// Returns the home register of the value or loads the value to `scratch`. The returned
+  /// register must not be modified.
+  Reg load_to_register(const Value* value, Reg scratch) {
+    if (has_home(value) && home(value).is_register()) {
+      return home(value).reg();
+    }
+
+    load(scratch, value);
+    return scratch;
+  }
+
+  /// Returns operand which can be used as r/m operand of an instruction without modifying it.
+  Operand operand(const Value* value, Reg scratch) {
+    if (has_home(value)) {
+      return home(value);
+    }
+
+    load(scratch, value);
+    return Operand::reg(scratch);
+  }
+
+  std::optional<int32_t> immediate(const Value* value, uint32_t size) const {
+    const auto constant = cast<Constant>(value);
+    if (!constant) {
+      return std::nullopt;
+    }
+
+    const auto value_u = constant->value_u();
+    if (size == 32) {
+      return int32_t(uint32_t(value_u));
+    }
+
+    const auto value_i = int64_t(value_u);
+    if (value_i >= std::numeric_limits<int32_t>::min() &&
+        value_i <= std::numeric_limits<int32_t>::max()) {
+      return int32_t(value_i);
+    }
+
+    return std::nullopt;
+  }
+
+  void store(const Instruction* instruction, Reg source) {
+    if (!has_home(instruction)) {
+      return;
+    }
+
+    const auto& destination = home(instruction);
+    if (destination != Operand::reg(source)) {
+      assembler.mov(64, destination, source);
+    }
+  }
+
+  void move(const Instruction* instruction, const Value* value) {
+    if (!has_home(instruction)) {
+      return;
+    }
+
+    const auto& destination = home(instruction);
+    if (destination.is_register()) {
+      load(destination.reg(), value);
+    } else {
+      store(instruction, load_to_register(value, Reg::Rax));
+    }
+  }
+
+  /// Zero extends the lowest `type` bits of the register.
+  void truncate(Reg reg, const Type* type) {
+    switch (type->bit_size()) {
+      // clang-format off
+      case 1:  assembler.alu(X86AluOp::And, 32, Operand::reg(reg), 1); break;
+      case 8:  assembler.movzx(8, reg, Operand::reg(reg)); break;
+      case 16: assembler.movzx(16, reg, Operand::reg(reg)); break;
+      case 32: assembler.mov(32, reg, Operand::reg(reg)); break;
+      case 64: break;
+      default: unreachable();
+        // clang-format on
+    }
+  }
+
+  /// Truncates result of a 32 bit operation.
+  void truncate_small(Reg reg, const Type* type) {
+    if (type->bit_size() < 32) {
+      truncate(reg, type);
+    }
+  }
+
+  /// Sign extends the lowest `bit_size` bits of the register to `size` bits.
+  void sign_extend(Reg reg, size_t bit_size, uint32_t size) {
+    switch (bit_size) {
+      // clang-format off
+      case 1:  assembler.unary(X86UnaryOp::Neg, size, Operand::reg(reg)); break;
+      case 8:  assembler.movsx(size, 8, reg, Operand::reg(reg)); break;
+      case 16: assembler.movsx(size, 16, reg, Operand::reg(reg)); break;
+      case 32: if (size == 64) { assembler.movsx(64, 32, reg, Operand::reg(reg)); } break;
+      case 64: break;
+      default: unreachable();
+        // clang-format on
+    }
+  }
+
+  void test_condition(const Value* condition) {
+    const auto condition_operand = operand(condition, Reg::Rdx);
+    if (condition_operand.is_register()) {
+      assembler.test(32, condition_operand.reg(), condition_operand.reg());
+    } else {
+      assembler.alu(X86AluOp::Cmp, 32, condition_operand, 0);
+    }
+  }
+
+  void jump_to(const Block* block) {
+    if (block != next_block) {
+      assembler.jmp(block_labels[block->dense_index()]);
+    }
+  }
+
+  void assign_homes(std::span<const Reg> allocatable) {
+    const auto register_count = registers.register_count();
+    const auto parameters_start = register_count + registers.spill_slot_count();
+
+    homes.resize(parameters_start + function->parameter_count());
+
+    for (uint32_t index = 0; index < register_count; ++index) {
+      const auto reg = allocatable[index];
+      homes[index] = Operand::reg(reg);
+
+      if (is_callee_saved(reg)) {
+        saved_registers.push_back(reg);
+      }
+    }
+
+    // Frame layout (growing down from RBP): saved registers, spill slots, StackAllocs and
+    // outgoing call arguments at RSP.
+    int64_t frame_end = int64_t(saved_registers.size() * 8);
+
+    for (size_t index = register_count; index < homes.size(); ++index) {
+      const auto parameter = index >= parameters_start ? index - parameters_start : size_t(-1);
+      if (parameter != size_t(-1) && parameter >= std::size(argument_registers)) {
+        // Stack arguments stay where the caller put them (above the return address).
+        homes[index] =
+          Operand::memory(Reg::Rbp, to_i32(16 + 8 * (parameter - std::size(argument_registers))));
+        continue;
+      }
+
+      frame_end += 8;
+      homes[index] = Operand::memory(Reg::Rbp, to_i32(-frame_end));
+    }
+
+    size_t outgoing_arguments = 0;
+
+    for (const Block& block : *function) {
+      for (const Instruction& instruction : block) {
+        if (const auto stackalloc = cast<StackAlloc>(instruction)) {
+          const auto size = memory_size(stackalloc->allocated_type()) * stackalloc->size();
+          frame_end = (frame_end + int64_t(size) + 7) & ~int64_t(7);
+          stackalloc_offsets.insert({stackalloc, to_i32(-frame_end)});
+        } else if (const auto call = cast<Call>(instruction)) {
+          outgoing_arguments = std::max(outgoing_arguments, call->argument_count());
+        }
+      }
+    }
+
+    if (outgoing_arguments > std::size(argument_registers)) {
+      frame_end += int64_t(8 * (outgoing_arguments - std::size(argument_registers)));
+    }
+
+    // RSP must be 16 byte aligned at calls. Return address and saved RBP keep the alignment.
+    frame_end = (frame_end + 15) & ~int64_t(15);
+    frame_size = to_i32(frame_end - int64_t(saved_registers.size() * 8));
+  }
+
+  void emit_prologue() {
+    assembler.push(Reg::Rbp);
+    assembler.mov(64, Operand::reg(Reg::Rbp), Reg::Rsp);
+
+    for (const auto reg : saved_registers) {
+      assembler.push(reg);
+    }
+
+    if (frame_size > 0) {
+      assembler.alu(X86AluOp::Sub, 64, Operand::reg(Reg::Rsp), frame_size);
+    }
+
+    // Callers outside of the module don't have to zero extend arguments.
+    const auto register_parameters =
+      std::min(function->parameter_count(), std::size(argument_registers));
+
+    for (size_t i = 0; i < register_parameters; ++i) {
+      const auto parameter = function->parameter(i);
+      const auto reg = argument_registers[i];
+
+      truncate(reg, parameter->type());
+      assembler.mov(64, home(parameter), reg);
+    }
+  }
+
+  void emit_epilogue() {
+    if (saved_registers.empty()) {
+      assembler.mov(64, Operand::reg(Reg::Rsp), Reg::Rbp);
+    } else {
+      assembler.lea(Reg::Rsp,
+                    Operand::memory(Reg::Rbp, -to_i32(int64_t(saved_registers.size() * 8))));
+    }
+
+    for (auto it = saved_registers.rbegin(); it != saved_registers.rend(); ++it) {
+      assembler.pop(*it);
+    }
+
+    assembler.pop(Reg::Rbp);
+    assembler.ret();
+  }
+
+ public:
+  X86FunctionLowering(Function* function,
+                      X86Assembler& assembler,
+                      const AllocatedRegisters& registers,
+                      std::span<const Reg> allocatable,
+                      const std::unordered_map<const Function*, X86Label>& function_labels,
+                      const std::unordered_map<const Function*, uint32_t>& extern_indices,
+                      std::vector<X86ExternCall>& extern_calls)
+      : assembler(assembler),
+        registers(registers),
+        function_labels(function_labels),
+        extern_indices(extern_indices),
+        extern_calls(extern_calls),
+        function(function) {
+    assign_homes(allocatable);
+  }
+
+  void lower() {
+    assembler.bind_label(function_labels.at(function));
+
+    emit_prologue();
+
+    block_labels.resize(function->block_index_capacity());
+    for (const Block& block : *function) {
+      block_labels[block.dense_index()] = assembler.create_label();
+    }
+
+    for (const Block& block : *function) {
+      assembler.bind_label(block_labels[block.dense_index()]);
+      next_block = block.next();
+
+      for (const Instruction& instruction : block) {
+        visitor::visit_instruction(&instruction, *this);
+      }
+    }
+  }
+
+  void visit_unary_instr(Argument<UnaryInstr> unary) {
+    const auto type = unary->type();
+
+    load(Reg::Rax, unary->value());
+    assembler.unary(unary->op() == UnaryOp::Neg ? X86UnaryOp::Neg : X86UnaryOp::Not,
+                    operation_size(type), Operand::reg(Reg::Rax));
+    truncate_small(Reg::Rax, type);
+
+    store(unary, Reg::Rax);
+  }
+
+  void visit_binary_instr(Argument<BinaryInstr> binary) {
+    const auto type = binary->type();
+    const auto size = operation_size(type);
+    const auto lhs = binary->lhs();
+    const auto rhs = binary->rhs();
+
+    // Register allocation copies Phi incoming values using `add x, 0`.
+    if (binary->op() == BinaryOp::Add && rhs->is_zero()) {
+      move(binary, lhs);
+      return;
+    }
+
+    // Signed division and arithmetic shift on i1 are evaluated on i8 (like in the interpreter).
+    const auto signed_bit_size = type->is_i1() ? 8 : type->bit_size();
+
+    auto result = Reg::Rax;
+
+    switch (binary->op()) {
+      case BinaryOp::Add:
+      case BinaryOp::Sub:
+      case BinaryOp::And:
+      case BinaryOp::Or:
+      case BinaryOp::Xor: {
+        X86AluOp op;
+        switch (binary->op()) {
+          // clang-format off
+          case BinaryOp::Add: op = X86AluOp::Add; break;
+          case BinaryOp::Sub: op = X86AluOp::Sub; break;
+          case BinaryOp::And: op = X86AluOp::And; break;
+          case BinaryOp::Or:  op = X86AluOp::Or; break;
+          case BinaryOp::Xor: op = X86AluOp::Xor; break;
+          default: unreachable();
+            // clang-format on
+        }
+
+        load(Reg::Rax, lhs);
+        if (const auto rhs_immediate = immediate(rhs, size)) {
+          assembler.alu(op, size, Operand::reg(Reg::Rax), *rhs_immediate);
+        } else {
+          assembler.alu(op, size, Reg::Rax, operand(rhs, Reg::Rcx));
+        }
+        truncate_small(Reg::Rax, type);
+        break;
+      }
+
+      case BinaryOp::Mul: {
+        if (const auto rhs_immediate = immediate(rhs, size)) {
+          assembler.imul(size, Reg::Rax, operand(lhs, Reg::Rax), *rhs_immediate);
+        } else {
+          load(Reg::Rax, lhs);
+          assembler.imul(size, Reg::Rax, operand(rhs, Reg::Rcx));
+        }
+        truncate_small(Reg::Rax, type);
+        break;
+      }
+
+      case BinaryOp::DivU:
+      case BinaryOp::ModU: {
+        load(Reg::Rax, lhs);
+        load(Reg::Rcx, rhs);
+        assembler.alu(X86AluOp::Xor, 32, Reg::Rdx, Operand::reg(Reg::Rdx));
+        assembler.unary(X86UnaryOp::Div, size, Operand::reg(Reg::Rcx));
+
+        result = binary->op() == BinaryOp::DivU ? Reg::Rax : Reg::Rdx;
+        break;
+      }
+
+      case BinaryOp::DivS:
+      case BinaryOp::ModS: {
+        load(Reg::Rax, lhs);
+        load(Reg::Rcx, rhs);
+        if (signed_bit_size < 32) {
+          sign_extend(Reg::Rax, signed_bit_size, 32);
+          sign_extend(Reg::Rcx, signed_bit_size, 32);
+        }
+        assembler.sign_extend_rax(size);
+        assembler.unary(X86UnaryOp::Idiv, size, Operand::reg(Reg::Rcx));
+
+        result = binary->op() == BinaryOp::DivS ? Reg::Rax : Reg::Rdx;
+        truncate_small(result, type);
+        break;
+      }
+
+      case BinaryOp::Shl:
+      case BinaryOp::Shr:
+      case BinaryOp::Sar: {
+        load(Reg::Rax, lhs);
+        load(Reg::Rcx, rhs);
+
+        X86ShiftOp op;
+        switch (binary->op()) {
+          // clang-format off
+          case BinaryOp::Shl: op = X86ShiftOp::Shl; break;
+          case BinaryOp::Shr: op = X86ShiftOp::Shr; break;
+          case BinaryOp::Sar: op = X86ShiftOp::Sar; break;
+          default: unreachable();
+            // clang-format on
+        }
+
+        if (op == X86ShiftOp::Sar && signed_bit_size < 32) {
+          sign_extend(Reg::Rax, signed_bit_size, 32);
+        }
+        assembler.shift(op, size, Reg::Rax);
+        truncate_small(Reg::Rax, type);
+        break;
+      }
+
+      default:
+        unreachable();
+    }
+
+    store(binary, result);
+  }
+
+  void visit_int_compare(Argument<IntCompare> int_compare) {
+    const auto type = int_compare->lhs()->type();
+    const auto size = operation_size(type);
+    const auto lhs = int_compare->lhs();
+    const auto rhs = int_compare->rhs();
+
+    auto predicate = int_compare->predicate();
+
+    // Signed i1 values are 0 and -1, so their signed order is reverse of the unsigned one.
+    if (type->is_i1()) {
+      switch (predicate) {
+        // clang-format off
+        case IntPredicate::GtS:  predicate = IntPredicate::LtU; break;
+        case IntPredicate::GteS: predicate = IntPredicate::LteU; break;
+        case IntPredicate::LtS:  predicate = IntPredicate::GtU; break;
+        case IntPredicate::LteS: predicate = IntPredicate::GteU; break;
+        default: break;
+          // clang-format on
+      }
+    }
+
+    X86Condition condition;
+
+    switch (predicate) {
+      // clang-format off
+      case IntPredicate::Equal:    condition = X86Condition::Equal; break;
+      case IntPredicate::NotEqual: condition = X86Condition::NotEqual; break;
+      case IntPredicate::GtU:      condition = X86Condition::Above; break;
+      case IntPredicate::GteU:     condition = X86Condition::AboveOrEqual; break;
+      case IntPredicate::LtU:      condition = X86Condition::Below; break;
+      case IntPredicate::LteU:     condition = X86Condition::BelowOrEqual; break;
+      case IntPredicate::GtS:      condition = X86Condition::Greater; break;
+      case IntPredicate::GteS:     condition = X86Condition::GreaterOrEqual; break;
+      case IntPredicate::LtS:      condition = X86Condition::Less; break;
+      case IntPredicate::LteS:     condition = X86Condition::LessOrEqual; break;
+      default: unreachable();
+        // clang-format on
+    }
+
+    const bool is_signed = predicate == IntPredicate::GtS || predicate == IntPredicate::GteS ||
+                           predicate == IntPredicate::LtS || predicate == IntPredicate::LteS;
+
+    if (is_signed && type->bit_size() < 32) {
+      load(Reg::Rax, lhs);
+      load(Reg::Rcx, rhs);
+      sign_extend(Reg::Rax, type->bit_size(), 32);
+      sign_extend(Reg::Rcx, type->bit_size(), 32);
+      assembler.alu(X86AluOp::Cmp, 32, Reg::Rax, Operand::reg(Reg::Rcx));
+    } else {
+      const auto lhs_register = load_to_register(lhs, Reg::Rax);
+      if (const auto rhs_immediate = immediate(rhs, size)) {
+        assembler.alu(X86AluOp::Cmp, size, Operand::reg(lhs_register), *rhs_immediate);
+      } else {
+        assembler.alu(X86AluOp::Cmp, size, lhs_register, operand(rhs, Reg::Rcx));
+      }
+    }
+
+    // Compare which is used only by the directly following branch doesn't need to materialize
+    // its result.
+    const auto cond_branch = cast<CondBranch>(int_compare->next());
+    if (cond_branch && cond_branch->condition() == int_compare && int_compare->user_count() == 1) {
+      fused_compare = int_compare;
+      fused_condition = condition;
+      return;
+    }
+
+    assembler.setcc(condition, Reg::Rax);
+    assembler.movzx(8, Reg::Rax, Operand::reg(Reg::Rax));
+
+    store(int_compare, Reg::Rax);
+  }
+
+  void visit_load(Argument<Load> load) {
+    const auto address = Operand::memory(load_to_register(load->address(), Reg::Rcx));
+
+    switch (memory_bit_size(load->type())) {
+      // clang-format off
+      case 8:  assembler.movzx(8, Reg::Rax, address); break;
+      case 16: assembler.movzx(16, Reg::Rax, address); break;
+      case 32: assembler.mov(32, Reg::Rax, address); break;
+      case 64: assembler.mov(64, Reg::Rax, address); break;
+      default: unreachable();
+        // clang-format on
+    }
+
+    store(load, Reg::Rax);
+  }
+
+  void visit_store(Argument<Store> store) {
+    const auto value = load_to_register(store->value(), Reg::Rax);
+    const auto address = Operand::memory(load_to_register(store->address(), Reg::Rcx));
+
+    assembler.mov(memory_bit_size(store->value()->type()), address, value);
+  }
+
+  void visit_call(Argument<Call> call) {
+    const auto callee = call->callee();
+
+    for (size_t i = std::size(argument_registers); i < call->argument_count(); ++i) {
+      load(Reg::Rax, call->argument(i));
+      assembler.mov(64, Operand::memory(Reg::Rsp, to_i32(8 * (i - std::size(argument_registers)))),
+                    Reg::Rax);
+    }
+
+    // Values of functions which make calls are never kept in argument registers.
+    for (size_t i = 0; i < std::min(call->argument_count(), std::size(argument_registers)); ++i) {
+      load(argument_registers[i], call->argument(i));
+    }
+
+    if (callee->is_extern()) {
+      const auto offset = assembler.call_external();
+      extern_calls.push_back(X86ExternCall{offset, extern_indices.at(callee)});
+
+      // Extern functions don't have to zero extend their return values.
+      if (!call->is_void()) {
+        truncate(Reg::Rax, call->type());
+      }
+    } else {
+      assembler.call(function_labels.at(callee));
+    }
+
+    if (!call->is_void()) {
+      store(call, Reg::Rax);
+    }
+  }
+
+  void visit_branch(Argument<Branch> branch) { jump_to(branch->target()); }
+
+  void visit_cond_branch(Argument<CondBranch> cond_branch) {
+    const auto true_target = cond_branch->true_target();
+    const auto false_target = cond_branch->false_target();
+
+    X86Condition condition = X86Condition::NotEqual;
+    if (fused_compare && cond_branch->condition() == fused_compare) {
+      condition = fused_condition;
+      fused_compare = nullptr;
+    } else if (true_target != false_target) {
+      test_condition(cond_branch->condition());
+    }
+
+    if (true_target == false_target) {
+      jump_to(true_target);
+      return;
+    }
+
+    if (true_target == next_block) {
+      assembler.jcc(invert_x86_condition(condition), block_labels[false_target->dense_index()]);
+      return;
+    }
+
+    assembler.jcc(condition, block_labels[true_target->dense_index()]);
+    jump_to(false_target);
+  }
+
+  void visit_stackalloc(Argument<StackAlloc> stackalloc) {
+    assembler.lea(Reg::Rax, Operand::memory(Reg::Rbp, stackalloc_offsets.at(stackalloc)));
+    store(stackalloc, Reg::Rax);
+  }
+
+  void visit_ret(Argument<Ret> ret) {
+    if (ret->returns_void()) {
+      assembler.mov(Reg::Rax, 0);
+    } else {
+      load(Reg::Rax, ret->return_value());
+    }
+
+    emit_epilogue();
+  }
+
+  void visit_offset(Argument<Offset> offset) {
+    const auto element_size = memory_size(cast<PointerType>(offset->type())->deref());
+    const auto index = offset->index();
+
+    load(Reg::Rax, offset->base());
+
+    if (const auto constant = cast<Constant>(index)) {
+      const auto displacement = int64_t(uint64_t(constant->value_i()) * element_size);
+      if (displacement >= std::numeric_limits<int32_t>::min() &&
+          displacement <= std::numeric_limits<int32_t>::max()) {
+        if (displacement != 0) {
+          assembler.lea(Reg::Rax, Operand::memory(Reg::Rax, int32_t(displacement)));
+        }
+
+        store(offset, Reg::Rax);
+        return;
+      }
+    }
+
+    load(Reg::Rcx, index);
+    sign_extend(Reg::Rcx, index->type()->bit_size(), 64);
+
+    if (element_size == 1 || element_size == 2 || element_size == 4 || element_size == 8) {
+      assembler.lea(Reg::Rax, Operand::memory(Reg::Rax, Reg::Rcx, uint8_t(element_size)));
+    } else {
+      assembler.imul(64, Reg::Rcx, Operand::reg(Reg::Rcx), to_i32(int64_t(element_size)));
+      assembler.alu(X86AluOp::Add, 64, Reg::Rax, Operand::reg(Reg::Rcx));
+    }
+
+    store(offset, Reg::Rax);
+  }
+
+  void visit_cast(Argument<Cast> cast) {
+    const auto from_type = cast->casted_value()->type();
+    const auto to_type = cast->type();
+
+    switch (cast->cast_kind()) {
+      case CastKind::ZeroExtend:
+      case CastKind::Bitcast:
+        move(cast, cast->casted_value());
+        return;
+
+      case CastKind::Truncate:
+        load(Reg::Rax, cast->casted_value());
+        truncate(Reg::Rax, to_type);
+        break;
+
+      case CastKind::SignExtend:
+        load(Reg::Rax, cast->casted_value());
+        sign_extend(Reg::Rax, from_type->bit_size(), 64);
+        truncate(Reg::Rax, to_type);
+        break;
+
+      default:
+        unreachable();
+    }
+
+    store(cast, Reg::Rax);
+  }
+
+  void visit_select(Argument<Select> select) {
+    load(Reg::Rax, select->true_value());
+    const auto false_value = operand(select->false_value(), Reg::Rcx);
+
+    test_condition(select->condition());
+    assembler.cmov(X86Condition::Equal, 64, Reg::Rax, false_value);
+
+    store(select, Reg::Rax);
+  }
+
+  void visit_phi(Argument<Phi>) {
+    // Phis share the register with all their incoming values so they don't need any code.
+  }
+};
+
+X86Code flugzeug::generate_x86_code(Module* module) {
+  X86Code output;
+  X86Assembler assembler;
+
+  std::unordered_map<const Function*, X86Label> function_labels;
+  std::unordered_map<const Function*, uint32_t> extern_indices;
+
+  for (const Function& function : module->local_functions()) {
+    function_labels.insert({&function, assembler.create_label()});
+  }
+
+  for (const Function& function : module->extern_functions()) {
+    extern_indices.insert({&function, uint32_t(output.extern_functions.size())});
+    output.extern_functions.emplace_back(function.name());
+  }
+
+  for (Function& function : module->local_functions()) {
+    const auto allocatable = allocatable_registers(&function);
+    const auto registers = allocate_registers(
+      &function, RegisterFile{.register_count = uint32_t(allocatable.size())});
+    const auto start = assembler.offset();
+
+    X86FunctionLowering lowering(&function, assembler, registers, allocatable, function_labels,
+                                 extern_indices, output.extern_calls);
+    lowering.lower();
+
+    output.functions.push_back(X86FunctionCode{
+      .name = std::string(function.name()),
+      .offset = start,
+      .size = assembler.offset() - start,
+    });
+  }
+
+  output.code = assembler.finish();
+
+  return output;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flugzeug {
+
+class Module;
+
+struct X86FunctionCode {
+  std::string name;
+  size_t offset = 0;
+  size_t size = 0;
+};
+
+/// `call rel32` to the extern function, `offset` is the position of the displacement field.
+struct X86ExternCall {
+  size_t offset = 0;
+  uint32_t extern_index = 0;
+};
+
+/// Machine code of all local functions of the module. Calls between local functions are already
+/// resolved, calls to extern functions have to be relocated.
+struct X86Code {
+  std::vector<uint8_t> code;
+  std::vector<X86FunctionCode> functions;
+  std::vector<std::string> extern_functions;
+  std::vector<X86ExternCall> extern_calls;
+};
+
+/// Generates x86-64 code which follows the System V calling convention. Register allocation is
+/// performed on every function which modifies the IR (see `allocate_registers`).
+///
+/// Values smaller than 64 bits are always kept zero extended and void functions return 0 (so
+/// void `main` exits successfully). All `StackAlloc`s get a fixed place in the stack frame.
+/// Unlike in the interpreters, invalid programs aren't detected.
+X86Code generate_x86_code(Module* module);
+
+}  // namespace flugzeug
@@ -0,0 +1,99 @@
+#include "X86Jit.hpp"
+#include "X86Assembler.hpp"
+
+#include <Flugzeug/Core/Platform.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace flugzeug;
+
+/// Host functions are reached through `mov r11, address; jmp r11`. R11 is a scratch register
+/// which isn't used for passing arguments.
+static std::vector<uint8_t> create_extern_stubs(const X86Code& code,
+                                                const std::unordered_map<std::string, void*>&
+                                                  host_functions,
+                                                std::vector<size_t>& stub_offsets) {
+  X86Assembler assembler;
+
+  stub_offsets.assign(code.extern_functions.size(), size_t(-1));
+
+  for (const auto& call : code.extern_calls) {
+    if (stub_offsets[call.extern_index] != size_t(-1)) {
+      continue;
+    }
+
+    const auto& name = code.extern_functions[call.extern_index];
+    const auto it = host_functions.find(name);
+    verify(it != host_functions.end() && it->second, "No host function for extern function `{}`",
+           name);
+
+    stub_offsets[call.extern_index] = assembler.offset();
+    assembler.mov(X86Register::R11, uint64_t(it->second));
+    assembler.jmp(X86Register::R11);
+  }
+
+  return assembler.finish();
+}
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_MAC)
+#include <sys/mman.h>
+#include <unistd.h>
+
+X86JitCode::X86JitCode(const X86Code& code,
+                       const std::unordered_map<std::string, void*>& host_functions) {
+  std::vector<size_t> stub_offsets;
+  const auto stubs = create_extern_stubs(code, host_functions, stub_offsets);
+
+  const auto stubs_base = (code.code.size() + 15) & ~size_t(15);
+  const auto page_size = size_t(sysconf(_SC_PAGESIZE));
+
+  mapped_size = (stubs_base + stubs.size() + page_size - 1) & ~(page_size - 1);
+  mapped_size = std::max(mapped_size, page_size);
+
+  const auto mapping =
+    mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  verify(mapping != MAP_FAILED, "Failed to map memory for JIT code");
+
+  memory = static_cast<uint8_t*>(mapping);
+
+  std::memcpy(memory, code.code.data(), code.code.size());
+  std::memcpy(memory + stubs_base, stubs.data(), stubs.size());
+
+  for (const auto& call : code.extern_calls) {
+    const auto target = int64_t(stubs_base + stub_offsets[call.extern_index]);
+    const auto displacement = int32_t(target - int64_t(call.offset + 4));
+    std::memcpy(memory + call.offset, &displacement, sizeof(displacement));
+  }
+
+  verify(mprotect(memory, mapped_size, PROT_READ | PROT_EXEC) == 0,
+         "Failed to make JIT code executable");
+
+  for (const auto& function : code.functions) {
+    function_offsets.insert({function.name, function.offset});
+  }
+}
+
+X86JitCode::~X86JitCode() {
+  munmap(memory, mapped_size);
+}
+
+#else
+
+X86JitCode::X86JitCode(const X86Code& code,
+                       const std::unordered_map<std::string, void*>& host_functions) {
+  fatal_error("JIT is not implemented yet for this platform.");
+}
+
+X86JitCode::~X86JitCode() = default;
+
+#endif
+
+void* X86JitCode::function_address(std::string_view name) const {
+  const auto it = function_offsets.find(std::string(name));
+  if (it == function_offsets.end()) {
+    return nullptr;
+  }
+
+  return memory + it->second;
+}
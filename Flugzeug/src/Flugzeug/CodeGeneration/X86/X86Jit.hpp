@@ -0,0 +1,48 @@
+#pragma once
+#include "X86CodeGenerator.hpp"
+
+#include <Flugzeug/Core/ClassTraits.hpp>
+#include <Flugzeug/Core/Error.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace flugzeug {
+
+/// Code generated by `generate_x86_code` loaded into executable memory of the current process.
+/// Memory is mapped writable, filled and then remapped executable (never both at once).
+///
+/// Calls to extern functions go through jump stubs placed after the code, so host functions can
+/// be anywhere in the address space. Host functions are called using the System V calling
+/// convention, they receive zero extended arguments like C functions with unsigned parameters.
+class X86JitCode {
+  uint8_t* memory = nullptr;
+  size_t mapped_size = 0;
+
+  std::unordered_map<std::string, size_t> function_offsets;
+
+ public:
+  CLASS_NON_MOVABLE_NON_COPYABLE(X86JitCode)
+
+  /// Every extern function which is called by the code must have an implementation in
+  /// `host_functions`.
+  X86JitCode(const X86Code& code, const std::unordered_map<std::string, void*>& host_functions);
+  ~X86JitCode();
+
+  /// Returns nullptr if there is no local function with given name.
+  void* function_address(std::string_view name) const;
+
+  /// Returns callable pointer to the local function. `T` must match the IR signature (for
+  /// example `void()` for `main` of Brainfuck programs).
+  template <typename T>
+  T* function(std::string_view name) const {
+    const auto address = function_address(name);
+    verify(address, "Function `{}` doesn't exist", name);
+    return reinterpret_cast<T*>(address);
+  }
+};
+
+}  // namespace flugzeug
@@ -0,0 +1,174 @@
+#include "DenseBitSet.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DENSE_BIT_SET_SSE2
+#endif
+
+using namespace flugzeug;
+
+// Set operations below process two words at a time. They don't exit early so the whole loop stays
+// branch free, changes are accumulated and checked once at the end.
+
+#ifdef DENSE_BIT_SET_SSE2
+static __m128i load_words(const uint64_t* words) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+}
+
+static void store_words(uint64_t* words, __m128i value) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(words), value);
+}
+
+static bool is_zero(__m128i value) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(value, _mm_setzero_si128())) == 0xffff;
+}
+#endif
+
+/// result |= source & ~mask for the first `count` words. Returns true if any bit was added.
+static bool merge_words(uint64_t* result,
+                        const uint64_t* source,
+                        const uint64_t* mask,
+                        size_t count) {
+  size_t i = 0;
+  uint64_t added = 0;
+
+#ifdef DENSE_BIT_SET_SSE2
+  auto added_vector = _mm_setzero_si128();
+
+  for (; i + 2 <= count; i += 2) {
+    const auto current = load_words(result + i);
+    auto incoming = load_words(source + i);
+    if (mask) {
+      incoming = _mm_andnot_si128(load_words(mask + i), incoming);
+    }
+
+    added_vector = _mm_or_si128(added_vector, _mm_andnot_si128(current, incoming));
+    store_words(result + i, _mm_or_si128(current, incoming));
+  }
+
+  added = is_zero(added_vector) ? 0 : 1;
+#endif
+
+  for (; i < count; ++i) {
+    const auto incoming = mask ? source[i] & ~mask[i] : source[i];
+
+    added |= incoming & ~result[i];
+    result[i] |= incoming;
+  }
+
+  return added != 0;
+}
+
+size_t DenseBitSet::find_next(size_t element) const {
+  const auto end_element = this->end_element();
+  if (element >= end_element) {
+    return end_element;
+  }
+
+  size_t index = word_index(element);
+
+  // Ignore bits below `element` in the first word.
+  uint64_t word = words[index] & ~(bit_mask(element) - 1);
+
+  while (word == 0) {
+    if (++index >= words.size()) {
+      return end_element;
+    }
+
+    word = words[index];
+  }
+
+  return index * word_bits + size_t(std::countr_zero(word));
+}
+
+void DenseBitSet::reserve(size_t capacity) {
+  const auto word_count = (capacity + word_bits - 1) / word_bits;
+  if (word_count > words.size()) {
+    words.resize(word_count, 0);
+  }
+}
+
+bool DenseBitSet::insert(size_t element) {
+  reserve(element + 1);
+
+  auto& word = words[word_index(element)];
+  const auto mask = bit_mask(element);
+
+  const bool inserted = (word & mask) == 0;
+  word |= mask;
+
+  return inserted;
+}
+
+bool DenseBitSet::erase(size_t element) {
+  const auto index = word_index(element);
+  if (index >= words.size()) {
+    return false;
+  }
+
+  auto& word = words[index];
+  const auto mask = bit_mask(element);
+
+  const bool erased = (word & mask) != 0;
+  word &= ~mask;
+
+  return erased;
+}
+
+bool DenseBitSet::merge(const DenseBitSet& other) {
+  if (other.words.size() > words.size()) {
+    words.resize(other.words.size(), 0);
+  }
+
+  return merge_words(words.data(), other.words.data(), nullptr, other.words.size());
+}
+
+void DenseBitSet::subtract(const DenseBitSet& other) {
+  const auto count = std::min(words.size(), other.words.size());
+  size_t i = 0;
+
+#ifdef DENSE_BIT_SET_SSE2
+  for (; i + 2 <= count; i += 2) {
+    store_words(&words[i], _mm_andnot_si128(load_words(&other.words[i]), load_words(&words[i])));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    words[i] &= ~other.words[i];
+  }
+}
+
+bool DenseBitSet::merge_difference(const DenseBitSet& a, const DenseBitSet& b) {
+  if (a.words.size() > words.size()) {
+    words.resize(a.words.size(), 0);
+  }
+
+  // Words of `a` past the end of `b` aren't masked.
+  const auto masked_count = std::min(a.words.size(), b.words.size());
+
+  bool added = merge_words(words.data(), a.words.data(), b.words.data(), masked_count);
+  added |= merge_words(words.data() + masked_count, a.words.data() + masked_count, nullptr,
+                       a.words.size() - masked_count);
+
+  return added;
+}
+
+size_t DenseBitSet::size() const {
+  size_t count = 0;
+  for (const uint64_t word : words) {
+    count += size_t(std::popcount(word));
+  }
+
+  return count;
+}
+
+bool DenseBitSet::empty() const {
+  return std::all_of(words.begin(), words.end(), [](uint64_t word) { return word == 0; });
+}
+
+void DenseBitSet::clear() {
+  std::fill(words.begin(), words.end(), 0);
+}
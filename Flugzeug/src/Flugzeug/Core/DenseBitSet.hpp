@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace flugzeug {
+
+/// Set of small non-negative integers stored as a bit vector. Grows automatically on insertion.
+/// Iteration yields elements in ascending order.
+class DenseBitSet {
+  constexpr static size_t word_bits = 64;
+
+  std::vector<uint64_t> words;
+
+  static size_t word_index(size_t element) { return element / word_bits; }
+  static uint64_t bit_mask(size_t element) { return uint64_t(1) << (element % word_bits); }
+
+ public:
+  class Iterator {
+    const DenseBitSet* set;
+    size_t element;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = size_t;
+    using pointer = const size_t*;
+    using reference = size_t;
+
+    Iterator(const DenseBitSet* set, size_t element) : set(set), element(element) {}
+
+    Iterator& operator++() {
+      element = set->find_next(element + 1);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      const auto before = *this;
+      ++(*this);
+      return before;
+    }
+
+    size_t operator*() const { return element; }
+
+    bool operator==(const Iterator& rhs) const { return element == rhs.element; }
+    bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
+  };
+
+  DenseBitSet() = default;
+  explicit DenseBitSet(size_t capacity) { reserve(capacity); }
+
+  void reserve(size_t capacity);
+
+  /// Returns true if the element wasn't present before.
+  bool insert(size_t element);
+  /// Returns true if the element was present before.
+  bool erase(size_t element);
+
+  bool contains(size_t element) const {
+    const auto index = word_index(element);
+    return index < words.size() && (words[index] & bit_mask(element)) != 0;
+  }
+
+  /// Returns the smallest element which is not less than `element` or `end_element()` if there
+  /// is none.
+  size_t find_next(size_t element) const;
+  size_t end_element() const { return words.size() * word_bits; }
+
+  /// Adds all elements of `other` to this set. Returns true if any element was added.
+  bool merge(const DenseBitSet& other);
+  /// Removes all elements of `other` from this set.
+  void subtract(const DenseBitSet& other);
+  /// Adds elements of `a` which aren't in `b` to this set (this |= a & ~b) without creating
+  /// a temporary set. Returns true if any element was added.
+  bool merge_difference(const DenseBitSet& a, const DenseBitSet& b);
+
+  /// Counts the elements, takes time proportional to the capacity.
+  size_t size() const;
+  bool empty() const;
+
+  void clear();
+
+  Iterator begin() const { return Iterator(this, find_next(0)); }
+  Iterator end() const { return Iterator(this, end_element()); }
+};
+
+}  // namespace flugzeug
@@ -2,6 +2,32 @@
 #include "Error.hpp"
 #include "Platform.hpp"
 
+#if defined(PLATFORM_WINDOWS) || defined(PLATFORM_LINUX)
+
+#include <chrono>
+
+// Timestamp counter frequency isn't exposed by the OS so measure it against the steady clock.
+static uint64_t calibrate_timestamp_frequency() {
+  using Clock = std::chrono::steady_clock;
+
+  const auto calibration_time = std::chrono::milliseconds(10);
+
+  const auto start_time = Clock::now();
+  const auto start_timestamp = flugzeug::Environment::monotonic_timestamp();
+
+  Clock::time_point end_time;
+  do {
+    end_time = Clock::now();
+  } while (end_time - start_time < calibration_time);
+
+  const auto end_timestamp = flugzeug::Environment::monotonic_timestamp();
+  const auto elapsed = std::chrono::duration<double>(end_time - start_time).count();
+
+  return uint64_t(double(end_timestamp - start_timestamp) / elapsed);
+}
+
+#endif
+
 #ifdef PLATFORM_WINDOWS
 
 #include <Windows.h>
@@ -17,6 +43,10 @@ uint32_t Environment::current_thread_id() {
 uint64_t Environment::monotonic_timestamp() {
   return __rdtsc();
 }
+uint64_t Environment::monotonic_timestamp_frequency() {
+  static const uint64_t frequency = calibrate_timestamp_frequency();
+  return frequency;
+}
 
 }  // namespace flugzeug
 
@@ -36,6 +66,10 @@ uint32_t Environment::current_thread_id() {
 uint64_t Environment::monotonic_timestamp() {
   return __rdtsc();
 }
+uint64_t Environment::monotonic_timestamp_frequency() {
+  static const uint64_t frequency = calibrate_timestamp_frequency();
+  return frequency;
+}
 
 }  // namespace flugzeug
 
@@ -57,6 +91,9 @@ uint32_t Environment::current_thread_id() {
 uint64_t Environment::monotonic_timestamp() {
   return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
 }
+uint64_t Environment::monotonic_timestamp_frequency() {
+  return 1'000'000'000;
+}
 
 }  // namespace flugzeug
 
@@ -73,6 +110,9 @@ uint32_t Environment::current_thread_id() {
 uint64_t Environment::monotonic_timestamp() {
   fatal_error("Not supported yet");
 }
+uint64_t Environment::monotonic_timestamp_frequency() {
+  fatal_error("Not supported yet");
+}
 
 }  // namespace flugzeug
 
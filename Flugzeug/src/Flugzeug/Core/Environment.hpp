@@ -8,6 +8,9 @@ class Environment {
   static uint32_t current_process_id();
   static uint32_t current_thread_id();
   static uint64_t monotonic_timestamp();
+
+  /// Number of `monotonic_timestamp` ticks per second.
+  static uint64_t monotonic_timestamp_frequency();
 };
 
 }  // namespace flugzeug
\ No newline at end of file
@@ -19,3 +19,11 @@ std::string flugzeug::File::read_to_string(const std::string& path) {
 
   return source;
 }
+
+void flugzeug::File::write_binary(const std::string& path, std::span<const uint8_t> data) {
+  std::ofstream file(path, std::ios::binary);
+  verify(!!file, "Failed to open `{}` for writing", path);
+
+  file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+  verify(!!file, "Failed to write to `{}`", path);
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <span>
 #include <string>
 
 namespace flugzeug {
@@ -6,6 +8,7 @@ namespace flugzeug {
 class File {
  public:
   static std::string read_to_string(const std::string& path);
+  static void write_binary(const std::string& path, std::span<const uint8_t> data);
 };
 
 }  // namespace flugzeug
\ No newline at end of file
@@ -0,0 +1 @@
+#include "FlatHashMap.hpp"
\ No newline at end of file
@@ -0,0 +1,537 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_HASH_MAP_SSE2
+#endif
+
+#include "Error.hpp"
+
+namespace flugzeug {
+
+namespace detail {
+
+/// Every slot of the table has a control byte. Full slots store the low 7 bits of the key hash,
+/// empty and deleted slots have the top bit set.
+enum class FlatHashControl : int8_t {
+  Empty = -128,
+  Deleted = -2,
+};
+
+/// Group of control bytes which are probed at once.
+class FlatHashGroup {
+  const int8_t* control;
+
+ public:
+  constexpr static size_t width = 16;
+
+  explicit FlatHashGroup(const int8_t* control) : control(control) {}
+
+  /// Bit N is set if slot N matches.
+  uint32_t match(int8_t h2) const {
+#ifdef FLAT_HASH_MAP_SSE2
+    const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+    return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(h2))));
+#else
+    uint32_t result = 0;
+    for (size_t i = 0; i < width; ++i) {
+      result |= uint32_t(control[i] == h2) << i;
+    }
+    return result;
+#endif
+  }
+
+  uint32_t match_empty() const { return match(int8_t(FlatHashControl::Empty)); }
+
+  uint32_t match_empty_or_deleted() const {
+#ifdef FLAT_HASH_MAP_SSE2
+    const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+    return uint32_t(_mm_movemask_epi8(bytes));
+#else
+    uint32_t result = 0;
+    for (size_t i = 0; i < width; ++i) {
+      result |= uint32_t(control[i] < 0) << i;
+    }
+    return result;
+#endif
+  }
+};
+
+/// Open addressing hash table with SIMD probed control bytes (Swiss table). Slots are stored
+/// inline, so references to elements are invalidated by rehashing (like with `std::vector`).
+///
+/// `TPolicy` describes the slot type: `TPolicy::key(slot)` returns the key of the slot.
+template <typename TSlot, typename TKey, typename TPolicy, typename THash, typename TEqual>
+class FlatHashTable {
+  using StorageT = std::aligned_storage_t<sizeof(TSlot), alignof(TSlot)>;
+
+  constexpr static size_t group_width = FlatHashGroup::width;
+
+  int8_t* control = nullptr;
+  StorageT* slots = nullptr;
+
+  /// Always 0 or a power of two which is a multiple of the group width.
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t deleted_count = 0;
+
+  [[no_unique_address]] THash hasher;
+  [[no_unique_address]] TEqual equal;
+
+  TSlot* slot(size_t index) { return reinterpret_cast<TSlot*>(&slots[index]); }
+  const TSlot* slot(size_t index) const { return reinterpret_cast<const TSlot*>(&slots[index]); }
+
+  bool is_full(size_t index) const { return control[index] >= 0; }
+
+  /// Maximum number of full and deleted slots before the table needs to be rehashed.
+  static size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+
+  static size_t mix_hash(size_t hash) {
+    // Hashes of pointers and integers from `std::hash` are often identities, mix the bits so both
+    // parts of the hash are usable.
+    uint64_t h = hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return size_t(h);
+  }
+
+  static int8_t h2(size_t hash) { return int8_t(hash & 0x7f); }
+
+  /// Visits groups in triangular order which covers all of them when their count is a power of
+  /// two.
+  template <typename Fn>
+  size_t probe(size_t hash, Fn&& callback) const {
+    const auto group_mask = capacity_ / group_width - 1;
+
+    size_t group = (hash >> 7) & group_mask;
+    for (size_t step = 1;; ++step) {
+      const auto first_slot = group * group_width;
+      const auto result = callback(first_slot, FlatHashGroup(control + first_slot));
+      if (result != size_t(-1)) {
+        return result;
+      }
+
+      group = (group + step) & group_mask;
+    }
+  }
+
+  size_t find_index(const TKey& key) const {
+    if (size_ == 0) {
+      return capacity_;
+    }
+
+    const auto hash = mix_hash(hasher(key));
+    const auto tag = h2(hash);
+
+    return probe(hash, [&](size_t first_slot, FlatHashGroup group) -> size_t {
+      for (uint32_t matches = group.match(tag); matches != 0; matches &= matches - 1) {
+        const auto index = first_slot + size_t(std::countr_zero(matches));
+        if (equal(TPolicy::key(*slot(index)), key)) {
+          return index;
+        }
+      }
+
+      if (group.match_empty() != 0) {
+        return capacity_;
+      }
+
+      return size_t(-1);
+    });
+  }
+
+  size_t find_free_index(size_t hash) const {
+    return probe(hash, [&](size_t first_slot, FlatHashGroup group) -> size_t {
+      if (const auto free = group.match_empty_or_deleted()) {
+        return first_slot + size_t(std::countr_zero(free));
+      }
+
+      return size_t(-1);
+    });
+  }
+
+  void allocate(size_t capacity) {
+    capacity_ = capacity;
+    control = new int8_t[capacity];
+    slots = new StorageT[capacity];
+
+    std::memset(control, int8_t(FlatHashControl::Empty), capacity);
+  }
+
+  void destroy_and_free() {
+    if (!control) {
+      return;
+    }
+
+    if constexpr (!std::is_trivially_destructible_v<TSlot>) {
+      for (size_t i = 0; i < capacity_; ++i) {
+        if (is_full(i)) {
+          slot(i)->~TSlot();
+        }
+      }
+    }
+
+    delete[] control;
+    delete[] slots;
+
+    control = nullptr;
+    slots = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+    deleted_count = 0;
+  }
+
+  void rehash(size_t new_capacity) {
+    const auto old_control = control;
+    const auto old_slots = slots;
+    const auto old_capacity = capacity_;
+
+    allocate(new_capacity);
+    deleted_count = 0;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_control[i] < 0) {
+        continue;
+      }
+
+      auto& old_slot = *reinterpret_cast<TSlot*>(&old_slots[i]);
+
+      const auto hash = mix_hash(hasher(TPolicy::key(old_slot)));
+      const auto index = find_free_index(hash);
+
+      control[index] = h2(hash);
+      new (slot(index)) TSlot(std::move(old_slot));
+      old_slot.~TSlot();
+    }
+
+    delete[] old_control;
+    delete[] old_slots;
+  }
+
+  static size_t capacity_for(size_t size) {
+    size_t capacity = group_width;
+    while (max_load(capacity) < size) {
+      capacity *= 2;
+    }
+
+    return capacity;
+  }
+
+  void prepare_insertion() {
+    if (size_ + deleted_count + 1 <= max_load(capacity_)) {
+      return;
+    }
+
+    // If most of the used slots are deleted then rehash in place to get rid of them.
+    const auto grow = capacity_ == 0 || size_ + 1 > max_load(capacity_) / 2;
+    rehash(grow ? capacity_for(std::max(size_ + 1, capacity_)) : capacity_);
+  }
+
+  void copy_from(const FlatHashTable& other) {
+    if (other.size_ == 0) {
+      return;
+    }
+
+    allocate(other.capacity_);
+
+    for (size_t i = 0; i < other.capacity_; ++i) {
+      if (other.is_full(i)) {
+        new (slot(i)) TSlot(*other.slot(i));
+      }
+      control[i] = other.control[i];
+    }
+
+    size_ = other.size_;
+    deleted_count = other.deleted_count;
+  }
+
+  void move_from(FlatHashTable& other) {
+    control = std::exchange(other.control, nullptr);
+    slots = std::exchange(other.slots, nullptr);
+    capacity_ = std::exchange(other.capacity_, 0);
+    size_ = std::exchange(other.size_, 0);
+    deleted_count = std::exchange(other.deleted_count, 0);
+  }
+
+ public:
+  template <typename TTable, typename TValue>
+  class IteratorInternal {
+    TTable* table;
+    size_t index;
+
+    void skip_non_full() {
+      while (index < table->capacity_ && !table->is_full(index)) {
+        index++;
+      }
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = TSlot;
+    using pointer = TValue*;
+    using reference = TValue&;
+
+    IteratorInternal() : table(nullptr), index(0) {}
+    IteratorInternal(TTable* table, size_t index) : table(table), index(index) { skip_non_full(); }
+
+    template <typename TOtherTable, typename TOtherValue>
+    friend class IteratorInternal;
+
+    template <typename TOtherTable, typename TOtherValue>
+    IteratorInternal(const IteratorInternal<TOtherTable, TOtherValue>& other)
+        : table(other.table), index(other.index) {}
+
+    size_t slot_index() const { return index; }
+
+    IteratorInternal& operator++() {
+      index++;
+      skip_non_full();
+      return *this;
+    }
+
+    IteratorInternal operator++(int) {
+      const auto before = *this;
+      ++(*this);
+      return before;
+    }
+
+    reference operator*() const { return *table->slot(index); }
+    pointer operator->() const { return table->slot(index); }
+
+    bool operator==(const IteratorInternal& rhs) const { return index == rhs.index; }
+    bool operator!=(const IteratorInternal& rhs) const { return !(*this == rhs); }
+  };
+
+  using iterator = IteratorInternal<FlatHashTable, TSlot>;
+  using const_iterator = IteratorInternal<const FlatHashTable, const TSlot>;
+
+  FlatHashTable() = default;
+  ~FlatHashTable() { destroy_and_free(); }
+
+  FlatHashTable(const FlatHashTable& other) { copy_from(other); }
+  FlatHashTable(FlatHashTable&& other) noexcept { move_from(other); }
+
+  FlatHashTable& operator=(const FlatHashTable& other) {
+    if (this != &other) {
+      destroy_and_free();
+      copy_from(other);
+    }
+
+    return *this;
+  }
+
+  FlatHashTable& operator=(FlatHashTable&& other) noexcept {
+    if (this != &other) {
+      destroy_and_free();
+      move_from(other);
+    }
+
+    return *this;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void clear() {
+    if constexpr (!std::is_trivially_destructible_v<TSlot>) {
+      for (size_t i = 0; i < capacity_; ++i) {
+        if (is_full(i)) {
+          slot(i)->~TSlot();
+        }
+      }
+    }
+
+    if (control) {
+      std::memset(control, int8_t(FlatHashControl::Empty), capacity_);
+    }
+
+    size_ = 0;
+    deleted_count = 0;
+  }
+
+  void reserve(size_t size) {
+    if (size > max_load(capacity_)) {
+      rehash(capacity_for(size));
+    }
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, capacity_); }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, capacity_); }
+
+  iterator find(const TKey& key) { return iterator(this, find_index(key)); }
+  const_iterator find(const TKey& key) const { return const_iterator(this, find_index(key)); }
+
+  bool contains(const TKey& key) const { return find_index(key) != capacity_; }
+  size_t count(const TKey& key) const { return contains(key) ? 1 : 0; }
+
+  /// Constructs the slot from `args` only if `key` isn't present yet.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_with_key(const TKey& key, Args&&... args) {
+    {
+      const auto index = find_index(key);
+      if (index != capacity_) {
+        return {iterator(this, index), false};
+      }
+    }
+
+    prepare_insertion();
+
+    const auto hash = mix_hash(hasher(key));
+    const auto index = find_free_index(hash);
+
+    if (control[index] == int8_t(FlatHashControl::Deleted)) {
+      deleted_count--;
+    }
+
+    new (slot(index)) TSlot(std::forward<Args>(args)...);
+    control[index] = h2(hash);
+    size_++;
+
+    return {iterator(this, index), true};
+  }
+
+  std::pair<iterator, bool> insert(const TSlot& value) {
+    return emplace_with_key(TPolicy::key(value), value);
+  }
+  std::pair<iterator, bool> insert(TSlot&& value) {
+    const TKey& key = TPolicy::key(value);
+    return emplace_with_key(key, std::move(value));
+  }
+
+  template <typename TIterator>
+  void insert(TIterator first, TIterator last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  iterator erase(const_iterator it) {
+    const auto index = it.slot_index();
+    verify(index < capacity_ && is_full(index), "Erasing invalid iterator");
+
+    slot(index)->~TSlot();
+    size_--;
+
+    // If the group has an empty slot then no probe sequence continues past it and the slot can
+    // become empty again. Otherwise a tombstone is needed.
+    const auto first_slot = index & ~(group_width - 1);
+    if (FlatHashGroup(control + first_slot).match_empty() != 0) {
+      control[index] = int8_t(FlatHashControl::Empty);
+    } else {
+      control[index] = int8_t(FlatHashControl::Deleted);
+      deleted_count++;
+    }
+
+    return iterator(this, index + 1);
+  }
+
+  size_t erase(const TKey& key) {
+    const auto index = find_index(key);
+    if (index == capacity_) {
+      return 0;
+    }
+
+    erase(const_iterator(this, index));
+    return 1;
+  }
+};
+
+template <typename TKey, typename TValue>
+struct FlatHashMapPolicy {
+  static const TKey& key(const std::pair<TKey, TValue>& slot) { return slot.first; }
+};
+
+template <typename TKey>
+struct FlatHashSetPolicy {
+  static const TKey& key(const TKey& slot) { return slot; }
+};
+
+}  // namespace detail
+
+/// Drop-in replacement for `std::unordered_map` which stores entries inline. Unlike
+/// `std::unordered_map`, insertion invalidates references and iterators. Keys must not be
+/// modified through iterators.
+template <typename TKey,
+          typename TValue,
+          typename THash = std::hash<TKey>,
+          typename TEqual = std::equal_to<TKey>>
+class FlatHashMap : public detail::FlatHashTable<std::pair<TKey, TValue>,
+                                                 TKey,
+                                                 detail::FlatHashMapPolicy<TKey, TValue>,
+                                                 THash,
+                                                 TEqual> {
+  using Base = detail::FlatHashTable<std::pair<TKey, TValue>,
+                                     TKey,
+                                     detail::FlatHashMapPolicy<TKey, TValue>,
+                                     THash,
+                                     TEqual>;
+
+ public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using value_type = std::pair<TKey, TValue>;
+
+  using Base::Base;
+  using Base::insert;
+
+  template <typename... Args>
+  std::pair<typename Base::iterator, bool> try_emplace(const TKey& key, Args&&... args) {
+    return this->emplace_with_key(key, std::piecewise_construct, std::forward_as_tuple(key),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  std::pair<typename Base::iterator, bool> emplace(const TKey& key, TValue value) {
+    return try_emplace(key, std::move(value));
+  }
+
+  TValue& operator[](const TKey& key) { return try_emplace(key).first->second; }
+
+  TValue& at(const TKey& key) {
+    const auto it = this->find(key);
+    verify(it != this->end(), "Key is not present in the map");
+    return it->second;
+  }
+  const TValue& at(const TKey& key) const {
+    const auto it = this->find(key);
+    verify(it != this->end(), "Key is not present in the map");
+    return it->second;
+  }
+};
+
+/// Drop-in replacement for `std::unordered_set` which stores entries inline. Insertion
+/// invalidates references and iterators.
+template <typename TKey, typename THash = std::hash<TKey>, typename TEqual = std::equal_to<TKey>>
+class FlatHashSet
+    : public detail::FlatHashTable<TKey, TKey, detail::FlatHashSetPolicy<TKey>, THash, TEqual> {
+  using Base = detail::FlatHashTable<TKey, TKey, detail::FlatHashSetPolicy<TKey>, THash, TEqual>;
+
+ public:
+  using key_type = TKey;
+  using value_type = TKey;
+
+  using Base::Base;
+  using Base::insert;
+
+  template <typename TIterator>
+  FlatHashSet(TIterator first, TIterator last) {
+    this->insert(first, last);
+  }
+
+  std::pair<typename Base::iterator, bool> emplace(TKey key) { return insert(std::move(key)); }
+};
+
+}  // namespace flugzeug
@@ -0,0 +1,81 @@
+#include "SizeClassArena.hpp"
+#include "Error.hpp"
+
+#include <new>
+
+using namespace flugzeug;
+
+static thread_local SizeClassArena* current_arena = nullptr;
+
+void* SizeClassArena::allocate_from_size_class(size_t size_class) {
+  if (const auto node = free_lists[size_class]) {
+    free_lists[size_class] = node->next;
+    return node;
+  }
+
+  const auto block_size = (size_class + 1) * granularity;
+
+  if (size_t(bump_end - bump_current) < block_size) {
+    const auto chunk = ::operator new(chunk_size);
+    chunks.push_back(chunk);
+
+    bump_current = static_cast<uint8_t*>(chunk);
+    bump_end = bump_current + chunk_size;
+  }
+
+  const auto result = bump_current;
+  bump_current += block_size;
+
+  return result;
+}
+
+void SizeClassArena::free_to_size_class(void* pointer, size_t size_class) {
+  const auto node = static_cast<FreeNode*>(pointer);
+  node->next = free_lists[size_class];
+  free_lists[size_class] = node;
+}
+
+SizeClassArena::Scope::Scope(SizeClassArena* arena) : previous_arena(current_arena) {
+  current_arena = arena;
+}
+
+SizeClassArena::Scope::~Scope() {
+  current_arena = previous_arena;
+}
+
+SizeClassArena::~SizeClassArena() {
+  for (void* chunk : chunks) {
+    ::operator delete(chunk);
+  }
+}
+
+void* SizeClassArena::allocate(size_t size) {
+  const auto total_size = size + sizeof(AllocationHeader);
+
+  SizeClassArena* arena = current_arena;
+  if (total_size > max_size_class_size) {
+    arena = nullptr;
+  }
+
+  const auto header = static_cast<AllocationHeader*>(
+    arena ? arena->allocate_from_size_class(size_class(total_size)) : ::operator new(total_size));
+  header->arena = arena;
+
+  return header + 1;
+}
+
+void SizeClassArena::deallocate(void* pointer, size_t size) {
+  if (!pointer) {
+    return;
+  }
+
+  const auto header = static_cast<AllocationHeader*>(pointer) - 1;
+  const auto total_size = size + sizeof(AllocationHeader);
+
+  if (const auto arena = header->arena) {
+    verify(total_size <= max_size_class_size, "Invalid size of arena allocation");
+    arena->free_to_size_class(header, size_class(total_size));
+  } else {
+    ::operator delete(header);
+  }
+}
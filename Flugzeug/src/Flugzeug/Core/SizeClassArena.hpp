@@ -0,0 +1,68 @@
+#pragma once
+#include "ClassTraits.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace flugzeug {
+
+/// Bump allocator with a free list per size class. Freed objects are reused by later
+/// allocations of the same size class; memory is returned to the system in bulk when the arena
+/// is destroyed. Single arena must not be used from multiple threads at once.
+///
+/// Objects are allocated through the static `allocate`/`deallocate` pair which uses the arena
+/// that is currently bound to the calling thread (via `Scope`) or the global heap if there is
+/// none. Every allocation remembers its arena so it can be freed from anywhere.
+class SizeClassArena {
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  struct AllocationHeader {
+    SizeClassArena* arena;
+  };
+
+  constexpr static size_t granularity = 16;
+  constexpr static size_t size_class_count = 32;
+  constexpr static size_t max_size_class_size = granularity * size_class_count;
+  constexpr static size_t chunk_size = 64 * 1024;
+
+  std::array<FreeNode*, size_class_count> free_lists{};
+  std::vector<void*> chunks;
+
+  uint8_t* bump_current = nullptr;
+  uint8_t* bump_end = nullptr;
+
+  static size_t size_class(size_t total_size) { return (total_size - 1) / granularity; }
+
+  void* allocate_from_size_class(size_t size_class);
+  void free_to_size_class(void* pointer, size_t size_class);
+
+ public:
+  CLASS_NON_MOVABLE_NON_COPYABLE(SizeClassArena)
+
+  /// Maximum alignment of objects allocated via `allocate`.
+  constexpr static size_t object_alignment = alignof(AllocationHeader);
+
+  /// Binds an arena to the current thread for the lifetime of the scope. Scopes can be nested.
+  /// Null arena makes allocations go to the global heap.
+  class Scope {
+    SizeClassArena* previous_arena;
+
+   public:
+    CLASS_NON_MOVABLE_NON_COPYABLE(Scope)
+
+    explicit Scope(SizeClassArena* arena);
+    ~Scope();
+  };
+
+  SizeClassArena() = default;
+  ~SizeClassArena();
+
+  static void* allocate(size_t size);
+  static void deallocate(void* pointer, size_t size);
+};
+
+}  // namespace flugzeug
@@ -0,0 +1,138 @@
+#include "ThreadPool.hpp"
+#include "Error.hpp"
+
+#include <algorithm>
+
+using namespace flugzeug;
+
+struct WorkerIdentity {
+  const ThreadPool* pool = nullptr;
+  size_t index = 0;
+};
+
+static thread_local WorkerIdentity current_worker;
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+  }
+
+  queues.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    queues.push_back(std::make_unique<WorkerQueue>());
+  }
+
+  workers.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers.emplace_back([this, i]() { worker_main(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  wait();
+
+  {
+    std::lock_guard lock(state_mutex);
+    stopping = true;
+  }
+
+  work_available.notify_all();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+bool ThreadPool::try_pop_task(size_t worker_index, Task& task) {
+  // Try our own queue first.
+  {
+    auto& queue = *queues[worker_index];
+    std::lock_guard lock(queue.mutex);
+
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      return true;
+    }
+  }
+
+  // Steal the oldest task from other workers.
+  for (size_t i = 1; i < queues.size(); ++i) {
+    auto& queue = *queues[(worker_index + i) % queues.size()];
+    std::lock_guard lock(queue.mutex);
+
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::worker_main(size_t worker_index) {
+  current_worker = WorkerIdentity{this, worker_index};
+
+  while (true) {
+    // Reserve one of the queued tasks. Tasks are pushed to the queues before `queued_tasks` is
+    // incremented so after the reservation there is guaranteed to be a task for us somewhere.
+    {
+      std::unique_lock lock(state_mutex);
+      work_available.wait(lock, [&] { return stopping || queued_tasks > 0; });
+
+      if (queued_tasks == 0) {
+        return;
+      }
+
+      queued_tasks--;
+    }
+
+    Task task;
+    while (!try_pop_task(worker_index, task)) {
+      std::this_thread::yield();
+    }
+
+    task();
+
+    {
+      std::lock_guard lock(state_mutex);
+      if (--unfinished_tasks == 0) {
+        work_finished.notify_all();
+      }
+    }
+  }
+}
+
+void ThreadPool::submit(Task task) {
+  // Workers push to their own queue, other threads distribute tasks evenly.
+  size_t queue_index;
+  if (current_worker.pool == this) {
+    queue_index = current_worker.index;
+  } else {
+    queue_index = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+  }
+
+  {
+    auto& queue = *queues[queue_index];
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard lock(state_mutex);
+    verify(!stopping, "Cannot submit tasks to stopping thread pool");
+
+    queued_tasks++;
+    unfinished_tasks++;
+  }
+
+  work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+  verify(current_worker.pool != this, "Cannot wait for the thread pool from its worker");
+
+  std::unique_lock lock(state_mutex);
+  work_finished.wait(lock, [&] { return unfinished_tasks == 0; });
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "ClassTraits.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace flugzeug {
+
+/// Work-stealing thread pool. Every worker has its own task queue. Workers take tasks from the
+/// back of their own queue (so tasks submitted by a worker are likely to run on it while their
+/// data is still in cache) and steal from the front of other queues when their own is empty.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> workers;
+
+  std::mutex state_mutex;
+  std::condition_variable work_available;
+  std::condition_variable work_finished;
+
+  size_t queued_tasks = 0;
+  size_t unfinished_tasks = 0;
+  bool stopping = false;
+
+  std::atomic<size_t> next_queue = 0;
+
+  bool try_pop_task(size_t worker_index, Task& task);
+  void worker_main(size_t worker_index);
+
+ public:
+  CLASS_NON_MOVABLE_NON_COPYABLE(ThreadPool)
+
+  /// If `thread_count` is 0 then the pool will use all hardware threads.
+  explicit ThreadPool(size_t thread_count = 0);
+  ~ThreadPool();
+
+  size_t thread_count() const { return workers.size(); }
+
+  /// Can be called from any thread, including worker threads of this pool.
+  void submit(Task task);
+
+  /// Waits until all submitted tasks (and tasks submitted by them) finish executing.
+  void wait();
+};
+
+}  // namespace flugzeug
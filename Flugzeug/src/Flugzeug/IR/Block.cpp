@@ -4,6 +4,7 @@
 #include "Function.hpp"
 #include "Instructions.hpp"
 #include "Internal/DebugIRPrinter.hpp"
+#include "PostDominatorTree.hpp"
 
 #include <algorithm>
 #include <deque>
@@ -147,8 +148,15 @@ static void remove_block_from_vector(std::vector<Block*>& blocks, Block* block)
 }
 
 void Block::on_added_node(Instruction* instruction) {
-  if (function() && !instruction->is_void()) {
-    instruction->set_display_index(function()->allocate_value_index());
+  if (const auto function = this->function()) {
+    if (!instruction->is_void()) {
+      instruction->set_display_index(function->allocate_value_index());
+    }
+
+    // Instructions keep their index when they are moved within the function.
+    function->assign_dense_index(instruction);
+    function->add_to_simplification_worklist(instruction);
+    function->on_block_modified(this);
   }
 
   if (instruction->is_branching()) {
@@ -160,10 +168,14 @@ void Block::on_added_node(Instruction* instruction) {
     }
   }
 
-  invalid_instruction_order = true;
+  instruction->order_in_block_ = 0;
 }
 
 void Block::on_removed_node(Instruction* instruction) {
+  if (const auto function = this->function()) {
+    function->on_block_modified(this);
+  }
+
   if (instruction->is_branching()) {
     for (Value& operand : instruction->operands()) {
       const auto target_block = cast<Block>(operand);
@@ -192,6 +204,10 @@ void Block::add_predecessor(Block* predecessor) {
     predecessors_list_unique.push_back(predecessor);
   }
   predecessors_list.push_back(predecessor);
+
+  if (const auto function = this->function()) {
+    function->on_block_modified(this);
+  }
 }
 
 void Block::remove_predecessor(Block* predecessor) {
@@ -201,16 +217,83 @@ void Block::remove_predecessor(Block* predecessor) {
       predecessors_list.end()) {
     remove_block_from_vector(predecessors_list_unique, predecessor);
   }
+
+  if (const auto function = this->function()) {
+    function->on_block_modified(this);
+  }
 }
 
-void Block::update_instruction_order() const {
-  if (invalid_instruction_order) {
-    size_t index = 0;
-    for (const Instruction& instruction : *this) {
-      instruction.order_in_block_ = index++;
+void Block::renumber_instructions(const Instruction* first,
+                                  const Instruction* last,
+                                  uint64_t lower_bound,
+                                  uint64_t step) const {
+  uint64_t order = lower_bound;
+
+  // Don't use `instruction_range` here as it would query the order which we are assigning.
+  const auto end = last->next();
+  for (auto instruction = first; instruction != end; instruction = instruction->next()) {
+    order += step;
+    instruction->order_in_block_ = order;
+  }
+}
+
+void Block::assign_instruction_order(const Instruction* instruction) const {
+  // Spacing used when numbering instructions appended to the end of the block.
+  constexpr uint64_t spacing = uint64_t(1) << 32;
+
+  // Minimal spacing which is acceptable after renumbering part of the block. Smaller spacing
+  // would make us renumber again too soon.
+  constexpr uint64_t min_spacing = uint64_t(1) << 12;
+
+  const Instruction* first = instruction;
+  const Instruction* last = instruction;
+  size_t count = 1;
+
+  // Instructions without assigned order cannot bound the range, they are renumbered with it.
+  const auto include_unassigned_neighbours = [&] {
+    while (first->previous() && first->previous()->order_in_block_ == 0) {
+      first = first->previous();
+      count++;
+    }
+    while (last->next() && last->next()->order_in_block_ == 0) {
+      last = last->next();
+      count++;
     }
+  };
 
-    invalid_instruction_order = false;
+  include_unassigned_neighbours();
+
+  // Grow the renumbered range in both directions until it has enough free numbers.
+  while (true) {
+    const uint64_t lower_bound = first->previous() ? first->previous()->order_in_block_ : 0;
+
+    if (!last->next()) {
+      // There is nothing after the range so we can use full spacing.
+      renumber_instructions(first, last, lower_bound, spacing);
+      return;
+    }
+
+    const uint64_t upper_bound = last->next()->order_in_block_;
+    const uint64_t step = (upper_bound - lower_bound) / (count + 1);
+
+    if (step >= min_spacing) {
+      renumber_instructions(first, last, lower_bound, step);
+      return;
+    }
+
+    const auto grow_by = count;
+    for (size_t i = 0; i < grow_by; ++i) {
+      if (first->previous()) {
+        first = first->previous();
+        count++;
+      }
+      if (last->next()) {
+        last = last->next();
+        count++;
+      }
+    }
+
+    include_unassigned_neighbours();
   }
 }
 
@@ -322,6 +405,10 @@ void Block::destroy() {
     phi.remove_incoming(this);
   }
 
+  if (const auto function = this->function()) {
+    function->release_dense_index(this);
+  }
+
   IntrusiveNode::destroy();
 }
 
@@ -372,6 +459,10 @@ bool Block::is_dominated_by(const Block* other, const DominatorTree& dominator_t
   return other->dominates(this, dominator_tree);
 }
 
+bool Block::post_dominates(const Block* other, const PostDominatorTree& post_dominator_tree) const {
+  return post_dominator_tree.first_post_dominates_second(this, other);
+}
+
 bool Block::has_successor(const Block* successor) const {
   const auto terminator = last_instruction();
   if (const auto branch = cast<Branch>(terminator)) {
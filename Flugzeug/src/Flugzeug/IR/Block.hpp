@@ -1,5 +1,6 @@
 #pragma once
 #include <Flugzeug/Core/IntrusiveLinkedList.hpp>
+#include <Flugzeug/Core/SizeClassArena.hpp>
 #include <span>
 #include <unordered_set>
 
@@ -9,6 +10,7 @@ namespace flugzeug {
 
 class Function;
 class DominatorTree;
+class PostDominatorTree;
 
 enum class TraversalType {
   BFS_WithStart,
@@ -36,11 +38,12 @@ class Block final : public Value, public ll::IntrusiveNode<Block, Function> {
   InstructionList instruction_list;
   bool is_entry = false;
 
-  mutable bool invalid_instruction_order = false;
-
   std::vector<Block*> predecessors_list;
   std::vector<Block*> predecessors_list_unique;
 
+  /// Function's modification epoch at the time of the last change of this block.
+  uint64_t modification_epoch_ = 0;
+
   InstructionList& intrusive_list() { return instruction_list; }
 
   void on_added_node(Instruction* instruction);
@@ -52,7 +55,11 @@ class Block final : public Value, public ll::IntrusiveNode<Block, Function> {
   void add_predecessor(Block* predecessor);
   void remove_predecessor(Block* predecessor);
 
-  void update_instruction_order() const;
+  void assign_instruction_order(const Instruction* instruction) const;
+  void renumber_instructions(const Instruction* first,
+                             const Instruction* last,
+                             uint64_t lower_bound,
+                             uint64_t step) const;
 
   std::unordered_set<const Value*> get_inlinable_values() const;
 
@@ -62,6 +69,11 @@ class Block final : public Value, public ll::IntrusiveNode<Block, Function> {
  public:
   ~Block() override;
 
+  static void* operator new(size_t size) { return SizeClassArena::allocate(size); }
+  static void operator delete(void* pointer, size_t size) {
+    SizeClassArena::deallocate(pointer, size);
+  }
+
   void print(IRPrinter& printer, IRPrintingMethod method = IRPrintingMethod::Standard) const;
   void print(IRPrintingMethod method = IRPrintingMethod::Standard) const;
   void debug_print() const;
@@ -118,6 +130,10 @@ class Block final : public Value, public ll::IntrusiveNode<Block, Function> {
 
   bool is_entry_block() const { return is_entry; }
 
+  /// Instructions, operands of instructions and predecessors of the block didn't change since
+  /// this epoch of the parent function.
+  uint64_t modification_epoch() const { return modification_epoch_; }
+
   Function* function() { return owner(); }
   const Function* function() const { return owner(); }
 
@@ -141,6 +157,9 @@ class Block final : public Value, public ll::IntrusiveNode<Block, Function> {
   bool dominates(const Block* other, const DominatorTree& dominator_tree) const;
   bool is_dominated_by(const Block* other, const DominatorTree& dominator_tree) const;
 
+  /// Returns true if every path from `other` to the function exit goes through this block.
+  bool post_dominates(const Block* other, const PostDominatorTree& post_dominator_tree) const;
+
   bool has_successor(const Block* successor) const;
   bool has_predecessor(const Block* predecessor) const;
 
@@ -15,10 +15,10 @@ size_t Context::PointerKeyHash::operator()(const Context::PointerKey& p) const {
 }
 
 void Context::increase_refcount() {
-  refcount++;
+  refcount.fetch_add(1, std::memory_order_relaxed);
 }
 void Context::decrease_refcount() {
-  verify(--refcount >= 0, "Refcount became negative");
+  verify(refcount.fetch_sub(1, std::memory_order_relaxed) > 0, "Refcount became negative");
 }
 
 Context::Context() {
@@ -33,8 +33,10 @@ Context::Context() {
 }
 
 Context::~Context() {
-  for (auto [key, constant] : constants) {
-    delete constant;
+  for (auto& shard : constant_shards) {
+    for (auto [key, constant] : shard.constants) {
+      delete constant;
+    }
   }
 
   for (auto [key, undef] : undefs) {
@@ -42,7 +44,8 @@ Context::~Context() {
   }
 
   constexpr size_t base_type_count = 8;
-  verify(refcount == base_type_count + pointer_types.size(), "Unexpected context refcount");
+  verify(size_t(refcount.load()) == base_type_count + pointer_types.size(),
+         "Unexpected context refcount");
 
   for (auto [key, type] : pointer_types) {
     delete type;
@@ -68,13 +71,16 @@ Constant* Context::make_constant(Type* type, uint64_t constant) {
 
   const ConstantKey key{type, constant};
 
-  const auto it = constants.find(key);
-  if (it != constants.end()) {
+  auto& shard = constant_shards[ConstantKeyHash{}(key) % shard_count];
+  std::lock_guard lock(shard.mutex);
+
+  const auto it = shard.constants.find(key);
+  if (it != shard.constants.end()) {
     return it->second;
   }
 
   auto result = new Constant(this, type, constant);
-  constants[key] = result;
+  shard.constants[key] = result;
   return result;
 }
 
@@ -82,6 +88,8 @@ Undef* Context::make_undef(Type* type) {
   verify(!type->is_void() && !type->is_block() && !type->is_function(),
          "Cannot create undef with that type.");
 
+  std::lock_guard lock(undefs_mutex);
+
   const auto it = undefs.find(type);
   if (it != undefs.end()) {
     return it->second;
@@ -96,6 +104,8 @@ PointerType* Context::make_pointer_type_internal(Type* base, uint32_t indirectio
   PointerKey key{base, indirection};
 
   {
+    std::lock_guard lock(pointer_types_mutex);
+
     const auto it = pointer_types.find(key);
     if (it != pointer_types.end()) {
       return it->second;
@@ -116,15 +126,22 @@ PointerType* Context::make_pointer_type_internal(Type* base, uint32_t indirectio
       break;
   }
 
-  PointerType* type = nullptr;
+  // Pointee needs to be created without holding the lock as it recurses.
+  Type* pointee = base;
+  if (indirection > 1) {
+    pointee = make_pointer_type_internal(base, indirection - 1);
+  }
+
+  std::lock_guard lock(pointer_types_mutex);
 
-  if (indirection == 1) {
-    type = new PointerType(this, base, base, indirection);
-  } else {
-    auto pointee = make_pointer_type_internal(base, indirection - 1);
-    type = new PointerType(this, base, pointee, indirection);
+  // Other thread could have created this type in the meantime.
+  const auto it = pointer_types.find(key);
+  if (it != pointer_types.end()) {
+    return it->second;
   }
 
+  const auto type = new PointerType(this, base, pointee, indirection);
+
   pointer_types[key] = type;
   return type;
 }
@@ -139,6 +156,12 @@ PointerType* Context::pointer_type(Type* pointee, uint32_t indirection) {
   return make_pointer_type_internal(base, indirection);
 }
 
+std::mutex& Context::global_value_uses_mutex(const Value* value) {
+  // Skip the lowest bits of the address as they are always zero due to the allocation alignment.
+  const auto index = (reinterpret_cast<uintptr_t>(value) >> 4) % shard_count;
+  return global_value_uses_mutexes[index];
+}
+
 Module* Context::create_module() {
   return new Module(this);
 }
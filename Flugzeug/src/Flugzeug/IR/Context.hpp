@@ -2,9 +2,12 @@
 #include "Type.hpp"
 
 #include <Flugzeug/Core/ClassTraits.hpp>
+#include <Flugzeug/Core/FlatHashMap.hpp>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
-#include <unordered_map>
+#include <mutex>
 
 namespace flugzeug {
 
@@ -12,14 +15,17 @@ class Function;
 class Constant;
 class Undef;
 class Module;
+class Value;
 
+/// Context is thread-safe: constants, undefs and pointer types can be created concurrently and
+/// uses of global values (which are shared between functions) are tracked under a lock.
 class Context {
   friend class Function;
   friend class Value;
   friend class Type;
   friend class Module;
 
-  int64_t refcount = 0;
+  std::atomic<int64_t> refcount = 0;
 
   void increase_refcount();
   void decrease_refcount();
@@ -50,10 +56,22 @@ class Context {
     size_t operator()(const PointerKey& p) const;
   };
 
-  std::unordered_map<ConstantKey, Constant*, ConstantKeyHash> constants;
-  std::unordered_map<Type*, Undef*> undefs;
+  constexpr static size_t shard_count = 16;
 
-  std::unordered_map<PointerKey, PointerType*, PointerKeyHash> pointer_types;
+  struct ConstantShard {
+    std::mutex mutex;
+    FlatHashMap<ConstantKey, Constant*, ConstantKeyHash> constants;
+  };
+
+  std::array<ConstantShard, shard_count> constant_shards;
+
+  std::mutex undefs_mutex;
+  FlatHashMap<Type*, Undef*> undefs;
+
+  std::mutex pointer_types_mutex;
+  FlatHashMap<PointerKey, PointerType*, PointerKeyHash> pointer_types;
+
+  std::array<std::mutex, shard_count> global_value_uses_mutexes;
 
   I1Type* i1_type = nullptr;
   I8Type* i8_type = nullptr;
@@ -69,6 +87,8 @@ class Context {
   Constant* make_constant(Type* type, uint64_t constant);
   Undef* make_undef(Type* type);
 
+  std::mutex& global_value_uses_mutex(const Value* value);
+
  public:
   CLASS_NON_MOVABLE_NON_COPYABLE(Context)
 
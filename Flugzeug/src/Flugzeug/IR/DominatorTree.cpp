@@ -9,20 +9,18 @@ static std::vector<const Block*> traverse_dfs_postorder(const Block* entry_block
 
   std::vector<const Block*> result;
   std::vector<const Block*> stack;
-  std::unordered_set<const Block*> visited;
-  std::unordered_set<const Block*> finished;
+  BlockSet visited(entry_block->function());
+  BlockSet finished(entry_block->function());
 
   result.reserve(block_count);
   stack.reserve(std::min(size_t(8), block_count));
-  visited.reserve(block_count);
-  finished.reserve(block_count);
 
   stack.push_back(entry_block);
 
   while (!stack.empty()) {
     const auto block = stack.back();
 
-    if (visited.insert(block).second) {
+    if (visited.insert(block)) {
       for (const Block* successor : block->successors()) {
         if (!visited.contains(successor)) {
           stack.push_back(successor);
@@ -31,7 +29,7 @@ static std::vector<const Block*> traverse_dfs_postorder(const Block* entry_block
     } else {
       stack.pop_back();
 
-      if (finished.insert(block).second) {
+      if (finished.insert(block)) {
         result.push_back(block);
       }
     }
@@ -52,53 +50,40 @@ static size_t intersect(const std::vector<size_t>& dominators, size_t finger1, s
   }
 }
 
-static std::unordered_map<const Block*, const Block*> calculate_immediate_dominators(
-  const Block* entry_block) {
+void DominatorTree::calculate_immediate_dominators(const Block* entry_block) {
   const auto postorder = traverse_dfs_postorder(entry_block);
   const auto entry_index = postorder.size() - 1;
 
   verify(!postorder.empty(), "Postorder travarsal returned no blocks");
   verify(postorder[entry_index] == entry_block, "Invalid postorder traversal results");
 
-  // If we have only entry block then dominance map will be empty.
-  if (postorder.size() <= 1) {
-    return {};
-  }
-
   std::vector<std::vector<size_t>> predecessors_map;
   predecessors_map.reserve(postorder.size());
 
-  {
-    std::unordered_map<const Block*, size_t> block_to_index;
-    block_to_index.reserve(postorder.size());
-
-    for (size_t i = 0; i < postorder.size(); ++i) {
-      block_to_index[postorder[i]] = i;
-    }
-
-    for (const Block* block : postorder) {
-      const auto predecessors = block->predecessors();
+  for (size_t i = 0; i < postorder.size(); ++i) {
+    block_to_node[postorder[i]] = i;
+  }
 
-      std::vector<size_t> predecessor_indices;
-      predecessor_indices.reserve(predecessors.size());
+  for (const Block* block : postorder) {
+    const auto predecessors = block->predecessors();
 
-      for (const Block* predecessor : predecessors) {
-        const auto it = block_to_index.find(predecessor);
-        if (it == block_to_index.end()) {
-          // This can happen for dead blocks.
-          continue;
-        }
+    std::vector<size_t> predecessor_indices;
+    predecessor_indices.reserve(predecessors.size());
 
-        predecessor_indices.push_back(it->second);
+    for (const Block* predecessor : predecessors) {
+      const auto node = block_to_node.find(predecessor);
+      if (!node) {
+        // This can happen for dead blocks.
+        continue;
       }
 
-      predecessors_map.push_back(std::move(predecessor_indices));
+      predecessor_indices.push_back(*node);
     }
-  }
 
-  constexpr static size_t undefined = std::numeric_limits<size_t>::max();
+    predecessors_map.push_back(std::move(predecessor_indices));
+  }
 
-  std::vector<size_t> dominators(postorder.size(), undefined);
+  std::vector<size_t> dominators(postorder.size(), invalid_node);
 
   {
     dominators[entry_index] = entry_index;
@@ -116,13 +101,13 @@ static std::unordered_map<const Block*, const Block*> calculate_immediate_domina
 
         verify(postorder[index] != entry_block, "Unexpected entry block");
 
-        size_t new_idom_index = undefined;
+        size_t new_idom_index = invalid_node;
         for (const size_t predecessor : predecessors_map[index]) {
-          if (dominators[predecessor] == undefined) {
+          if (dominators[predecessor] == invalid_node) {
             continue;
           }
 
-          if (new_idom_index == undefined) {
+          if (new_idom_index == invalid_node) {
             new_idom_index = predecessor;
           } else {
             new_idom_index = intersect(dominators, new_idom_index, predecessor);
@@ -139,21 +124,284 @@ static std::unordered_map<const Block*, const Block*> calculate_immediate_domina
     }
   }
 
-  std::unordered_map<const Block*, const Block*> final_dominators;
-  final_dominators.reserve(dominators.size());
+  nodes.resize(postorder.size());
 
   for (size_t i = 0; i < postorder.size(); ++i) {
     const auto dominator = dominators[i];
-    verify(dominator != undefined, "Not every dominator was calculated");
+    verify(dominator != invalid_node, "Not every dominator was calculated");
+
+    auto& node = nodes[i];
+    node.block = postorder[i];
+
+    if (i != entry_index) {
+      node.immediate_dominator = dominator;
+      nodes[dominator].children.push_back(i);
+    }
+  }
+}
+
+void DominatorTree::calculate_dfs_numbers(size_t root) {
+  // Number nodes in DFS order of the dominator tree. Node A dominates node B iff B's DFS
+  // interval is nested in A's one.
+  std::vector<std::pair<size_t, size_t>> stack;
+  stack.reserve(nodes.size());
+  stack.emplace_back(root, 0);
+
+  size_t counter = 0;
+
+  nodes[root].dfs_entry = counter++;
+
+  while (!stack.empty()) {
+    auto& [node_index, next_child] = stack.back();
+    const auto& node = nodes[node_index];
+
+    if (next_child < node.children.size()) {
+      const auto child = node.children[next_child++];
+
+      nodes[child].dfs_entry = counter++;
+      stack.emplace_back(child, 0);
+    } else {
+      nodes[node_index].dfs_exit = counter++;
+      stack.pop_back();
+    }
+  }
+}
+
+size_t DominatorTree::get_node(const Block* block) const {
+  const auto node = block_to_node.find(block);
+  return node ? *node : invalid_node;
+}
+
+bool DominatorTree::is_ancestor(size_t ancestor, size_t node) const {
+  const auto& a = nodes[ancestor];
+  const auto& b = nodes[node];
+
+  return a.dfs_entry <= b.dfs_entry && b.dfs_exit <= a.dfs_exit;
+}
+
+size_t DominatorTree::nearest_common_dominator_node(size_t a, size_t b) const {
+  while (!is_ancestor(a, b)) {
+    a = nodes[a].immediate_dominator;
+  }
+
+  return a;
+}
+
+size_t DominatorTree::create_node(const Block* block) {
+  size_t node;
+
+  if (!free_nodes.empty()) {
+    node = free_nodes.back();
+    free_nodes.pop_back();
+  } else {
+    node = nodes.size();
+    nodes.emplace_back();
+  }
+
+  nodes[node].block = block;
+  block_to_node[block] = node;
+
+  return node;
+}
+
+void DominatorTree::destroy_node(size_t node) {
+  block_to_node.erase(nodes[node].block);
+  nodes[node] = Node{};
+
+  free_nodes.push_back(node);
+}
+
+void DominatorTree::recalculate() {
+  nodes.clear();
+  block_to_node.clear();
+  free_nodes.clear();
+
+  const auto entry_block = function->entry_block();
+
+  calculate_immediate_dominators(entry_block);
+
+  root_node = get_node(entry_block);
+  calculate_dfs_numbers(root_node);
+}
+
+void DominatorTree::recalculate_subtree(size_t root) {
+  // Every block dominated by `root` before the update is still dominated by it (or has become
+  // dead). Blocks which have become reachable can be reached only through `root` too. So the
+  // subtree can be recalculated in isolation: we only need to look at blocks which were dominated
+  // by `root` and at blocks which were dead.
+  //
+  // Blocks outside of the subtree can still be affected if they have a predecessor which was
+  // dead and has become reachable (or the other way around). In that case we move `root` up and
+  // try again.
+  std::vector<size_t> old_subtree;
+  std::vector<const Block*> preorder;
+  std::vector<size_t> parents;
+  BlockMap<size_t> numbers(function);
+
+  while (true) {
+    if (root == root_node) {
+      recalculate();
+      return;
+    }
+
+    const auto is_in_region = [&](const Block* block) {
+      const auto node = get_node(block);
+      return node == invalid_node || is_ancestor(root, node);
+    };
+
+    old_subtree.clear();
+    preorder.clear();
+    parents.clear();
+    numbers.clear();
+
+    for (size_t node = 0; node < nodes.size(); ++node) {
+      if (nodes[node].block && is_ancestor(root, node)) {
+        old_subtree.push_back(node);
+      }
+    }
+
+    // Number blocks in DFS preorder (`root` gets number 0).
+    {
+      std::vector<std::pair<const Block*, size_t>> stack;
+      stack.emplace_back(nodes[root].block, invalid_node);
+
+      while (!stack.empty()) {
+        const auto [block, parent] = stack.back();
+        stack.pop_back();
+
+        if (!numbers.insert(block, preorder.size())) {
+          continue;
+        }
+
+        const auto number = preorder.size();
+        preorder.push_back(block);
+        parents.push_back(parent);
+
+        for (const Block* successor : block->successors()) {
+          if (!numbers.contains(successor) && is_in_region(successor)) {
+            stack.emplace_back(successor, number);
+          }
+        }
+      }
+    }
+
+    size_t new_root = root;
+
+    const auto check_escaping_edges = [&](const Block* block) {
+      for (const Block* successor : block->successors()) {
+        const auto node = get_node(successor);
+        if (node != invalid_node && !is_ancestor(root, node)) {
+          new_root = nearest_common_dominator_node(new_root, node);
+        }
+      }
+    };
+
+    for (const Block* block : preorder) {
+      if (get_node(block) == invalid_node) {
+        check_escaping_edges(block);
+      }
+    }
+    for (const size_t node : old_subtree) {
+      if (!numbers.contains(nodes[node].block)) {
+        check_escaping_edges(nodes[node].block);
+      }
+    }
+
+    if (new_root == root) {
+      break;
+    }
+
+    root = new_root;
+  }
+
+  // Semi-NCA: calculate semidominators using simple path compression and then get immediate
+  // dominators by walking up the DFS tree until we hit a node above the semidominator.
+  const auto count = preorder.size();
+
+  std::vector<size_t> semi(count);
+  std::vector<size_t> label(count);
+  std::vector<size_t> ancestor(count, invalid_node);
+  std::vector<size_t> idoms(parents);
+
+  for (size_t i = 0; i < count; ++i) {
+    semi[i] = i;
+    label[i] = i;
+  }
+
+  std::vector<size_t> compress_path;
+
+  const auto eval = [&](size_t v) {
+    if (ancestor[v] == invalid_node) {
+      return v;
+    }
+
+    compress_path.clear();
+    for (size_t x = v; ancestor[ancestor[x]] != invalid_node; x = ancestor[x]) {
+      compress_path.push_back(x);
+    }
+
+    for (auto it = compress_path.rbegin(); it != compress_path.rend(); ++it) {
+      const auto x = *it;
+      const auto a = ancestor[x];
+
+      if (semi[label[a]] < semi[label[x]]) {
+        label[x] = label[a];
+      }
+      ancestor[x] = ancestor[a];
+    }
+
+    return label[v];
+  };
+
+  for (size_t w = count - 1; w > 0; --w) {
+    for (const Block* predecessor : preorder[w]->predecessors()) {
+      const auto number = numbers.find(predecessor);
+      if (!number) {
+        continue;
+      }
+
+      semi[w] = std::min(semi[w], semi[eval(*number)]);
+    }
+
+    ancestor[w] = parents[w];
+  }
+
+  for (size_t w = 1; w < count; ++w) {
+    while (idoms[w] > semi[w]) {
+      idoms[w] = idoms[idoms[w]];
+    }
+  }
+
+  // Blocks from the old subtree which weren't visited are now dead.
+  for (const size_t node : old_subtree) {
+    nodes[node].children.clear();
+
+    if (!numbers.contains(nodes[node].block)) {
+      destroy_node(node);
+    }
+  }
+
+  std::vector<size_t> number_to_node(count);
+  number_to_node[0] = root;
 
-    if (i == entry_index) {
-      continue;
+  for (size_t i = 1; i < count; ++i) {
+    auto node = get_node(preorder[i]);
+    if (node == invalid_node) {
+      node = create_node(preorder[i]);
     }
 
-    final_dominators[postorder[i]] = postorder[dominator];
+    number_to_node[i] = node;
+  }
+
+  for (size_t i = 1; i < count; ++i) {
+    const auto node = number_to_node[i];
+    const auto dominator = number_to_node[idoms[i]];
+
+    nodes[node].immediate_dominator = dominator;
+    nodes[dominator].children.push_back(node);
   }
 
-  return final_dominators;
+  calculate_dfs_numbers(root_node);
 }
 
 bool DominatorTree::first_dominates_second(const Block* dominator, const Block* block) const {
@@ -168,32 +416,96 @@ bool DominatorTree::first_dominates_second(const Block* dominator, const Block*
     return true;
   }
 
-  while (block) {
-    if (block == dominator) {
-      return true;
-    }
-
-    block = immediate_dominator(block);
+  const auto dominator_node = get_node(dominator);
+  const auto block_node = get_node(block);
+  if (dominator_node == invalid_node || block_node == invalid_node) {
+    return false;
   }
 
-  return false;
+  return is_ancestor(dominator_node, block_node);
 }
 
 DominatorTree::DominatorTree(const Function* function)
-    : immediate_dominators(calculate_immediate_dominators(function->entry_block())) {
+    : function(function), block_to_node(function) {
+  recalculate();
+
   verify(!immediate_dominator(function->entry_block()),
          "Entry block shouldn't have immediate dominator");
 }
 
 bool DominatorTree::is_block_dead(const Block* block) const {
-  return !block->is_entry_block() && !immediate_dominators.contains(block);
+  return !block_to_node.contains(block);
 }
 
 const Block* DominatorTree::immediate_dominator(const Block* block) const {
-  const auto it = immediate_dominators.find(block);
-  if (it == immediate_dominators.end()) {
+  const auto node = get_node(block);
+  if (node == invalid_node) {
     return nullptr;
   }
 
-  return it->second;
-}
\ No newline at end of file
+  const auto dominator = nodes[node].immediate_dominator;
+  if (dominator == invalid_node) {
+    return nullptr;
+  }
+
+  return nodes[dominator].block;
+}
+
+const Block* DominatorTree::nearest_common_dominator(const Block* a, const Block* b) const {
+  const auto a_node = get_node(a);
+  const auto b_node = get_node(b);
+  if (a_node == invalid_node || b_node == invalid_node) {
+    return nullptr;
+  }
+
+  return nodes[nearest_common_dominator_node(a_node, b_node)].block;
+}
+
+void DominatorTree::apply_updates(std::span<const Update> updates, bool verify_result) {
+  // Find the root of the smallest subtree which contains all (previously alive) updated blocks.
+  // Only this subtree can be affected by the updates.
+  size_t affected_root = invalid_node;
+
+  for (const auto& update : updates) {
+    const auto successors = update.from->successors();
+    const bool has_edge = std::find(successors.begin(), successors.end(), update.to) !=
+                          successors.end();
+
+    verify(has_edge == (update.kind == Update::Kind::Insert),
+           "CFG edge update doesn't match the function");
+
+    for (const Block* block : {update.from, update.to}) {
+      const auto node = get_node(block);
+      if (node == invalid_node) {
+        continue;
+      }
+
+      affected_root = affected_root == invalid_node
+                        ? node
+                        : nearest_common_dominator_node(affected_root, node);
+    }
+  }
+
+  if (affected_root == root_node) {
+    recalculate();
+  } else if (affected_root != invalid_node) {
+    recalculate_subtree(affected_root);
+  }
+
+  if (verify_result) {
+    verify(matches_recalculation(), "Updated dominator tree differs from recalculated one");
+  }
+}
+
+bool DominatorTree::matches_recalculation() const {
+  const DominatorTree recalculated(function);
+
+  for (const Block& block : *function) {
+    if (is_block_dead(&block) != recalculated.is_block_dead(&block) ||
+        immediate_dominator(&block) != recalculated.immediate_dominator(&block)) {
+      return false;
+    }
+  }
+
+  return true;
+}
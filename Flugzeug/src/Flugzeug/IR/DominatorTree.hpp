@@ -1,5 +1,10 @@
 #pragma once
-#include <unordered_map>
+#include "ValueMap.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
 
 namespace flugzeug {
 
@@ -10,15 +15,69 @@ class Instruction;
 class DominatorTree {
   friend class Block;
 
-  std::unordered_map<const Block*, const Block*> immediate_dominators;
+  constexpr static size_t invalid_node = std::numeric_limits<size_t>::max();
+
+  struct Node {
+    const Block* block = nullptr;
+    size_t immediate_dominator = invalid_node;
+    std::vector<size_t> children;
+
+    /// Position of the node in DFS traversal of the dominator tree. Used to answer dominance
+    /// queries in constant time.
+    size_t dfs_entry = 0;
+    size_t dfs_exit = 0;
+  };
+
+  const Function* function;
+
+  /// After full calculation nodes are stored in postorder of the CFG. Incremental updates reuse
+  /// nodes of removed blocks. Dead blocks have no node.
+  std::vector<Node> nodes;
+  std::vector<size_t> free_nodes;
+  BlockMap<size_t> block_to_node;
+  size_t root_node = invalid_node;
+
+  void calculate_immediate_dominators(const Block* entry_block);
+  void calculate_dfs_numbers(size_t root);
+
+  size_t get_node(const Block* block) const;
+  size_t create_node(const Block* block);
+  void destroy_node(size_t node);
+
+  bool is_ancestor(size_t ancestor, size_t node) const;
+  size_t nearest_common_dominator_node(size_t a, size_t b) const;
+
+  void recalculate();
+  void recalculate_subtree(size_t root);
 
   bool first_dominates_second(const Block* dominator, const Block* block) const;
 
  public:
+  struct Update {
+    enum class Kind {
+      Insert,
+      Delete,
+    };
+
+    Kind kind;
+    const Block* from;
+    const Block* to;
+  };
+
   explicit DominatorTree(const Function* function);
 
   bool is_block_dead(const Block* block) const;
   const Block* immediate_dominator(const Block* block) const;
+
+  /// Returns null if any of the blocks is dead.
+  const Block* nearest_common_dominator(const Block* a, const Block* b) const;
+
+  /// Updates the tree after CFG edges were inserted or deleted. The CFG must already reflect all
+  /// `updates`. Only the subtree which contains all updated blocks is recalculated.
+  /// If `verify_result` is true then the result is checked against full recalculation.
+  void apply_updates(std::span<const Update> updates, bool verify_result = false);
+
+  bool matches_recalculation() const;
 };
 
-}  // namespace flugzeug
\ No newline at end of file
+}  // namespace flugzeug
@@ -9,8 +9,67 @@ namespace flugzeug {
 ValidationResults validate_function(const Function* function, ValidationBehaviour behaviour);
 }
 
+void Function::assign_dense_index(Value* value) {
+  if (value->has_dense_index()) {
+    return;
+  }
+
+  if (free_value_indices.empty()) {
+    value->dense_index_ = value_index_capacity_++;
+    values_by_index.push_back(value);
+  } else {
+    value->dense_index_ = free_value_indices.back();
+    free_value_indices.pop_back();
+    values_by_index[value->dense_index_] = value;
+  }
+}
+
+void Function::assign_dense_index(Block* block) {
+  if (block->has_dense_index()) {
+    return;
+  }
+
+  if (free_block_indices.empty()) {
+    block->dense_index_ = block_index_capacity_++;
+    blocks_by_index.push_back(block);
+  } else {
+    block->dense_index_ = free_block_indices.back();
+    free_block_indices.pop_back();
+    blocks_by_index[block->dense_index_] = block;
+  }
+}
+
+void Function::release_dense_index(Value* value) {
+  if (value->has_dense_index()) {
+    values_by_index[value->dense_index_] = nullptr;
+    simplification_worklist_.erase(value->dense_index_);
+    free_value_indices.push_back(value->dense_index_);
+    value->dense_index_ = invalid_dense_index;
+  }
+}
+
+void Function::release_dense_index(Block* block) {
+  if (block->has_dense_index()) {
+    blocks_by_index[block->dense_index_] = nullptr;
+    free_block_indices.push_back(block->dense_index_);
+    block->dense_index_ = invalid_dense_index;
+  }
+}
+
+void Function::add_to_simplification_worklist(const Instruction* instruction) {
+  const auto index = instruction->dense_index();
+  simplification_worklist_.insert(index);
+  simplification_worklist_start = std::min(simplification_worklist_start, index);
+}
+
+void Function::on_block_modified(Block* block) {
+  block->modification_epoch_ = ++modification_epoch_;
+}
+
 void Function::on_added_node(Block* block) {
   block->set_display_index(allocate_block_index());
+  assign_dense_index(block);
+  on_block_modified(block);
 
   if (block->is_entry) {
     // We cannot check if size() == 0 because it's already updated before calling `on_added_node`.
@@ -21,16 +80,49 @@ void Function::on_added_node(Block* block) {
     if (!instruction.is_void()) {
       instruction.set_display_index(allocate_value_index());
     }
+
+    assign_dense_index(&instruction);
+    add_to_simplification_worklist(&instruction);
   }
 }
 
 void Function::on_removed_node(Block* block) {
+  on_block_modified(block);
+
   if (block->is_entry) {
     verify(intrusive_list().empty(), "Entry block must be removed last");
     block->is_entry = false;
   }
 }
 
+void Function::enqueue_for_simplification(Value* value) {
+  if (const auto instruction = cast<Instruction>(value)) {
+    if (instruction->function() == this) {
+      add_to_simplification_worklist(instruction);
+      on_block_modified(instruction->block());
+    }
+  }
+}
+
+void Function::enqueue_users_for_simplification(Value* value) {
+  for (Instruction& user : value->users<Instruction>()) {
+    enqueue_for_simplification(&user);
+  }
+}
+
+Instruction* Function::take_from_simplification_worklist() {
+  const auto index = simplification_worklist_.find_next(simplification_worklist_start);
+  if (index == simplification_worklist_.end_element()) {
+    simplification_worklist_start = std::numeric_limits<size_t>::max();
+    return nullptr;
+  }
+
+  simplification_worklist_.erase(index);
+  simplification_worklist_start = index + 1;
+
+  return cast<Instruction>(values_by_index[index]);
+}
+
 void Function::print_prototype(IRPrinter& printer, bool end_line) const {
   auto p = printer.create_line_printer();
 
@@ -76,6 +168,7 @@ Function::Function(Context* context,
 
     auto parameter = new Parameter(context, type);
     parameter->set_display_index(allocate_value_index());
+    assign_dense_index(parameter);
 
     parameters_.push_back(parameter);
   }
@@ -154,6 +247,8 @@ void Function::reassign_display_indices() {
 }
 
 Block* Function::create_block() {
+  const AllocationScope allocation_scope(this);
+
   const auto block = new Block(context());
   insert_block(block);
   return block;
@@ -173,6 +268,7 @@ void Function::destroy() {
     delete param;
   }
 
+  // Memory of all destroyed blocks and instructions is released in bulk together with the arena.
   IntrusiveNode::destroy();
 }
 
@@ -5,8 +5,13 @@
 #include "Validator.hpp"
 #include "Value.hpp"
 
+#include <Flugzeug/Core/DenseBitSet.hpp>
 #include <Flugzeug/Core/IntrusiveLinkedList.hpp>
+#include <Flugzeug/Core/SizeClassArena.hpp>
 
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <string_view>
 #include <vector>
 
@@ -21,6 +26,7 @@ class Function final : public Value, public ll::IntrusiveNode<Function, Module>
   friend class ll::IntrusiveLinkedList<Block, Function>;
   friend class ll::IntrusiveNode<Block, Function>;
   friend class Block;
+  friend class Instruction;
   friend class Module;
 
   using BlockList = ll::IntrusiveLinkedList<Block, Function>;
@@ -85,15 +91,52 @@ class Function final : public Value, public ll::IntrusiveNode<Function, Module>
   const std::string name_;
   std::vector<Parameter*> parameters_;
 
+  /// Backs blocks, instructions and operand uses of this function. Declared before `blocks_` so
+  /// it outlives them.
+  SizeClassArena arena_;
+
   /// Entry block is always first block in the list.
   BlockList blocks_;
 
+  /// Copying instructions out of this function temporarily adds uses to its values, so it must
+  /// not happen concurrently (e.g. when multiple callers are inlining this function in parallel).
+  std::mutex copy_mutex_;
+
   size_t next_value_index = 0;
   size_t next_block_index = 0;
 
   size_t allocate_value_index() { return next_value_index++; }
   size_t allocate_block_index() { return next_block_index++; }
 
+  /// Dense indices are reused after the value is destroyed so they stay close to the number of
+  /// live values.
+  size_t value_index_capacity_ = 0;
+  size_t block_index_capacity_ = 0;
+  std::vector<size_t> free_value_indices;
+  std::vector<size_t> free_block_indices;
+  std::vector<Value*> values_by_index;
+  std::vector<Block*> blocks_by_index;
+
+  /// Dense indices of instructions which were inserted or modified since InstructionSimplification
+  /// last looked at them.
+  DenseBitSet simplification_worklist_;
+  size_t simplification_worklist_start = std::numeric_limits<size_t>::max();
+
+  uint64_t modification_epoch_ = 1;
+
+  /// Number of instructions which cost model based inlining can still add to this function.
+  /// Assigned on the first inlining attempt so the growth is limited across all iterations of
+  /// the optimization loop.
+  std::optional<size_t> inlining_budget_;
+
+  void assign_dense_index(Value* value);
+  void assign_dense_index(Block* block);
+  void release_dense_index(Value* value);
+  void release_dense_index(Block* block);
+
+  void add_to_simplification_worklist(const Instruction* instruction);
+  void on_block_modified(Block* block);
+
   BlockList& intrusive_list() { return blocks_; }
 
   void on_added_node(Block* block);
@@ -112,8 +155,22 @@ class Function final : public Value, public ll::IntrusiveNode<Function, Module>
            const std::vector<Type*>& arguments);
 
  public:
+  /// Makes blocks, instructions and operand uses created by the current thread get allocated from
+  /// the function's arena. Everything created inside the scope must end up in this function.
+  class AllocationScope {
+    SizeClassArena::Scope scope;
+
+   public:
+    CLASS_NON_MOVABLE_NON_COPYABLE(AllocationScope)
+
+    explicit AllocationScope(Function* function)
+        : scope(function ? &function->arena_ : nullptr) {}
+  };
+
   ~Function() override;
 
+  std::mutex& copy_mutex() { return copy_mutex_; }
+
   ValidationResults validate(ValidationBehaviour behaviour) const;
 
   void print(IRPrinter& printer, IRPrintingMethod method = IRPrintingMethod::Standard) const;
@@ -163,6 +220,36 @@ class Function final : public Value, public ll::IntrusiveNode<Function, Module>
 
   void reassign_display_indices();
 
+  /// Upper bounds (exclusive) of dense value and block indices.
+  size_t value_index_capacity() const { return value_index_capacity_; }
+  size_t block_index_capacity() const { return block_index_capacity_; }
+
+  /// Returns null if no value or block currently uses the index.
+  Value* value_by_index(size_t index) const {
+    return index < values_by_index.size() ? values_by_index[index] : nullptr;
+  }
+  Block* block_by_index(size_t index) const {
+    return index < blocks_by_index.size() ? blocks_by_index[index] : nullptr;
+  }
+
+  /// Incremented on every modification of the function (insertion or removal of blocks and
+  /// instructions, changes of instructions and of the CFG).
+  uint64_t modification_epoch() const { return modification_epoch_; }
+
+  /// Instructions are added to the simplification worklist automatically when they are inserted
+  /// or their operands change. Passes which modify instructions in other ways (or which know
+  /// that some instructions may simplify now) can enqueue them explicitly. Values which aren't
+  /// instructions of this function are ignored. Enqueued instructions count as modified.
+  void enqueue_for_simplification(Value* value);
+  void enqueue_users_for_simplification(Value* value);
+
+  /// Removes the instruction with the lowest dense index from the worklist. Returns null if the
+  /// worklist is empty.
+  Instruction* take_from_simplification_worklist();
+  const DenseBitSet& simplification_worklist() const { return simplification_worklist_; }
+
+  std::optional<size_t>& inlining_budget() { return inlining_budget_; }
+
   Block* create_block();
 
   void destroy();
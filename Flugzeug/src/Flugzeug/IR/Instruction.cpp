@@ -1,6 +1,7 @@
 #include "Instruction.hpp"
 #include "Block.hpp"
 #include "ConsoleIRPrinter.hpp"
+#include "Function.hpp"
 #include "InstructionVisitor.hpp"
 #include "Instructions.hpp"
 #include "Internal/DebugIRPrinter.hpp"
@@ -46,8 +47,11 @@ void Instruction::print_value_compact(const Value* value,
   printer.print(value);
 }
 
-size_t Instruction::order_in_block() const {
-  block()->update_instruction_order();
+uint64_t Instruction::order_in_block() const {
+  if (order_in_block_ == 0) {
+    block()->assign_instruction_order(this);
+  }
+
   return order_in_block_;
 }
 
@@ -94,10 +98,22 @@ const Function* Instruction::function() const {
   return block() ? block()->function() : nullptr;
 }
 
+void Instruction::on_modified() {
+  if (const auto function = this->function()) {
+    function->add_to_simplification_worklist(this);
+    function->on_block_modified(block());
+  }
+}
+
 void Instruction::destroy() {
   if (!is_void()) {
     replace_uses_with_undef();
   }
+
+  if (const auto function = this->function()) {
+    function->release_dense_index(this);
+  }
+
   IntrusiveNode::destroy();
 }
 
@@ -4,6 +4,7 @@
 
 #include <Flugzeug/Core/HashCombine.hpp>
 #include <Flugzeug/Core/IntrusiveLinkedList.hpp>
+#include <Flugzeug/Core/SizeClassArena.hpp>
 #include <Flugzeug/Core/StaticVector.hpp>
 
 #include <unordered_set>
@@ -23,9 +24,11 @@ class Instruction : public User, public ll::IntrusiveNode<Instruction, Block> {
   friend class Block;
   friend class Function;
 
-  mutable size_t order_in_block_ = 0;
+  /// Orders are sparse so an inserted instruction can usually take a number between its
+  /// neighbours. They are assigned lazily, 0 means that the order wasn't assigned yet.
+  mutable uint64_t order_in_block_ = 0;
 
-  size_t order_in_block() const;
+  uint64_t order_in_block() const;
 
  protected:
   using User::User;
@@ -43,6 +46,10 @@ class Instruction : public User, public ll::IntrusiveNode<Instruction, Block> {
   bool print_compact(IRPrinter& printer,
                      const std::unordered_set<const Value*>& inlined_values) const;
 
+  /// Adds the instruction to the simplification worklist of its function and bumps modification
+  /// epoch of its block.
+  void on_modified() override;
+
  public:
   using IntrusiveNode::insert_after;
   using IntrusiveNode::insert_before;
@@ -54,6 +61,13 @@ class Instruction : public User, public ll::IntrusiveNode<Instruction, Block> {
   using IntrusiveNode::push_front;
   using IntrusiveNode::unlink;
 
+  /// Instructions are allocated from the arena of the function which is currently being
+  /// modified by this thread (see `Function::AllocationScope`).
+  static void* operator new(size_t size) { return SizeClassArena::allocate(size); }
+  static void operator delete(void* pointer, size_t size) {
+    SizeClassArena::deallocate(pointer, size);
+  }
+
   virtual Instruction* clone() = 0;
 
   void print(IRPrinter& printer) const;
@@ -1,7 +1,17 @@
 #include "InstructionInserter.hpp"
+#include "Function.hpp"
 
 using namespace flugzeug;
 
+template <typename T, typename... Args>
+T* InstructionInserter::create_and_insert(Args&&... args) {
+  const Function::AllocationScope allocation_scope(insertion_function());
+
+  const auto instruction = new T(context, std::forward<Args>(args)...);
+  insert_internal(instruction);
+  return instruction;
+}
+
 void InstructionInserter::insert_internal(Instruction* instruction) {
   switch (insert_type) {
     case InsertType::BlockFront:
@@ -60,64 +70,69 @@ Block* InstructionInserter::insertion_block() {
   return nullptr;
 }
 
+Function* InstructionInserter::insertion_function() {
+  const auto block = insertion_block();
+  return block ? block->function() : nullptr;
+}
+
 UnaryInstr* InstructionInserter::unary_instr(UnaryOp op, Value* value) {
-  return insert(new UnaryInstr(context, op, value));
+  return create_and_insert<UnaryInstr>(op, value);
 }
 
 BinaryInstr* InstructionInserter::binary_instr(Value* lhs, BinaryOp op, Value* rhs) {
-  return insert(new BinaryInstr(context, lhs, op, rhs));
+  return create_and_insert<BinaryInstr>(lhs, op, rhs);
 }
 
 IntCompare* InstructionInserter::int_compare(Value* lhs, IntPredicate predicate, Value* rhs) {
-  return insert(new IntCompare(context, lhs, predicate, rhs));
+  return create_and_insert<IntCompare>(lhs, predicate, rhs);
 }
 
 Load* InstructionInserter::load(Value* address) {
-  return insert(new Load(context, address));
+  return create_and_insert<Load>(address);
 }
 
 Store* InstructionInserter::store(Value* address, Value* stored_value) {
-  return insert(new Store(context, address, stored_value));
+  return create_and_insert<Store>(address, stored_value);
 }
 
 Call* InstructionInserter::call(Function* function, const std::vector<Value*>& arguments) {
-  return insert(new Call(context, function, arguments));
+  return create_and_insert<Call>(function, arguments);
 }
 
 Branch* InstructionInserter::branch(Block* target) {
-  return insert(new Branch(context, target));
+  return create_and_insert<Branch>(target);
 }
 
 CondBranch* InstructionInserter::cond_branch(Value* condition,
                                              Block* true_target,
                                              Block* false_target) {
-  return insert(new CondBranch(context, condition, true_target, false_target));
+  return create_and_insert<CondBranch>(condition, true_target, false_target);
 }
 
 StackAlloc* InstructionInserter::stack_alloc(Type* type, size_t size) {
-  return insert(new StackAlloc(context, type, size));
+  return create_and_insert<StackAlloc>(type, size);
 }
 
 Ret* InstructionInserter::ret(Value* value) {
-  return insert(new Ret(context, value));
+  return create_and_insert<Ret>(value);
 }
 
 Offset* InstructionInserter::offset(Value* base, Value* index) {
-  return insert(new Offset(context, base, index));
+  return create_and_insert<Offset>(base, index);
 }
 
 Cast* InstructionInserter::cast(CastKind kind, Value* casted_value, Type* target_type) {
-  return insert(new Cast(context, kind, casted_value, target_type));
+  return create_and_insert<Cast>(kind, casted_value, target_type);
 }
 
 Select* InstructionInserter::select(Value* condition, Value* true_value, Value* false_value) {
-  return insert(new Select(context, condition, true_value, false_value));
+  return create_and_insert<Select>(condition, true_value, false_value);
 }
 
 Phi* InstructionInserter::phi(Type* type) {
-  return insert(new Phi(context, type));
+  return create_and_insert<Phi>(type);
 }
 
 Phi* InstructionInserter::phi(const std::vector<Phi::Incoming>& incoming) {
-  return insert(new Phi(context, incoming));
+  return create_and_insert<Phi>(incoming);
 }
\ No newline at end of file
@@ -28,11 +28,10 @@ class InstructionInserter {
 
   void insert_internal(Instruction* instruction);
 
-  template <typename T>
-  T* insert(T* instruction) {
-    insert_internal(instruction);
-    return instruction;
-  }
+  Function* insertion_function();
+
+  template <typename T, typename... Args>
+  T* create_and_insert(Args&&... args);
 
  public:
   InstructionInserter() = default;
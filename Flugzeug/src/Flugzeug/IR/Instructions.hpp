@@ -68,7 +68,12 @@ class UnaryInstr final : public Instruction {
   const Value* value() const { return operand(0); }
 
   void set_value(Value* value) { return set_operand(0, value); }
-  void set_op(UnaryOp new_op) { op_ = new_op; }
+  void set_op(UnaryOp new_op) {
+    if (op_ != new_op) {
+      op_ = new_op;
+      on_modified();
+    }
+  }
 
   void set_new_operands(UnaryOp new_op, Value* value) {
     set_op(new_op);
@@ -108,7 +113,12 @@ class BinaryInstr final : public Instruction {
 
   void set_lhs(Value* lhs) { return set_operand(0, lhs); }
   void set_rhs(Value* rhs) { return set_operand(1, rhs); }
-  void set_op(BinaryOp new_op) { op_ = new_op; }
+  void set_op(BinaryOp new_op) {
+    if (op_ != new_op) {
+      op_ = new_op;
+      on_modified();
+    }
+  }
 
   void set_new_operands(Value* lhs, BinaryOp new_op, Value* rhs) {
     set_lhs(lhs);
@@ -151,7 +161,12 @@ class IntCompare final : public Instruction {
 
   void set_lhs(Value* lhs) { return set_operand(0, lhs); }
   void set_rhs(Value* rhs) { return set_operand(1, rhs); }
-  void set_predicate(IntPredicate new_predicate) { predicate_ = new_predicate; }
+  void set_predicate(IntPredicate new_predicate) {
+    if (predicate_ != new_predicate) {
+      predicate_ = new_predicate;
+      on_modified();
+    }
+  }
 
   void set_new_operands(Value* lhs, IntPredicate new_predicate, Value* rhs) {
     set_lhs(lhs);
@@ -441,7 +456,12 @@ class Cast final : public Instruction {
   const Value* casted_value() const { return operand(0); }
 
   void set_casted_value(Value* casted_value) { return set_operand(0, casted_value); }
-  void set_cast_kind(CastKind new_cast_kind) { cast_kind_ = new_cast_kind; }
+  void set_cast_kind(CastKind new_cast_kind) {
+    if (cast_kind_ != new_cast_kind) {
+      cast_kind_ = new_cast_kind;
+      on_modified();
+    }
+  }
 
   Instruction* clone() override { return new Cast(context(), cast_kind(), casted_value(), type()); }
 
@@ -1,4 +1,6 @@
 #pragma once
+#include <Flugzeug/Core/SizeClassArena.hpp>
+
 #include <cstdint>
 #include <iterator>
 
@@ -38,6 +40,11 @@ class Use {
   Use() = default;
   Use(User* user, size_t operand_index) : user_(user), operand_index_(uint32_t(operand_index)) {}
 
+  static void* operator new(size_t size) { return SizeClassArena::allocate(size); }
+  static void operator delete(void* pointer, size_t size) {
+    SizeClassArena::deallocate(pointer, size);
+  }
+
   size_t operand_index() const { return size_t(operand_index_); }
 
   User* user() { return user_; }
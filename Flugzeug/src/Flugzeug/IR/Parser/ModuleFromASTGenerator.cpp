@@ -372,6 +372,8 @@ void ModuleFromASTGenerator::generate() {
     const auto function = module->find_function(pr_function->name);
     verify(function, "Failed to get the IR function");
 
+    const Function::AllocationScope allocation_scope(function);
+
     fn_ctx = FunctionGenerationContext{pr_function.get(), function};
     generate_function_body();
     fn_ctx = FunctionGenerationContext{};
@@ -0,0 +1,193 @@
+#include "PostDominatorTree.hpp"
+#include "Block.hpp"
+#include "Function.hpp"
+
+using namespace flugzeug;
+
+static size_t intersect(const std::vector<size_t>& dominators, size_t finger1, size_t finger2) {
+  while (true) {
+    if (finger1 < finger2) {
+      finger1 = dominators[finger1];
+    } else if (finger1 > finger2) {
+      finger2 = dominators[finger2];
+    } else {
+      return finger1;
+    }
+  }
+}
+
+void PostDominatorTree::calculate_immediate_post_dominators(const Function* function) {
+  std::vector<const Block*> exits;
+  for (const Block& block : *function) {
+    if (block.successors().empty()) {
+      exits.push_back(&block);
+    }
+  }
+
+  // Traverse the reversed CFG starting from the virtual exit node (represented by null block).
+  // Successors of the virtual exit are all exits, successors of other blocks are their
+  // predecessors in the CFG.
+  std::vector<const Block*> postorder;
+  {
+    std::vector<std::pair<const Block*, size_t>> stack;
+    BlockSet visited(function);
+
+    stack.emplace_back(nullptr, 0);
+
+    while (!stack.empty()) {
+      auto& [block, next_successor] = stack.back();
+
+      const auto successors = block ? block->predecessors() : std::span<const Block*>(exits);
+
+      if (next_successor < successors.size()) {
+        const auto successor = successors[next_successor++];
+
+        if (visited.insert(successor)) {
+          stack.emplace_back(successor, 0);
+        }
+      } else {
+        postorder.push_back(block);
+        stack.pop_back();
+      }
+    }
+  }
+
+  const auto root_index = postorder.size() - 1;
+
+  for (size_t i = 0; i < root_index; ++i) {
+    block_to_node[postorder[i]] = i;
+  }
+
+  // Predecessors in the reversed CFG are successors in the original one. Exits have the virtual
+  // exit node as their only predecessor.
+  std::vector<std::vector<size_t>> predecessors_map(postorder.size());
+  for (size_t i = 0; i < root_index; ++i) {
+    const auto block = postorder[i];
+    const auto successors = block->successors();
+
+    if (successors.empty()) {
+      predecessors_map[i].push_back(root_index);
+    } else {
+      for (const Block* successor : successors) {
+        if (const auto node = block_to_node.find(successor)) {
+          predecessors_map[i].push_back(*node);
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> dominators(postorder.size(), invalid_node);
+  dominators[root_index] = root_index;
+
+  bool changed = true;
+
+  while (changed) {
+    changed = false;
+
+    for (size_t i = 0; i < root_index; ++i) {
+      const size_t index = root_index - 1 - i;
+
+      size_t new_idom_index = invalid_node;
+      for (const size_t predecessor : predecessors_map[index]) {
+        if (dominators[predecessor] == invalid_node) {
+          continue;
+        }
+
+        if (new_idom_index == invalid_node) {
+          new_idom_index = predecessor;
+        } else {
+          new_idom_index = intersect(dominators, new_idom_index, predecessor);
+        }
+      }
+
+      verify(new_idom_index < postorder.size(), "Calculating post-idom index failed");
+
+      if (new_idom_index != dominators[index]) {
+        dominators[index] = new_idom_index;
+        changed = true;
+      }
+    }
+  }
+
+  nodes.resize(postorder.size());
+  root_node = root_index;
+
+  for (size_t i = 0; i < postorder.size(); ++i) {
+    auto& node = nodes[i];
+    node.block = postorder[i];
+
+    if (i != root_index) {
+      node.immediate_post_dominator = dominators[i];
+      nodes[dominators[i]].children.push_back(i);
+    }
+  }
+}
+
+void PostDominatorTree::calculate_dfs_numbers() {
+  std::vector<std::pair<size_t, size_t>> stack;
+  stack.reserve(nodes.size());
+  stack.emplace_back(root_node, 0);
+
+  size_t counter = 0;
+
+  nodes[root_node].dfs_entry = counter++;
+
+  while (!stack.empty()) {
+    auto& [node_index, next_child] = stack.back();
+    const auto& node = nodes[node_index];
+
+    if (next_child < node.children.size()) {
+      const auto child = node.children[next_child++];
+
+      nodes[child].dfs_entry = counter++;
+      stack.emplace_back(child, 0);
+    } else {
+      nodes[node_index].dfs_exit = counter++;
+      stack.pop_back();
+    }
+  }
+}
+
+size_t PostDominatorTree::get_node(const Block* block) const {
+  const auto node = block_to_node.find(block);
+  return node ? *node : invalid_node;
+}
+
+bool PostDominatorTree::first_post_dominates_second(const Block* post_dominator,
+                                                    const Block* block) const {
+  if (post_dominator == block) {
+    return true;
+  }
+
+  verify(post_dominator->function() == block->function(),
+         "`first_post_dominates_second` works only on blocks that belong to the same function");
+
+  const auto post_dominator_node = get_node(post_dominator);
+  const auto block_node = get_node(block);
+  if (post_dominator_node == invalid_node || block_node == invalid_node) {
+    return false;
+  }
+
+  const auto& a = nodes[post_dominator_node];
+  const auto& b = nodes[block_node];
+
+  return a.dfs_entry <= b.dfs_entry && b.dfs_exit <= a.dfs_exit;
+}
+
+PostDominatorTree::PostDominatorTree(const Function* function) : block_to_node(function) {
+  calculate_immediate_post_dominators(function);
+  calculate_dfs_numbers();
+}
+
+bool PostDominatorTree::can_reach_exit(const Block* block) const {
+  return block_to_node.contains(block);
+}
+
+const Block* PostDominatorTree::immediate_post_dominator(const Block* block) const {
+  const auto node = get_node(block);
+  if (node == invalid_node) {
+    return nullptr;
+  }
+
+  return nodes[nodes[node].immediate_post_dominator].block;
+}
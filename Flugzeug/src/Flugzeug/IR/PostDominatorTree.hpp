@@ -0,0 +1,52 @@
+#pragma once
+#include "ValueMap.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace flugzeug {
+
+class Block;
+class Function;
+
+/// Dominator tree of the reversed CFG. All blocks without successors are post-dominated by
+/// a virtual exit node which is the root of the tree. Blocks which cannot reach any exit
+/// (e.g. infinite loops) are not part of the tree.
+class PostDominatorTree {
+  friend class Block;
+
+  constexpr static size_t invalid_node = std::numeric_limits<size_t>::max();
+
+  struct Node {
+    /// Null for the virtual exit node.
+    const Block* block = nullptr;
+    size_t immediate_post_dominator = invalid_node;
+    std::vector<size_t> children;
+
+    size_t dfs_entry = 0;
+    size_t dfs_exit = 0;
+  };
+
+  /// Nodes are stored in postorder of the reversed CFG (so virtual exit node is last).
+  std::vector<Node> nodes;
+  BlockMap<size_t> block_to_node;
+  size_t root_node = invalid_node;
+
+  void calculate_immediate_post_dominators(const Function* function);
+  void calculate_dfs_numbers();
+
+  size_t get_node(const Block* block) const;
+
+  bool first_post_dominates_second(const Block* post_dominator, const Block* block) const;
+
+ public:
+  explicit PostDominatorTree(const Function* function);
+
+  bool can_reach_exit(const Block* block) const;
+
+  /// Returns null for blocks without successors and for blocks which cannot reach any exit.
+  const Block* immediate_post_dominator(const Block* block) const;
+};
+
+}  // namespace flugzeug
@@ -19,11 +19,13 @@ PointerType* Type::ref(uint32_t indirection) const {
   const auto non_const = const_cast<Type*>(this);
 
   if (indirection == 1) {
-    if (!pointer_to_this) {
-      pointer_to_this = context()->pointer_type(non_const, 1);
+    auto pointer = pointer_to_this.load(std::memory_order_acquire);
+    if (!pointer) {
+      pointer = context()->pointer_type(non_const, 1);
+      pointer_to_this.store(pointer, std::memory_order_release);
     }
 
-    return pointer_to_this;
+    return pointer;
   }
 
   return context()->pointer_type(non_const, indirection);
@@ -115,19 +117,23 @@ Constant* Type::constant(uint64_t constant) const {
   const auto non_const = const_cast<Type*>(this);
 
   if (constant == 0) {
-    if (!zero_) {
-      zero_ = context_->make_constant(non_const, 0);
+    auto zero = zero_.load(std::memory_order_acquire);
+    if (!zero) {
+      zero = context_->make_constant(non_const, 0);
+      zero_.store(zero, std::memory_order_release);
     }
 
-    return zero_;
+    return zero;
   }
 
   if (constant == 1) {
-    if (!one_) {
-      one_ = context_->make_constant(non_const, 1);
+    auto one = one_.load(std::memory_order_acquire);
+    if (!one) {
+      one = context_->make_constant(non_const, 1);
+      one_.store(one, std::memory_order_release);
     }
 
-    return one_;
+    return one;
   }
 
   return context_->make_constant(non_const, constant);
@@ -141,11 +147,13 @@ Constant* Type::one() const {
 }
 
 Undef* Type::undef() const {
-  if (!undef_) {
-    undef_ = context_->make_undef(const_cast<Type*>(this));
+  auto undef = undef_.load(std::memory_order_acquire);
+  if (!undef) {
+    undef = context_->make_undef(const_cast<Type*>(this));
+    undef_.store(undef, std::memory_order_release);
   }
 
-  return undef_;
+  return undef;
 }
 
 bool Type::is_arithmetic() const {
@@ -2,6 +2,7 @@
 #include <Flugzeug/Core/Casting.hpp>
 #include <Flugzeug/Core/ClassTraits.hpp>
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -31,11 +32,13 @@ class Type {
   const Kind kind_;
   Context* const context_;
 
-  mutable PointerType* pointer_to_this = nullptr;
+  // Caches are atomic because types are shared between threads. Racing threads will get the same
+  // interned values from the context so it doesn't matter which one stores the result.
+  mutable std::atomic<PointerType*> pointer_to_this = nullptr;
 
-  mutable Constant* zero_ = nullptr;
-  mutable Constant* one_ = nullptr;
-  mutable Undef* undef_ = nullptr;
+  mutable std::atomic<Constant*> zero_ = nullptr;
+  mutable std::atomic<Constant*> one_ = nullptr;
+  mutable std::atomic<Undef*> undef_ = nullptr;
 
  protected:
   Type(Context* context, Kind kind);
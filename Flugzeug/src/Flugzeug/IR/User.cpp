@@ -140,6 +140,8 @@ void User::set_operand(size_t index, Value* operand) {
   }
 
   used_operands[index] = operand;
+
+  on_modified();
 }
 
 bool User::uses_value(Value* value) const {
@@ -59,6 +59,10 @@ class User : public Value {
  protected:
   using Value::Value;
 
+  /// Called after operands change. Virtual dispatch makes this a no-op when called from the
+  /// destructor.
+  virtual void on_modified() {}
+
   void remove_phi_incoming_helper(size_t incoming_index);
 
   void adjust_uses_count(size_t count);
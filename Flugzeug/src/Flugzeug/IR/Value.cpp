@@ -14,6 +14,16 @@ void Value::set_user_operand(User* user, size_t operand_index, Value* value) {
 }
 
 void Value::add_use(detail::Use* use) {
+  // Global values are shared between functions which may be optimized in parallel.
+  if (is_global()) {
+    std::lock_guard lock(context_->global_value_uses_mutex(this));
+
+    uses.add_use(use);
+    user_count_excluding_self_++;
+
+    return;
+  }
+
   uses.add_use(use);
 
   if (use->user() != this) {
@@ -26,6 +36,15 @@ void Value::add_use(detail::Use* use) {
 }
 
 void Value::remove_use(detail::Use* use) {
+  if (is_global()) {
+    std::lock_guard lock(context_->global_value_uses_mutex(this));
+
+    uses.remove_use(use);
+    user_count_excluding_self_--;
+
+    return;
+  }
+
   uses.remove_use(use);
 
   if (use->user() != this) {
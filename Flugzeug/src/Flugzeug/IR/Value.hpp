@@ -9,6 +9,7 @@
 #include <Flugzeug/Core/Error.hpp>
 #include <Flugzeug/Core/Iterator.hpp>
 
+#include <limits>
 #include <optional>
 #include <string>
 #include <vector>
@@ -51,6 +52,7 @@ class Value {
 
  private:
   friend class User;
+  friend class Function;
 
   const Kind kind_;
 
@@ -62,6 +64,10 @@ class Value {
 
   size_t display_index_ = 0;
 
+  /// Stable dense index inside the function (see `ValueMap`). Unlike display index it doesn't
+  /// change when the value is moved or when indices are reassigned for printing.
+  size_t dense_index_ = invalid_dense_index;
+
   static Block* cast_to_block(Value* value);
   static void set_user_operand(User* user, size_t operand_index, Value* value);
 
@@ -75,6 +81,8 @@ class Value {
   Value(Context* context, Kind kind, Type* type);
 
  public:
+  constexpr static size_t invalid_dense_index = std::numeric_limits<size_t>::max();
+
   CLASS_NON_MOVABLE_NON_COPYABLE(Value);
 
   virtual ~Value();
@@ -89,6 +97,11 @@ class Value {
   size_t display_index() const { return display_index_; }
   void set_display_index(size_t index);
 
+  /// Only parameters, blocks and instructions which are part of a function have an index.
+  /// Blocks and other values use separate index spaces.
+  size_t dense_index() const { return dense_index_; }
+  bool has_dense_index() const { return dense_index_ != invalid_dense_index; }
+
   bool is_void() const { return type()->is_void(); }
   bool is_global() const {
     return kind_ == Kind::Undef || kind_ == Kind::Function || kind_ == Kind::Constant;
@@ -0,0 +1,32 @@
+#include "ValueMap.hpp"
+
+using namespace flugzeug;
+
+BlockSet::BlockSet(const Function* function)
+    : function(function), bits(function->block_index_capacity()) {}
+
+bool BlockSet::insert(const Block* block) {
+  verify(block->function() == function, "Block doesn't belong to the function of the set");
+
+  if (bits.insert(block->dense_index())) {
+    size_++;
+    return true;
+  }
+
+  return false;
+}
+
+bool BlockSet::erase(const Block* block) {
+  if (contains(block)) {
+    bits.erase(block->dense_index());
+    size_--;
+    return true;
+  }
+
+  return false;
+}
+
+bool BlockSet::contains(const Block* block) const {
+  return block->has_dense_index() && bits.contains(block->dense_index()) &&
+         function->block_by_index(block->dense_index()) == block;
+}
@@ -0,0 +1,252 @@
+#pragma once
+#include "Block.hpp"
+#include "Function.hpp"
+#include "Value.hpp"
+
+#include <Flugzeug/Core/DenseBitSet.hpp>
+#include <Flugzeug/Core/Error.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flugzeug {
+
+namespace detail {
+
+/// Map from values of a single function to `T` which is indexed by their dense index. Every
+/// slot remembers its key so lookups of values which reused an index of a destroyed value
+/// don't return stale entries.
+template <typename TKey, typename T>
+class DenseValueMap {
+  using Entry = std::pair<const TKey*, T>;
+
+  std::vector<Entry> entries;
+  size_t size_ = 0;
+
+  static size_t index_capacity(const Function* function) {
+    if constexpr (std::is_same_v<TKey, Block>) {
+      return function->block_index_capacity();
+    } else {
+      return function->value_index_capacity();
+    }
+  }
+
+  Entry* find_entry(const TKey* key) {
+    const auto index = key->dense_index();
+    if (index >= entries.size() || entries[index].first != key) {
+      return nullptr;
+    }
+
+    return &entries[index];
+  }
+
+  const Entry* find_entry(const TKey* key) const {
+    return const_cast<DenseValueMap*>(this)->find_entry(key);
+  }
+
+  Entry& get_or_create_entry(const TKey* key, bool& created) {
+    verify(key->has_dense_index(), "Value doesn't have a dense index");
+
+    const auto index = key->dense_index();
+    if (index >= entries.size()) {
+      entries.resize(index + 1);
+    }
+
+    auto& entry = entries[index];
+
+    created = entry.first != key;
+    if (created) {
+      entry = Entry{key, T{}};
+      size_++;
+    }
+
+    return entry;
+  }
+
+ public:
+  class ConstIterator {
+    const Entry* current;
+    const Entry* end;
+
+    void skip_empty() {
+      while (current != end && !current->first) {
+        ++current;
+      }
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = Entry;
+    using pointer = const Entry*;
+    using reference = const Entry&;
+
+    ConstIterator(const Entry* current, const Entry* end) : current(current), end(end) {
+      skip_empty();
+    }
+
+    ConstIterator& operator++() {
+      ++current;
+      skip_empty();
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      const auto before = *this;
+      ++(*this);
+      return before;
+    }
+
+    reference operator*() const { return *current; }
+    pointer operator->() const { return current; }
+
+    bool operator==(const ConstIterator& rhs) const { return current == rhs.current; }
+    bool operator!=(const ConstIterator& rhs) const { return !(*this == rhs); }
+  };
+
+  DenseValueMap() = default;
+  explicit DenseValueMap(const Function* function) { reserve(index_capacity(function)); }
+
+  void reserve(size_t capacity) {
+    if (capacity > entries.size()) {
+      entries.resize(capacity);
+    }
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void clear() {
+    std::fill(entries.begin(), entries.end(), Entry{});
+    size_ = 0;
+  }
+
+  bool contains(const TKey* key) const { return find_entry(key) != nullptr; }
+
+  /// Returns null if the key isn't present.
+  T* find(const TKey* key) {
+    const auto entry = find_entry(key);
+    return entry ? &entry->second : nullptr;
+  }
+  const T* find(const TKey* key) const {
+    const auto entry = find_entry(key);
+    return entry ? &entry->second : nullptr;
+  }
+
+  /// Doesn't overwrite existing value. Returns false if the key was already present.
+  bool insert(const TKey* key, T value) {
+    bool created;
+    auto& entry = get_or_create_entry(key, created);
+    if (created) {
+      entry.second = std::move(value);
+    }
+
+    return created;
+  }
+
+  T& operator[](const TKey* key) {
+    bool created;
+    return get_or_create_entry(key, created).second;
+  }
+
+  /// Returns true if the key was present.
+  bool erase(const TKey* key) {
+    const auto entry = find_entry(key);
+    if (!entry) {
+      return false;
+    }
+
+    *entry = Entry{};
+    size_--;
+
+    return true;
+  }
+
+  ConstIterator begin() const { return {entries.data(), entries.data() + entries.size()}; }
+  ConstIterator end() const {
+    return {entries.data() + entries.size(), entries.data() + entries.size()};
+  }
+};
+
+}  // namespace detail
+
+/// Side table for parameters and instructions of a single function.
+template <typename T>
+using ValueMap = detail::DenseValueMap<Value, T>;
+
+/// Side table for blocks of a single function.
+template <typename T>
+using BlockMap = detail::DenseValueMap<Block, T>;
+
+/// Set of blocks of a single function stored as a bit vector. Blocks are iterated in the order
+/// of their dense indices.
+class BlockSet {
+  const Function* function = nullptr;
+  DenseBitSet bits;
+  size_t size_ = 0;
+
+ public:
+  class Iterator {
+    const Function* function;
+    DenseBitSet::Iterator iterator;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = Block*;
+    using pointer = Block* const*;
+    using reference = Block*;
+
+    Iterator(const Function* function, DenseBitSet::Iterator iterator)
+        : function(function), iterator(iterator) {}
+
+    Iterator& operator++() {
+      ++iterator;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      const auto before = *this;
+      ++(*this);
+      return before;
+    }
+
+    Block* operator*() const { return function->block_by_index(*iterator); }
+
+    bool operator==(const Iterator& rhs) const { return iterator == rhs.iterator; }
+    bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
+  };
+
+  BlockSet() = default;
+  explicit BlockSet(const Function* function);
+
+  template <typename TIterator>
+  BlockSet(const Function* function, TIterator begin, TIterator end) : BlockSet(function) {
+    for (auto it = begin; it != end; ++it) {
+      insert(*it);
+    }
+  }
+
+  /// Returns true if the block wasn't present before.
+  bool insert(const Block* block);
+  /// Returns true if the block was present before.
+  bool erase(const Block* block);
+
+  bool contains(const Block* block) const;
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void clear() {
+    bits.clear();
+    size_ = 0;
+  }
+
+  Iterator begin() const { return {function, bits.begin()}; }
+  Iterator end() const { return {function, bits.end()}; }
+};
+
+}  // namespace flugzeug
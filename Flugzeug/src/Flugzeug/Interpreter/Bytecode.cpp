@@ -0,0 +1,479 @@
+#include "Bytecode.hpp"
+
+#include <Flugzeug/Core/Log.hpp>
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionVisitor.hpp>
+#include <Flugzeug/IR/Module.hpp>
+
+#include <Flugzeug/CodeGeneration/RegAlloc/RegisterAllocation.hpp>
+
+#include <limits>
+#include <unordered_map>
+
+using namespace flugzeug;
+
+std::string_view flugzeug::stringify_bytecode_opcode(BytecodeOpcode opcode) {
+  switch (opcode) {
+#define FLUGZEUG_BYTECODE_STRINGIFY_ENTRY(name) \
+  case BytecodeOpcode::name:                    \
+    return #name;
+    FLUGZEUG_BYTECODE_OPCODES(FLUGZEUG_BYTECODE_STRINGIFY_ENTRY)
+#undef FLUGZEUG_BYTECODE_STRINGIFY_ENTRY
+  }
+
+  unreachable();
+}
+
+/// i1 values are stored in memory as a single byte.
+static size_t memory_size(const Type* type) {
+  return type->is_i1() ? 1 : type->byte_size();
+}
+
+/// Offset of the width variant within a group of opcodes created by `FLUGZEUG_BYTECODE_WIDTHS`.
+/// i1 values are processed by 8 bit opcodes.
+static uint32_t width_index(const Type* type) {
+  switch (type->bit_size()) {
+    case 1:
+    case 8:
+      return 0;
+    case 16:
+      return 1;
+    case 32:
+      return 2;
+    case 64:
+      return 3;
+    default:
+      unreachable();
+  }
+}
+
+static BytecodeOpcode with_width(BytecodeOpcode opcode8, const Type* type) {
+  return BytecodeOpcode(uint32_t(opcode8) + width_index(type));
+}
+
+static uint32_t to_u32(size_t value) {
+  verify(value <= std::numeric_limits<uint32_t>::max(), "Bytecode operand is too large");
+  return uint32_t(value);
+}
+
+class FunctionLowering : public ConstInstructionVisitor {
+  const AllocatedRegisters& registers;
+  const std::unordered_map<const Function*, uint32_t>& function_indices;
+  const std::unordered_map<const Function*, uint32_t>& extern_indices;
+
+  BytecodeFunction& output;
+
+  std::unordered_map<const Value*, uint32_t> parameter_slots;
+  std::unordered_map<uint64_t, uint32_t> constant_slots;
+
+  uint32_t register_base = 0;
+  uint32_t scratch_slot = 0;
+
+  /// Block that is emitted right after the current one, branches to it fall through.
+  const Block* next_block = nullptr;
+
+  void emit(BytecodeOpcode opcode, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0) {
+    output.instructions.push_back(BytecodeInstruction{opcode, a, b, c, d});
+  }
+
+  void emit_move(uint32_t destination, uint32_t source) {
+    if (destination != source) {
+      emit(BytecodeOpcode::Move, destination, source);
+    }
+  }
+
+  uint32_t constant_slot(uint64_t value) {
+    const auto [it, inserted] =
+      constant_slots.try_emplace(value, to_u32(output.constant_base + output.constants.size()));
+    if (inserted) {
+      output.constants.push_back(value);
+    }
+
+    return it->second;
+  }
+
+  uint32_t slot(const Value* value) {
+    switch (value->kind()) {
+      case Value::Kind::Constant:
+        return constant_slot(cast<Constant>(value)->value_u());
+      case Value::Kind::Undef:
+        return constant_slot(0);
+      case Value::Kind::Parameter:
+        return parameter_slots.at(value);
+      default: {
+        const auto instruction = cast<Instruction>(value);
+        verify(instruction, "Unexpected bytecode operand");
+        return register_base + registers.register_for_instruction(instruction);
+      }
+    }
+  }
+
+  uint32_t destination(const Instruction* instruction) const {
+    if (registers.has_register(instruction)) {
+      return register_base + registers.register_for_instruction(instruction);
+    }
+
+    return scratch_slot;
+  }
+
+ public:
+  FunctionLowering(const Function* function,
+                   const AllocatedRegisters& registers,
+                   const std::unordered_map<const Function*, uint32_t>& function_indices,
+                   const std::unordered_map<const Function*, uint32_t>& extern_indices,
+                   BytecodeFunction& output)
+      : registers(registers),
+        function_indices(function_indices),
+        extern_indices(extern_indices),
+        output(output) {
+    output.name = function->name();
+    output.parameter_count = to_u32(function->parameter_count());
+
+    for (size_t i = 0; i < function->parameter_count(); ++i) {
+      const auto parameter = function->parameter(i);
+      parameter_slots.insert({parameter, uint32_t(i)});
+      output.parameter_masks.push_back(parameter->type()->bit_mask());
+    }
+
+    register_base = output.parameter_count;
+    scratch_slot = to_u32(register_base + registers.register_count());
+    output.constant_base = scratch_slot + 1;
+  }
+
+  void lower(const Function* function) {
+    // Branches are emitted with dense block indices as targets and resolved when the whole
+    // function is laid out.
+    std::vector<uint32_t> block_offsets(function->block_index_capacity());
+
+    for (const Block& block : *function) {
+      block_offsets[block.dense_index()] = to_u32(output.instructions.size());
+      next_block = block.next();
+
+      for (const Instruction& instruction : block) {
+        visitor::visit_instruction(&instruction, *this);
+      }
+    }
+
+    for (auto& instruction : output.instructions) {
+      switch (instruction.opcode) {
+        case BytecodeOpcode::Branch:
+          instruction.a = block_offsets[instruction.a];
+          break;
+        case BytecodeOpcode::BranchIf:
+        case BytecodeOpcode::BranchIfNot:
+          instruction.b = block_offsets[instruction.b];
+          break;
+        default:
+          break;
+      }
+    }
+
+    output.slot_count = to_u32(output.constant_base + output.constants.size());
+  }
+
+  void visit_unary_instr(Argument<UnaryInstr> unary) {
+    const auto type = unary->type();
+    const auto base = unary->op() == UnaryOp::Neg ? BytecodeOpcode::Neg8 : BytecodeOpcode::Not8;
+    const auto result = destination(unary);
+
+    emit(with_width(base, type), result, slot(unary->value()));
+
+    if (type->is_i1()) {
+      emit(BytecodeOpcode::And1, result, result);
+    }
+  }
+
+  void visit_binary_instr(Argument<BinaryInstr> binary) {
+    const auto type = binary->type();
+    const auto result = destination(binary);
+
+    // Register allocation copies Phi incoming values using `add x, 0`.
+    if (binary->op() == BinaryOp::Add && binary->rhs()->is_zero()) {
+      emit_move(result, slot(binary->lhs()));
+      return;
+    }
+
+    BytecodeOpcode opcode;
+    bool sized = true;
+
+    switch (binary->op()) {
+      // clang-format off
+      case BinaryOp::Add:  opcode = BytecodeOpcode::Add8; break;
+      case BinaryOp::Sub:  opcode = BytecodeOpcode::Sub8; break;
+      case BinaryOp::Mul:  opcode = BytecodeOpcode::Mul8; break;
+      case BinaryOp::DivS: opcode = BytecodeOpcode::DivS8; break;
+      case BinaryOp::ModS: opcode = BytecodeOpcode::ModS8; break;
+      case BinaryOp::Shr:  opcode = BytecodeOpcode::Shr8; break;
+      case BinaryOp::Shl:  opcode = BytecodeOpcode::Shl8; break;
+      case BinaryOp::Sar:  opcode = BytecodeOpcode::Sar8; break;
+      case BinaryOp::DivU: opcode = BytecodeOpcode::DivU; sized = false; break;
+      case BinaryOp::ModU: opcode = BytecodeOpcode::ModU; sized = false; break;
+      case BinaryOp::And:  opcode = BytecodeOpcode::And; sized = false; break;
+      case BinaryOp::Or:   opcode = BytecodeOpcode::Or; sized = false; break;
+      case BinaryOp::Xor:  opcode = BytecodeOpcode::Xor; sized = false; break;
+      default: unreachable();
+        // clang-format on
+    }
+
+    emit(sized ? with_width(opcode, type) : opcode, result, slot(binary->lhs()),
+         slot(binary->rhs()));
+
+    if (sized && type->is_i1()) {
+      emit(BytecodeOpcode::And1, result, result);
+    }
+  }
+
+  void visit_int_compare(Argument<IntCompare> int_compare) {
+    const auto type = int_compare->lhs()->type();
+    auto lhs = slot(int_compare->lhs());
+    auto rhs = slot(int_compare->rhs());
+
+    const auto predicate = int_compare->predicate();
+
+    if (predicate == IntPredicate::Equal || predicate == IntPredicate::NotEqual) {
+      emit(predicate == IntPredicate::Equal ? BytecodeOpcode::Equal : BytecodeOpcode::NotEqual,
+           destination(int_compare), lhs, rhs);
+      return;
+    }
+
+    // Greater-than predicates are emitted as less-than predicates with swapped operands.
+    bool is_signed = false;
+    bool or_equal = false;
+    bool swap = false;
+
+    switch (predicate) {
+      // clang-format off
+      case IntPredicate::GtU:  swap = true; break;
+      case IntPredicate::GteU: swap = true; or_equal = true; break;
+      case IntPredicate::GtS:  swap = true; is_signed = true; break;
+      case IntPredicate::GteS: swap = true; is_signed = true; or_equal = true; break;
+      case IntPredicate::LtU:  break;
+      case IntPredicate::LteU: or_equal = true; break;
+      case IntPredicate::LtS:  is_signed = true; break;
+      case IntPredicate::LteS: is_signed = true; or_equal = true; break;
+      default: unreachable();
+        // clang-format on
+    }
+
+    // Signed i1 values are 0 and -1, so their signed order is reverse of the unsigned one.
+    if (is_signed && type->is_i1()) {
+      is_signed = false;
+      swap = !swap;
+    }
+
+    if (swap) {
+      std::swap(lhs, rhs);
+    }
+
+    BytecodeOpcode opcode;
+    if (is_signed) {
+      opcode = with_width(or_equal ? BytecodeOpcode::LteS8 : BytecodeOpcode::LtS8, type);
+    } else {
+      opcode = or_equal ? BytecodeOpcode::LteU : BytecodeOpcode::LtU;
+    }
+
+    emit(opcode, destination(int_compare), lhs, rhs);
+  }
+
+  void visit_load(Argument<Load> load) {
+    emit(with_width(BytecodeOpcode::Load8, load->type()), destination(load), slot(load->address()));
+  }
+
+  void visit_store(Argument<Store> store) {
+    emit(with_width(BytecodeOpcode::Store8, store->value()->type()), slot(store->address()),
+         slot(store->value()));
+  }
+
+  void visit_call(Argument<Call> call) {
+    const auto callee = call->callee();
+    const auto arguments_offset = to_u32(output.call_arguments.size());
+
+    for (size_t i = 0; i < call->argument_count(); ++i) {
+      output.call_arguments.push_back(slot(call->argument(i)));
+    }
+
+    const auto argument_count = to_u32(call->argument_count());
+
+    if (callee->is_extern()) {
+      emit(BytecodeOpcode::CallHost, destination(call), extern_indices.at(callee),
+           arguments_offset, argument_count);
+    } else {
+      emit(BytecodeOpcode::Call, destination(call), function_indices.at(callee), arguments_offset,
+           argument_count);
+    }
+  }
+
+  void visit_branch(Argument<Branch> branch) {
+    if (branch->target() != next_block) {
+      emit(BytecodeOpcode::Branch, to_u32(branch->target()->dense_index()));
+    }
+  }
+
+  void visit_cond_branch(Argument<CondBranch> cond_branch) {
+    const auto condition = slot(cond_branch->condition());
+    const auto true_target = cond_branch->true_target();
+    const auto false_target = cond_branch->false_target();
+
+    if (true_target == false_target) {
+      if (true_target != next_block) {
+        emit(BytecodeOpcode::Branch, to_u32(true_target->dense_index()));
+      }
+      return;
+    }
+
+    if (true_target == next_block) {
+      emit(BytecodeOpcode::BranchIfNot, condition, to_u32(false_target->dense_index()));
+      return;
+    }
+
+    emit(BytecodeOpcode::BranchIf, condition, to_u32(true_target->dense_index()));
+
+    if (false_target != next_block) {
+      emit(BytecodeOpcode::Branch, to_u32(false_target->dense_index()));
+    }
+  }
+
+  void visit_stackalloc(Argument<StackAlloc> stackalloc) {
+    const auto size = memory_size(stackalloc->allocated_type()) * stackalloc->size();
+    emit(BytecodeOpcode::StackAlloc, destination(stackalloc), to_u32(size));
+  }
+
+  void visit_ret(Argument<Ret> ret) {
+    if (ret->returns_void()) {
+      emit(BytecodeOpcode::RetVoid);
+    } else {
+      emit(BytecodeOpcode::Ret, slot(ret->return_value()));
+    }
+  }
+
+  void visit_offset(Argument<Offset> offset) {
+    const auto element_size = memory_size(cast<PointerType>(offset->type())->deref());
+    const auto index_type = offset->index()->type();
+
+    auto index = slot(offset->index());
+    auto opcode = BytecodeOpcode::Offset64;
+
+    if (index_type->is_i1()) {
+      emit(BytecodeOpcode::SignExtend1, scratch_slot, index, 64);
+      index = scratch_slot;
+    } else {
+      opcode = with_width(BytecodeOpcode::Offset8, index_type);
+    }
+
+    emit(opcode, destination(offset), slot(offset->base()), index, to_u32(element_size));
+  }
+
+  void visit_cast(Argument<Cast> cast) {
+    const auto from_type = cast->casted_value()->type();
+    const auto to_type = cast->type();
+    const auto result = destination(cast);
+    const auto value = slot(cast->casted_value());
+
+    switch (cast->cast_kind()) {
+      case CastKind::ZeroExtend:
+      case CastKind::Bitcast:
+        emit_move(result, value);
+        break;
+
+      case CastKind::Truncate: {
+        switch (to_type->bit_size()) {
+          // clang-format off
+          case 1:  emit(BytecodeOpcode::Truncate1, result, value); break;
+          case 8:  emit(BytecodeOpcode::Truncate8, result, value); break;
+          case 16: emit(BytecodeOpcode::Truncate16, result, value); break;
+          case 32: emit(BytecodeOpcode::Truncate32, result, value); break;
+          default: emit_move(result, value); break;
+            // clang-format on
+        }
+        break;
+      }
+
+      case CastKind::SignExtend: {
+        BytecodeOpcode opcode;
+        switch (from_type->bit_size()) {
+          // clang-format off
+          case 1:  opcode = BytecodeOpcode::SignExtend1; break;
+          case 8:  opcode = BytecodeOpcode::SignExtend8; break;
+          case 16: opcode = BytecodeOpcode::SignExtend16; break;
+          case 32: opcode = BytecodeOpcode::SignExtend32; break;
+          default: unreachable();
+            // clang-format on
+        }
+
+        emit(opcode, result, value, to_u32(to_type->bit_size()));
+        break;
+      }
+
+      default:
+        unreachable();
+    }
+  }
+
+  void visit_select(Argument<Select> select) {
+    emit(BytecodeOpcode::Select, destination(select), slot(select->condition()),
+         slot(select->true_value()), slot(select->false_value()));
+  }
+
+  void visit_phi(Argument<Phi>) {
+    // Phis share the register with all their incoming values so they don't need any code.
+  }
+};
+
+size_t BytecodeModule::find_function(std::string_view name) const {
+  for (size_t i = 0; i < functions.size(); ++i) {
+    if (functions[i].name == name) {
+      return i;
+    }
+  }
+
+  return size_t(-1);
+}
+
+void BytecodeModule::debug_print() const {
+  for (const auto& function : functions) {
+    log_debug("{}: {} parameters, {} slots, {} constants", function.name,
+              function.parameter_count, function.slot_count, function.constants.size());
+
+    for (size_t i = 0; i < function.instructions.size(); ++i) {
+      const auto& instruction = function.instructions[i];
+      log_debug("{:>6}: {:<14} {:>6} {:>6} {:>6} {:>6}", i,
+                stringify_bytecode_opcode(instruction.opcode), instruction.a, instruction.b,
+                instruction.c, instruction.d);
+    }
+
+    log_debug("");
+  }
+}
+
+BytecodeModule flugzeug::lower_to_bytecode(Module* module) {
+  BytecodeModule bytecode;
+
+  std::unordered_map<const Function*, uint32_t> function_indices;
+  std::unordered_map<const Function*, uint32_t> extern_indices;
+
+  for (const Function& function : module->local_functions()) {
+    function_indices.insert({&function, to_u32(function_indices.size())});
+  }
+
+  for (const Function& function : module->extern_functions()) {
+    extern_indices.insert({&function, to_u32(bytecode.extern_functions.size())});
+    bytecode.extern_functions.push_back(BytecodeExternFunction{
+      .name = std::string(function.name()),
+      .return_mask = function.return_type()->is_void() ? 0 : function.return_type()->bit_mask(),
+    });
+  }
+
+  bytecode.functions.resize(function_indices.size());
+
+  for (Function& function : module->local_functions()) {
+    const auto registers = allocate_registers(&function);
+
+    auto& output = bytecode.functions[function_indices.at(&function)];
+    FunctionLowering lowering(&function, registers, function_indices, extern_indices, output);
+    lowering.lower(&function);
+  }
+
+  return bytecode;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace flugzeug {
+
+class Module;
+
+#define FLUGZEUG_BYTECODE_WIDTHS(X, name) X(name##8) X(name##16) X(name##32) X(name##64)
+
+/// Opcodes suffixed with a width operate on values of that bit size. All slot values are kept
+/// zero extended to 64 bits so opcodes which don't depend on the width have a single variant.
+#define FLUGZEUG_BYTECODE_OPCODES(X)      \
+  X(Move)                                 \
+  X(And1)                                 \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Neg)        \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Not)        \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Add)        \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Sub)        \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Mul)        \
+  X(DivU)                                 \
+  X(ModU)                                 \
+  FLUGZEUG_BYTECODE_WIDTHS(X, DivS)       \
+  FLUGZEUG_BYTECODE_WIDTHS(X, ModS)       \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Shr)        \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Shl)        \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Sar)        \
+  X(And)                                  \
+  X(Or)                                   \
+  X(Xor)                                  \
+  X(Equal)                                \
+  X(NotEqual)                             \
+  X(LtU)                                  \
+  X(LteU)                                 \
+  FLUGZEUG_BYTECODE_WIDTHS(X, LtS)        \
+  FLUGZEUG_BYTECODE_WIDTHS(X, LteS)       \
+  X(SignExtend1)                          \
+  X(SignExtend8)                          \
+  X(SignExtend16)                         \
+  X(SignExtend32)                         \
+  X(Truncate1)                            \
+  X(Truncate8)                            \
+  X(Truncate16)                           \
+  X(Truncate32)                           \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Load)       \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Store)      \
+  FLUGZEUG_BYTECODE_WIDTHS(X, Offset)     \
+  X(Select)                               \
+  X(StackAlloc)                           \
+  X(Branch)                               \
+  X(BranchIf)                             \
+  X(BranchIfNot)                          \
+  X(Call)                                 \
+  X(CallHost)                             \
+  X(Ret)                                  \
+  X(RetVoid)
+
+enum class BytecodeOpcode : uint32_t {
+#define FLUGZEUG_BYTECODE_ENUM_ENTRY(name) name,
+  FLUGZEUG_BYTECODE_OPCODES(FLUGZEUG_BYTECODE_ENUM_ENTRY)
+#undef FLUGZEUG_BYTECODE_ENUM_ENTRY
+};
+
+std::string_view stringify_bytecode_opcode(BytecodeOpcode opcode);
+
+/// Operands are slot indices unless noted otherwise:
+///   a = b op c                       (arithmetic, compares; unary ops and casts use only b)
+///   SignExtend: a = extend(b)        (c is the bit size of the result)
+///   Load:       a = [b]              Store:      [a] = b
+///   Offset:     a = b + c * d        (d is the element size in bytes)
+///   Select:     a = b ? c : d
+///   StackAlloc: a = allocate(b)      (b is the size in bytes)
+///   Branch:     goto a               BranchIf(Not): if (a) goto b
+///   Call(Host): a = function b with argument list c of length d
+///   Ret:        return a
+/// Branch targets are indices of instructions in the function.
+struct BytecodeInstruction {
+  BytecodeOpcode opcode;
+  uint32_t a = 0;
+  uint32_t b = 0;
+  uint32_t c = 0;
+  uint32_t d = 0;
+};
+
+/// Slot layout of a frame: parameters, allocated registers, a scratch slot which receives unused
+/// results and constants (copied to the frame on entry).
+struct BytecodeFunction {
+  std::string name;
+
+  uint32_t parameter_count = 0;
+  uint32_t constant_base = 0;
+  uint32_t slot_count = 0;
+
+  std::vector<uint64_t> parameter_masks;
+  std::vector<uint64_t> constants;
+
+  std::vector<BytecodeInstruction> instructions;
+
+  /// Slot indices of call arguments referenced by Call and CallHost.
+  std::vector<uint32_t> call_arguments;
+};
+
+struct BytecodeExternFunction {
+  std::string name;
+  uint64_t return_mask = 0;
+};
+
+struct BytecodeModule {
+  std::vector<BytecodeFunction> functions;
+  std::vector<BytecodeExternFunction> extern_functions;
+
+  /// Returns index of the local function or `size_t(-1)` if it doesn't exist.
+  size_t find_function(std::string_view name) const;
+
+  void debug_print() const;
+};
+
+/// Lowers all local functions of the module to bytecode. Register allocation is performed on
+/// every function which modifies the IR (see `allocate_registers`).
+BytecodeModule lower_to_bytecode(Module* module);
+
+}  // namespace flugzeug
@@ -0,0 +1,436 @@
+#include "BytecodeInterpreter.hpp"
+
+#include <Flugzeug/Core/Error.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+using namespace flugzeug;
+
+constexpr size_t stack_alignment = 16;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FLUGZEUG_COMPUTED_GOTO
+#endif
+
+static void load_constants(const BytecodeFunction* function, uint64_t* frame) {
+  std::copy(function->constants.begin(), function->constants.end(),
+            frame + function->constant_base);
+}
+
+static uint64_t bit_mask(uint32_t bit_size) {
+  return bit_size >= 64 ? ~uint64_t(0) : (uint64_t(1) << bit_size) - 1;
+}
+
+template <typename T>
+static void verify_shift(uint64_t amount) {
+  constexpr auto bit_size = sizeof(T) * 8;
+  if (amount >= bit_size) {
+    fatal_error("Interpreted program shifted {}-bit value by {}.", bit_size, amount);
+  }
+}
+
+template <typename T>
+static void verify_signed_division(std::make_signed_t<T> lhs, std::make_signed_t<T> rhs) {
+  using S = std::make_signed_t<T>;
+
+  if (rhs == 0) {
+    fatal_error("Interpreted program divided by zero.");
+  }
+  if (lhs == std::numeric_limits<S>::min() && rhs == -1) {
+    fatal_error("Interpreted program overflowed signed division.");
+  }
+}
+
+BytecodeInterpreter::BytecodeInterpreter(const BytecodeModule& module,
+                                         size_t stack_size,
+                                         size_t slot_count)
+    : module(module),
+      stack(stack_size),
+      slots(slot_count),
+      host_functions(module.extern_functions.size()) {}
+
+uint64_t BytecodeInterpreter::execute(const BytecodeFunction* entry_function) {
+  const BytecodeFunction* function = entry_function;
+  const BytecodeInstruction* code = function->instructions.data();
+  const BytecodeInstruction* pc = code;
+
+  size_t frame_base = 0;
+  uint64_t* frame = slots.data() + frame_base;
+
+  uint64_t return_value = 0;
+
+  // Every handler ends with `NEXT()` or jumps by itself. With computed goto every handler has its
+  // own indirect jump to the next one which is much easier to predict than a single shared one.
+#ifdef FLUGZEUG_COMPUTED_GOTO
+  static const void* const handlers[] = {
+#define FLUGZEUG_BYTECODE_HANDLER_ADDRESS(name) &&handler_##name,
+    FLUGZEUG_BYTECODE_OPCODES(FLUGZEUG_BYTECODE_HANDLER_ADDRESS)
+#undef FLUGZEUG_BYTECODE_HANDLER_ADDRESS
+  };
+
+#define DISPATCH() goto* handlers[size_t(pc->opcode)]
+#define HANDLER(name) handler_##name:
+#else
+#define DISPATCH() goto dispatch
+#define HANDLER(name) case BytecodeOpcode::name:
+#endif
+
+#define NEXT() \
+  ++pc;        \
+  DISPATCH()
+
+#define SIZED_HANDLERS(name, ...)   \
+  HANDLER(name##8) {                \
+    using T = uint8_t;              \
+    __VA_ARGS__                     \
+  }                                 \
+  HANDLER(name##16) {               \
+    using T = uint16_t;             \
+    __VA_ARGS__                     \
+  }                                 \
+  HANDLER(name##32) {               \
+    using T = uint32_t;             \
+    __VA_ARGS__                     \
+  }                                 \
+  HANDLER(name##64) {               \
+    using T = uint64_t;             \
+    __VA_ARGS__                     \
+  }
+
+#define A frame[pc->a]
+#define B frame[pc->b]
+#define C frame[pc->c]
+#define SIGNED(value) std::make_signed_t<T>(T(value))
+
+#ifdef FLUGZEUG_COMPUTED_GOTO
+  DISPATCH();
+#else
+dispatch:
+  switch (pc->opcode) {
+#endif
+
+  HANDLER(Move) {
+    A = B;
+    NEXT();
+  }
+  HANDLER(And1) {
+    A = B & 1;
+    NEXT();
+  }
+
+  SIZED_HANDLERS(Neg, A = T(0 - B); NEXT();)
+  SIZED_HANDLERS(Not, A = T(~B); NEXT();)
+  SIZED_HANDLERS(Add, A = T(B + C); NEXT();)
+  SIZED_HANDLERS(Sub, A = T(B - C); NEXT();)
+  SIZED_HANDLERS(Mul, A = T(B * C); NEXT();)
+
+  HANDLER(DivU) {
+    if (C == 0) {
+      fatal_error("Interpreted program divided by zero.");
+    }
+    A = B / C;
+    NEXT();
+  }
+  HANDLER(ModU) {
+    if (C == 0) {
+      fatal_error("Interpreted program divided by zero.");
+    }
+    A = B % C;
+    NEXT();
+  }
+
+  SIZED_HANDLERS(DivS, {
+    verify_signed_division<T>(SIGNED(B), SIGNED(C));
+    A = T(SIGNED(B) / SIGNED(C));
+    NEXT();
+  })
+  SIZED_HANDLERS(ModS, {
+    verify_signed_division<T>(SIGNED(B), SIGNED(C));
+    A = T(SIGNED(B) % SIGNED(C));
+    NEXT();
+  })
+
+  SIZED_HANDLERS(Shr, {
+    verify_shift<T>(C);
+    A = B >> C;
+    NEXT();
+  })
+  SIZED_HANDLERS(Shl, {
+    verify_shift<T>(C);
+    A = T(B << C);
+    NEXT();
+  })
+  SIZED_HANDLERS(Sar, {
+    verify_shift<T>(C);
+    A = T(SIGNED(B) >> C);
+    NEXT();
+  })
+
+  HANDLER(And) {
+    A = B & C;
+    NEXT();
+  }
+  HANDLER(Or) {
+    A = B | C;
+    NEXT();
+  }
+  HANDLER(Xor) {
+    A = B ^ C;
+    NEXT();
+  }
+
+  HANDLER(Equal) {
+    A = B == C;
+    NEXT();
+  }
+  HANDLER(NotEqual) {
+    A = B != C;
+    NEXT();
+  }
+  HANDLER(LtU) {
+    A = B < C;
+    NEXT();
+  }
+  HANDLER(LteU) {
+    A = B <= C;
+    NEXT();
+  }
+  SIZED_HANDLERS(LtS, A = SIGNED(B) < SIGNED(C); NEXT();)
+  SIZED_HANDLERS(LteS, A = SIGNED(B) <= SIGNED(C); NEXT();)
+
+  HANDLER(SignExtend1) {
+    A = (0 - (B & 1)) & bit_mask(pc->c);
+    NEXT();
+  }
+  HANDLER(SignExtend8) {
+    A = uint64_t(int64_t(int8_t(B))) & bit_mask(pc->c);
+    NEXT();
+  }
+  HANDLER(SignExtend16) {
+    A = uint64_t(int64_t(int16_t(B))) & bit_mask(pc->c);
+    NEXT();
+  }
+  HANDLER(SignExtend32) {
+    A = uint64_t(int64_t(int32_t(B))) & bit_mask(pc->c);
+    NEXT();
+  }
+
+  HANDLER(Truncate1) {
+    A = B & 1;
+    NEXT();
+  }
+  HANDLER(Truncate8) {
+    A = uint8_t(B);
+    NEXT();
+  }
+  HANDLER(Truncate16) {
+    A = uint16_t(B);
+    NEXT();
+  }
+  HANDLER(Truncate32) {
+    A = uint32_t(B);
+    NEXT();
+  }
+
+  SIZED_HANDLERS(Load, {
+    T value;
+    std::memcpy(&value, memory(B, sizeof(T)), sizeof(T));
+    A = value;
+    NEXT();
+  })
+  SIZED_HANDLERS(Store, {
+    const T value = T(B);
+    std::memcpy(memory(A, sizeof(T)), &value, sizeof(T));
+    NEXT();
+  })
+  SIZED_HANDLERS(Offset, {
+    A = B + uint64_t(int64_t(SIGNED(C))) * pc->d;
+    NEXT();
+  })
+
+  HANDLER(Select) {
+    A = B ? C : frame[pc->d];
+    NEXT();
+  }
+
+  HANDLER(StackAlloc) {
+    A = allocate_memory(pc->b);
+    NEXT();
+  }
+
+  HANDLER(Branch) {
+    pc = code + pc->a;
+    DISPATCH();
+  }
+  HANDLER(BranchIf) {
+    if (A) {
+      pc = code + pc->b;
+      DISPATCH();
+    }
+    NEXT();
+  }
+  HANDLER(BranchIfNot) {
+    if (!A) {
+      pc = code + pc->b;
+      DISPATCH();
+    }
+    NEXT();
+  }
+
+  HANDLER(Call) {
+    const auto callee = &module.functions[pc->b];
+    const auto callee_base = frame_base + function->slot_count;
+    if (callee->slot_count > slots.size() - callee_base) {
+      fatal_error("Interpreted program overflowed the slot stack.");
+    }
+
+    const auto callee_frame = slots.data() + callee_base;
+    const auto arguments = function->call_arguments.data() + pc->c;
+    for (uint32_t i = 0; i < pc->d; ++i) {
+      callee_frame[i] = frame[arguments[i]];
+    }
+    load_constants(callee, callee_frame);
+
+    call_frames.push_back(CallFrame{
+      .function = function,
+      .return_address = pc + 1,
+      .slot_base = frame_base,
+      .stack_pointer = stack_pointer,
+      .result_slot = pc->a,
+    });
+
+    function = callee;
+    code = function->instructions.data();
+    pc = code;
+    frame_base = callee_base;
+    frame = callee_frame;
+    DISPATCH();
+  }
+
+  HANDLER(CallHost) {
+    const auto& host_function = host_functions[pc->b];
+    const auto& extern_function = module.extern_functions[pc->b];
+    if (!host_function) {
+      fatal_error("Extern function `{}` has no host implementation.", extern_function.name);
+    }
+
+    const auto arguments = function->call_arguments.data() + pc->c;
+    host_arguments.clear();
+    for (uint32_t i = 0; i < pc->d; ++i) {
+      host_arguments.push_back(frame[arguments[i]]);
+    }
+
+    A = host_function(*this, host_arguments) & extern_function.return_mask;
+    NEXT();
+  }
+
+  HANDLER(Ret) {
+    return_value = A;
+    goto function_return;
+  }
+  HANDLER(RetVoid) {
+    return_value = 0;
+    goto function_return;
+  }
+
+#ifndef FLUGZEUG_COMPUTED_GOTO
+  }
+  unreachable();
+#endif
+
+function_return:
+  if (call_frames.empty()) {
+    return return_value;
+  }
+
+  {
+    const auto caller = call_frames.back();
+    call_frames.pop_back();
+
+    // Stackallocs are freed when the function returns.
+    stack_pointer = caller.stack_pointer;
+
+    function = caller.function;
+    code = function->instructions.data();
+    pc = caller.return_address;
+    frame_base = caller.slot_base;
+    frame = slots.data() + frame_base;
+
+    frame[caller.result_slot] = return_value;
+    DISPATCH();
+  }
+
+#undef DISPATCH
+#undef HANDLER
+#undef NEXT
+#undef SIZED_HANDLERS
+#undef A
+#undef B
+#undef C
+#undef SIGNED
+}
+
+void BytecodeInterpreter::register_host_function(std::string_view name, HostFunction function) {
+  for (size_t i = 0; i < module.extern_functions.size(); ++i) {
+    if (module.extern_functions[i].name == name) {
+      host_functions[i] = std::move(function);
+    }
+  }
+}
+
+uint64_t BytecodeInterpreter::run(std::string_view function_name,
+                                  std::span<const uint64_t> arguments) {
+  verify(!running, "Bytecode interpreter is not reentrant");
+
+  const auto index = module.find_function(function_name);
+  verify(index != size_t(-1), "Function `{}` doesn't exist", function_name);
+
+  const auto function = &module.functions[index];
+  verify(arguments.size() == function->parameter_count,
+         "Function `{}` called with {} arguments, expected {}", function->name, arguments.size(),
+         function->parameter_count);
+  verify(function->slot_count <= slots.size(), "Function `{}` doesn't fit in the slot stack",
+         function->name);
+
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    slots[i] = arguments[i] & function->parameter_masks[i];
+  }
+  load_constants(function, slots.data());
+
+  const auto saved_stack_pointer = stack_pointer;
+  running = true;
+  const auto result = execute(function);
+  running = false;
+  stack_pointer = saved_stack_pointer;
+
+  return result;
+}
+
+uint64_t BytecodeInterpreter::allocate_memory(size_t size) {
+  const auto aligned_size = (size + stack_alignment - 1) & ~(stack_alignment - 1);
+  if (aligned_size > stack.size() - stack_pointer) {
+    fatal_error("Interpreted program overflowed the stack.");
+  }
+
+  const auto memory = stack.data() + stack_pointer;
+  stack_pointer += aligned_size;
+
+  std::memset(memory, 0, size);
+
+  return uint64_t(memory);
+}
+
+uint8_t* BytecodeInterpreter::memory(uint64_t address, size_t size) {
+  const auto begin = uint64_t(stack.data());
+  const auto end = begin + stack_pointer;
+
+  if (address < begin || address > end || size > end - address) {
+    fatal_error("Interpreted program accessed invalid memory (address {:#x}, size {}).", address,
+                size);
+  }
+
+  return reinterpret_cast<uint8_t*>(address);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "Bytecode.hpp"
+
+#include <Flugzeug/Core/ClassTraits.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace flugzeug {
+
+/// Executes bytecode created by `lower_to_bytecode`. Calls don't recurse on the host stack, every
+/// frame is a window into a single slot stack. Memory model is the same as in `Interpreter`.
+class BytecodeInterpreter {
+ public:
+  /// Implementation of an extern function. Receives raw argument values and returns the raw
+  /// return value (ignored for void functions).
+  using HostFunction = std::function<uint64_t(BytecodeInterpreter& interpreter,
+                                              std::span<const uint64_t> arguments)>;
+
+ private:
+  struct CallFrame {
+    const BytecodeFunction* function;
+    const BytecodeInstruction* return_address;
+    size_t slot_base;
+    size_t stack_pointer;
+    uint32_t result_slot;
+  };
+
+  const BytecodeModule& module;
+
+  std::vector<uint8_t> stack;
+  size_t stack_pointer = 0;
+
+  std::vector<uint64_t> slots;
+  bool running = false;
+
+  std::vector<CallFrame> call_frames;
+  std::vector<uint64_t> host_arguments;
+
+  std::vector<HostFunction> host_functions;
+
+  uint64_t execute(const BytecodeFunction* entry_function);
+
+ public:
+  CLASS_NON_MOVABLE_NON_COPYABLE(BytecodeInterpreter)
+
+  constexpr static size_t default_stack_size = 8 * 1024 * 1024;
+  constexpr static size_t default_slot_count = 1024 * 1024;
+
+  explicit BytecodeInterpreter(const BytecodeModule& module,
+                               size_t stack_size = default_stack_size,
+                               size_t slot_count = default_slot_count);
+
+  /// Host functions registered for functions which aren't extern functions of the module are
+  /// ignored, so the same set can be registered for every module.
+  void register_host_function(std::string_view name, HostFunction function);
+
+  /// Calls the function with given raw arguments and returns its raw return value (0 for void
+  /// functions). Invalid programs cause a fatal error.
+  uint64_t run(std::string_view function_name, std::span<const uint64_t> arguments = {});
+
+  /// Allocates zeroed memory inside the interpreter stack which stays valid until the
+  /// interpreter is destroyed. Can be used to pass buffers to the interpreted program.
+  uint64_t allocate_memory(size_t size);
+
+  /// Verifies that `size` bytes starting at `address` are inside the interpreter memory and
+  /// returns host pointer to them.
+  uint8_t* memory(uint64_t address, size_t size);
+};
+
+}  // namespace flugzeug
@@ -0,0 +1,448 @@
+#include "Interpreter.hpp"
+
+#include <Flugzeug/Core/Log.hpp>
+#include <Flugzeug/Core/StringifyEnum.hpp>
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionVisitor.hpp>
+#include <Flugzeug/IR/Module.hpp>
+
+#include <Flugzeug/Passes/Utils/Evaluation.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace flugzeug;
+
+/// Protects the host stack from unbounded recursion of the interpreted program.
+constexpr size_t max_call_depth = 4096;
+constexpr size_t stack_alignment = 16;
+
+BEGIN_ENUM_STRINGIFY(stringify_instruction_kind, Value::Kind)
+ENUM_CASE(UnaryInstr)
+ENUM_CASE(BinaryInstr)
+ENUM_CASE(IntCompare)
+ENUM_CASE(Load)
+ENUM_CASE(Store)
+ENUM_CASE(Call)
+ENUM_CASE(Branch)
+ENUM_CASE(CondBranch)
+ENUM_CASE(StackAlloc)
+ENUM_CASE(Ret)
+ENUM_CASE(Offset)
+ENUM_CASE(Cast)
+ENUM_CASE(Select)
+ENUM_CASE(Phi)
+END_ENUM_STRINGIFY()
+
+/// i1 values are stored in memory as a single byte.
+static size_t memory_size(const Type* type) {
+  return type->is_i1() ? 1 : type->byte_size();
+}
+
+static uint64_t evaluate_binary(Type* type, uint64_t lhs, BinaryOp op, uint64_t rhs) {
+  const auto bit_size = type->bit_size();
+
+  switch (op) {
+    case BinaryOp::DivU:
+    case BinaryOp::ModU:
+    case BinaryOp::DivS:
+    case BinaryOp::ModS: {
+      if (rhs == 0) {
+        fatal_error("Interpreted program divided by zero.");
+      }
+
+      const auto min_signed = uint64_t(1) << (bit_size - 1);
+      if ((op == BinaryOp::DivS || op == BinaryOp::ModS) && lhs == min_signed &&
+          rhs == type->bit_mask()) {
+        fatal_error("Interpreted program overflowed signed division.");
+      }
+      break;
+    }
+
+    case BinaryOp::Shl:
+    case BinaryOp::Shr:
+    case BinaryOp::Sar:
+      if (rhs >= bit_size) {
+        fatal_error("Interpreted program shifted {}-bit value by {}.", bit_size, rhs);
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  // Arithmetic on i1 is evaluated on i8 (everything except signed division behaves the same
+  // modulo 2).
+  if (type->is_i1()) {
+    const auto i8 = type->context()->i8_ty();
+    return utils::evaluate_binary_instr(i8, lhs, op, rhs) & 1;
+  }
+
+  return utils::evaluate_binary_instr(type, lhs, op, rhs);
+}
+
+struct Interpreter::Frame : public ConstInstructionVisitor {
+  Interpreter& interpreter;
+  const Function* function;
+
+  /// Values of parameters and instructions indexed by their dense index.
+  std::vector<uint64_t> registers;
+  std::vector<uint64_t>& block_counts;
+
+  std::vector<uint64_t> phi_values;
+  std::vector<uint64_t> call_arguments;
+
+  const Block* current_block = nullptr;
+  const Block* next_block = nullptr;
+
+  bool returned = false;
+  uint64_t return_value = 0;
+
+  Frame(Interpreter& interpreter, const Function* function)
+      : interpreter(interpreter),
+        function(function),
+        registers(function->value_index_capacity()),
+        block_counts(interpreter.statistics_.block_counts[function]) {
+    block_counts.resize(std::max(block_counts.size(), function->block_index_capacity()));
+  }
+
+  uint64_t get(const Value* value) const {
+    switch (value->kind()) {
+      case Value::Kind::Constant:
+        return cast<Constant>(value)->value_u();
+      case Value::Kind::Undef:
+        return 0;
+      default:
+        verify(value->has_dense_index(), "Interpreted value is not part of the function");
+        return registers[value->dense_index()];
+    }
+  }
+
+  void set(const Value* value, uint64_t result) { registers[value->dense_index()] = result; }
+
+  /// Phis of the entered block are evaluated together as if they executed in parallel.
+  const Instruction* enter_block(const Block* block) {
+    const auto previous_block = current_block;
+
+    current_block = block;
+    block_counts[block->dense_index()]++;
+
+    phi_values.clear();
+
+    const Instruction* instruction = block->first_instruction();
+    for (; instruction && cast<Phi>(instruction); instruction = instruction->next()) {
+      const auto phi = cast<Phi>(instruction);
+      const auto incoming = phi->incoming_for_block(previous_block);
+      verify(incoming, "Phi has no incoming value for the predecessor");
+
+      phi_values.push_back(get(incoming));
+    }
+
+    size_t phi_index = 0;
+    for (const Phi& phi : block->instructions<Phi>()) {
+      set(&phi, phi_values[phi_index++]);
+    }
+
+    interpreter.statistics_.executed_instructions += phi_values.size();
+    interpreter.statistics_.instruction_counts[instruction_kind_index(Value::Kind::Phi)] +=
+      phi_values.size();
+
+    return instruction;
+  }
+
+  uint64_t execute() {
+    auto& statistics = interpreter.statistics_;
+
+    const Instruction* instruction = enter_block(function->entry_block());
+
+    while (true) {
+      verify(instruction, "Block doesn't end with a terminator");
+
+      statistics.executed_instructions++;
+      statistics.instruction_counts[instruction_kind_index(instruction->kind())]++;
+
+      visitor::visit_instruction(instruction, *this);
+
+      if (returned) {
+        return return_value;
+      }
+
+      if (next_block) {
+        instruction = enter_block(next_block);
+        next_block = nullptr;
+      } else {
+        instruction = instruction->next();
+      }
+    }
+  }
+
+  void visit_unary_instr(Argument<UnaryInstr> unary) {
+    const auto type = unary->type();
+    const auto value = get(unary->value());
+
+    if (type->is_i1()) {
+      const auto i8 = type->context()->i8_ty();
+      set(unary, utils::evaluate_unary_instr(i8, unary->op(), value) & 1);
+    } else {
+      set(unary, utils::evaluate_unary_instr(type, unary->op(), value));
+    }
+  }
+
+  void visit_binary_instr(Argument<BinaryInstr> binary) {
+    set(binary, evaluate_binary(binary->type(), get(binary->lhs()), binary->op(),
+                                get(binary->rhs())));
+  }
+
+  void visit_int_compare(Argument<IntCompare> int_compare) {
+    auto type = int_compare->lhs()->type();
+    auto lhs = get(int_compare->lhs());
+    auto rhs = get(int_compare->rhs());
+
+    // Sign extension to i8 preserves both signed and unsigned order of i1 values.
+    if (type->is_i1()) {
+      const auto i8 = type->context()->i8_ty();
+      lhs = utils::evaluate_cast(lhs, type, i8, CastKind::SignExtend);
+      rhs = utils::evaluate_cast(rhs, type, i8, CastKind::SignExtend);
+      type = i8;
+    }
+
+    set(int_compare, utils::evaluate_int_compare(type, lhs, int_compare->predicate(), rhs));
+  }
+
+  void visit_load(Argument<Load> load) {
+    const auto size = memory_size(load->type());
+
+    uint64_t value = 0;
+    std::memcpy(&value, interpreter.memory(get(load->address()), size), size);
+
+    set(load, value);
+  }
+
+  void visit_store(Argument<Store> store) {
+    const auto size = memory_size(store->value()->type());
+    const auto value = get(store->value());
+
+    std::memcpy(interpreter.memory(get(store->address()), size), &value, size);
+  }
+
+  void visit_call(Argument<Call> call) {
+    call_arguments.clear();
+    for (size_t i = 0; i < call->argument_count(); ++i) {
+      call_arguments.push_back(get(call->argument(i)));
+    }
+
+    const auto result = interpreter.call_function(call->callee(), call_arguments);
+
+    if (!call->is_void()) {
+      set(call, result & call->type()->bit_mask());
+    }
+  }
+
+  void visit_branch(Argument<Branch> branch) { next_block = branch->target(); }
+
+  void visit_cond_branch(Argument<CondBranch> cond_branch) {
+    next_block = cond_branch->select_target(get(cond_branch->condition()) != 0);
+  }
+
+  void visit_stackalloc(Argument<StackAlloc> stackalloc) {
+    const auto size = memory_size(stackalloc->allocated_type()) * stackalloc->size();
+    set(stackalloc, interpreter.allocate_memory(size));
+  }
+
+  void visit_ret(Argument<Ret> ret) {
+    returned = true;
+    return_value = ret->returns_void() ? 0 : get(ret->return_value());
+  }
+
+  void visit_offset(Argument<Offset> offset) {
+    const auto element_size = memory_size(cast<PointerType>(offset->type())->deref());
+    const auto index =
+      Constant::constrain_i(offset->index()->type(), int64_t(get(offset->index())));
+
+    set(offset, get(offset->base()) + uint64_t(index) * element_size);
+  }
+
+  void visit_cast(Argument<Cast> cast) {
+    const auto from = cast->casted_value();
+    set(cast, utils::evaluate_cast(get(from), from->type(), cast->type(), cast->cast_kind()));
+  }
+
+  void visit_select(Argument<Select> select) {
+    set(select, get(select->select_value(get(select->condition()) != 0)));
+  }
+
+  void visit_phi(Argument<Phi>) { unreachable(); }
+};
+
+Interpreter::Interpreter(const Module* module, size_t stack_size)
+    : module(module), stack(stack_size) {}
+
+uint64_t Interpreter::execute_function(const Function* function,
+                                       std::span<const uint64_t> arguments) {
+  verify(arguments.size() == function->parameter_count(),
+         "Function `{}` called with {} arguments, expected {}", function->name(), arguments.size(),
+         function->parameter_count());
+
+  Frame frame(*this, function);
+
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    const auto parameter = function->parameter(i);
+    frame.set(parameter, arguments[i] & parameter->type()->bit_mask());
+  }
+
+  // Stackallocs are freed when the function returns.
+  const auto saved_stack_pointer = stack_pointer;
+  const auto result = frame.execute();
+  stack_pointer = saved_stack_pointer;
+
+  return result;
+}
+
+uint64_t Interpreter::call_function(const Function* function, std::span<const uint64_t> arguments) {
+  statistics_.executed_calls++;
+
+  if (function->is_extern()) {
+    const auto it = host_functions.find(function);
+    if (it == host_functions.end()) {
+      fatal_error("Extern function `{}` has no host implementation.", function->name());
+    }
+
+    return it->second(*this, arguments);
+  }
+
+  if (call_depth >= max_call_depth) {
+    fatal_error("Interpreted program exceeded maximum call depth ({}).", max_call_depth);
+  }
+
+  call_depth++;
+  const auto result = execute_function(function, arguments);
+  call_depth--;
+
+  return result;
+}
+
+void Interpreter::register_host_function(std::string_view name, HostFunction function) {
+  const auto module_function = module->find_function(name);
+  if (module_function && module_function->is_extern()) {
+    host_functions[module_function] = std::move(function);
+  }
+}
+
+uint64_t Interpreter::run(const Function* function, std::span<const uint64_t> arguments) {
+  verify(function->module() == module, "Cannot run function from another module");
+
+  const auto result = call_function(function, arguments);
+
+  return function->return_type()->is_void() ? 0 : result;
+}
+
+uint64_t Interpreter::run(std::string_view function_name, std::span<const uint64_t> arguments) {
+  const auto function = module->find_function(function_name);
+  verify(function, "Function `{}` doesn't exist", function_name);
+
+  return run(function, arguments);
+}
+
+uint64_t Interpreter::allocate_memory(size_t size) {
+  const auto aligned_size = (size + stack_alignment - 1) & ~(stack_alignment - 1);
+  if (aligned_size > stack.size() - stack_pointer) {
+    fatal_error("Interpreted program overflowed the stack.");
+  }
+
+  const auto memory = stack.data() + stack_pointer;
+  stack_pointer += aligned_size;
+
+  std::memset(memory, 0, size);
+
+  return uint64_t(memory);
+}
+
+uint8_t* Interpreter::memory(uint64_t address, size_t size) {
+  const auto begin = uint64_t(stack.data());
+  const auto end = begin + stack_pointer;
+
+  if (address < begin || address > end || size > end - address) {
+    fatal_error("Interpreted program accessed invalid memory (address {:#x}, size {}).", address,
+                size);
+  }
+
+  return reinterpret_cast<uint8_t*>(address);
+}
+
+uint64_t Interpreter::block_execution_count(const Block* block) const {
+  const auto it = statistics_.block_counts.find(block->function());
+  if (it == statistics_.block_counts.end() || block->dense_index() >= it->second.size()) {
+    return 0;
+  }
+
+  return it->second[block->dense_index()];
+}
+
+void Interpreter::clear_statistics() {
+  statistics_ = ExecutionStatistics{};
+}
+
+void Interpreter::show_statistics() const {
+  constexpr auto indentation = "    ";
+  constexpr size_t shown_block_count = 10;
+
+  log_info("");
+  log_info("Execution statistics:");
+  log_info("{}Executed instructions: {}", indentation, statistics_.executed_instructions);
+  log_info("{}Executed calls:        {}", indentation, statistics_.executed_calls);
+
+  log_info("");
+  {
+    std::vector<std::pair<Value::Kind, uint64_t>> sorted_counts;
+    for (size_t i = 0; i < instruction_kind_count; ++i) {
+      if (const auto count = statistics_.instruction_counts[i]) {
+        sorted_counts.emplace_back(Value::Kind(size_t(Value::Kind::InstructionBegin) + 1 + i),
+                                   count);
+      }
+    }
+
+    std::sort(sorted_counts.begin(), sorted_counts.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    log_info("Executed instructions by kind:");
+
+    for (const auto& [kind, count] : sorted_counts) {
+      const auto ratio = double(count) / double(statistics_.executed_instructions) * 100.0;
+      log_info("{}{:<12} | {:>12} | {:>5.1f}%", indentation, stringify_instruction_kind(kind),
+               count, ratio);
+    }
+  }
+
+  log_info("");
+  {
+    std::vector<std::pair<const Block*, uint64_t>> sorted_blocks;
+    for (const auto& [function, counts] : statistics_.block_counts) {
+      for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] > 0) {
+          sorted_blocks.emplace_back(function->block_by_index(i), counts[i]);
+        }
+      }
+    }
+
+    const auto shown = std::min(sorted_blocks.size(), shown_block_count);
+    std::partial_sort(sorted_blocks.begin(), sorted_blocks.begin() + std::ptrdiff_t(shown),
+                      sorted_blocks.end(),
+                      [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    log_info("Most executed blocks:");
+
+    for (size_t i = 0; i < shown; ++i) {
+      const auto [block, count] = sorted_blocks[i];
+      if (block) {
+        log_info("{}{:>2}. {}:{:<10} | {:>12}", indentation, i + 1, block->function()->name(),
+                 block->format(), count);
+      } else {
+        log_info("{}{:>2}. (removed block)    | {:>12}", indentation, i + 1, count);
+      }
+    }
+  }
+
+  log_info("");
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <Flugzeug/Core/ClassTraits.hpp>
+#include <Flugzeug/Core/FlatHashMap.hpp>
+#include <Flugzeug/IR/Value.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace flugzeug {
+
+class Module;
+class Function;
+class Block;
+
+/// Executes Flugzeug IR directly and counts executed instructions. All memory accessible to the
+/// program lives in the interpreter stack; pointers are host addresses into it so host functions
+/// can access memory passed to them (see `memory`).
+class Interpreter {
+ public:
+  /// Implementation of an extern function. Receives raw argument values and returns the raw
+  /// return value (ignored for void functions).
+  using HostFunction =
+    std::function<uint64_t(Interpreter& interpreter, std::span<const uint64_t> arguments)>;
+
+  constexpr static size_t instruction_kind_count =
+    size_t(Value::Kind::InstructionEnd) - size_t(Value::Kind::InstructionBegin) - 1;
+
+  struct ExecutionStatistics {
+    uint64_t executed_instructions = 0;
+    uint64_t executed_calls = 0;
+
+    /// Indexed by instruction kind (see `instruction_kind_index`).
+    std::array<uint64_t, instruction_kind_count> instruction_counts{};
+
+    /// Indexed by dense block index of every executed function. Frames keep references to
+    /// the vectors so the map must not invalidate them on insertion.
+    std::unordered_map<const Function*, std::vector<uint64_t>> block_counts;
+  };
+
+ private:
+  struct Frame;
+
+  const Module* module;
+
+  std::vector<uint8_t> stack;
+  size_t stack_pointer = 0;
+  size_t call_depth = 0;
+
+  FlatHashMap<const Function*, HostFunction> host_functions;
+
+  ExecutionStatistics statistics_;
+
+  uint64_t execute_function(const Function* function, std::span<const uint64_t> arguments);
+  uint64_t call_function(const Function* function, std::span<const uint64_t> arguments);
+
+ public:
+  CLASS_NON_MOVABLE_NON_COPYABLE(Interpreter)
+
+  constexpr static size_t default_stack_size = 8 * 1024 * 1024;
+
+  explicit Interpreter(const Module* module, size_t stack_size = default_stack_size);
+
+  /// Host functions registered for functions which aren't extern functions of the module are
+  /// ignored, so the same set can be registered for every module.
+  void register_host_function(std::string_view name, HostFunction function);
+
+  /// Calls the function with given raw arguments and returns its raw return value (0 for void
+  /// functions). Invalid programs (division by zero, out of bounds memory accesses, calls to
+  /// extern functions without host implementation) cause a fatal error.
+  uint64_t run(const Function* function, std::span<const uint64_t> arguments = {});
+  uint64_t run(std::string_view function_name, std::span<const uint64_t> arguments = {});
+
+  /// Allocates zeroed memory inside the interpreter stack which stays valid until the
+  /// interpreter is destroyed. Can be used to pass buffers to the interpreted program.
+  uint64_t allocate_memory(size_t size);
+
+  /// Verifies that `size` bytes starting at `address` are inside the interpreter memory and
+  /// returns host pointer to them.
+  uint8_t* memory(uint64_t address, size_t size);
+
+  static size_t instruction_kind_index(Value::Kind kind) {
+    return size_t(kind) - size_t(Value::Kind::InstructionBegin) - 1;
+  }
+
+  const ExecutionStatistics& statistics() const { return statistics_; }
+  uint64_t block_execution_count(const Block* block) const;
+
+  void clear_statistics();
+  void show_statistics() const;
+};
+
+}  // namespace flugzeug
@@ -0,0 +1,98 @@
+#include "CallGraph.hpp"
+#include "SCC.hpp"
+
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/Instructions.hpp>
+#include <Flugzeug/IR/Module.hpp>
+
+#include <algorithm>
+
+using namespace flugzeug;
+using namespace flugzeug::analysis;
+
+void CallGraph::add_function(Function* function) {
+  auto& callees = callees_[function];
+
+  std::unordered_set<Function*> visited;
+  for (Call& call : function->instructions<Call>()) {
+    Function* callee = call.callee();
+    if (!callee->is_extern() && visited.insert(callee).second) {
+      callees.push_back(callee);
+    }
+  }
+}
+
+void CallGraph::calculate_sccs() {
+  std::unordered_set<Function*> functions;
+  for (const auto& [function, _] : callees_) {
+    functions.insert(const_cast<Function*>(function));
+  }
+
+  // Tarjan's algorithm outputs SCCs in reverse topological order which is exactly the bottom-up
+  // order that we want.
+  bottom_up_sccs_ = analysis::calculate_sccs<Function*, false>(
+    functions, [&](Function* function) -> const std::vector<Function*>& {
+      return callees(function);
+    });
+
+  for (size_t i = 0; i < bottom_up_sccs_.size(); ++i) {
+    for (const Function* function : bottom_up_sccs_[i]) {
+      scc_indices_.insert({function, i});
+    }
+  }
+}
+
+CallGraph::CallGraph(Module* module) {
+  for (Function& function : module->local_functions()) {
+    add_function(&function);
+  }
+
+  calculate_sccs();
+}
+
+CallGraph::CallGraph(Function* root) {
+  std::vector<Function*> worklist{root};
+  add_function(root);
+
+  while (!worklist.empty()) {
+    const auto function = worklist.back();
+    worklist.pop_back();
+
+    for (Function* callee : callees(function)) {
+      if (!callees_.contains(callee)) {
+        add_function(callee);
+        worklist.push_back(callee);
+      }
+    }
+  }
+
+  calculate_sccs();
+}
+
+const std::vector<Function*>& CallGraph::callees(const Function* function) const {
+  const auto it = callees_.find(function);
+  verify(it != callees_.end(), "Function {} is not in the call graph", function->name());
+  return it->second;
+}
+
+bool CallGraph::are_in_same_scc(const Function* a, const Function* b) const {
+  const auto a_scc = scc_indices_.find(a);
+  const auto b_scc = scc_indices_.find(b);
+  verify(a_scc != scc_indices_.end() && b_scc != scc_indices_.end(),
+         "Function is not in the call graph");
+
+  return a_scc->second == b_scc->second;
+}
+
+bool CallGraph::is_recursive(const Function* function) const {
+  const auto scc = scc_indices_.find(function);
+  verify(scc != scc_indices_.end(), "Function is not in the call graph");
+
+  if (bottom_up_sccs_[scc->second].size() > 1) {
+    return true;
+  }
+
+  const auto& function_callees = callees(function);
+  return std::find(function_callees.begin(), function_callees.end(), function) !=
+         function_callees.end();
+}
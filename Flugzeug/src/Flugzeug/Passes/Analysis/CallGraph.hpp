@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace flugzeug {
+
+class Function;
+class Module;
+
+namespace analysis {
+
+/// Direct calls between local functions of the module. Calls to extern functions are ignored.
+class CallGraph {
+  std::unordered_map<const Function*, std::vector<Function*>> callees_;
+  std::unordered_map<const Function*, size_t> scc_indices_;
+  std::vector<std::vector<Function*>> bottom_up_sccs_;
+
+  void add_function(Function* function);
+  void calculate_sccs();
+
+ public:
+  explicit CallGraph(Module* module);
+
+  /// Call graph of functions reachable from `root` (including `root`). Unlike the module call
+  /// graph it never looks at unrelated functions (which may be modified concurrently).
+  explicit CallGraph(Function* root);
+
+  /// Unique local functions called by `function`.
+  const std::vector<Function*>& callees(const Function* function) const;
+
+  /// Strongly connected components of the call graph ordered bottom-up: every SCC comes after
+  /// all SCCs that it calls into.
+  const std::vector<std::vector<Function*>>& bottom_up_sccs() const { return bottom_up_sccs_; }
+
+  /// Functions in the same SCC can (possibly indirectly) call each other.
+  bool are_in_same_scc(const Function* a, const Function* b) const;
+
+  /// Function is recursive if it can (possibly indirectly) call itself.
+  bool is_recursive(const Function* function) const;
+};
+
+}  // namespace analysis
+
+}  // namespace flugzeug
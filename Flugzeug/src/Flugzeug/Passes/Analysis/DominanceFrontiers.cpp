@@ -0,0 +1,70 @@
+#include "DominanceFrontiers.hpp"
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/DominatorTree.hpp>
+#include <Flugzeug/IR/Function.hpp>
+
+using namespace flugzeug;
+using namespace flugzeug::analysis;
+
+DominanceFrontiers::DominanceFrontiers(Function* function, const DominatorTree& dominator_tree)
+    : function(function), frontiers(function) {
+  // Cooper, Harvey, Kennedy: walk up the dominator tree from every predecessor of join point
+  // until we hit its immediate dominator.
+  for (Block& block : *function) {
+    if (dominator_tree.is_block_dead(&block)) {
+      continue;
+    }
+
+    const auto predecessors = block.predecessors();
+    if (predecessors.size() < 2) {
+      continue;
+    }
+
+    const auto immediate_dominator = dominator_tree.immediate_dominator(&block);
+
+    for (const Block* predecessor : predecessors) {
+      if (dominator_tree.is_block_dead(predecessor)) {
+        continue;
+      }
+
+      for (const Block* runner = predecessor; runner && runner != immediate_dominator;
+           runner = dominator_tree.immediate_dominator(runner)) {
+        auto& frontier = frontiers[runner];
+        if (frontier.empty() || frontier.back() != &block) {
+          frontier.push_back(&block);
+        }
+      }
+    }
+  }
+}
+
+std::span<Block* const> DominanceFrontiers::frontier(const Block* block) const {
+  const auto frontier = frontiers.find(block);
+  if (!frontier) {
+    return {};
+  }
+
+  return *frontier;
+}
+
+std::vector<Block*> DominanceFrontiers::iterated_frontier(std::span<Block* const> blocks) const {
+  std::vector<Block*> result;
+  BlockSet in_result(function);
+
+  std::vector<const Block*> worklist(blocks.begin(), blocks.end());
+
+  while (!worklist.empty()) {
+    const auto block = worklist.back();
+    worklist.pop_back();
+
+    for (Block* frontier_block : frontier(block)) {
+      if (in_result.insert(frontier_block)) {
+        result.push_back(frontier_block);
+        worklist.push_back(frontier_block);
+      }
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <Flugzeug/IR/ValueMap.hpp>
+
+#include <span>
+#include <vector>
+
+namespace flugzeug {
+
+class DominatorTree;
+
+namespace analysis {
+
+/// Dominance frontier of block B is the set of blocks where dominance of B ends: blocks which
+/// are not strictly dominated by B but have a predecessor dominated by B. Dead blocks are ignored.
+class DominanceFrontiers {
+  const Function* function;
+  BlockMap<std::vector<Block*>> frontiers;
+
+ public:
+  DominanceFrontiers(Function* function, const DominatorTree& dominator_tree);
+
+  std::span<Block* const> frontier(const Block* block) const;
+
+  /// Iterated dominance frontier of a set of blocks (places where Phis are needed for a value
+  /// defined in all of these blocks).
+  std::vector<Block*> iterated_frontier(std::span<Block* const> blocks) const;
+};
+
+}  // namespace analysis
+
+}  // namespace flugzeug
@@ -0,0 +1,131 @@
+#include "Liveness.hpp"
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/Instructions.hpp>
+
+using namespace flugzeug;
+using namespace flugzeug::analysis;
+
+static bool is_tracked(const Value* value) {
+  return cast<Instruction>(value) || cast<Parameter>(value);
+}
+
+Liveness::Liveness(const Function* function) : function(function), blocks(function) {
+  const auto value_count = function->value_index_capacity();
+
+  // Per block local information which doesn't change during the fixpoint:
+  //   gen:      values used in the block before being defined in it (Phis excluded),
+  //   kill:     values defined in the block,
+  //   phi_defs: Phis of the block,
+  //   phi_uses: values used by Phis of the successors (live at the end of the block).
+  struct LocalSets {
+    DenseBitSet gen;
+    DenseBitSet kill;
+    DenseBitSet phi_defs;
+    DenseBitSet phi_uses;
+  };
+
+  BlockMap<LocalSets> local_sets(function);
+
+  for (const Block& block : *function) {
+    LocalSets sets{
+      .gen = DenseBitSet(value_count),
+      .kill = DenseBitSet(value_count),
+      .phi_defs = DenseBitSet(value_count),
+      .phi_uses = DenseBitSet(value_count),
+    };
+
+    for (const Instruction& instruction : reversed(block)) {
+      if (cast<Phi>(instruction)) {
+        sets.phi_defs.insert(instruction.dense_index());
+        sets.kill.insert(instruction.dense_index());
+        continue;
+      }
+
+      sets.kill.insert(instruction.dense_index());
+      sets.gen.erase(instruction.dense_index());
+
+      for (const Value& operand : instruction.operands()) {
+        if (is_tracked(&operand)) {
+          sets.gen.insert(operand.dense_index());
+        }
+      }
+    }
+
+    for (const Block* successor : block.successors()) {
+      for (const Phi& phi : successor->instructions<Phi>()) {
+        const auto incoming = phi.incoming_for_block(&block);
+        if (is_tracked(incoming)) {
+          sets.phi_uses.insert(incoming->dense_index());
+        }
+      }
+    }
+
+    blocks.insert(&block, BlockLiveness{
+                            .live_in = sets.gen,
+                            .live_out = DenseBitSet(value_count),
+                          });
+    local_sets.insert(&block, std::move(sets));
+  }
+
+  // Process blocks so that successors usually come before predecessors. The order only affects
+  // the number of iterations, not the result.
+  std::vector<const Block*> worklist;
+  BlockSet in_worklist(function);
+
+  if (const auto entry_block = function->entry_block()) {
+    for (const Block* block : entry_block->reachable_blocks(TraversalType::DFS_WithStart)) {
+      if (in_worklist.insert(block)) {
+        worklist.push_back(block);
+      }
+    }
+  }
+
+  // Dead blocks are processed first, they don't affect live sets of reachable blocks.
+  for (const Block& block : *function) {
+    if (in_worklist.insert(&block)) {
+      worklist.push_back(&block);
+    }
+  }
+
+  //   LiveOut(B) = PhiUses(B) ∪ (∪ over successors S: LiveIn(S) - PhiDefs(S))
+  //   LiveIn(B)  = Gen(B) ∪ (LiveOut(B) - Kill(B))
+  // Sets only grow so when LiveIn(B) changes only predecessors of B need to be revisited.
+  while (!worklist.empty()) {
+    const auto block = worklist.back();
+    worklist.pop_back();
+    in_worklist.erase(block);
+
+    auto& liveness = *blocks.find(block);
+    const auto& sets = *local_sets.find(block);
+
+    liveness.live_out.merge(sets.phi_uses);
+    for (const Block* successor : block->successors()) {
+      liveness.live_out.merge_difference(blocks.find(successor)->live_in,
+                                         local_sets.find(successor)->phi_defs);
+    }
+
+    if (liveness.live_in.merge_difference(liveness.live_out, sets.kill)) {
+      for (const Block* predecessor : block->predecessors()) {
+        if (in_worklist.insert(predecessor)) {
+          worklist.push_back(predecessor);
+        }
+      }
+    }
+  }
+}
+
+const Liveness::BlockLiveness& Liveness::get(const Block* block) const {
+  const auto liveness = blocks.find(block);
+  verify(liveness, "Liveness wasn't computed for a given block");
+  return *liveness;
+}
+
+bool Liveness::is_live_in(const Block* block, const Value* value) const {
+  return value->has_dense_index() && live_in(block).contains(value->dense_index());
+}
+
+bool Liveness::is_live_out(const Block* block, const Value* value) const {
+  return value->has_dense_index() && live_out(block).contains(value->dense_index());
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <Flugzeug/Core/DenseBitSet.hpp>
+#include <Flugzeug/IR/ValueMap.hpp>
+
+namespace flugzeug {
+
+class Function;
+class Block;
+class Value;
+
+namespace analysis {
+
+/// Values which are live at the beginning and at the end of every block. Sets contain dense
+/// indices of values (see `Value::dense_index`), only instructions and parameters are tracked.
+///
+/// Phis are live at the beginning of their block only if they are used there. Incoming values of
+/// Phis are live at the end of the corresponding predecessor but not (because of the Phi) at the
+/// beginning of the Phi's block.
+///
+/// Sets are computed using a worklist so any control flow (including irreducible loops) is fine.
+class Liveness {
+  struct BlockLiveness {
+    DenseBitSet live_in;
+    DenseBitSet live_out;
+  };
+
+  const Function* function;
+  BlockMap<BlockLiveness> blocks;
+
+  const BlockLiveness& get(const Block* block) const;
+
+ public:
+  explicit Liveness(const Function* function);
+
+  const DenseBitSet& live_in(const Block* block) const { return get(block).live_in; }
+  const DenseBitSet& live_out(const Block* block) const { return get(block).live_out; }
+
+  bool is_live_in(const Block* block, const Value* value) const;
+  bool is_live_out(const Block* block, const Value* value) const;
+};
+
+}  // namespace analysis
+
+}  // namespace flugzeug
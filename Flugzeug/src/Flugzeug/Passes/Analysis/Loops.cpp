@@ -14,7 +14,7 @@ struct DfsContext {
     Discovered,
     Finished,
   };
-  std::unordered_map<Block*, State> block_state;
+  BlockMap<State> block_state;
 };
 
 struct MaybeSubLoopBackedge {
@@ -23,9 +23,9 @@ struct MaybeSubLoopBackedge {
   bool in_subloop = false;
 };
 
-static std::vector<std::vector<Block*>> calculate_block_sccs(
-  SccContext<Block*>& context,
-  const std::unordered_set<Block*>& blocks) {
+template <typename TBlockSet>
+static std::vector<std::vector<Block*>> calculate_block_sccs(SccContext<Block*>& context,
+                                                             const TBlockSet& blocks) {
   return calculate_sccs<Block*, true>(context, blocks,
                                       [](Block* block) { return block->successors(); });
 }
@@ -34,7 +34,7 @@ static bool visit_loop_block(DfsContext& dfs_context,
                              Block* block,
                              Loop& loop,
                              std::vector<std::pair<Block*, Block*>>& exiting_edges,
-                             std::unordered_set<Block*>& back_edges_from,
+                             BlockSet& back_edges_from,
                              std::vector<MaybeSubLoopBackedge>& maybe_subloops_backedges) {
   verify(!dfs_context.block_state.contains(block),
          "Running `visit_loop_block` on already visited block");
@@ -59,16 +59,15 @@ static bool visit_loop_block(DfsContext& dfs_context,
       continue;
     }
 
-    const auto successor_it = dfs_context.block_state.find(successor);
-    if (successor_it == dfs_context.block_state.end()) {
+    const auto successor_state = dfs_context.block_state.find(successor);
+    if (!successor_state) {
       // Visit successor.
       if (!visit_loop_block(dfs_context, successor, loop, exiting_edges, back_edges_from,
                             maybe_subloops_backedges)) {
         return false;
       }
     } else {
-      const auto& successor_state = successor_it->second;
-      if (successor_state == DfsContext::State::Discovered) {
+      if (*successor_state == DfsContext::State::Discovered) {
         // We have found a back edge in the graph. There are valid 2 possible scenarios:
         //   1. It's a back edge to the loop header.
         //   2. It's part of a sub-loop and it's a back edge to its loop header (we will verify this
@@ -109,7 +108,8 @@ bool Loop::find_loops_in_scc(Function* function,
                              SccContext<Block*>& scc_context,
                              std::vector<std::unique_ptr<Loop>>& loops) {
   Loop loop;
-  loop.blocks_ = std::unordered_set<Block*>(scc_vector.begin(), scc_vector.end());
+  loop.blocks_ = BlockSet(function, scc_vector.begin(), scc_vector.end());
+  loop.back_edges_from_ = BlockSet(function);
 
   // Find the block that dominates all other blocks in the SCC. This will be potentially a loop
   // header.
@@ -132,7 +132,7 @@ bool Loop::find_loops_in_scc(Function* function,
 
   // Verify some loop properties using DFS traversal. Collect all exiting edges, back edges and
   // potential sub-loop back edges.
-  DfsContext dfs_context{};
+  DfsContext dfs_context{BlockMap<DfsContext::State>(function)};
   std::vector<MaybeSubLoopBackedge> maybe_subloops_backedges;
   if (!visit_loop_block(dfs_context, loop.header_, loop, loop.exiting_edges_, loop.back_edges_from_,
                         maybe_subloops_backedges)) {
@@ -222,7 +222,10 @@ std::vector<std::unique_ptr<Loop>> flugzeug::analysis::analyze_function_loops(
   Function* function,
   const DominatorTree& dominator_tree) {
   // Loops are defined only for reachable blocks.
-  const auto reachable_blocks = function->entry_block()->reachable_blocks_set(IncludeStart::Yes);
+  const auto reachable_blocks_vector =
+    function->entry_block()->reachable_blocks(TraversalType::DFS_WithStart);
+  const BlockSet reachable_blocks(function, reachable_blocks_vector.begin(),
+                                  reachable_blocks_vector.end());
 
   std::vector<std::unique_ptr<Loop>> loops;
   SccContext<Block*> scc_context{};
@@ -248,14 +251,14 @@ Block* Loop::header() const {
   return header_;
 }
 
-const std::unordered_set<Block*>& Loop::blocks() const {
+const BlockSet& Loop::blocks() const {
   return blocks_;
 }
-const std::unordered_set<Block*>& Loop::blocks_without_sub_loops() const {
+const BlockSet& Loop::blocks_without_sub_loops() const {
   return blocks_without_sub_loops_;
 }
 
-const std::unordered_set<Block*>& Loop::back_edges_from() const {
+const BlockSet& Loop::back_edges_from() const {
   return back_edges_from_;
 }
 const std::vector<std::pair<Block*, Block*>>& Loop::exiting_edges() const {
@@ -1,8 +1,8 @@
 #pragma once
 #include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/ValueMap.hpp>
 
 #include <memory>
-#include <unordered_map>
 #include <vector>
 
 namespace flugzeug {
@@ -25,10 +25,10 @@ class Loop {
     const DominatorTree& dominator_tree);
 
   Block* header_ = nullptr;
-  std::unordered_set<Block*> blocks_;
-  std::unordered_set<Block*> blocks_without_sub_loops_;
+  BlockSet blocks_;
+  BlockSet blocks_without_sub_loops_;
 
-  std::unordered_set<Block*> back_edges_from_;
+  BlockSet back_edges_from_;
   std::vector<std::pair<Block*, Block*>> exiting_edges_;
 
   std::vector<std::unique_ptr<Loop>> sub_loops_;
@@ -44,10 +44,10 @@ class Loop {
  public:
   Block* header() const;
 
-  const std::unordered_set<Block*>& blocks() const;
-  const std::unordered_set<Block*>& blocks_without_sub_loops() const;
+  const BlockSet& blocks() const;
+  const BlockSet& blocks_without_sub_loops() const;
 
-  const std::unordered_set<Block*>& back_edges_from() const;
+  const BlockSet& back_edges_from() const;
   const std::vector<std::pair<Block*, Block*>>& exiting_edges() const;
 
   Block* single_back_edge() const;
@@ -0,0 +1,270 @@
+#include "MemorySSA.hpp"
+#include "DominanceFrontiers.hpp"
+#include "PointerAliasing.hpp"
+
+#include <Flugzeug/Core/HashCombine.hpp>
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/DominatorTree.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/Instructions.hpp>
+
+#include <algorithm>
+
+using namespace flugzeug;
+using namespace flugzeug::analysis;
+
+/// Clobber queries which need to look at more accesses give up and return the nearest Phi.
+constexpr size_t max_visited_accesses = 1024;
+
+size_t MemorySSA::QueryKeyHash::operator()(const QueryKey& key) const {
+  return combine_hash(key.access, key.pointer);
+}
+
+MemoryAccess* MemorySSA::create_access(MemoryAccess::Kind kind,
+                                       Block* block,
+                                       Instruction* instruction) {
+  return &accesses.emplace_back(kind, block, instruction);
+}
+
+void MemorySSA::set_defining_access(MemoryAccess* access, MemoryAccess* defining_access) {
+  access->defining_access_ = defining_access;
+  defining_access->users_.push_back(access);
+}
+
+bool MemorySSA::clobbers(const MemoryAccess* access,
+                         const Value* pointer,
+                         PointerAliasing::IterationScope scope) const {
+  return alias_analysis.can_instruction_access_pointer(
+           access->instruction(), pointer, PointerAliasing::AccessType::Store, scope) !=
+         Aliasing::Never;
+}
+
+MemorySSA::MemorySSA(Function* function,
+                     const DominatorTree& dominator_tree,
+                     const DominanceFrontiers& dominance_frontiers,
+                     const PointerAliasing& alias_analysis)
+    : alias_analysis(alias_analysis),
+      instruction_accesses(function),
+      phis(function),
+      block_accesses_(function) {
+  using Kind = MemoryAccess::Kind;
+
+  live_on_entry_ = create_access(Kind::LiveOnEntry, nullptr, nullptr);
+
+  BlockMap<std::vector<Block*>> children(function);
+  std::vector<Block*> def_blocks;
+
+  for (Block& block : *function) {
+    if (dominator_tree.is_block_dead(&block)) {
+      continue;
+    }
+
+    if (!block.is_entry_block()) {
+      children[dominator_tree.immediate_dominator(&block)].push_back(&block);
+    }
+
+    auto& block_accesses = block_accesses_[&block];
+    bool has_def = false;
+
+    for (Instruction& instruction : block) {
+      Kind kind;
+      if (cast<Store>(instruction) || cast<Call>(instruction)) {
+        kind = Kind::Def;
+      } else if (cast<Load>(instruction) || cast<Ret>(instruction)) {
+        kind = Kind::Use;
+      } else {
+        continue;
+      }
+
+      const auto access = create_access(kind, &block, &instruction);
+      instruction_accesses.insert(&instruction, access);
+      block_accesses.push_back(access);
+
+      has_def |= kind == Kind::Def;
+    }
+
+    if (has_def) {
+      def_blocks.push_back(&block);
+    }
+  }
+
+  for (Block* block : dominance_frontiers.iterated_frontier(def_blocks)) {
+    phis.insert(block, create_access(Kind::Phi, block, nullptr));
+  }
+
+  // Connect accesses to the nearest definitions by walking the dominator tree.
+  struct Frame {
+    Block* block;
+    size_t next_child;
+    MemoryAccess* exit_definition;
+  };
+
+  std::vector<Frame> stack;
+
+  const auto enter = [&](Block* block, MemoryAccess* definition) {
+    if (const auto block_phi = phi(block)) {
+      definition = block_phi;
+    }
+
+    for (MemoryAccess* access : block_accesses(block)) {
+      set_defining_access(access, definition);
+      if (access->kind() == Kind::Def) {
+        definition = access;
+      }
+    }
+
+    for (Block* successor : block->successors()) {
+      const auto successor_phi = phi(successor);
+      if (!successor_phi) {
+        continue;
+      }
+
+      auto& incoming = successor_phi->incoming_;
+      const bool has_incoming = std::any_of(
+        incoming.begin(), incoming.end(), [&](const auto& entry) { return entry.first == block; });
+      if (!has_incoming) {
+        incoming.push_back({block, definition});
+        definition->users_.push_back(successor_phi);
+      }
+    }
+
+    stack.push_back(Frame{block, 0, definition});
+  };
+
+  enter(function->entry_block(), live_on_entry_);
+
+  while (!stack.empty()) {
+    auto& frame = stack.back();
+    const auto block_children = children.find(frame.block);
+
+    if (block_children && frame.next_child < block_children->size()) {
+      const auto child = (*block_children)[frame.next_child++];
+      enter(child, frame.exit_definition);
+    } else {
+      stack.pop_back();
+    }
+  }
+}
+
+MemoryAccess* MemorySSA::access(const Instruction* instruction) const {
+  const auto access = instruction_accesses.find(instruction);
+  return access ? *access : nullptr;
+}
+
+MemoryAccess* MemorySSA::phi(const Block* block) const {
+  const auto phi = phis.find(block);
+  return phi ? *phi : nullptr;
+}
+
+std::span<MemoryAccess* const> MemorySSA::block_accesses(const Block* block) const {
+  const auto block_accesses = block_accesses_.find(block);
+  if (!block_accesses) {
+    return {};
+  }
+  return *block_accesses;
+}
+
+MemoryAccess* MemorySSA::clobbering_access(const MemoryAccess* access, const Value* pointer) {
+  using Kind = MemoryAccess::Kind;
+
+  verify(access->kind() == Kind::Def || access->kind() == Kind::Use,
+         "Clobber queries are only supported for defs and uses");
+
+  const QueryKey key{access, pointer};
+  if (const auto it = query_cache.find(key); it != query_cache.end()) {
+    return it->second;
+  }
+
+  // Skip definitions which don't clobber the pointer until the first Phi.
+  auto current = access->defining_access();
+  while (current->kind() == Kind::Def &&
+         !clobbers(current, pointer, PointerAliasing::IterationScope::Same)) {
+    current = current->defining_access();
+  }
+
+  if (current->kind() == Kind::Phi) {
+    // Find clobbers of all paths to the Phi. Phis are looked through, if all paths end in the same
+    // clobber then it is the result. Paths which reach already visited accesses (loops) don't
+    // bring new clobbers. Definitions behind the Phi can come from previous loop iterations.
+    const auto nearest_phi = current;
+    MemoryAccess* clobber = nullptr;
+
+    FlatHashSet<const MemoryAccess*> visited;
+    std::vector<MemoryAccess*> worklist{nearest_phi};
+
+    while (!worklist.empty()) {
+      const auto candidate = worklist.back();
+      worklist.pop_back();
+
+      if (!visited.insert(candidate).second) {
+        continue;
+      }
+
+      if (visited.size() > max_visited_accesses) {
+        clobber = nearest_phi;
+        break;
+      }
+
+      if (candidate->kind() == Kind::Phi) {
+        for (const auto& [block, incoming] : candidate->incoming()) {
+          worklist.push_back(incoming);
+        }
+        continue;
+      }
+
+      if (candidate->kind() == Kind::Def &&
+          !clobbers(candidate, pointer, PointerAliasing::IterationScope::Any)) {
+        worklist.push_back(candidate->defining_access());
+        continue;
+      }
+
+      if (clobber && clobber != candidate) {
+        clobber = nearest_phi;
+        break;
+      }
+
+      clobber = candidate;
+    }
+
+    current = clobber ? clobber : nearest_phi;
+  }
+
+  query_cache.insert({key, current});
+
+  return current;
+}
+
+void MemorySSA::remove_access(const Instruction* instruction) {
+  const auto found = instruction_accesses.find(instruction);
+  if (!found) {
+    return;
+  }
+
+  const auto access = *found;
+  const auto defining_access = access->defining_access_;
+
+  std::erase(defining_access->users_, access);
+
+  for (MemoryAccess* user : access->users_) {
+    if (user->kind() == MemoryAccess::Kind::Phi) {
+      for (auto& [block, incoming] : user->incoming_) {
+        if (incoming == access) {
+          incoming = defining_access;
+        }
+      }
+    } else {
+      user->defining_access_ = defining_access;
+    }
+
+    defining_access->users_.push_back(user);
+  }
+
+  access->users_.clear();
+
+  std::erase(block_accesses_[access->block()], access);
+  instruction_accesses.erase(instruction);
+
+  // Cached results may refer to the removed access.
+  query_cache.clear();
+}
\ No newline at end of file
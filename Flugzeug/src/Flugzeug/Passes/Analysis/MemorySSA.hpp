@@ -0,0 +1,133 @@
+#pragma once
+#include <Flugzeug/Core/ClassTraits.hpp>
+#include <Flugzeug/Core/FlatHashMap.hpp>
+#include <Flugzeug/IR/ValueMap.hpp>
+#include <Flugzeug/Passes/Analysis/PointerAliasing.hpp>
+
+#include <deque>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace flugzeug {
+
+class DominatorTree;
+class Instruction;
+
+namespace analysis {
+
+class DominanceFrontiers;
+
+/// Node of the memory SSA form. Definitions (stores and calls) and Phis create new versions of
+/// the whole memory, uses (loads and returns, which expose memory to the caller) read the version
+/// defined by their defining access.
+class MemoryAccess {
+  friend class MemorySSA;
+
+ public:
+  enum class Kind {
+    LiveOnEntry,
+    Def,
+    Use,
+    Phi,
+  };
+
+ private:
+  Kind kind_;
+  Block* block_;
+  Instruction* instruction_;
+
+  MemoryAccess* defining_access_ = nullptr;
+  std::vector<std::pair<Block*, MemoryAccess*>> incoming_;
+  std::vector<MemoryAccess*> users_;
+
+ public:
+  MemoryAccess(Kind kind, Block* block, Instruction* instruction)
+      : kind_(kind), block_(block), instruction_(instruction) {}
+
+  Kind kind() const { return kind_; }
+
+  /// Null for the live on entry definition.
+  Block* block() const { return block_; }
+
+  /// Null for Phis and for the live on entry definition.
+  Instruction* instruction() const { return instruction_; }
+
+  /// Memory version read or overwritten by a def or use.
+  MemoryAccess* defining_access() const { return defining_access_; }
+
+  /// Incoming memory versions of a Phi (one per reachable predecessor edge).
+  std::span<const std::pair<Block*, MemoryAccess*>> incoming() const { return incoming_; }
+
+  /// Accesses which have this access as their defining access or incoming value.
+  std::span<MemoryAccess* const> users() const { return users_; }
+};
+
+/// Memory SSA form of a function. Accesses are chained over the dominator tree and Phis are
+/// placed on the iterated dominance frontier of blocks with definitions, so every access sees the
+/// nearest definitions of the whole memory. `clobbering_access` refines this to a single pointer
+/// using pointer aliasing. Dead blocks have no accesses.
+class MemorySSA {
+  struct QueryKey {
+    const MemoryAccess* access;
+    const Value* pointer;
+
+    bool operator==(const QueryKey& other) const {
+      return access == other.access && pointer == other.pointer;
+    }
+  };
+
+  struct QueryKeyHash {
+    size_t operator()(const QueryKey& key) const;
+  };
+
+  const PointerAliasing& alias_analysis;
+
+  std::deque<MemoryAccess> accesses;
+  MemoryAccess* live_on_entry_ = nullptr;
+
+  ValueMap<MemoryAccess*> instruction_accesses;
+  BlockMap<MemoryAccess*> phis;
+  BlockMap<std::vector<MemoryAccess*>> block_accesses_;
+
+  FlatHashMap<QueryKey, MemoryAccess*, QueryKeyHash> query_cache;
+
+  MemoryAccess* create_access(MemoryAccess::Kind kind, Block* block, Instruction* instruction);
+  void set_defining_access(MemoryAccess* access, MemoryAccess* defining_access);
+
+  bool clobbers(const MemoryAccess* access,
+                const Value* pointer,
+                PointerAliasing::IterationScope scope) const;
+
+ public:
+  CLASS_NON_MOVABLE_NON_COPYABLE(MemorySSA)
+
+  MemorySSA(Function* function,
+            const DominatorTree& dominator_tree,
+            const DominanceFrontiers& dominance_frontiers,
+            const PointerAliasing& alias_analysis);
+
+  MemoryAccess* live_on_entry() const { return live_on_entry_; }
+
+  /// Returns null if the instruction doesn't access memory (or is in a dead block).
+  MemoryAccess* access(const Instruction* instruction) const;
+
+  /// Returns null if the block doesn't have a memory Phi.
+  MemoryAccess* phi(const Block* block) const;
+
+  /// Defs and uses of the block in instruction order (without the Phi).
+  std::span<MemoryAccess* const> block_accesses(const Block* block) const;
+
+  /// Nearest access above `access` (a def or use) which may store to `pointer`. All paths to
+  /// `access` pass through the returned def (or start at the live on entry definition). If
+  /// different paths have different clobbers then the nearest Phi is returned. Results are cached.
+  MemoryAccess* clobbering_access(const MemoryAccess* access, const Value* pointer);
+
+  /// Removes access of an instruction which is going to be destroyed. Users of a removed def
+  /// are connected to its defining access.
+  void remove_access(const Instruction* instruction);
+};
+
+}  // namespace analysis
+
+}  // namespace flugzeug
\ No newline at end of file
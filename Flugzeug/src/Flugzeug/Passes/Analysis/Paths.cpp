@@ -7,7 +7,7 @@ static bool can_reach(Block* from,
                       Block* to,
                       Block* barrier,
                       std::vector<Block*>& stack,
-                      std::unordered_set<Block*>& visited) {
+                      FlatHashSet<Block*>& visited) {
   stack.push_back(from);
 
   while (!stack.empty()) {
@@ -37,15 +37,15 @@ static bool can_reach(Block* from,
 void analysis::get_blocks_inbetween(Block* from,
                                     Block* to,
                                     Block* barrier,
-                                    std::unordered_set<Block*>& blocks_inbetween,
+                                    FlatHashSet<Block*>& blocks_inbetween,
                                     PathAnalysisWorkData* work_data) {
   verify(from != barrier && to != barrier, "Invalid barrier block");
 
-  std::unordered_set<Block*> buffer_visited;
+  FlatHashSet<Block*> buffer_visited;
   std::vector<Block*> buffer_path;
   std::vector<detail::BlockChildren> buffer_stack;
 
-  std::unordered_set<Block*>* visited;
+  FlatHashSet<Block*>* visited;
   std::vector<Block*>* path;
   std::vector<detail::BlockChildren>* stack;
 
@@ -98,23 +98,23 @@ void analysis::get_blocks_inbetween(Block* from,
   }
 }
 
-std::unordered_set<Block*> analysis::get_blocks_inbetween(Block* from,
-                                                          Block* to,
-                                                          Block* barrier,
-                                                          PathAnalysisWorkData* work_data) {
-  std::unordered_set<Block*> blocks_inbetween;
+FlatHashSet<Block*> analysis::get_blocks_inbetween(Block* from,
+                                                   Block* to,
+                                                   Block* barrier,
+                                                   PathAnalysisWorkData* work_data) {
+  FlatHashSet<Block*> blocks_inbetween;
   get_blocks_inbetween(from, to, barrier, blocks_inbetween, work_data);
   return blocks_inbetween;
 }
 
 void analysis::get_blocks_from_dominator_to_target(Block* dominator,
                                                    Block* target,
-                                                   std::unordered_set<Block*>& blocks_inbetween,
+                                                   FlatHashSet<Block*>& blocks_inbetween,
                                                    PathAnalysisWorkData* work_data) {
-  std::unordered_set<Block*> buffer_visited;
+  FlatHashSet<Block*> buffer_visited;
   std::vector<Block*> buffer_stack;
 
-  std::unordered_set<Block*>* visited;
+  FlatHashSet<Block*>* visited;
   std::vector<Block*>* stack;
 
   if (work_data) {
@@ -160,11 +160,11 @@ void analysis::get_blocks_from_dominator_to_target(Block* dominator,
   blocks_inbetween.insert(dominator);
 }
 
-std::unordered_set<Block*> analysis::get_blocks_from_dominator_to_target(
+FlatHashSet<Block*> analysis::get_blocks_from_dominator_to_target(
   Block* dominator,
   Block* target,
   PathAnalysisWorkData* work_data) {
-  std::unordered_set<Block*> blocks_inbetween;
+  FlatHashSet<Block*> blocks_inbetween;
   get_blocks_from_dominator_to_target(dominator, target, blocks_inbetween, work_data);
   return blocks_inbetween;
 }
@@ -173,7 +173,7 @@ size_t PathValidator::CacheKeyHash::operator()(const PathValidator::CacheKey& p)
   return combine_hash(p.start, p.end, p.memory_kill_target);
 }
 
-bool PathValidator::get_blocks_to_check(const std::unordered_set<Block*>*& blocks_to_check,
+bool PathValidator::get_blocks_to_check(const FlatHashSet<Block*>*& blocks_to_check,
                                         const DominatorTree& dominator_tree,
                                         Instruction* start,
                                         Instruction* end,
@@ -194,7 +194,7 @@ bool PathValidator::get_blocks_to_check(const std::unordered_set<Block*>*& block
     return false;
   }
 
-  std::unordered_set<Block*> blocks;
+  FlatHashSet<Block*> blocks;
   get_blocks_from_dominator_to_target(start_block, end_block, blocks, &work_data);
 
   // Remove `start` and `end` blocks as they will be only checked partially.
@@ -251,7 +251,7 @@ std::optional<size_t> PathValidator::validate_path(const DominatorTree& dominato
     return instruction_count;
   }
 
-  const std::unordered_set<Block*>* blocks_to_check;
+  const FlatHashSet<Block*>* blocks_to_check;
   if (!get_blocks_to_check(blocks_to_check, dominator_tree, start, end, kill_target)) {
     return std::nullopt;
   }
@@ -326,7 +326,7 @@ std::optional<size_t> PathValidator::validate_path_count(const DominatorTree& do
     return instruction_count;
   }
 
-  const std::unordered_set<Block*>* blocks_to_check;
+  const FlatHashSet<Block*>* blocks_to_check;
   if (!get_blocks_to_check(blocks_to_check, dominator_tree, start, end, MemoryKillTarget::None)) {
     return std::nullopt;
   }
@@ -1,7 +1,7 @@
 #pragma once
 #include <optional>
-#include <unordered_map>
-#include <unordered_set>
+
+#include <Flugzeug/Core/FlatHashMap.hpp>
 
 #include <Flugzeug/IR/Block.hpp>
 
@@ -37,14 +37,14 @@ class PathAnalysisWorkData {
   friend void get_blocks_inbetween(Block* from,
                                    Block* to,
                                    Block* barrier,
-                                   std::unordered_set<Block*>& blocks_inbetween,
+                                   FlatHashSet<Block*>& blocks_inbetween,
                                    PathAnalysisWorkData* work_data);
   friend void get_blocks_from_dominator_to_target(Block* dominator,
                                                   Block* target,
-                                                  std::unordered_set<Block*>& blocks_inbetween,
+                                                  FlatHashSet<Block*>& blocks_inbetween,
                                                   PathAnalysisWorkData* work_data);
 
-  std::unordered_set<Block*> visited;
+  FlatHashSet<Block*> visited;
   std::vector<Block*> blocks;
   std::vector<detail::BlockChildren> children;
 };
@@ -52,21 +52,20 @@ class PathAnalysisWorkData {
 void get_blocks_inbetween(Block* from,
                           Block* to,
                           Block* barrier,
-                          std::unordered_set<Block*>& blocks_inbetween,
+                          FlatHashSet<Block*>& blocks_inbetween,
                           PathAnalysisWorkData* work_data = nullptr);
-std::unordered_set<Block*> get_blocks_inbetween(Block* from,
-                                                Block* to,
-                                                Block* barrier,
-                                                PathAnalysisWorkData* work_data = nullptr);
+FlatHashSet<Block*> get_blocks_inbetween(Block* from,
+                                         Block* to,
+                                         Block* barrier,
+                                         PathAnalysisWorkData* work_data = nullptr);
 
 void get_blocks_from_dominator_to_target(Block* dominator,
                                          Block* target,
-                                         std::unordered_set<Block*>& blocks_inbetween,
+                                         FlatHashSet<Block*>& blocks_inbetween,
                                          PathAnalysisWorkData* work_data = nullptr);
-std::unordered_set<Block*> get_blocks_from_dominator_to_target(
-  Block* dominator,
-  Block* target,
-  PathAnalysisWorkData* work_data = nullptr);
+FlatHashSet<Block*> get_blocks_from_dominator_to_target(Block* dominator,
+                                                        Block* target,
+                                                        PathAnalysisWorkData* work_data = nullptr);
 
 class PathValidator {
  public:
@@ -94,9 +93,9 @@ class PathValidator {
 
   PathAnalysisWorkData work_data;
 
-  std::unordered_map<CacheKey, std::unordered_set<Block*>, CacheKeyHash> cache;
+  FlatHashMap<CacheKey, FlatHashSet<Block*>, CacheKeyHash> cache;
 
-  bool get_blocks_to_check(const std::unordered_set<Block*>*& blocks_to_check,
+  bool get_blocks_to_check(const FlatHashSet<Block*>*& blocks_to_check,
                            const DominatorTree& dominator_tree,
                            Instruction* start,
                            Instruction* end,
@@ -4,36 +4,36 @@
 #include <Flugzeug/IR/InstructionVisitor.hpp>
 #include <Flugzeug/IR/Patterns.hpp>
 
-#include <Flugzeug/Core/HashCombine.hpp>
 #include <Flugzeug/Core/Log.hpp>
 
+#include <algorithm>
+
 using namespace flugzeug;
 using namespace flugzeug::analysis;
 
 using analysis::detail::PointerOriginMap;
+using analysis::detail::SymbolicOffset;
 
-template <typename T>
-struct ValuePairHash {
-  size_t operator()(const std::pair<const Value*, const Value*>& p) const {
-    return combine_hash(p.first, p.second);
-  }
-};
+/// Maximum depth of index expressions which are inspected to compute known bits.
+constexpr size_t max_known_bits_depth = 6;
 
-using BaseIndexToOffset = std::
-  unordered_map<std::pair<const Value*, const Value*>, const Offset*, ValuePairHash<const Value*>>;
+struct IndexKnownBits {
+  uint64_t mask = 0;
+  uint64_t value = 0;
+};
 
-template <typename K, typename V>
-std::optional<V> lookup_map(const std::unordered_map<K, V>& map, K key) {
-  const auto it = map.find(key);
-  if (it == map.end()) {
+template <typename V>
+std::optional<V> lookup_map(const ValueMap<V>& map, const Value* key) {
+  const auto value = map.find(key);
+  if (!value) {
     return std::nullopt;
   }
 
-  return it->second;
+  return *value;
 }
 
 void PointerOriginMap::insert(const Value* value, const Value* origin) {
-  verify(map.insert({value, origin}).second, "Value was already present in the origin map");
+  verify(map.insert(value, origin), "Value was already present in the origin map");
 }
 
 const Value* PointerOriginMap::get(const Value* value, bool presence_required) const {
@@ -41,8 +41,8 @@ const Value* PointerOriginMap::get(const Value* value, bool presence_required) c
     return value;
   }
 
-  const auto it = map.find(value);
-  if (it == map.end()) {
+  const auto origin = map.find(value);
+  if (!origin) {
     if (presence_required) {
       fatal_error("Failed to get value origin from the map");
     } else {
@@ -50,7 +50,7 @@ const Value* PointerOriginMap::get(const Value* value, bool presence_required) c
     }
   }
 
-  return it->second;
+  return *origin;
 }
 
 class PointerOriginCalculator : public ConstInstructionVisitor {
@@ -113,11 +113,11 @@ class PointerOriginCalculator : public ConstInstructionVisitor {
 };
 
 class PointerSafetyCalculator : public ConstInstructionVisitor {
-  const std::unordered_set<const Value*>& safe_pointers;
+  const DenseBitSet& safe_pointers;
   const Value* pointer;
 
  public:
-  explicit PointerSafetyCalculator(const std::unordered_set<const Value*>& safe_pointers,
+  explicit PointerSafetyCalculator(const DenseBitSet& safe_pointers,
                                    const Value* pointer)
       : safe_pointers(safe_pointers), pointer(pointer) {}
 
@@ -133,12 +133,12 @@ class PointerSafetyCalculator : public ConstInstructionVisitor {
   bool visit_offset(Argument<Offset> offset) {
     // Offset returns memory which belongs to the source pointer. Make sure that offset return value
     // is safely used.
-    return offset->base() == pointer && safe_pointers.contains(offset);
+    return offset->base() == pointer && safe_pointers.contains(offset->dense_index());
   }
 
   bool visit_phi(Argument<Phi> phi) {
     // If Phi pointer safety wasn't computed then assume that it is unsafe.
-    return safe_pointers.contains(phi);
+    return safe_pointers.contains(phi->dense_index());
   }
 
   bool visit_call(Argument<Call> call) { return false; }
@@ -151,69 +151,251 @@ class PointerSafetyCalculator : public ConstInstructionVisitor {
   bool visit_cond_branch(Argument<CondBranch> cond_branch) { return false; }
 };
 
-static void process_offset_instruction(
-  const Offset* offset,
-  std::unordered_map<const Value*, std::pair<const Value*, int64_t>>& constant_offset_db,
-  BaseIndexToOffset& base_index_to_offset) {
-  const auto base = offset->base();
-  const auto index = offset->index();
+static uint64_t low_bits_mask(size_t count) {
+  return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+}
 
-  if (const auto c_index = cast<Constant>(index)) {
-    std::pair result = {base, c_index->value_i()};
+static size_t known_trailing_zeros(const IndexKnownBits& bits, size_t bit_size) {
+  size_t count = 0;
+  while (count < bit_size && ((bits.mask >> count) & 1) != 0 && ((bits.value >> count) & 1) == 0) {
+    count++;
+  }
+  return count;
+}
 
-    const auto it = constant_offset_db.find(base);
-    if (it != constant_offset_db.end()) {
-      const auto parent = it->second;
-      result = {parent.first, parent.second + c_index->value_i()};
+static IndexKnownBits add_known_bits(const IndexKnownBits& a,
+                                     const IndexKnownBits& b,
+                                     size_t bit_size) {
+  IndexKnownBits computed{};
+  uint64_t carry = 0;
+
+  // Result bits are known up to the first bit which is unknown in any operand.
+  for (size_t i = 0; i < bit_size; ++i) {
+    const uint64_t m = uint64_t(1) << i;
+    if ((a.mask & m) == 0 || (b.mask & m) == 0) {
+      break;
     }
 
-    constant_offset_db.insert({offset, result});
-    return;
+    const uint64_t result = ((a.value >> i) & 1) + ((b.value >> i) & 1) + carry;
+
+    computed.value |= (result & 1) << i;
+    computed.mask |= m;
+
+    carry = result >> 1;
   }
 
-  base_index_to_offset[std::pair{base, index}] = offset;
+  return computed;
+}
 
-  const Value* index_base;
-  int64_t index_add;
-  if (match_pattern(index, pat::add(pat::value(index_base), pat::constant_i(index_add)))) {
-    const Offset* other_offset;
-    {
-      const auto it = base_index_to_offset.find(std::pair{base, index_base});
-      if (it == base_index_to_offset.end()) {
-        return;
+static IndexKnownBits compute_known_bits(const Value* value, size_t depth) {
+  const auto bit_size = value->type()->bit_size();
+  const auto type_mask = value->type()->bit_mask();
+
+  if (const auto constant = cast<Constant>(value)) {
+    return IndexKnownBits{.mask = type_mask, .value = constant->value_u() & type_mask};
+  }
+
+  if (depth >= max_known_bits_depth) {
+    return {};
+  }
+
+  if (const auto binary = cast<BinaryInstr>(value)) {
+    const auto lhs = compute_known_bits(binary->lhs(), depth + 1);
+    const auto rhs = compute_known_bits(binary->rhs(), depth + 1);
+
+    switch (binary->op()) {
+      case BinaryOp::Add:
+        return add_known_bits(lhs, rhs, bit_size);
+
+      case BinaryOp::Mul: {
+        const auto zeros = std::min(
+          bit_size, known_trailing_zeros(lhs, bit_size) + known_trailing_zeros(rhs, bit_size));
+        return IndexKnownBits{.mask = low_bits_mask(zeros), .value = 0};
+      }
+
+      case BinaryOp::Shl: {
+        const auto amount = cast<Constant>(binary->rhs());
+        if (!amount || amount->value_u() >= bit_size) {
+          return {};
+        }
+
+        const auto shift = amount->value_u();
+        return IndexKnownBits{
+          .mask = ((lhs.mask << shift) | low_bits_mask(shift)) & type_mask,
+          .value = (lhs.value << shift) & type_mask,
+        };
+      }
+
+      case BinaryOp::And: {
+        const auto zeros = (lhs.mask & ~lhs.value) | (rhs.mask & ~rhs.value);
+        const auto ones = lhs.value & rhs.value;
+        return IndexKnownBits{.mask = zeros | ones, .value = ones};
+      }
+
+      case BinaryOp::Or: {
+        const auto zeros = (lhs.mask & ~lhs.value) & (rhs.mask & ~rhs.value);
+        const auto ones = lhs.value | rhs.value;
+        return IndexKnownBits{.mask = zeros | ones, .value = ones};
+      }
+
+      default:
+        return {};
+    }
+  }
+
+  if (const auto cast_instr = cast<Cast>(value)) {
+    const auto casted_value = cast_instr->casted_value();
+    if (!casted_value->type()->is_arithmetic()) {
+      return {};
+    }
+
+    const auto bits = compute_known_bits(casted_value, depth + 1);
+    const auto extended_mask = type_mask & ~casted_value->type()->bit_mask();
+
+    switch (cast_instr->cast_kind()) {
+      case CastKind::ZeroExtend:
+        return IndexKnownBits{.mask = bits.mask | extended_mask, .value = bits.value};
+
+      case CastKind::SignExtend: {
+        const auto sign_bit = casted_value->type()->bit_size() - 1;
+        if (((bits.mask >> sign_bit) & 1) == 0) {
+          return bits;
+        }
+
+        const bool negative = ((bits.value >> sign_bit) & 1) != 0;
+        return IndexKnownBits{
+          .mask = bits.mask | extended_mask,
+          .value = bits.value | (negative ? extended_mask : 0),
+        };
       }
-      other_offset = it->second;
+
+      case CastKind::Truncate:
+        return IndexKnownBits{.mask = bits.mask & type_mask, .value = bits.value & type_mask};
+
+      default:
+        return {};
     }
+  }
+
+  return {};
+}
+
+/// Entry block has no predecessors so its instructions (like all non-instruction values) are
+/// computed at most once per function execution.
+static bool is_invariant(const Value* value) {
+  const auto instruction = cast<Instruction>(value);
+  return !instruction || instruction->block()->is_entry_block();
+}
 
-    std::pair<const Value*, int64_t> result = {other_offset, index_add};
+static SymbolicOffset decompose_offset(const Offset* offset,
+                                       const ValueMap<SymbolicOffset>& symbolic_offset_db) {
+  const auto base = offset->base();
+  const auto index = offset->index();
 
-    const auto it = constant_offset_db.find(other_offset);
-    if (it != constant_offset_db.end()) {
-      const auto parent = it->second;
-      result = {parent.first, Constant::constrain_i(index_base->type(), parent.second + index_add)};
+  SymbolicOffset parent{.base = base, .is_invariant = is_invariant(base)};
+  if (const auto parent_offset = symbolic_offset_db.find(base)) {
+    parent = *parent_offset;
+  }
+
+  if (const auto c_index = cast<Constant>(index)) {
+    parent.constant += c_index->value_i();
+    return parent;
+  }
+
+  // Split constant addend from the index.
+  const Value* variable = index;
+  int64_t addend = 0;
+  {
+    const Value* add_lhs;
+    int64_t add_rhs;
+    if (match_pattern(index, pat::add(pat::value(add_lhs), pat::constant_i(add_rhs)))) {
+      variable = add_lhs;
+      addend = add_rhs;
     }
+  }
+
+  // 64 bit index additions wrap together with the address, so the addend can be moved to the
+  // constant part. Smaller indices are sign extended after the addition.
+  const auto bit_size = index->type()->bit_size();
+  const bool wide_index = bit_size == 64;
+  const auto known_bits = compute_known_bits(variable, 0);
+
+  SymbolicOffset result{
+    .base = parent.base,
+    .index = variable,
+    .index_addend = wide_index ? 0 : addend,
+    .constant = parent.constant + (wide_index ? addend : 0),
+    .index_bit_size = bit_size,
+    .index_known_mask = known_bits.mask,
+    .index_known_value = known_bits.value,
+    .is_invariant = parent.is_invariant && is_invariant(variable),
+  };
+
+  // Two variable indices cannot be combined, use the direct base instead.
+  if (parent.index) {
+    result.base = base;
+    result.constant = wide_index ? addend : 0;
+    result.is_invariant = is_invariant(base) && is_invariant(variable);
+  }
 
-    constant_offset_db.insert({offset, result});
+  return result;
+}
+
+/// Returns true if known bits prove that two offsets from the same base point to different
+/// elements.
+static bool are_indices_different(const SymbolicOffset& a, const SymbolicOffset& b) {
+  if (a.index && b.index && a.index_bit_size != b.index_bit_size) {
+    return false;
   }
+
+  const auto bit_size = a.index ? a.index_bit_size : b.index_bit_size;
+  const auto type_mask = low_bits_mask(bit_size);
+
+  // Constant parts of 64 bit indices are compared together with the index. Smaller indices are
+  // sign extended, so constant parts must match to compare just the indices.
+  const bool wide_index = bit_size == 64;
+  if (!wide_index && a.constant != b.constant) {
+    return false;
+  }
+
+  if (a.index == b.index) {
+    return ((a.index_addend ^ b.index_addend) & type_mask) != 0;
+  }
+
+  const auto get_index_bits = [&](const SymbolicOffset& offset) {
+    const auto addend = uint64_t(wide_index ? offset.constant : offset.index_addend);
+    const IndexKnownBits addend_bits{.mask = type_mask, .value = addend & type_mask};
+
+    if (!offset.index) {
+      return addend_bits;
+    }
+
+    const IndexKnownBits index_bits{
+      .mask = offset.index_known_mask,
+      .value = offset.index_known_value,
+    };
+    return add_known_bits(index_bits, addend_bits, bit_size);
+  };
+
+  const auto a_bits = get_index_bits(a);
+  const auto b_bits = get_index_bits(b);
+
+  return ((a_bits.value ^ b_bits.value) & a_bits.mask & b_bits.mask) != 0;
 }
 
-std::pair<const Value*, int64_t> PointerAliasing::get_constant_offset(const Value* value) const {
-  const auto it = constant_offset_db.find(value);
-  if (it == constant_offset_db.end()) {
-    return {value, 0};
+SymbolicOffset PointerAliasing::get_symbolic_offset(const Value* value) const {
+  if (const auto offset = symbolic_offset_db.find(value)) {
+    return *offset;
   }
 
-  return it->second;
+  return SymbolicOffset{.base = value, .is_invariant = is_invariant(value)};
 }
 
-PointerAliasing::PointerAliasing(const Function* function) {
+PointerAliasing::PointerAliasing(const Function* function)
+    : pointer_origin_map(function), stackalloc_safety(function), symbolic_offset_db(function) {
   const auto traversal = function->entry_block()->reachable_blocks(TraversalType::DFS_WithStart);
 
-  size_t offset_instruction_count = 0;
-  size_t pointer_instruction_count = 0;
-  size_t stackalloc_instruction_count = 0;
-
-  std::unordered_set<const Value*> safe_pointers;
+  DenseBitSet safe_pointers(function->value_index_capacity());
   {
     // Reverse ordering so every value is used before being created.
     //
@@ -228,14 +410,6 @@ PointerAliasing::PointerAliasing(const Function* function) {
           continue;
         }
 
-        pointer_instruction_count++;
-        if (const auto offset = cast<Offset>(instruction)) {
-          offset_instruction_count++;
-        }
-        if (const auto stackalloc = cast<StackAlloc>(instruction)) {
-          stackalloc_instruction_count++;
-        }
-
         PointerSafetyCalculator safety_calculator(safe_pointers, &instruction);
         bool safe = true;
 
@@ -250,7 +424,7 @@ PointerAliasing::PointerAliasing(const Function* function) {
         }
 
         if (safe) {
-          safe_pointers.insert(&instruction);
+          safe_pointers.insert(instruction.dense_index());
         }
       }
     }
@@ -258,16 +432,10 @@ PointerAliasing::PointerAliasing(const Function* function) {
 
   {
     PointerOriginCalculator origin_calculator(pointer_origin_map);
-    BaseIndexToOffset base_index_to_offset;
-
-    base_index_to_offset.reserve(offset_instruction_count);
-    constant_offset_db.reserve(offset_instruction_count);
-    pointer_origin_map.reserve(pointer_instruction_count);
-    stackalloc_safety.reserve(stackalloc_instruction_count);
 
     // Get origin of all pointers used in the function.
     // Save safety of stackallocs.
-    // Save constant pointer offsets.
+    // Save symbolic pointer offsets.
     for (const Block* block : traversal) {
       for (const Instruction& instruction : *block) {
         if (!instruction.type()->is_pointer()) {
@@ -280,13 +448,13 @@ PointerAliasing::PointerAliasing(const Function* function) {
 
         // Get information about `stackalloc`: check if it's safely used and can't escape.
         if (const auto stackalloc = cast<StackAlloc>(instruction)) {
-          const bool safe = safe_pointers.contains(stackalloc);
-          stackalloc_safety.insert({stackalloc, safe});
+          const bool safe = safe_pointers.contains(stackalloc->dense_index());
+          stackalloc_safety.insert(stackalloc, safe);
         }
 
-        // Get information about constant pointer offsets.
+        // Decompose pointer offsets so offsets from the same base can be compared.
         if (const auto offset = cast<Offset>(&instruction)) {
-          process_offset_instruction(offset, constant_offset_db, base_index_to_offset);
+          symbolic_offset_db.insert(offset, decompose_offset(offset, symbolic_offset_db));
         }
       }
     }
@@ -295,7 +463,8 @@ PointerAliasing::PointerAliasing(const Function* function) {
 
 Aliasing PointerAliasing::can_alias(const Instruction* instruction,
                                     const Value* v1,
-                                    const Value* v2) const {
+                                    const Value* v2,
+                                    IterationScope scope) const {
   verify(v1->type()->is_pointer() && v2->type()->is_pointer(), "Provided values aren't pointers");
 
   // More advanced alias analysis would make use of this instruction.
@@ -306,17 +475,29 @@ Aliasing PointerAliasing::can_alias(const Instruction* instruction,
     return Aliasing::Never;
   }
 
-  // If two pointers are the same they always alias.
-  if (v1 == v2) {
-    return Aliasing::Always;
-  }
-
   {
-    const auto offset_1 = get_constant_offset(v1);
-    const auto offset_2 = get_constant_offset(v2);
+    const auto offset_1 = get_symbolic_offset(v1);
+    const auto offset_2 = get_symbolic_offset(v2);
+
+    // In different iterations only invariant pointers can be compared by their values.
+    const bool comparable = scope == IterationScope::Same ||
+                            (offset_1.is_invariant && offset_2.is_invariant);
 
-    if (offset_1.first == offset_2.first) {
-      return offset_1.second != offset_2.second ? Aliasing::Never : Aliasing::Always;
+    // If two pointers are the same they always alias.
+    if (v1 == v2 && comparable) {
+      return Aliasing::Always;
+    }
+
+    // Pointers derived from the same base have the same type, so they access whole elements and
+    // pointers to different elements never alias.
+    if (offset_1.base == offset_2.base && comparable) {
+      if (offset_1.index == offset_2.index && offset_1.index_addend == offset_2.index_addend) {
+        return offset_1.constant != offset_2.constant ? Aliasing::Never : Aliasing::Always;
+      }
+
+      if (are_indices_different(offset_1, offset_2)) {
+        return Aliasing::Never;
+      }
     }
   }
 
@@ -361,18 +542,19 @@ Aliasing PointerAliasing::can_alias(const Instruction* instruction,
 
 Aliasing PointerAliasing::can_instruction_access_pointer(const Instruction* instruction,
                                                          const Value* pointer,
-                                                         AccessType access_type) const {
+                                                         AccessType access_type,
+                                                         IterationScope scope) const {
   verify(pointer->type()->is_pointer(), "Provided value is not a pointer");
 
   if (access_type == AccessType::Store || access_type == AccessType::All) {
     if (const auto store = cast<Store>(instruction)) {
-      return can_alias(store, store->address(), pointer);
+      return can_alias(store, store->address(), pointer, scope);
     }
   }
 
   if (access_type == AccessType::Load || access_type == AccessType::All) {
     if (const auto load = cast<Load>(instruction)) {
-      return can_alias(load, load->address(), pointer);
+      return can_alias(load, load->address(), pointer, scope);
     }
   }
 
@@ -452,9 +634,9 @@ bool PointerAliasing::is_pointer_stackalloc(const Value* pointer) const {
 
 std::optional<std::pair<const StackAlloc*, int64_t>>
 PointerAliasing::get_constant_offset_from_stackalloc(const Value* pointer) const {
-  const auto [base, offset] = get_constant_offset(pointer);
-  if (lookup_map(stackalloc_safety, base)) {
-    return std::pair{cast<StackAlloc>(base), offset};
+  const auto offset = get_symbolic_offset(pointer);
+  if (!offset.index && lookup_map(stackalloc_safety, offset.base)) {
+    return std::pair{cast<StackAlloc>(offset.base), offset.constant};
   } else {
     return std::nullopt;
   }
@@ -475,9 +657,14 @@ void PointerAliasing::debug_dump() const {
   }
   log_debug("");
 
-  log_debug("Constant offsets:");
-  for (auto [pointer, offset] : constant_offset_db) {
-    log_debug("  {} = {} + {}", pointer->format(), offset.first->format(), offset.second);
+  log_debug("Symbolic offsets:");
+  for (auto [pointer, offset] : symbolic_offset_db) {
+    if (offset.index) {
+      log_debug("  {} = {} + ({} + {}) + {}", pointer->format(), offset.base->format(),
+                offset.index->format(), offset.index_addend, offset.constant);
+    } else {
+      log_debug("  {} = {} + {}", pointer->format(), offset.base->format(), offset.constant);
+    }
   }
   log_debug("");
 }
@@ -1,16 +1,17 @@
 #pragma once
 #include <Flugzeug/IR/Instructions.hpp>
 #include <Flugzeug/IR/Value.hpp>
+#include <Flugzeug/IR/ValueMap.hpp>
 
 namespace flugzeug::analysis {
 
 namespace detail {
 
 class PointerOriginMap {
-  std::unordered_map<const Value*, const Value*> map;
+  ValueMap<const Value*> map;
 
  public:
-  void reserve(size_t size) { map.reserve(size); }
+  explicit PointerOriginMap(const Function* function) : map(function) {}
 
   auto begin() const { return map.begin(); }
   auto end() const { return map.end(); }
@@ -19,6 +20,24 @@ class PointerOriginMap {
   const Value* get(const Value* value, bool presence_required = true) const;
 };
 
+/// Pointer decomposed to `base + sext(index + index_addend) + constant` elements. `index` is null
+/// for constant offsets. Addends of 64 bit indices are folded into `constant`. Known bits of the
+/// index and its invariance are computed upfront as the index may be destroyed while the analysis
+/// is in use.
+struct SymbolicOffset {
+  const Value* base = nullptr;
+  const Value* index = nullptr;
+  int64_t index_addend = 0;
+  int64_t constant = 0;
+
+  size_t index_bit_size = 0;
+  uint64_t index_known_mask = 0;
+  uint64_t index_known_value = 0;
+
+  /// Base and index are computed at most once per function execution.
+  bool is_invariant = false;
+};
+
 }  // namespace detail
 
 enum class Aliasing {
@@ -29,10 +48,10 @@ enum class Aliasing {
 
 class PointerAliasing {
   detail::PointerOriginMap pointer_origin_map;
-  std::unordered_map<const Value*, bool> stackalloc_safety;
-  std::unordered_map<const Value*, std::pair<const Value*, int64_t>> constant_offset_db;
+  ValueMap<bool> stackalloc_safety;
+  ValueMap<detail::SymbolicOffset> symbolic_offset_db;
 
-  std::pair<const Value*, int64_t> get_constant_offset(const Value* value) const;
+  detail::SymbolicOffset get_symbolic_offset(const Value* value) const;
 
  public:
   enum class AccessType {
@@ -41,12 +60,23 @@ class PointerAliasing {
     All,
   };
 
+  /// Accesses compared across a loop back edge (e.g. by memory SSA walks going through Phis) can
+  /// come from different iterations. The same instruction can have different values in them.
+  enum class IterationScope {
+    Same,
+    Any,
+  };
+
   explicit PointerAliasing(const Function* function);
 
-  Aliasing can_alias(const Instruction* instruction, const Value* v1, const Value* v2) const;
+  Aliasing can_alias(const Instruction* instruction,
+                     const Value* v1,
+                     const Value* v2,
+                     IterationScope scope = IterationScope::Same) const;
   Aliasing can_instruction_access_pointer(const Instruction* instruction,
                                           const Value* pointer,
-                                          AccessType access_type) const;
+                                          AccessType access_type,
+                                          IterationScope scope = IterationScope::Same) const;
 
   bool is_pointer_accessed_inbetween(const Value* pointer,
                                      const Instruction* begin,
@@ -25,10 +25,10 @@ struct SccContext {
 };
 
 namespace detail {
-template <typename T, bool SkipTrivialNonLoopingSCCs, typename Fn>
+template <typename T, bool SkipTrivialNonLoopingSCCs, typename TSet, typename Fn>
 static void scc_visit(SccContext<T>& context,
                       T value,
-                      const std::unordered_set<T>& value_set,
+                      const TSet& value_set,
                       const Fn& get_neighbours) {
   const auto get_vertex = [&](T value) -> typename SccContext<T>::VertexData& {
     const auto it = context.indices.find(value);
@@ -63,7 +63,8 @@ static void scc_visit(SccContext<T>& context,
         current_vertex.lowlink = std::min(current_vertex.lowlink, *other_index);
       }
     } else {
-      scc_visit<T, SkipTrivialNonLoopingSCCs, Fn>(context, other, value_set, get_neighbours);
+      scc_visit<T, SkipTrivialNonLoopingSCCs, TSet, Fn>(context, other, value_set,
+                                                        get_neighbours);
 
       current_vertex.lowlink = std::min(current_vertex.lowlink, other_vertex.lowlink);
     }
@@ -112,9 +113,10 @@ static void scc_visit(SccContext<T>& context,
 }
 }  // namespace detail
 
-template <typename T, bool SkipTrivialNonLoopingSCCs, typename Fn>
+/// `values` can be any set of `T` which supports iteration and `contains` (e.g. `BlockSet`).
+template <typename T, bool SkipTrivialNonLoopingSCCs, typename TSet, typename Fn>
 std::vector<std::vector<T>> calculate_sccs(SccContext<T>& context,
-                                           const std::unordered_set<T>& values,
+                                           const TSet& values,
                                            const Fn& get_neighbours) {
   // Clear the context.
   context.index = 0;
@@ -134,7 +136,8 @@ std::vector<std::vector<T>> calculate_sccs(SccContext<T>& context,
   context.vertices.resize(values.size());
 
   for (T value : values) {
-    detail::scc_visit<T, SkipTrivialNonLoopingSCCs, Fn>(context, value, values, get_neighbours);
+    detail::scc_visit<T, SkipTrivialNonLoopingSCCs, TSet, Fn>(context, value, values,
+                                                              get_neighbours);
   }
 
   verify(context.stack.empty(), "SCC stack is not empty at the end of the calculation");
@@ -142,11 +145,10 @@ std::vector<std::vector<T>> calculate_sccs(SccContext<T>& context,
   return std::move(context.sccs);
 }
 
-template <typename T, bool SkipTrivialNonLoopingSCCs, typename Fn>
-std::vector<std::vector<T>> calculate_sccs(const std::unordered_set<T>& values,
-                                           const Fn& get_neighbours) {
+template <typename T, bool SkipTrivialNonLoopingSCCs, typename TSet, typename Fn>
+std::vector<std::vector<T>> calculate_sccs(const TSet& values, const Fn& get_neighbours) {
   SccContext<T> context{};
-  return calculate_sccs<T, SkipTrivialNonLoopingSCCs, Fn>(context, values, get_neighbours);
+  return calculate_sccs<T, SkipTrivialNonLoopingSCCs, TSet, Fn>(context, values, get_neighbours);
 }
 
 }  // namespace flugzeug::analysis
\ No newline at end of file
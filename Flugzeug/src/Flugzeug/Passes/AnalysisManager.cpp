@@ -0,0 +1,130 @@
+#include "AnalysisManager.hpp"
+
+#include <Flugzeug/Core/Error.hpp>
+#include <Flugzeug/IR/Function.hpp>
+
+using namespace flugzeug;
+
+const DominatorTree& AnalysisManager::dominator_tree() {
+  if (!dominator_tree_) {
+    dominator_tree_.emplace(function);
+  }
+  return *dominator_tree_;
+}
+
+const std::vector<std::unique_ptr<analysis::Loop>>& AnalysisManager::loops() {
+  if (!loops_) {
+    loops_ = analysis::analyze_function_loops(function, dominator_tree());
+  }
+  return *loops_;
+}
+
+const analysis::PointerAliasing& AnalysisManager::pointer_aliasing() {
+  if (!pointer_aliasing_) {
+    pointer_aliasing_.emplace(function);
+  }
+  return *pointer_aliasing_;
+}
+
+const PostDominatorTree& AnalysisManager::post_dominator_tree() {
+  if (!post_dominator_tree_) {
+    post_dominator_tree_.emplace(function);
+  }
+  return *post_dominator_tree_;
+}
+
+const analysis::DominanceFrontiers& AnalysisManager::dominance_frontiers() {
+  if (!dominance_frontiers_) {
+    dominance_frontiers_.emplace(function, dominator_tree());
+  }
+  return *dominance_frontiers_;
+}
+
+const analysis::Liveness& AnalysisManager::liveness() {
+  if (!liveness_) {
+    liveness_.emplace(function);
+  }
+  return *liveness_;
+}
+
+const std::vector<Block*>& AnalysisManager::dfs_block_order() {
+  if (!dfs_block_order_) {
+    dfs_block_order_ = function->entry_block()->reachable_blocks(TraversalType::DFS_WithStart);
+  }
+  return *dfs_block_order_;
+}
+
+bool AnalysisManager::is_cached(Analysis analysis) const {
+  switch (analysis) {
+    case Analysis::DominatorTree:
+      return dominator_tree_.has_value();
+    case Analysis::Loops:
+      return loops_.has_value();
+    case Analysis::PointerAliasing:
+      return pointer_aliasing_.has_value();
+    case Analysis::BlockOrder:
+      return dfs_block_order_.has_value();
+    case Analysis::PostDominatorTree:
+      return post_dominator_tree_.has_value();
+    case Analysis::DominanceFrontiers:
+      return dominance_frontiers_.has_value();
+    case Analysis::Liveness:
+      return liveness_.has_value();
+
+    default:
+      unreachable();
+  }
+}
+
+void AnalysisManager::update_dominator_tree(std::span<const DominatorTree::Update> updates) {
+  if (dominator_tree_) {
+    dominator_tree_->apply_updates(updates);
+  }
+
+  invalidate(Analysis::BlockOrder);
+  invalidate(Analysis::PostDominatorTree);
+  invalidate(Analysis::DominanceFrontiers);
+}
+
+void AnalysisManager::invalidate(Analysis analysis) {
+  switch (analysis) {
+    case Analysis::DominatorTree:
+      dominator_tree_.reset();
+      break;
+    case Analysis::Loops:
+      loops_.reset();
+      break;
+    case Analysis::PointerAliasing:
+      pointer_aliasing_.reset();
+      break;
+    case Analysis::BlockOrder:
+      dfs_block_order_.reset();
+      break;
+    case Analysis::PostDominatorTree:
+      post_dominator_tree_.reset();
+      break;
+    case Analysis::DominanceFrontiers:
+      dominance_frontiers_.reset();
+      break;
+    case Analysis::Liveness:
+      liveness_.reset();
+      break;
+
+    default:
+      unreachable();
+  }
+}
+
+void AnalysisManager::invalidate_all() {
+  invalidate_all_except(PreservedAnalyses::none());
+}
+
+void AnalysisManager::invalidate_all_except(PreservedAnalyses preserved) {
+  for (const auto analysis :
+       {Analysis::DominatorTree, Analysis::Loops, Analysis::PointerAliasing, Analysis::BlockOrder,
+        Analysis::PostDominatorTree, Analysis::DominanceFrontiers, Analysis::Liveness}) {
+    if (!preserved.is_preserved(analysis)) {
+      invalidate(analysis);
+    }
+  }
+}
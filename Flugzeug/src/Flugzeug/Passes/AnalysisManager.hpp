@@ -0,0 +1,62 @@
+#pragma once
+#include "Analysis/DominanceFrontiers.hpp"
+#include "Analysis/Liveness.hpp"
+#include "Analysis/Loops.hpp"
+#include "Analysis/PointerAliasing.hpp"
+#include "Pass.hpp"
+
+#include <Flugzeug/Core/ClassTraits.hpp>
+#include <Flugzeug/IR/DominatorTree.hpp>
+#include <Flugzeug/IR/PostDominatorTree.hpp>
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace flugzeug {
+
+class Block;
+class Function;
+
+/// Lazily computes and caches function analyses. Cached results are only discarded when they
+/// are explicitly invalidated, so every modification of the function must be followed by
+/// a call to `invalidate` (FunctionPassRunner does this automatically after successful passes).
+class AnalysisManager {
+  Function* function;
+
+  std::optional<DominatorTree> dominator_tree_;
+  std::optional<std::vector<std::unique_ptr<analysis::Loop>>> loops_;
+  std::optional<analysis::PointerAliasing> pointer_aliasing_;
+  std::optional<std::vector<Block*>> dfs_block_order_;
+  std::optional<PostDominatorTree> post_dominator_tree_;
+  std::optional<analysis::DominanceFrontiers> dominance_frontiers_;
+  std::optional<analysis::Liveness> liveness_;
+
+ public:
+  CLASS_NON_MOVABLE_NON_COPYABLE(AnalysisManager)
+
+  explicit AnalysisManager(Function* function) : function(function) {}
+
+  const DominatorTree& dominator_tree();
+  const std::vector<std::unique_ptr<analysis::Loop>>& loops();
+  const analysis::PointerAliasing& pointer_aliasing();
+  const PostDominatorTree& post_dominator_tree();
+  const analysis::DominanceFrontiers& dominance_frontiers();
+  const analysis::Liveness& liveness();
+
+  /// Blocks reachable from the entry block in DFS order (entry block included).
+  const std::vector<Block*>& dfs_block_order();
+
+  bool is_cached(Analysis analysis) const;
+
+  /// Repairs cached dominator tree after CFG edits instead of discarding it. Other cached CFG
+  /// analyses are invalidated.
+  void update_dominator_tree(std::span<const DominatorTree::Update> updates);
+
+  void invalidate(Analysis analysis);
+  void invalidate_all();
+  void invalidate_all_except(PreservedAnalyses preserved);
+};
+
+}  // namespace flugzeug
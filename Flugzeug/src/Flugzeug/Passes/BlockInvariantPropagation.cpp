@@ -1,4 +1,7 @@
 #include "BlockInvariantPropagation.hpp"
+#include "AnalysisManager.hpp"
+
+#include <Flugzeug/Core/FlatHashMap.hpp>
 
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
@@ -57,7 +60,7 @@ static std::optional<std::pair<Value*, Value*>> get_edge_invariant(Block* from,
   return std::nullopt;
 }
 
-bool opt::BlockInvariantPropagation::run(Function* function) {
+bool opt::BlockInvariantPropagation::run(Function*, AnalysisManager& analysis_manager) {
   // Certain blocks have invariants and to be reached some condition must be true.
   // if (x == y) { block1 }
   // In this case in block1 it is known that x == y. If one of these is constant we will
@@ -66,10 +69,10 @@ bool opt::BlockInvariantPropagation::run(Function* function) {
   bool did_something = false;
 
   // We need to traverse blocks in the DFS order.
-  const auto blocks = function->entry_block()->reachable_blocks(TraversalType::DFS_WithStart);
+  const auto& blocks = analysis_manager.dfs_block_order();
 
-  std::unordered_map<Block*, std::unordered_map<Value*, Value*>> block_invariants;
-  std::vector<std::unordered_map<Value*, Value*>> predecessor_invariants;
+  FlatHashMap<Block*, FlatHashMap<Value*, Value*>> block_invariants;
+  std::vector<FlatHashMap<Value*, Value*>> predecessor_invariants;
 
   for (Block* block : blocks) {
     // Entry block doesn't have any invariants so nothing can be optimized.
@@ -118,7 +121,7 @@ bool opt::BlockInvariantPropagation::run(Function* function) {
       }
     }
 
-    std::unordered_map<Value*, Value*> final_invariants;
+    FlatHashMap<Value*, Value*> final_invariants;
 
     // Merge all invariants from predecessors into one invariant list.
     for (const auto [from, to] : predecessor_invariants[0]) {
@@ -1,11 +1,38 @@
 #include "CallInlining.hpp"
+#include "AnalysisManager.hpp"
+#include "Analysis/CallGraph.hpp"
+#include "Analysis/Loops.hpp"
 
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
 #include <Flugzeug/Passes/Utils/Inline.hpp>
 
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
 using namespace flugzeug;
 
+/// Call sites whose cost (in instructions) is not higher than this are inlined even without any
+/// bonuses.
+constexpr size_t inline_threshold = 40;
+
+/// Bonus for every use of a parameter which receives a constant argument (up to
+/// `max_constant_argument_uses` uses per parameter). Such uses will likely fold after inlining.
+constexpr size_t constant_argument_bonus = 10;
+constexpr size_t max_constant_argument_uses = 4;
+
+/// Bonus for every loop around the call site (up to `max_loop_depth` loops).
+constexpr size_t loop_depth_bonus = 40;
+constexpr size_t max_loop_depth = 3;
+
+/// Caller can grow by `growth_percent`% of its size at the first inlining attempt (but at least
+/// by `min_growth_budget` instructions). The budget is shared by all iterations of the
+/// optimization loop. Callers are never grown past `max_caller_size`.
+constexpr size_t growth_percent = 100;
+constexpr size_t min_growth_budget = 200;
+constexpr size_t max_caller_size = 8000;
+
 static bool inline_everything(Function* function) {
   std::vector<Call*> inlinable_calls;
 
@@ -23,11 +50,156 @@ static bool inline_everything(Function* function) {
   return !inlinable_calls.empty();
 }
 
-bool opt::CallInlining::run(Function* function, InliningStrategy strategy) {
+static size_t function_size(const Function* function) {
+  size_t size = 0;
+  for (const Block& block : *function) {
+    size += block.instruction_count();
+  }
+  return size;
+}
+
+static void assign_loop_depths(const analysis::Loop* loop,
+                               size_t depth,
+                               std::vector<size_t>& block_depths) {
+  depth = std::min(depth + 1, max_loop_depth);
+
+  for (Block* block : loop->blocks_without_sub_loops()) {
+    block_depths[block->dense_index()] = depth;
+  }
+
+  for (const auto& sub_loop : loop->sub_loops()) {
+    assign_loop_depths(sub_loop.get(), depth, block_depths);
+  }
+}
+
+struct CalleeSummary {
+  size_t size = 0;
+  std::vector<size_t> parameter_uses;
+};
+
+static CalleeSummary summarize_callee(Function* callee) {
+  // Other callers may be copying the callee in parallel which temporarily adds uses to its
+  // parameters.
+  std::lock_guard callee_lock(callee->copy_mutex());
+
+  CalleeSummary summary{.size = function_size(callee), .parameter_uses = {}};
+  for (size_t i = 0; i < callee->parameter_count(); ++i) {
+    summary.parameter_uses.push_back(callee->parameter(i)->user_count());
+  }
+
+  return summary;
+}
+
+struct InliningCandidate {
+  Call* call;
+
+  /// Number of instructions that inlining will add to the caller.
+  size_t cost;
+
+  /// How far below the (bonus adjusted) threshold the cost is.
+  size_t benefit;
+};
+
+static bool inline_with_cost_model(Function* function, AnalysisManager& analysis_manager) {
+  const auto caller_size = function_size(function);
+  if (caller_size >= max_caller_size) {
+    return false;
+  }
+
+  auto& budget = function->inlining_budget();
+  if (!budget) {
+    budget = std::max(caller_size * growth_percent / 100, min_growth_budget);
+  }
+  if (*budget == 0) {
+    return false;
+  }
+
+  // Only functions reachable from the caller are analyzed. With bottom-up processing of the
+  // module they are either already optimized or in the caller's SCC (and processed on this
+  // thread).
+  const analysis::CallGraph call_graph(function);
+
+  std::vector<size_t> block_depths(function->block_index_capacity(), 0);
+  for (const auto& loop : analysis_manager.loops()) {
+    assign_loop_depths(loop.get(), 0, block_depths);
+  }
+
+  std::unordered_map<const Function*, CalleeSummary> callee_summaries;
+  std::vector<InliningCandidate> candidates;
+
+  for (Call& call : function->instructions<Call>()) {
+    Function* callee = call.callee();
+
+    // Inlining recursive callee would just expose another call to it in every iteration of the
+    // optimization loop.
+    if (callee->is_extern() || call_graph.are_in_same_scc(function, callee) ||
+        call_graph.is_recursive(callee)) {
+      continue;
+    }
+
+    auto summary = callee_summaries.find(callee);
+    if (summary == callee_summaries.end()) {
+      summary = callee_summaries.insert({callee, summarize_callee(callee)}).first;
+    }
+
+    const auto callee_size = summary->second.size;
+
+    // Call instruction itself is removed and its arguments don't need to be prepared anymore.
+    const auto call_overhead = 1 + call.argument_count();
+    const auto cost = callee_size > call_overhead ? callee_size - call_overhead : 0;
+
+    size_t threshold = inline_threshold;
+
+    for (size_t i = 0; i < call.argument_count(); ++i) {
+      if (cast<Constant>(call.argument(i))) {
+        const auto uses = std::min(summary->second.parameter_uses[i], max_constant_argument_uses);
+        threshold += uses * constant_argument_bonus;
+      }
+    }
+
+    threshold += block_depths[call.block()->dense_index()] * loop_depth_bonus;
+
+    if (cost <= threshold) {
+      candidates.push_back(InliningCandidate{
+        .call = &call,
+        .cost = cost,
+        .benefit = threshold - cost,
+      });
+    }
+  }
+
+  // Most beneficial call sites get the budget first.
+  std::stable_sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+    return a.benefit > b.benefit;
+  });
+
+  auto run_budget = std::min(*budget, max_caller_size - caller_size);
+
+  bool did_something = false;
+
+  for (const auto& candidate : candidates) {
+    if (candidate.cost <= run_budget) {
+      run_budget -= candidate.cost;
+      *budget -= candidate.cost;
+
+      flugzeug::utils::inline_call(candidate.call);
+      did_something = true;
+    }
+  }
+
+  return did_something;
+}
+
+bool opt::CallInlining::run(Function* function,
+                            AnalysisManager& analysis_manager,
+                            InliningStrategy strategy) {
   switch (strategy) {
     case InliningStrategy::InlineEverything:
       return inline_everything(function);
 
+    case InliningStrategy::CostModel:
+      return inline_with_cost_model(function, analysis_manager);
+
     default:
       unreachable();
   }
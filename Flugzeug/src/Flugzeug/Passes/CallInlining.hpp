@@ -5,11 +5,20 @@ namespace flugzeug::opt {
 
 enum class InliningStrategy {
   InlineEverything,
+  /// Inlines call sites whose estimated size cost is below a threshold increased by bonuses for
+  /// constant arguments and for call sites inside loops. Recursive functions are never inlined
+  /// and growth of every caller is limited by a budget proportional to its initial size.
+  CostModel,
 };
 
 class CallInlining : public Pass<"CallInlining"> {
  public:
-  static bool run(Function* function, InliningStrategy strategy);
+  /// Inlining decisions depend on callees.
+  consteval static PassDependencies dependencies() { return PassDependencies::Module; }
+
+  static bool run(Function* function,
+                  AnalysisManager& analysis_manager,
+                  InliningStrategy strategy);
 };
 
 }  // namespace flugzeug::opt
\ No newline at end of file
@@ -5,6 +5,10 @@ namespace flugzeug::opt {
 
 class DeadCodeElimination : public Pass<"DeadCodeElimination"> {
  public:
+  consteval static PreservedAnalyses preserved_analyses() {
+    return PreservedAnalyses::control_flow();
+  }
+
   static bool run(Function* function);
 };
 
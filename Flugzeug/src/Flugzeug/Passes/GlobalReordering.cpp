@@ -1,4 +1,5 @@
 #include "GlobalReordering.hpp"
+#include "AnalysisManager.hpp"
 #include "Analysis/Loops.hpp"
 #include "Analysis/Paths.hpp"
 
@@ -24,7 +25,7 @@ static bool can_be_reordered(const Instruction* instruction) {
 }
 
 static bool do_users_allow_reordering(Instruction* instruction,
-                                      const std::unordered_set<Block*>& loop_blocks) {
+                                      const BlockSet& loop_blocks) {
   for (Instruction& user : instruction->users<Instruction>()) {
     // We cannot reorder within the same block.
     if (user.block() == instruction->block()) {
@@ -88,7 +89,7 @@ Instruction* find_best_user(Instruction* instruction,
   return best_location;
 }
 
-bool opt::GlobalReordering::run(Function* function) {
+bool opt::GlobalReordering::run(Function* function, AnalysisManager& analysis_manager) {
   // Reorder instructions so they are executed just before first instruction that needs them. This
   // reduces register pressure and makes IR easier to follow. Deduplication pass may create values
   // which are far away from first use. Limitation is that we can reorder things to a different
@@ -102,17 +103,14 @@ bool opt::GlobalReordering::run(Function* function) {
   //    finish.
 
   analysis::PathValidator path_validator;
-  const DominatorTree dominator_tree(function);
+  const auto& dominator_tree = analysis_manager.dominator_tree();
 
   // Find all blocks in the loops to not interfere with loop invariant optimization.
-  std::unordered_set<Block*> loop_blocks;
+  BlockSet loop_blocks(function);
   {
-    const auto loops = analysis::analyze_function_loops(function, dominator_tree);
+    const auto& loops = analysis_manager.loops();
     for (const auto& loop : loops) {
-      const auto& blocks = loop->blocks();
-
-      loop_blocks.reserve(blocks.size());
-      for (const auto& block : blocks) {
+      for (const auto& block : loop->blocks()) {
         loop_blocks.insert(block);
       }
     }
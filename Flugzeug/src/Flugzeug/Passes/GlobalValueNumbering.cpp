@@ -0,0 +1,342 @@
+#include "GlobalValueNumbering.hpp"
+#include "AnalysisManager.hpp"
+#include "Analysis/PointerAliasing.hpp"
+
+#include <Flugzeug/Core/FlatHashMap.hpp>
+#include <Flugzeug/Core/HashCombine.hpp>
+#include <Flugzeug/Core/StaticVector.hpp>
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/DominatorTree.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionVisitor.hpp>
+#include <Flugzeug/IR/Instructions.hpp>
+
+#include <algorithm>
+
+using namespace flugzeug;
+
+/// Loads which are remembered across stores. Every store or call re-inserts all of them, so the
+/// limit keeps long blocks with a lot of memory operations linear.
+constexpr size_t max_available_loads = 64;
+
+/// Kind, type, instruction specific payload and canonicalized operands of an instruction.
+using Expression = StaticVector<uintptr_t, 6>;
+
+struct ExpressionHash {
+  size_t operator()(const Expression& expression) const {
+    size_t hash = 0;
+
+    for (const auto element : expression) {
+      combine_hash_to(hash, element);
+    }
+
+    return hash;
+  }
+};
+
+class ExpressionVisitor : public ConstInstructionVisitor {
+  Expression& expression;
+
+  void add_operands(const Value* a, const Value* b, bool commutative) {
+    if (commutative && uintptr_t(b) < uintptr_t(a)) {
+      std::swap(a, b);
+    }
+
+    expression.push_back(uintptr_t(a));
+    expression.push_back(uintptr_t(b));
+  }
+
+ public:
+  explicit ExpressionVisitor(Expression& expression) : expression(expression) {}
+
+  bool visit_unary_instr(Argument<UnaryInstr> unary) {
+    expression.push_back(uintptr_t(unary->op()));
+    expression.push_back(uintptr_t(unary->value()));
+    return true;
+  }
+
+  bool visit_binary_instr(Argument<BinaryInstr> binary) {
+    expression.push_back(uintptr_t(binary->op()));
+    add_operands(binary->lhs(), binary->rhs(), BinaryInstr::is_binary_op_commutative(binary->op()));
+    return true;
+  }
+
+  bool visit_int_compare(Argument<IntCompare> int_compare) {
+    const Value* lhs = int_compare->lhs();
+    const Value* rhs = int_compare->rhs();
+    auto predicate = int_compare->predicate();
+
+    // `a < b` and `b > a` are the same expression.
+    if (uintptr_t(rhs) < uintptr_t(lhs)) {
+      std::swap(lhs, rhs);
+      predicate = IntCompare::swapped_order_predicate(predicate);
+    }
+
+    expression.push_back(uintptr_t(predicate));
+    add_operands(lhs, rhs, false);
+    return true;
+  }
+
+  bool visit_cast(Argument<Cast> cast) {
+    expression.push_back(uintptr_t(cast->cast_kind()));
+    expression.push_back(uintptr_t(cast->casted_value()));
+    return true;
+  }
+
+  bool visit_select(Argument<Select> select) {
+    expression.push_back(uintptr_t(select->condition()));
+    add_operands(select->true_value(), select->false_value(), false);
+    return true;
+  }
+
+  bool visit_offset(Argument<Offset> offset) {
+    add_operands(offset->base(), offset->index(), false);
+    return true;
+  }
+
+  bool visit_load(Argument<Load>) { return false; }
+  bool visit_store(Argument<Store>) { return false; }
+  bool visit_call(Argument<Call>) { return false; }
+  bool visit_branch(Argument<Branch>) { return false; }
+  bool visit_cond_branch(Argument<CondBranch>) { return false; }
+  bool visit_stackalloc(Argument<StackAlloc>) { return false; }
+  bool visit_ret(Argument<Ret>) { return false; }
+  bool visit_phi(Argument<Phi>) { return false; }
+};
+
+/// Instructions are numbered in preorder of the dominator tree. Expressions defined in a block
+/// are removed from the table when its dominator subtree is left, so every leader found in the
+/// table dominates the current instruction.
+class ValueNumbering {
+  struct MemoryState {
+    size_t generation = 0;
+    std::vector<Load*> available_loads;
+  };
+
+  struct Frame {
+    const Block* block;
+    size_t next_child = 0;
+    size_t expressions_size = 0;
+
+    /// Memory at the end of the block, restored before entering every child.
+    MemoryState exit_memory;
+  };
+
+  Function* function;
+  const DominatorTree& dominator_tree;
+  const analysis::PointerAliasing& alias_analysis;
+
+  FlatHashMap<Expression, Instruction*, ExpressionHash> expressions;
+  std::vector<Expression> inserted_expressions;
+
+  MemoryState memory;
+  size_t next_generation = 1;
+
+  bool did_something = false;
+
+  Expression load_expression(const Load* load) const {
+    Expression expression;
+    expression.push_back(uintptr_t(load->kind()));
+    expression.push_back(uintptr_t(load->type()));
+    expression.push_back(uintptr_t(load->address()));
+    expression.push_back(memory.generation);
+    return expression;
+  }
+
+  void insert_expression(Expression expression, Instruction* leader) {
+    if (expressions.insert({expression, leader}).second) {
+      inserted_expressions.push_back(std::move(expression));
+    }
+  }
+
+  void leave_scope(size_t expressions_size) {
+    while (inserted_expressions.size() > expressions_size) {
+      expressions.erase(inserted_expressions.back());
+      inserted_expressions.pop_back();
+    }
+  }
+
+  void replace(Instruction* instruction, Value* leader) {
+    instruction->replace_uses_with_and_destroy(leader);
+    did_something = true;
+  }
+
+  /// Loads stay available only if the instruction can't store to their address.
+  void clobber_memory(const Instruction* instruction) {
+    memory.generation = next_generation++;
+
+    std::erase_if(memory.available_loads, [&](const Load* load) {
+      return alias_analysis.can_instruction_access_pointer(
+               instruction, load->address(), analysis::PointerAliasing::AccessType::Store) !=
+             analysis::Aliasing::Never;
+    });
+
+    for (Load* load : memory.available_loads) {
+      insert_expression(load_expression(load), load);
+    }
+  }
+
+  void number_load(Load* load) {
+    auto expression = load_expression(load);
+
+    if (const auto it = expressions.find(expression); it != expressions.end()) {
+      return replace(load, it->second);
+    }
+
+    insert_expression(std::move(expression), load);
+
+    if (memory.available_loads.size() >= max_available_loads) {
+      memory.available_loads.erase(memory.available_loads.begin());
+    }
+    memory.available_loads.push_back(load);
+  }
+
+  /// Phi is congruent to its only incoming value (ignoring itself) or to an earlier Phi in the
+  /// same block with the same incoming values.
+  void number_phis(Block* block) {
+    std::vector<Phi*> leaders;
+
+    for (Phi& phi : advance_early(block->instructions<Phi>())) {
+      Value* single_value = nullptr;
+      bool has_single_value = true;
+
+      for (const auto incoming : phi) {
+        if (incoming.value == &phi) {
+          continue;
+        }
+
+        if (single_value && single_value != incoming.value) {
+          has_single_value = false;
+          break;
+        }
+
+        single_value = incoming.value;
+      }
+
+      // Value from the same block can't dominate the Phi.
+      const auto single_instruction = single_value ? cast<Instruction>(single_value) : nullptr;
+      if (single_value && has_single_value &&
+          (!single_instruction || single_instruction->block() != block)) {
+        replace(&phi, single_value);
+        continue;
+      }
+
+      const auto congruent = std::find_if(leaders.begin(), leaders.end(), [&](Phi* leader) {
+        if (leader->type() != phi.type() || leader->incoming_count() != phi.incoming_count()) {
+          return false;
+        }
+
+        return std::all_of(phi.begin(), phi.end(), [&](const auto incoming) {
+          return leader->incoming_for_block(incoming.block) == incoming.value;
+        });
+      });
+
+      if (congruent != leaders.end()) {
+        replace(&phi, *congruent);
+      } else {
+        leaders.push_back(&phi);
+      }
+    }
+  }
+
+  void number_block(Block* block) {
+    number_phis(block);
+
+    for (Instruction& instruction : advance_early(*block)) {
+      if (cast<Phi>(instruction)) {
+        continue;
+      }
+
+      if (const auto load = cast<Load>(instruction)) {
+        number_load(load);
+        continue;
+      }
+
+      if (cast<Store>(instruction) || cast<Call>(instruction)) {
+        clobber_memory(&instruction);
+        continue;
+      }
+
+      Expression expression;
+      expression.push_back(uintptr_t(instruction.kind()));
+      expression.push_back(uintptr_t(instruction.type()));
+
+      ExpressionVisitor visitor(expression);
+      if (!visitor::visit_instruction(static_cast<const Instruction*>(&instruction), visitor)) {
+        continue;
+      }
+
+      if (const auto it = expressions.find(expression); it != expressions.end()) {
+        replace(&instruction, it->second);
+      } else {
+        insert_expression(std::move(expression), &instruction);
+      }
+    }
+  }
+
+  /// Memory at the start of a block is known only if the dominator is its single predecessor.
+  void enter_block(const Block* block, const Frame* parent) {
+    const auto predecessors = block->predecessors();
+    const bool inherits_memory =
+      parent && !predecessors.empty() &&
+      std::all_of(predecessors.begin(), predecessors.end(),
+                  [&](const Block* predecessor) { return predecessor == parent->block; });
+
+    if (inherits_memory) {
+      memory = parent->exit_memory;
+    } else {
+      memory.generation = next_generation++;
+      memory.available_loads.clear();
+    }
+  }
+
+ public:
+  ValueNumbering(Function* function,
+                 const DominatorTree& dominator_tree,
+                 const analysis::PointerAliasing& alias_analysis)
+      : function(function), dominator_tree(dominator_tree), alias_analysis(alias_analysis) {}
+
+  bool run() {
+    BlockMap<std::vector<Block*>> children(function);
+    for (Block& block : *function) {
+      if (!block.is_entry_block() && !dominator_tree.is_block_dead(&block)) {
+        children[dominator_tree.immediate_dominator(&block)].push_back(&block);
+      }
+    }
+
+    std::vector<Frame> stack;
+
+    const auto enter = [&](Block* block) {
+      enter_block(block, stack.empty() ? nullptr : &stack.back());
+
+      const auto expressions_size = inserted_expressions.size();
+      number_block(block);
+
+      stack.push_back(
+        Frame{.block = block, .expressions_size = expressions_size, .exit_memory = memory});
+    };
+
+    enter(function->entry_block());
+
+    while (!stack.empty()) {
+      auto& frame = stack.back();
+      const auto block_children = children.find(frame.block);
+
+      if (block_children && frame.next_child < block_children->size()) {
+        enter((*block_children)[frame.next_child++]);
+      } else {
+        leave_scope(frame.expressions_size);
+        stack.pop_back();
+      }
+    }
+
+    return did_something;
+  }
+};
+
+bool opt::GlobalValueNumbering::run(Function* function, AnalysisManager& analysis_manager) {
+  ValueNumbering value_numbering(function, analysis_manager.dominator_tree(),
+                                 analysis_manager.pointer_aliasing());
+  return value_numbering.run();
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include "Pass.hpp"
+
+namespace flugzeug::opt {
+
+/// Hash-based value numbering over the dominator tree. Operands of commutative instructions and
+/// comparisons are canonicalized, Phis with the same incoming values are congruent and loads are
+/// reused until a possibly aliasing store or call.
+class GlobalValueNumbering : public Pass<"GlobalValueNumbering"> {
+ public:
+  consteval static PreservedAnalyses preserved_analyses() {
+    return PreservedAnalyses::control_flow();
+  }
+
+  static bool run(Function* function, AnalysisManager& analysis_manager);
+};
+
+}  // namespace flugzeug::opt
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "InstructionDeduplication.hpp"
 
+#include <Flugzeug/Core/FlatHashMap.hpp>
+#include <Flugzeug/Core/HashCombine.hpp>
 #include <Flugzeug/Core/StaticVector.hpp>
 
 #include <Flugzeug/IR/Block.hpp>
@@ -8,6 +10,7 @@
 #include <Flugzeug/IR/InstructionVisitor.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
 
+#include "AnalysisManager.hpp"
 #include "Analysis/Paths.hpp"
 #include "Analysis/PointerAliasing.hpp"
 
@@ -22,7 +25,7 @@ struct InstructionUniqueIdentifierHash {
     size_t hash = 0;
 
     for (const auto element : identifier) {
-      combine_hash(hash, element);
+      combine_hash_to(hash, element);
     }
 
     return hash;
@@ -88,12 +91,12 @@ static bool can_be_deduplicated(Instruction* instruction) {
   }
 }
 
-static bool deduplicate_block_local(Function* function) {
+static bool deduplicate_block_local(Function* function, AnalysisManager& analysis_manager) {
   bool did_something = false;
 
-  const analysis::PointerAliasing alias_analysis(function);
-  std::unordered_map<Value::Kind, std::unordered_map<InstructionUniqueIdentifier, Instruction*,
-                                                     InstructionUniqueIdentifierHash>>
+  const auto& alias_analysis = analysis_manager.pointer_aliasing();
+  FlatHashMap<Value::Kind, FlatHashMap<InstructionUniqueIdentifier, Instruction*,
+                                       InstructionUniqueIdentifierHash>>
     deduplication_map;
 
   for (Block& block : *function) {
@@ -136,12 +139,11 @@ static bool deduplicate_block_local(Function* function) {
   return did_something;
 }
 
-static bool deduplicate_global(Function* function) {
-  std::unordered_map<Value::Kind,
-                     std::unordered_map<InstructionUniqueIdentifier, std::vector<Instruction*>,
-                                        InstructionUniqueIdentifierHash>>
+static bool deduplicate_global(Function* function, AnalysisManager& analysis_manager) {
+  FlatHashMap<Value::Kind, FlatHashMap<InstructionUniqueIdentifier, std::vector<Instruction*>,
+                                       InstructionUniqueIdentifierHash>>
     deduplication_map;
-  std::unordered_map<Instruction*, std::span<Instruction*>> fast_deduplication_map;
+  FlatHashMap<Instruction*, std::span<Instruction*>> fast_deduplication_map;
 
   for (Instruction& instruction : function->instructions()) {
     if (!can_be_deduplicated(&instruction)) {
@@ -163,10 +165,10 @@ static bool deduplicate_global(Function* function) {
     }
   }
 
-  std::unordered_set<Instruction*> deduplicated_instructions;
+  FlatHashSet<Instruction*> deduplicated_instructions;
 
-  const analysis::PointerAliasing alias_analysis(function);
-  const DominatorTree dominator_tree(function);
+  const auto& alias_analysis = analysis_manager.pointer_aliasing();
+  const auto& dominator_tree = analysis_manager.dominator_tree();
   analysis::PathValidator path_validator;
 
   for (Instruction& instruction : advance_early(function->instructions())) {
@@ -216,13 +218,15 @@ static bool deduplicate_global(Function* function) {
   return !deduplicated_instructions.empty();
 }
 
-bool opt::InstructionDeduplication::run(Function* function, OptimizationLocality locality) {
+bool opt::InstructionDeduplication::run(Function* function,
+                                        AnalysisManager& analysis_manager,
+                                        OptimizationLocality locality) {
   switch (locality) {
     case OptimizationLocality::BlockLocal:
-      return deduplicate_block_local(function);
+      return deduplicate_block_local(function, analysis_manager);
 
     case OptimizationLocality::Global:
-      return deduplicate_global(function);
+      return deduplicate_global(function, analysis_manager);
 
     default:
       unreachable();
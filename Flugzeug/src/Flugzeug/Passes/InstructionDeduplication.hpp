@@ -6,7 +6,13 @@ namespace flugzeug::opt {
 
 class InstructionDeduplication : public Pass<"InstructionDeduplication"> {
  public:
-  static bool run(Function* function, OptimizationLocality locality);
+  consteval static PreservedAnalyses preserved_analyses() {
+    return PreservedAnalyses::control_flow();
+  }
+
+  static bool run(Function* function,
+                  AnalysisManager& analysis_manager,
+                  OptimizationLocality locality);
 };
 
 }  // namespace flugzeug::opt
\ No newline at end of file
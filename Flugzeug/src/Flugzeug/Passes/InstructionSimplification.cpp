@@ -54,7 +54,9 @@ static OptimizationResult chain_commutative_expressions(BinaryInstr* binary) {
   if (!match_pattern(
         binary, pat::binary_commutative(pat::constant_u(c1),
                                         pat::binary_specific(parent_binary, pat::value(operand), op,
-                                                             pat::constant_u(c2))))) {
+                                                             pat::constant_u(c2)))) ||
+      parent_binary == binary) {
+    // Self-referential instructions can appear in unreachable code.
     return OptimizationResult::unchanged();
   }
 
@@ -974,36 +976,73 @@ class Simplifier : public InstructionVisitor {
   OptimizationResult visit_ret(Argument<Ret> ret) { return OptimizationResult::unchanged(); }
 };
 
+static bool simplify_instruction(Function* function,
+                                 Instruction* instruction,
+                                 std::vector<size_t>& user_indices) {
+  // Simplification may destroy the instruction so its users need to be remembered beforehand.
+  user_indices.clear();
+  for (Instruction& user : instruction->users<Instruction>()) {
+    user_indices.push_back(user.dense_index());
+  }
+
+  Simplifier simplifier(instruction);
+
+  const auto result = visitor::visit_instruction(instruction, simplifier);
+  if (!result) {
+    return false;
+  }
+
+  // Users may match patterns which look through this instruction now. Newly inserted
+  // instructions and users of the replacement are added to the worklist automatically.
+  for (const size_t index : user_indices) {
+    if (const auto user = function->value_by_index(index)) {
+      function->enqueue_for_simplification(user);
+    }
+  }
+
+  if (const auto replacement = result.replacement()) {
+    instruction->replace_instruction_or_uses_and_destroy(replacement);
+  }
+
+  return true;
+}
+
 bool opt::InstructionSimplification::run(Function* function) {
   bool did_something = false;
 
-  for (Instruction& instruction : advance_early(function->instructions())) {
-    Simplifier simplifier(&instruction);
-
-    // Simplify current instruction. If we have inserted new instruction than try to simplify it
-    // again.
-    Instruction* current_instruction = &instruction;
-    while (current_instruction) {
-      if (const auto result = visitor::visit_instruction(current_instruction, simplifier)) {
-        current_instruction = nullptr;
-
-        if (const auto replacement = result.replacement()) {
-          if (const auto new_instruction = cast<Instruction>(replacement)) {
-            if (!new_instruction->block()) {
-              // Try to simplify newly added instruction in the next iteration.
-              current_instruction = new_instruction;
-            }
-          }
+  // Patterns look through up to two levels of operands. Instructions which use modified
+  // instructions (directly or through another instruction) may simplify now too.
+  {
+    std::vector<Instruction*> modified;
+    for (const size_t index : function->simplification_worklist()) {
+      modified.push_back(cast<Instruction>(function->value_by_index(index)));
+    }
 
-          instruction.replace_instruction_or_uses_and_destroy(replacement);
-        }
+    for (size_t depth = 0; depth < 2; ++depth) {
+      std::vector<Instruction*> users;
 
-        did_something = true;
-      } else {
-        break;
+      for (Instruction* instruction : modified) {
+        for (Instruction& user : instruction->users<Instruction>()) {
+          if (!function->simplification_worklist().contains(user.dense_index())) {
+            function->enqueue_for_simplification(&user);
+            users.push_back(&user);
+          }
+        }
       }
+
+      modified = std::move(users);
+    }
+  }
+
+  // Users of simplified values get added to the worklist automatically when their operands
+  // change.
+  std::vector<size_t> user_indices;
+
+  while (const auto instruction = function->take_from_simplification_worklist()) {
+    if (simplify_instruction(function, instruction, user_indices)) {
+      did_something = true;
     }
   }
 
   return did_something;
-}
\ No newline at end of file
+}
@@ -3,6 +3,8 @@
 
 namespace flugzeug::opt {
 
+/// Simplifies instructions from the function's simplification worklist (see
+/// `Function::enqueue_for_simplification`) until it is empty.
 class InstructionSimplification : public Pass<"InstructionSimplification"> {
  public:
   static bool run(Function* function);
@@ -1,9 +1,11 @@
 #include "KnownBitsOptimization.hpp"
+#include "AnalysisManager.hpp"
 #include "Utils/Evaluation.hpp"
 
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/InstructionVisitor.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
+#include <Flugzeug/IR/ValueMap.hpp>
 
 using namespace flugzeug;
 
@@ -23,9 +25,11 @@ struct KnownBits {
 };
 
 class KnownBitsDatabase {
-  std::unordered_map<Value*, KnownBits> known_bits;
+  ValueMap<KnownBits> known_bits;
 
  public:
+  explicit KnownBitsDatabase(const Function* function) : known_bits(function) {}
+
   KnownBits get(Value* value) {
     const auto type_bitmask = value->type()->bit_mask();
 
@@ -43,9 +47,8 @@ class KnownBitsDatabase {
       };
     }
 
-    const auto it = known_bits.find(value);
-    if (it != known_bits.end()) {
-      return it->second;
+    if (const auto bits = known_bits.find(value)) {
+      return *bits;
     }
 
     return KnownBits{};
@@ -612,13 +615,13 @@ class BitOptimizer : InstructionVisitor {
   BitOptimizationResult visit_ret(Argument<Ret> ret) { return BitOptimizationResult::Unchanged; }
 };
 
-bool opt::KnownBitsOptimization::run(Function* function) {
+bool opt::KnownBitsOptimization::run(Function* function, AnalysisManager& analysis_manager) {
   bool did_something = false;
 
   // We need to traverse blocks in the DFS order.
-  const auto blocks = function->entry_block()->reachable_blocks(TraversalType::DFS_WithStart);
+  const auto& blocks = analysis_manager.dfs_block_order();
 
-  KnownBitsDatabase bits_database;
+  KnownBitsDatabase bits_database(function);
 
   for (Block* block : blocks) {
     for (Instruction& instruction : advance_early(*block)) {
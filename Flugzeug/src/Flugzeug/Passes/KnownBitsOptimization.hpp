@@ -5,7 +5,11 @@ namespace flugzeug::opt {
 
 class KnownBitsOptimization : public Pass<"KnownBitsOptimization"> {
  public:
-  static bool run(Function* function);
+  consteval static PreservedAnalyses preserved_analyses() {
+    return PreservedAnalyses::control_flow();
+  }
+
+  static bool run(Function* function, AnalysisManager& analysis_manager);
 };
 
 }  // namespace flugzeug::opt
\ No newline at end of file
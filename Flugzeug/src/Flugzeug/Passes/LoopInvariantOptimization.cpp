@@ -4,6 +4,7 @@
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
 #include <Flugzeug/Passes/Analysis/Loops.hpp>
+#include <Flugzeug/Passes/AnalysisManager.hpp>
 #include <Flugzeug/Passes/Utils/LoopTransforms.hpp>
 #include <Flugzeug/Passes/Utils/SimplifyPhi.hpp>
 
@@ -131,8 +132,8 @@ static bool optimize_invariants_in_loop_or_sub_loops(Function* function,
   return false;
 }
 
-bool opt::LoopInvariantOptimization::run(Function* function) {
-  const auto loops = analysis::analyze_function_loops(function);
+bool opt::LoopInvariantOptimization::run(Function* function, AnalysisManager& analysis_manager) {
+  const auto& loops = analysis_manager.loops();
 
   bool did_something = false;
 
@@ -1,7 +1,9 @@
 #include "LoopMemoryExtraction.hpp"
+#include "AnalysisManager.hpp"
 #include "Analysis/Loops.hpp"
 #include "Analysis/PointerAliasing.hpp"
 #include "Flugzeug/IR/DominatorTree.hpp"
+#include "Flugzeug/IR/PostDominatorTree.hpp"
 #include "Utils/LoopTransforms.hpp"
 
 #include <algorithm>
@@ -24,11 +26,41 @@ static Value* get_load_store_pointer(Instruction* instruction) {
   return nullptr;
 }
 
+/// Record CFG changes caused by redirecting edges from predecessors of `intermediate_block` to
+/// go through it instead of going directly to `target`.
+static void add_intermediate_block_updates(Block* intermediate_block,
+                                           Block* target,
+                                           std::vector<DominatorTree::Update>& updates) {
+  using Kind = DominatorTree::Update::Kind;
+
+  for (Block* predecessor : intermediate_block->predecessors()) {
+    updates.push_back({Kind::Delete, predecessor, target});
+    updates.push_back({Kind::Insert, predecessor, intermediate_block});
+  }
+
+  updates.push_back({Kind::Insert, intermediate_block, target});
+}
+
 /// Return true if this loop will always execute at least one of the instructions in `loads_stores`
 /// before exiting.
 static bool is_memory_access_unconditional(MemoryDfsContext& dfs_context,
+                                           const PostDominatorTree& post_dominator_tree,
                                            const analysis::Loop* loop,
+                                           const Block* exit_target,
                                            const std::unordered_set<Instruction*>& loads_stores) {
+  // Fast path: the accessing block post-dominates the header. If some path left the loop without
+  // going through it, all paths from the exit target to the function exit would have to, so the
+  // block would post-dominate the exit target too.
+  if (post_dominator_tree.can_reach_exit(exit_target)) {
+    for (const Instruction* instruction : loads_stores) {
+      const auto block = instruction->block();
+      if (block->post_dominates(loop->header(), post_dominator_tree) &&
+          !block->post_dominates(exit_target, post_dominator_tree)) {
+        return true;
+      }
+    }
+  }
+
   dfs_context.stack.clear();
   dfs_context.visited.clear();
 
@@ -126,7 +158,7 @@ static void rewrite_pointer(Value* pointer,
 static bool optimize_loop(Function* function,
                           const analysis::Loop* loop,
                           const analysis::PointerAliasing& alias_analysis,
-                          DominatorTree& dominator_tree,
+                          AnalysisManager& analysis_manager,
                           MemoryDfsContext& dfs_context) {
   // TODO: Check correctness of single exit target. Previous runs may have invalidated it (?).
   const auto exit_target = loop->single_exit_target();
@@ -165,7 +197,7 @@ static bool optimize_loop(Function* function,
       if (const auto creation_instruction = cast<Instruction>(pointer)) {
         const auto creation_block = creation_instruction->block();
         if (creation_block == loop->header() ||
-            !creation_block->dominates(loop->header(), dominator_tree)) {
+            !creation_block->dominates(loop->header(), analysis_manager.dominator_tree())) {
           continue;
         }
       }
@@ -212,9 +244,13 @@ static bool optimize_loop(Function* function,
 
   // Remove all pointers that are accessed conditionally in the loop. Extracting them would change
   // the program behaviour.
-  std::erase_if(pointers_map, [&](const auto& data) {
-    return !is_memory_access_unconditional(dfs_context, loop, data.second);
-  });
+  {
+    const auto& post_dominator_tree = analysis_manager.post_dominator_tree();
+    std::erase_if(pointers_map, [&](const auto& data) {
+      return !is_memory_access_unconditional(dfs_context, post_dominator_tree, loop, exit_target,
+                                             data.second);
+    });
+  }
 
   // No pointers to extract.
   if (pointers_map.empty()) {
@@ -241,7 +277,16 @@ static bool optimize_loop(Function* function,
   const auto dedicated_exit = utils::get_or_create_loop_dedicated_exit(function, loop);
 
   // Update dominator tree as we have affected the control flow.
-  dominator_tree = DominatorTree(function);
+  {
+    std::vector<DominatorTree::Update> cfg_updates;
+
+    add_intermediate_block_updates(preheader, loop->header(), cfg_updates);
+    if (dedicated_exit != exit_target) {
+      add_intermediate_block_updates(dedicated_exit, exit_target, cfg_updates);
+    }
+
+    analysis_manager.update_dominator_tree(cfg_updates);
+  }
 
   std::vector<Value*> rewritten;
   for (const auto& [pointer, data] : pointers) {
@@ -268,10 +313,10 @@ static bool optimize_loop(Function* function,
 static bool optimize_loop_or_sub_loops(Function* function,
                                        const analysis::Loop* loop,
                                        const analysis::PointerAliasing& alias_analysis,
-                                       DominatorTree& dominator_tree,
+                                       AnalysisManager& analysis_manager,
                                        MemoryDfsContext& dfs_context) {
   // Try to optimize this loop.
-  if (optimize_loop(function, loop, alias_analysis, dominator_tree, dfs_context)) {
+  if (optimize_loop(function, loop, alias_analysis, analysis_manager, dfs_context)) {
     return true;
   }
 
@@ -280,25 +325,23 @@ static bool optimize_loop_or_sub_loops(Function* function,
 
   for (const auto& sub_loop : loop->sub_loops()) {
     optimized_subloop |= optimize_loop_or_sub_loops(function, sub_loop.get(), alias_analysis,
-                                                    dominator_tree, dfs_context);
+                                                    analysis_manager, dfs_context);
   }
 
   return optimized_subloop;
 }
 
-bool opt::LoopMemoryExtraction::run(Function* function) {
-  const analysis::PointerAliasing alias_analysis(function);
+bool opt::LoopMemoryExtraction::run(Function* function, AnalysisManager& analysis_manager) {
+  const auto& alias_analysis = analysis_manager.pointer_aliasing();
+  const auto& loops = analysis_manager.loops();
 
-  DominatorTree dominator_tree(function);
   MemoryDfsContext dfs_context;
 
-  const auto loops = analysis::analyze_function_loops(function);
-
   bool did_something = false;
 
   for (const auto& loop : loops) {
-    did_something |=
-      optimize_loop_or_sub_loops(function, loop.get(), alias_analysis, dominator_tree, dfs_context);
+    did_something |= optimize_loop_or_sub_loops(function, loop.get(), alias_analysis,
+                                                analysis_manager, dfs_context);
   }
 
   return did_something;
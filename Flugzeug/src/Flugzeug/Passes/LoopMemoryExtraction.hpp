@@ -5,7 +5,7 @@ namespace flugzeug::opt {
 
 class LoopMemoryExtraction : public Pass<"LoopMemoryExtraction"> {
  public:
-  static bool run(Function* function);
+  static bool run(Function* function, AnalysisManager& analysis_manager);
 };
 
 }  // namespace flugzeug::opt
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "LoopRotation.hpp"
+#include "AnalysisManager.hpp"
 #include "Analysis/Loops.hpp"
 #include "Utils/LoopTransforms.hpp"
 #include "Utils/SimplifyPhi.hpp"
@@ -291,8 +292,8 @@ static bool rotate_loop_or_sub_loops(Function* function, const analysis::Loop* l
   return false;
 }
 
-bool opt::LoopRotation::run(Function* function) {
-  const auto loops = analysis::analyze_function_loops(function);
+bool opt::LoopRotation::run(Function* function, AnalysisManager& analysis_manager) {
+  const auto& loops = analysis_manager.loops();
 
   bool did_something = false;
 
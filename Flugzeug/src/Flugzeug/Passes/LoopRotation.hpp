@@ -5,7 +5,9 @@ namespace flugzeug::opt {
 
 class LoopRotation : public Pass<"LoopRotation"> {
  public:
-  static bool run(Function* function);
+  consteval static PassDependencies dependencies() { return PassDependencies::Loops; }
+
+  static bool run(Function* function, AnalysisManager& analysis_manager);
 };
 
 }  // namespace flugzeug::opt
\ No newline at end of file
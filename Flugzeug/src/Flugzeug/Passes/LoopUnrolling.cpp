@@ -4,6 +4,7 @@
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
 #include <Flugzeug/Passes/Analysis/Loops.hpp>
+#include <Flugzeug/Passes/AnalysisManager.hpp>
 #include <Flugzeug/Passes/Utils/Evaluation.hpp>
 #include <Flugzeug/Passes/Utils/SimplifyPhi.hpp>
 
@@ -658,10 +659,9 @@ static bool unroll_loop_or_sub_loops(Function* function,
   return false;
 }
 
-bool opt::LoopUnrolling::run(Function* function) {
-  DominatorTree dominator_tree(function);
-
-  const auto loops = analysis::analyze_function_loops(function, dominator_tree);
+bool opt::LoopUnrolling::run(Function* function, AnalysisManager& analysis_manager) {
+  const auto& dominator_tree = analysis_manager.dominator_tree();
+  const auto& loops = analysis_manager.loops();
 
   bool did_something = false;
 
@@ -1,5 +1,7 @@
 #include "DeadStoreElimination.hpp"
 
+#include <Flugzeug/Core/FlatHashMap.hpp>
+
 #include <Flugzeug/IR/Block.hpp>
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
@@ -15,7 +17,7 @@ bool opt::memory::eliminate_dead_stores_local(Function* function,
                                               const analysis::PointerAliasing& alias_analysis) {
   bool did_something = false;
 
-  std::unordered_map<Value*, Store*> stores;
+  FlatHashMap<Value*, Store*> stores;
 
   for (Block& block : *function) {
     stores.clear();
@@ -52,104 +54,85 @@ bool opt::memory::eliminate_dead_stores_local(Function* function,
   return did_something;
 }
 
-static bool is_store_dead(const Store* store, const analysis::PointerAliasing& alias_analysis) {
-  enum class CheckResult {
-    Ok,
-    Invalid,
-    CheckSuccessors,
-  };
+static bool is_store_dead(const Store* store,
+                          const analysis::MemorySSA& memory_ssa,
+                          const analysis::PointerAliasing& alias_analysis) {
+  using Kind = analysis::MemoryAccess::Kind;
+  using Scope = analysis::PointerAliasing::IterationScope;
 
   const auto pointer = store->address();
-
-  const auto check_instruction_range = [&](const Instruction* begin, const Instruction* end) {
-    for (const Instruction& instruction : instruction_range(begin, end)) {
-      // If there is another store to this pointer then no successors can observe the old value.
-      if (const auto store = cast<Store>(instruction)) {
-        if (alias_analysis.can_alias(store, store->address(), pointer) ==
-            analysis::Aliasing::Always) {
-          return CheckResult::Ok;
-        }
-      }
-
-      // If this value can be observed we need to back down.
-      if (alias_analysis.can_instruction_access_pointer(
-            &instruction, pointer, analysis::PointerAliasing::AccessType::Load) !=
-          analysis::Aliasing::Never) {
-        return CheckResult::Invalid;
-      }
-    }
-
-    // Nothing here can observe the pointer but block's successors may.
-    return CheckResult::CheckSuccessors;
-  };
-
-  const auto check_block = [&](const Block* block) -> CheckResult {
-    return check_instruction_range(block->first_instruction(), nullptr);
-  };
-
-  {
-    // Make sure that nothing in the remaining part of the store block can observe the pointer.
-    const auto result = check_instruction_range(store->next(), nullptr);
-    if (result == CheckResult::Ok) {
-      return true;
-    }
-    if (result == CheckResult::Invalid) {
-      return false;
-    }
+  const auto access = memory_ssa.access(store);
+  if (!access) {
+    return false;
   }
 
-  std::unordered_set<const Block*> visited;
-  std::vector<const Block*> stack;
-
-  // Start from store block and traverse down.
-  stack.push_back(store->block());
+  // Accesses reached through a Phi can be in later loop iterations than the store. They are
+  // visited again if they were first reached without going through a Phi.
+  FlatHashSet<const analysis::MemoryAccess*> visited;
+  FlatHashSet<const analysis::MemoryAccess*> visited_through_phi;
+  std::vector<std::pair<const analysis::MemoryAccess*, Scope>> stack;
 
-  bool can_reach_itself = false;
+  // Traverse all memory versions which can contain the stored value.
+  for (const auto user : access->users()) {
+    stack.emplace_back(user, Scope::Same);
+  }
 
   while (!stack.empty()) {
-    const auto block = stack.back();
+    auto [user, scope] = stack.back();
     stack.pop_back();
 
-    if (!visited.insert(block).second) {
+    auto& visited_in_scope = scope == Scope::Same ? visited : visited_through_phi;
+    if (!visited_in_scope.insert(user).second) {
       continue;
     }
 
-    if (block != store->block()) {
-      const auto result = check_block(block);
-      if (result == CheckResult::Ok) {
-        continue;
-      }
-      if (result == CheckResult::Invalid) {
-        return false;
-      }
-    }
+    const auto instruction = user->instruction();
 
-    const auto successors = block->successors();
+    switch (user->kind()) {
+      case Kind::Phi:
+        scope = Scope::Any;
+        break;
 
-    // If block ends with `ret` and `pointer` is not coming from stackalloc than `store`
-    // can be observed by the caller.
-    if (successors.empty() && !alias_analysis.is_pointer_stackalloc(pointer)) {
-      return false;
-    }
+      case Kind::Use:
+        // If `pointer` is not coming from stackalloc than `store` can be observed by the caller.
+        if (cast<Ret>(instruction)) {
+          if (!alias_analysis.is_pointer_stackalloc(pointer)) {
+            return false;
+          }
+          continue;
+        }
 
-    for (const auto successor : successors) {
-      if (successor == store->block()) {
-        can_reach_itself = true;
+        if (alias_analysis.can_instruction_access_pointer(
+              instruction, pointer, analysis::PointerAliasing::AccessType::Load, scope) !=
+            analysis::Aliasing::Never) {
+          return false;
+        }
         continue;
-      }
 
-      if (!visited.contains(successor)) {
-        stack.push_back(successor);
+      case Kind::Def: {
+        // If there is another store to this pointer then no successors can observe the old value.
+        if (const auto other_store = cast<Store>(instruction)) {
+          if (alias_analysis.can_alias(other_store, other_store->address(), pointer, scope) ==
+              analysis::Aliasing::Always) {
+            continue;
+          }
+        }
+
+        // If this value can be observed we need to back down.
+        if (alias_analysis.can_instruction_access_pointer(
+              instruction, pointer, analysis::PointerAliasing::AccessType::Load, scope) !=
+            analysis::Aliasing::Never) {
+          return false;
+        }
+        break;
       }
+
+      default:
+        unreachable();
     }
-  }
 
-  if (can_reach_itself) {
-    // Store block can reach itself. Make sure that nothing in the initial part of the store block
-    // can observe the pointer.
-    const auto first_instruction = store->block()->first_instruction();
-    if (check_instruction_range(first_instruction, store) == CheckResult::Invalid) {
-      return false;
+    for (const auto next_user : user->users()) {
+      stack.emplace_back(next_user, scope);
     }
   }
 
@@ -157,13 +140,14 @@ static bool is_store_dead(const Store* store, const analysis::PointerAliasing& a
 }
 
 bool opt::memory::eliminate_dead_stores_global(Function* function,
-                                               const DominatorTree& dominator_tree,
+                                               analysis::MemorySSA& memory_ssa,
                                                const analysis::PointerAliasing& alias_analysis) {
   bool did_something = false;
 
   for (Store& store : advance_early(function->instructions<Store>())) {
     // Remove this store if it's dead.
-    if (is_store_dead(&store, alias_analysis)) {
+    if (is_store_dead(&store, memory_ssa, alias_analysis)) {
+      memory_ssa.remove_access(&store);
       store.destroy();
       did_something = true;
     }
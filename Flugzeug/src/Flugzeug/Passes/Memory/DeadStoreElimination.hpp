@@ -1,6 +1,6 @@
 #pragma once
-#include <Flugzeug/IR/DominatorTree.hpp>
 #include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/Passes/Analysis/MemorySSA.hpp>
 #include <Flugzeug/Passes/Analysis/PointerAliasing.hpp>
 
 namespace flugzeug::opt::memory {
@@ -8,7 +8,7 @@ namespace flugzeug::opt::memory {
 bool eliminate_dead_stores_local(Function* function,
                                  const analysis::PointerAliasing& alias_analysis);
 bool eliminate_dead_stores_global(Function* function,
-                                  const DominatorTree& dominator_tree,
+                                  analysis::MemorySSA& memory_ssa,
                                   const analysis::PointerAliasing& alias_analysis);
 
 }  // namespace flugzeug::opt::memory
\ No newline at end of file
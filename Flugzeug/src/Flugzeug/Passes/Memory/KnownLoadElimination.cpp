@@ -1,7 +1,8 @@
 #include "KnownLoadElimination.hpp"
 
+#include <Flugzeug/Core/FlatHashMap.hpp>
+
 #include <Flugzeug/IR/Block.hpp>
-#include <Flugzeug/IR/DominatorTree.hpp>
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Instructions.hpp>
 
@@ -14,8 +15,8 @@ using namespace flugzeug;
 // Z = load X
 // => last load will be replaced with Y
 
-static bool handle_out_of_bounds_stackalloc_load(Load* load,
-                                                 const analysis::PointerAliasing& alias_analysis) {
+static bool is_out_of_bounds_stackalloc_load(const Load* load,
+                                             const analysis::PointerAliasing& alias_analysis) {
   const auto const_offset = alias_analysis.get_constant_offset_from_stackalloc(load->address());
   if (!const_offset) {
     return false;
@@ -23,19 +24,14 @@ static bool handle_out_of_bounds_stackalloc_load(Load* load,
 
   const auto size = int64_t(const_offset->first->size());
   const auto offset = const_offset->second;
-  if (offset < 0 || offset >= size) {
-    load->replace_uses_with_and_destroy(load->type()->undef());
-    return true;
-  }
-
-  return false;
+  return offset < 0 || offset >= size;
 }
 
 bool opt::memory::eliminate_known_loads_local(Function* function,
                                               const analysis::PointerAliasing& alias_analysis) {
   bool did_something = false;
 
-  std::unordered_map<Value*, Store*> stores;
+  FlatHashMap<Value*, Store*> stores;
   analysis::PathValidator path_validator;
 
   for (Block& block : *function) {
@@ -49,7 +45,8 @@ bool opt::memory::eliminate_known_loads_local(Function* function,
       }
 
       if (const auto load = cast<Load>(instruction)) {
-        if (handle_out_of_bounds_stackalloc_load(load, alias_analysis)) {
+        if (is_out_of_bounds_stackalloc_load(load, alias_analysis)) {
+          load->replace_uses_with_and_destroy(load->type()->undef());
           did_something = true;
           continue;
         }
@@ -77,51 +74,33 @@ bool opt::memory::eliminate_known_loads_local(Function* function,
 }
 
 bool opt::memory::eliminate_known_loads_global(Function* function,
-                                               const DominatorTree& dominator_tree,
+                                               analysis::MemorySSA& memory_ssa,
                                                const analysis::PointerAliasing& alias_analysis) {
   bool did_something = false;
 
-  std::unordered_map<Value*, std::vector<Store*>> stores_to_pointers;
-  analysis::PathValidator path_validator;
-
-  // Create a database of all stores in the function.
-  for (Store& store : function->instructions<Store>()) {
-    stores_to_pointers[store.address()].push_back(&store);
-  }
-
   for (Load& load : advance_early(function->instructions<Load>())) {
-    if (handle_out_of_bounds_stackalloc_load(&load, alias_analysis)) {
-      did_something = true;
+    const auto access = memory_ssa.access(&load);
+    if (!access) {
       continue;
     }
 
-    const auto pointer = load.address();
-    const auto it = stores_to_pointers.find(pointer);
-    if (it == stores_to_pointers.end()) {
+    if (is_out_of_bounds_stackalloc_load(&load, alias_analysis)) {
+      memory_ssa.remove_access(&load);
+      load.replace_uses_with_and_destroy(load.type()->undef());
+      did_something = true;
       continue;
     }
-    const auto& stores = it->second;
-
-    Value* replacement = nullptr;
-
-    for (Store* store : stores) {
-      // Check if anything in the path between `store` and `load` can store to the pointer.
-      const auto result = path_validator.validate_path(
-        dominator_tree, store, &load, analysis::PathValidator::MemoryKillTarget::End,
-        [&](const Instruction* instruction) {
-          return alias_analysis.can_instruction_access_pointer(
-                   instruction, pointer, analysis::PointerAliasing::AccessType::Store) ==
-                 analysis::Aliasing::Never;
-        });
-
-      if (result) {
-        replacement = store->value();
-        break;
-      }
+
+    // Check if the nearest store which can modify the pointer stores to exactly the same address.
+    const auto clobber = memory_ssa.clobbering_access(access, load.address());
+    if (clobber->kind() != analysis::MemoryAccess::Kind::Def) {
+      continue;
     }
 
-    if (replacement) {
-      load.replace_uses_with_and_destroy(replacement);
+    const auto store = cast<Store>(clobber->instruction());
+    if (store && store->address() == load.address() && store->value()->type() == load.type()) {
+      memory_ssa.remove_access(&load);
+      load.replace_uses_with_and_destroy(store->value());
       did_something = true;
     }
   }
@@ -1,12 +1,16 @@
 #include "MemoryOptimization.hpp"
+#include "AnalysisManager.hpp"
+#include "Analysis/MemorySSA.hpp"
 #include "Analysis/PointerAliasing.hpp"
 #include "Memory/DeadStoreElimination.hpp"
 #include "Memory/KnownLoadElimination.hpp"
 
 using namespace flugzeug;
 
-bool opt::MemoryOptimization::run(Function* function, opt::OptimizationLocality locality) {
-  analysis::PointerAliasing alias_analysis(function);
+bool opt::MemoryOptimization::run(Function* function,
+                                  AnalysisManager& analysis_manager,
+                                  opt::OptimizationLocality locality) {
+  const auto& alias_analysis = analysis_manager.pointer_aliasing();
 
   switch (locality) {
     case OptimizationLocality::BlockLocal:
@@ -14,10 +18,11 @@ bool opt::MemoryOptimization::run(Function* function, opt::OptimizationLocality
              memory::eliminate_known_loads_local(function, alias_analysis);
 
     case OptimizationLocality::Global: {
-      const DominatorTree dominator_tree(function);
+      analysis::MemorySSA memory_ssa(function, analysis_manager.dominator_tree(),
+                                     analysis_manager.dominance_frontiers(), alias_analysis);
 
-      return memory::eliminate_dead_stores_global(function, dominator_tree, alias_analysis) |
-             memory::eliminate_known_loads_global(function, dominator_tree, alias_analysis);
+      return memory::eliminate_dead_stores_global(function, memory_ssa, alias_analysis) |
+             memory::eliminate_known_loads_global(function, memory_ssa, alias_analysis);
     }
 
     default:
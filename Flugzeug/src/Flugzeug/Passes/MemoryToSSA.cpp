@@ -10,6 +10,9 @@ using namespace flugzeug;
 struct MemoryToSsaContext {
   std::vector<Phi*> inserted_phis;
   std::unordered_map<Block*, Value*> values_at_blocks;
+  /// Loads are replaced only after all blocks are processed. Stored value can be a load of the
+  /// same stackalloc from a block which wasn't processed yet.
+  std::vector<std::pair<Load*, Value*>> replaced_loads;
 };
 
 static bool is_stackalloc_optimizable(const StackAlloc* stackalloc) {
@@ -67,7 +70,7 @@ static void optimize_stackalloc(MemoryToSsaContext& ctx, StackAlloc* stackalloc)
           }
 
           // This load will use currently known value.
-          load->replace_uses_with_and_destroy(current_value);
+          ctx.replaced_loads.emplace_back(load, current_value);
         }
       } else if (const auto store = cast<Store>(instruction)) {
         if (store->address() == stackalloc) {
@@ -98,6 +101,21 @@ static void optimize_stackalloc(MemoryToSsaContext& ctx, StackAlloc* stackalloc)
     }
   }
 
+  // Value of the load may be another load of the same stackalloc which is also being replaced.
+  // Resolve all values before any load is destroyed.
+  const std::unordered_map<Load*, Value*> load_values(ctx.replaced_loads.begin(),
+                                                      ctx.replaced_loads.end());
+  for (auto& [load, value] : ctx.replaced_loads) {
+    for (auto it = load_values.find(cast<Load>(value)); it != load_values.end();
+         it = load_values.find(cast<Load>(value))) {
+      value = it->second;
+    }
+  }
+
+  for (const auto& [load, value] : ctx.replaced_loads) {
+    load->replace_uses_with_and_destroy(value);
+  }
+
   // Remove unused Phis and optimize Phis with zero or one incoming values.
   for (Phi* phi : ctx.inserted_phis) {
     utils::simplify_phi(phi, true);
@@ -115,6 +133,7 @@ bool opt::MemoryToSSA::run(Function* function) {
     for (StackAlloc* stackalloc : optimizable) {
       context.inserted_phis.clear();
       context.values_at_blocks.clear();
+      context.replaced_loads.clear();
 
       optimize_stackalloc(context, stackalloc);
     }
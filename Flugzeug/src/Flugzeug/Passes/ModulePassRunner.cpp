@@ -0,0 +1,80 @@
+#include "ModulePassRunner.hpp"
+#include "Analysis/CallGraph.hpp"
+
+#include <Flugzeug/Core/ThreadPool.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/Module.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+using namespace flugzeug;
+
+struct SccNode {
+  std::vector<size_t> callers;
+  std::atomic<size_t> pending_callees = 0;
+};
+
+void ModulePassRunner::run_on_functions(const FunctionCallback& callback) {
+  const analysis::CallGraph call_graph(module);
+  const auto& sccs = call_graph.bottom_up_sccs();
+
+  std::unordered_map<const Function*, size_t> scc_indices;
+  for (size_t i = 0; i < sccs.size(); ++i) {
+    for (const Function* function : sccs[i]) {
+      scc_indices.insert({function, i});
+    }
+  }
+
+  // SCC can be processed only after all SCCs it calls into are processed.
+  std::vector<SccNode> nodes(sccs.size());
+  {
+    std::unordered_set<size_t> callee_sccs;
+
+    for (size_t i = 0; i < sccs.size(); ++i) {
+      callee_sccs.clear();
+
+      for (const Function* function : sccs[i]) {
+        for (const Function* callee : call_graph.callees(function)) {
+          const auto callee_scc = scc_indices[callee];
+          if (callee_scc != i && callee_sccs.insert(callee_scc).second) {
+            nodes[callee_scc].callers.push_back(i);
+            nodes[i].pending_callees++;
+          }
+        }
+      }
+    }
+  }
+
+  std::mutex statistics_mutex;
+  ThreadPool thread_pool(thread_count);
+
+  std::function<void(size_t)> process_scc = [&](size_t scc_index) {
+    OptimizationStatistics local_statistics;
+
+    for (Function* function : sccs[scc_index]) {
+      callback(function, statistics ? &local_statistics : nullptr);
+    }
+
+    if (statistics) {
+      std::lock_guard lock(statistics_mutex);
+      statistics->merge(local_statistics);
+    }
+
+    // Schedule callers which were waiting only for this SCC.
+    for (const size_t caller : nodes[scc_index].callers) {
+      if (nodes[caller].pending_callees.fetch_sub(1) == 1) {
+        thread_pool.submit([&process_scc, caller]() { process_scc(caller); });
+      }
+    }
+  };
+
+  for (size_t i = 0; i < sccs.size(); ++i) {
+    if (nodes[i].pending_callees == 0) {
+      thread_pool.submit([&process_scc, i]() { process_scc(i); });
+    }
+  }
+
+  thread_pool.wait();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "PassRunner.hpp"
+
+#include <Flugzeug/Core/ClassTraits.hpp>
+
+#include <functional>
+
+namespace flugzeug {
+
+class Function;
+class Module;
+
+/// Runs function optimizations on the whole module in parallel. Functions are processed
+/// bottom-up over the call graph so callees are always fully optimized before their callers
+/// (which may inline them). Functions from the same call graph SCC are processed sequentially.
+class ModulePassRunner {
+ public:
+  using FunctionCallback = std::function<void(Function*, OptimizationStatistics*)>;
+
+ private:
+  Module* module = nullptr;
+  OptimizationStatistics* statistics = nullptr;
+  size_t thread_count = 0;
+
+ public:
+  CLASS_NON_COPYABLE(ModulePassRunner)
+
+  /// If `thread_count` is 0 then all hardware threads will be used.
+  explicit ModulePassRunner(Module* module,
+                            OptimizationStatistics* statistics = nullptr,
+                            size_t thread_count = 0)
+      : module(module), statistics(statistics), thread_count(thread_count) {}
+
+  /// Callback receives statistics object local to the current task (or nullptr if statistics
+  /// aren't collected). These are merged into the module statistics when the task finishes.
+  void run_on_functions(const FunctionCallback& callback);
+};
+
+}  // namespace flugzeug
@@ -1,10 +1,64 @@
 #pragma once
 #include <algorithm>
+#include <cstdint>
 #include <string_view>
 
 namespace flugzeug {
 
 class Function;
+class AnalysisManager;
+
+enum class Analysis : uint32_t {
+  DominatorTree = 1 << 0,
+  Loops = 1 << 1,
+  PointerAliasing = 1 << 2,
+  BlockOrder = 1 << 3,
+  PostDominatorTree = 1 << 4,
+  DominanceFrontiers = 1 << 5,
+  Liveness = 1 << 6,
+};
+
+class PreservedAnalyses {
+  uint32_t mask = 0;
+
+  constexpr explicit PreservedAnalyses(uint32_t mask) : mask(mask) {}
+
+ public:
+  constexpr PreservedAnalyses() = default;
+
+  constexpr static PreservedAnalyses none() { return PreservedAnalyses(); }
+  constexpr static PreservedAnalyses all() { return PreservedAnalyses(~uint32_t(0)); }
+
+  /// Analyses which depend only on the control flow graph. Passes which modify instructions but
+  /// never add, remove or retarget blocks should preserve these.
+  constexpr static PreservedAnalyses control_flow() {
+    return none()
+      .preserve(Analysis::DominatorTree)
+      .preserve(Analysis::Loops)
+      .preserve(Analysis::BlockOrder)
+      .preserve(Analysis::PostDominatorTree)
+      .preserve(Analysis::DominanceFrontiers);
+  }
+
+  constexpr PreservedAnalyses preserve(Analysis analysis) const {
+    return PreservedAnalyses(mask | uint32_t(analysis));
+  }
+
+  constexpr bool is_preserved(Analysis analysis) const {
+    return (mask & uint32_t(analysis)) != 0;
+  }
+};
+
+/// Parts of the IR which can affect the result of the pass. FunctionPassRunner skips a pass if
+/// none of them changed since the pass last ran without modifying anything.
+enum class PassDependencies {
+  /// Any block of the function.
+  Function,
+  /// Blocks inside loops together with their predecessors and successors.
+  Loops,
+  /// Other functions too. Such passes are never skipped.
+  Module,
+};
 
 namespace detail {
 class PassBase {};
@@ -21,6 +75,12 @@ template <detail::StringLiteral PassName>
 class Pass : public detail::PassBase {
  public:
   consteval static std::string_view pass_name() { return std::string_view(PassName.value); }
+
+  /// Analyses which stay valid when the pass reports that it has modified the function.
+  /// Passes can shadow this to keep cached analyses alive across their invocations.
+  consteval static PreservedAnalyses preserved_analyses() { return PreservedAnalyses::none(); }
+
+  consteval static PassDependencies dependencies() { return PassDependencies::Function; }
 };
 
-}  // namespace flugzeug
\ No newline at end of file
+}  // namespace flugzeug
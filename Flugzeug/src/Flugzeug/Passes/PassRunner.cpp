@@ -1,19 +1,88 @@
 #include "PassRunner.hpp"
 
+#include <Flugzeug/Core/Environment.hpp>
+#include <Flugzeug/Core/Error.hpp>
 #include <Flugzeug/Core/Log.hpp>
 #include <Flugzeug/IR/Function.hpp>
 
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
 using namespace flugzeug;
 
+static size_t count_instructions(const Function* function) {
+  size_t count = 0;
+  for (const Block& block : *function) {
+    count += block.instruction_count();
+  }
+
+  return count;
+}
+
+static double microseconds_per_timestamp_tick() {
+  return 1'000'000.0 / double(Environment::monotonic_timestamp_frequency());
+}
+
+static std::string escape_json_string(std::string_view string) {
+  std::string result;
+  result.reserve(string.size());
+
+  for (const char c : string) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      default:
+        if (uint8_t(c) < 0x20) {
+          result += fmt::format("\\u{:04x}", uint32_t(c));
+        } else {
+          result += c;
+        }
+    }
+  }
+
+  return result;
+}
+
+static std::string escape_csv_string(std::string_view string) {
+  std::string result = "\"";
+
+  for (const char c : string) {
+    if (c == '"') {
+      result += '"';
+    }
+    result += c;
+  }
+
+  return result + '"';
+}
+
 OptimizationStatistics::StatisticsContext OptimizationStatistics::pre_pass_callback(
-  std::string_view pass_name) {
-  return {std::chrono::high_resolution_clock::now()};
+  std::string_view pass_name,
+  const Function* function) {
+  StatisticsContext context{};
+
+  context.instructions_before = count_instructions(function);
+  context.blocks_before = function->block_count();
+
+  // Take timestamps last so counting isn't included in the pass time.
+  context.start_timestamp = Environment::monotonic_timestamp();
+  context.start_time = std::chrono::high_resolution_clock::now();
+
+  return context;
 }
 
 void OptimizationStatistics::post_pass_callback(const StatisticsContext& context,
                                                 std::string_view pass_name,
+                                                const Function* function,
+                                                size_t iteration,
                                                 bool success) {
   const auto end_time = std::chrono::high_resolution_clock::now();
+  const auto end_timestamp = Environment::monotonic_timestamp();
   const auto start_time = context.start_time;
   const float elapsed = std::chrono::duration<float>(end_time - start_time).count();
 
@@ -29,6 +98,20 @@ void OptimizationStatistics::post_pass_callback(const StatisticsContext& context
 
   pass_info.time_spent += elapsed;
   total_time_spend += elapsed;
+
+  records.push_back(PassRecord{
+    .pass_name = pass_name,
+    .function_name = std::string(function->name()),
+    .iteration = iteration,
+    .thread_id = Environment::current_thread_id(),
+    .start_timestamp = context.start_timestamp,
+    .end_timestamp = end_timestamp,
+    .instructions_before = context.instructions_before,
+    .instructions_after = count_instructions(function),
+    .blocks_before = context.blocks_before,
+    .blocks_after = function->block_count(),
+    .success = success,
+  });
 }
 
 void OptimizationStatistics::show() const {
@@ -94,12 +177,133 @@ void OptimizationStatistics::clear() {
   total_time_spend = 0.f;
 
   passes_info.clear();
+  records.clear();
+}
+
+void OptimizationStatistics::merge(const OptimizationStatistics& other) {
+  for (const auto& [pass_name, other_info] : other.passes_info) {
+    auto& pass_info = passes_info[pass_name];
+
+    pass_info.invocations += other_info.invocations;
+    pass_info.successes += other_info.successes;
+    pass_info.time_spent += other_info.time_spent;
+  }
+
+  total_invocations += other.total_invocations;
+  total_successes += other.total_successes;
+  total_time_spend += other.total_time_spend;
+
+  records.insert(records.end(), other.records.begin(), other.records.end());
+}
+
+void OptimizationStatistics::export_chrome_trace(const std::string& path) const {
+  std::ofstream file(path, std::ios::out);
+  verify(!!file, "Failed to open `{}` for writing", path);
+
+  // Trace events use microseconds relative to the first recorded pass.
+  uint64_t base_timestamp = std::numeric_limits<uint64_t>::max();
+  for (const auto& record : records) {
+    base_timestamp = std::min(base_timestamp, record.start_timestamp);
+  }
+
+  const auto microseconds_per_tick = microseconds_per_timestamp_tick();
+  const auto process_id = Environment::current_process_id();
+
+  file << "{\"traceEvents\":[\n";
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    const auto& record = records[i];
+
+    const auto start = double(record.start_timestamp - base_timestamp) * microseconds_per_tick;
+    const auto duration =
+      double(record.end_timestamp - record.start_timestamp) * microseconds_per_tick;
+
+    file << fmt::format(
+      "{{\"name\":\"{}\",\"cat\":\"pass\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+      "\"pid\":{},\"tid\":{},\"args\":{{\"function\":\"{}\",\"iteration\":{},"
+      "\"success\":{},\"instructions_before\":{},\"instructions_after\":{},"
+      "\"blocks_before\":{},\"blocks_after\":{}}}}}{}\n",
+      escape_json_string(record.pass_name), start, duration, process_id, record.thread_id,
+      escape_json_string(record.function_name), record.iteration, record.success,
+      record.instructions_before, record.instructions_after, record.blocks_before,
+      record.blocks_after, i + 1 == records.size() ? "" : ",");
+  }
+
+  file << "],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void OptimizationStatistics::export_csv(const std::string& path) const {
+  std::ofstream file(path, std::ios::out);
+  verify(!!file, "Failed to open `{}` for writing", path);
+
+  const auto microseconds_per_tick = microseconds_per_timestamp_tick();
+
+  file << "function,iteration,pass,thread_id,start_timestamp,end_timestamp,duration_us,success,"
+          "instructions_before,instructions_after,blocks_before,blocks_after\n";
+
+  for (const auto& record : records) {
+    const auto duration =
+      double(record.end_timestamp - record.start_timestamp) * microseconds_per_tick;
+
+    file << fmt::format("{},{},{},{},{},{},{:.3f},{},{},{},{},{}\n",
+                        escape_csv_string(record.function_name), record.iteration,
+                        record.pass_name, record.thread_id, record.start_timestamp,
+                        record.end_timestamp, duration, int(record.success),
+                        record.instructions_before, record.instructions_after,
+                        record.blocks_before, record.blocks_after);
+  }
 }
 
 void FunctionPassRunner::on_finished_optimization(Function* function) {
   function->reassign_display_indices();
 }
 
+bool FunctionPassRunner::is_modified_since(PassDependencies dependencies,
+                                           uint64_t modification_epoch) {
+  if (function->modification_epoch() == modification_epoch) {
+    return false;
+  }
+
+  switch (dependencies) {
+    case PassDependencies::Function:
+    case PassDependencies::Module:
+      return true;
+
+    case PassDependencies::Loops: {
+      const auto is_block_modified = [&](const Block* block) {
+        return block->modification_epoch() > modification_epoch;
+      };
+
+      // Top level loops contain blocks of all their sub-loops. Predecessors and successors of
+      // loop blocks cover preheaders and exit targets.
+      for (const auto& loop : analysis_manager_.loops()) {
+        for (Block* block : loop->blocks()) {
+          if (is_block_modified(block)) {
+            return true;
+          }
+
+          for (const Block* predecessor : block->predecessors()) {
+            if (is_block_modified(predecessor)) {
+              return true;
+            }
+          }
+
+          for (const Block* successor : block->successors()) {
+            if (is_block_modified(successor)) {
+              return true;
+            }
+          }
+        }
+      }
+
+      return false;
+    }
+
+    default:
+      unreachable();
+  }
+}
+
 void FunctionPassRunner::validate() const {
   function->validate(ValidationBehaviour::ErrorsAreFatal);
 }
\ No newline at end of file
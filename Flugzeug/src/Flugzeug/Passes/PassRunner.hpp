@@ -1,10 +1,18 @@
 #pragma once
+#include "AnalysisManager.hpp"
 #include "Pass.hpp"
 
 #include <Flugzeug/Core/ClassTraits.hpp>
+#include <Flugzeug/Core/FlatHashMap.hpp>
+#include <Flugzeug/Core/HashCombine.hpp>
+#include <Flugzeug/IR/Function.hpp>
 
 #include <chrono>
+#include <optional>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 namespace flugzeug {
 
@@ -15,6 +23,9 @@ class OptimizationStatistics {
 
   struct StatisticsContext {
     std::chrono::high_resolution_clock::time_point start_time;
+    uint64_t start_timestamp = 0;
+    size_t instructions_before = 0;
+    size_t blocks_before = 0;
   };
 
   struct PassInfo {
@@ -23,15 +34,39 @@ class OptimizationStatistics {
     float time_spent = 0.f;
   };
 
+ public:
+  /// Single invocation of a pass on a function. Timestamps come from
+  /// `Environment::monotonic_timestamp`.
+  struct PassRecord {
+    std::string_view pass_name;
+    std::string function_name;
+    size_t iteration = 0;
+    uint32_t thread_id = 0;
+
+    uint64_t start_timestamp = 0;
+    uint64_t end_timestamp = 0;
+
+    size_t instructions_before = 0;
+    size_t instructions_after = 0;
+    size_t blocks_before = 0;
+    size_t blocks_after = 0;
+
+    bool success = false;
+  };
+
+ private:
   std::unordered_map<std::string_view, PassInfo> passes_info;
+  std::vector<PassRecord> records;
 
   size_t total_invocations = 0;
   size_t total_successes = 0;
   float total_time_spend = 0.f;
 
-  StatisticsContext pre_pass_callback(std::string_view pass_name);
+  StatisticsContext pre_pass_callback(std::string_view pass_name, const Function* function);
   void post_pass_callback(const StatisticsContext& context,
                           std::string_view pass_name,
+                          const Function* function,
+                          size_t iteration,
                           bool success);
 
  public:
@@ -39,6 +74,15 @@ class OptimizationStatistics {
 
   void show() const;
   void clear();
+
+  const std::vector<PassRecord>& pass_records() const { return records; }
+
+  /// Writes pass records as Chrome trace events (viewable in chrome://tracing or Perfetto).
+  void export_chrome_trace(const std::string& path) const;
+  /// Writes pass records as CSV with one row per pass invocation.
+  void export_csv(const std::string& path) const;
+
+  void merge(const OptimizationStatistics& other);
 };
 
 class FunctionPassRunner {
@@ -46,22 +90,53 @@ class FunctionPassRunner {
   OptimizationStatistics* statistics = nullptr;
   bool strict_validation = false;
 
+  /// Iteration of the optimization loop, reported in statistics.
+  size_t iteration = 0;
+
+  AnalysisManager analysis_manager_;
+
+  struct CleanRun {
+    size_t arguments_hash = 0;
+    uint64_t modification_epoch = 0;
+  };
+
+  /// Function modification epochs at which passes last ran without changing anything.
+  FlatHashMap<std::string_view, CleanRun> clean_runs;
+
   bool did_something_ = false;
 
   static void on_finished_optimization(Function* function);
 
+  /// Only passes with integer and enum arguments can be skipped, other arguments cannot be
+  /// compared between invocations.
+  template <typename... Args>
+  static std::optional<size_t> hash_arguments(const Args&... args) {
+    if constexpr ((... && (std::is_integral_v<Args> || std::is_enum_v<Args>))) {
+      size_t hash = 0;
+      combine_hash_to(hash, args...);
+      return hash;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  bool is_modified_since(PassDependencies dependencies, uint64_t modification_epoch);
+
   void validate() const;
 
  public:
   CLASS_NON_COPYABLE(FunctionPassRunner)
 
   explicit FunctionPassRunner(Function* function, bool strict_validation = false)
-      : function(function), strict_validation(strict_validation) {}
+      : function(function), strict_validation(strict_validation), analysis_manager_(function) {}
 
   explicit FunctionPassRunner(Function* function,
                               OptimizationStatistics* statistics,
                               bool strict_validation = false)
-      : function(function), statistics(statistics), strict_validation(strict_validation) {}
+      : function(function),
+        statistics(statistics),
+        strict_validation(strict_validation),
+        analysis_manager_(function) {}
 
   template <typename T, typename... Args>
   bool run(Args&&... args) {
@@ -70,16 +145,49 @@ class FunctionPassRunner {
 
     const auto pass_name = T::pass_name();
 
+    // Skip the pass if nothing it depends on has changed since it last did nothing.
+    const auto arguments_hash = T::dependencies() == PassDependencies::Module
+                                  ? std::nullopt
+                                  : hash_arguments<std::decay_t<Args>...>(args...);
+    if (arguments_hash) {
+      const auto it = clean_runs.find(pass_name);
+      if (it != clean_runs.end() && it->second.arguments_hash == *arguments_hash &&
+          !is_modified_since(T::dependencies(), it->second.modification_epoch)) {
+        return false;
+      }
+    }
+
     OptimizationStatistics::StatisticsContext statistics_context{};
 
     if (statistics) {
-      statistics_context = statistics->pre_pass_callback(pass_name);
+      statistics_context = statistics->pre_pass_callback(pass_name, function);
     }
 
-    const bool success = T::run(function, std::forward<Args>(args)...);
+    // Everything created by the pass will be allocated from the function's arena.
+    const Function::AllocationScope allocation_scope(function);
+
+    // Passes which take the analysis manager get cached analyses instead of computing their own.
+    bool success;
+    if constexpr (requires { T::run(function, analysis_manager_, std::forward<Args>(args)...); }) {
+      success = T::run(function, analysis_manager_, std::forward<Args>(args)...);
+    } else {
+      success = T::run(function, std::forward<Args>(args)...);
+    }
+
+    if (success) {
+      analysis_manager_.invalidate_all_except(T::preserved_analyses());
+    }
+
+    if (arguments_hash) {
+      if (success) {
+        clean_runs.erase(pass_name);
+      } else {
+        clean_runs[pass_name] = CleanRun{*arguments_hash, function->modification_epoch()};
+      }
+    }
 
     if (statistics) {
-      statistics->post_pass_callback(statistics_context, pass_name, success);
+      statistics->post_pass_callback(statistics_context, pass_name, function, iteration, success);
     }
 
     did_something_ |= success;
@@ -93,6 +201,10 @@ class FunctionPassRunner {
 
   bool did_something() const { return did_something_; }
 
+  /// Analyses are cached across passes. If the function is modified outside of the runner then
+  /// affected analyses must be invalidated manually.
+  AnalysisManager& analysis_manager() { return analysis_manager_; }
+
   template <typename OptCallback>
   static bool enter_optimization_loop(Function* function,
                                       OptimizationStatistics* statistics,
@@ -100,8 +212,12 @@ class FunctionPassRunner {
                                       OptCallback opt_callback) {
     bool did_something = false;
 
-    while (true) {
-      FunctionPassRunner runner(function, statistics, strict_validation);
+    // Use single runner for all iterations so cached analyses survive between them.
+    FunctionPassRunner runner(function, statistics, strict_validation);
+
+    for (size_t iteration = 0;; ++iteration) {
+      runner.did_something_ = false;
+      runner.iteration = iteration;
       opt_callback(runner);
 
       did_something |= runner.did_something();
@@ -10,11 +10,26 @@
 
 using namespace flugzeug;
 
+/// Phis which were already replaced (and destroyed) mapped to their replacements. The Phi graph
+/// isn't updated so its operands need to be looked up here first.
+using PhiReplacements = std::unordered_map<Value*, Value*>;
+
 bool minimize_phis(const std::unordered_set<Phi*>& phis,
-                   const std::unordered_map<Phi*, std::vector<Value*>>& phi_graph);
+                   const std::unordered_map<Phi*, std::vector<Value*>>& phi_graph,
+                   PhiReplacements& replacements);
+
+static Value* resolve_replacement(const PhiReplacements& replacements, Value* value) {
+  for (auto it = replacements.find(value); it != replacements.end();
+       it = replacements.find(value)) {
+    value = it->second;
+  }
+
+  return value;
+}
 
 static bool process_scc(const std::vector<Phi*>& scc,
-                        const std::unordered_map<Phi*, std::vector<Value*>>& phi_graph) {
+                        const std::unordered_map<Phi*, std::vector<Value*>>& phi_graph,
+                        PhiReplacements& replacements) {
   // If there is only one Phi in the SCC than it is already in the simplest posssible form.
   if (scc.size() == 1) {
     return false;
@@ -28,7 +43,8 @@ static bool process_scc(const std::vector<Phi*>& scc,
     bool is_inner = true;
 
     // Get all operands outside SCC that this Phi references.
-    for (Value* operand : phi_graph.find(phi)->second) {
+    for (Value* original_operand : phi_graph.find(phi)->second) {
+      const auto operand = resolve_replacement(replacements, original_operand);
       if (std::find(scc.begin(), scc.end(), operand) == scc.end()) {
         outer.insert(operand);
         is_inner = false;
@@ -47,7 +63,7 @@ static bool process_scc(const std::vector<Phi*>& scc,
   } else if (outer.size() > 1) {
     // Phis in the SCC reference each other and more than one other value.
     // Try minimizing SCC of Phis which don't reference other values.
-    return minimize_phis(inner, phi_graph);
+    return minimize_phis(inner, phi_graph, replacements);
   } else {
     // All Phis in the SCC reference each other and one other value.
     // We can optimize Phis to just reference that other value.
@@ -55,6 +71,7 @@ static bool process_scc(const std::vector<Phi*>& scc,
 
     for (Phi* phi : scc) {
       phi->replace_uses_with_and_destroy(value);
+      replacements.insert({phi, value});
     }
 
     return true;
@@ -62,7 +79,8 @@ static bool process_scc(const std::vector<Phi*>& scc,
 }
 
 bool minimize_phis(const std::unordered_set<Phi*>& phis,
-                   const std::unordered_map<Phi*, std::vector<Value*>>& phi_graph) {
+                   const std::unordered_map<Phi*, std::vector<Value*>>& phi_graph,
+                   PhiReplacements& replacements) {
   const auto sccs = analysis::calculate_sccs<Phi*, false>(
     phis,
     [&phi_graph](Phi* phi) -> const std::vector<Value*>& { return phi_graph.find(phi)->second; });
@@ -70,7 +88,7 @@ bool minimize_phis(const std::unordered_set<Phi*>& phis,
   bool minimized = false;
 
   for (const auto& scc : sccs) {
-    minimized |= process_scc(scc, phi_graph);
+    minimized |= process_scc(scc, phi_graph, replacements);
   }
 
   return minimized;
@@ -93,5 +111,7 @@ bool opt::PhiMinimization::run(Function* function) {
     phis.insert(&phi);
   }
 
-  return minimize_phis(phis, phi_graph);
+  PhiReplacements replacements;
+
+  return minimize_phis(phis, phi_graph, replacements);
 }
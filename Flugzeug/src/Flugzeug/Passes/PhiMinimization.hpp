@@ -5,6 +5,10 @@ namespace flugzeug::opt {
 
 class PhiMinimization : public Pass<"PhiMinimization"> {
  public:
+  consteval static PreservedAnalyses preserved_analyses() {
+    return PreservedAnalyses::control_flow();
+  }
+
   static bool run(Function* function);
 };
 
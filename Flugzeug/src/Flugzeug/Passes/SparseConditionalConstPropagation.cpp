@@ -0,0 +1,403 @@
+#include "SparseConditionalConstPropagation.hpp"
+#include "Utils/Evaluation.hpp"
+#include "Utils/SimplifyPhi.hpp"
+
+#include <Flugzeug/Core/FlatHashMap.hpp>
+
+#include <Flugzeug/IR/Block.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionVisitor.hpp>
+#include <Flugzeug/IR/ValueMap.hpp>
+
+// https://dl.acm.org/doi/pdf/10.1145/103135.103136
+
+using namespace flugzeug;
+
+/// Value of an instruction: unknown (not evaluated in any executable block yet), a single
+/// constant or overdefined. Values only move down the lattice.
+class LatticeValue {
+  enum class State {
+    Unknown,
+    Constant,
+    Overdefined,
+  };
+
+  State state = State::Unknown;
+  uint64_t constant_value_ = 0;
+
+  LatticeValue(State state, uint64_t constant_value)
+      : state(state), constant_value_(constant_value) {}
+
+ public:
+  LatticeValue() = default;
+
+  static LatticeValue constant(uint64_t value) { return {State::Constant, value}; }
+  static LatticeValue overdefined() { return {State::Overdefined, 0}; }
+
+  bool is_unknown() const { return state == State::Unknown; }
+  bool is_constant() const { return state == State::Constant; }
+  bool is_overdefined() const { return state == State::Overdefined; }
+
+  uint64_t constant_value() const { return constant_value_; }
+
+  /// Moves this value to the meet of both values. Returns true if it changed.
+  bool meet(const LatticeValue& other) {
+    if (is_overdefined() || other.is_unknown()) {
+      return false;
+    }
+
+    if (is_unknown()) {
+      *this = other;
+      return true;
+    }
+
+    if (other.is_constant() && other.constant_value() == constant_value()) {
+      return false;
+    }
+
+    *this = overdefined();
+    return true;
+  }
+};
+
+class Solver : public InstructionVisitor {
+  Function* function;
+
+  std::vector<LatticeValue> values;
+  BlockSet executable_blocks;
+  FlatHashSet<uint64_t> executable_edges;
+
+  std::vector<Block*> block_worklist;
+  std::vector<Instruction*> instruction_worklist;
+
+  static uint64_t edge_key(const Block* from, const Block* to) {
+    return (uint64_t(from->dense_index()) << 32) | uint64_t(to->dense_index());
+  }
+
+  void update(Instruction* instruction, const LatticeValue& value) {
+    if (values[instruction->dense_index()].meet(value)) {
+      for (Instruction& user : instruction->users<Instruction>()) {
+        instruction_worklist.push_back(&user);
+      }
+    }
+  }
+
+  void mark_overdefined(Instruction* instruction) {
+    update(instruction, LatticeValue::overdefined());
+  }
+
+  void mark_edge_executable(Block* from, Block* to) {
+    if (!executable_edges.insert(edge_key(from, to)).second) {
+      return;
+    }
+
+    if (executable_blocks.insert(to)) {
+      block_worklist.push_back(to);
+    } else {
+      // New incoming edge can change Phis of already visited block.
+      for (Phi& phi : to->instructions<Phi>()) {
+        instruction_worklist.push_back(&phi);
+      }
+    }
+  }
+
+  /// Branch on a value which is still unknown after solving (it is computed only from undefined
+  /// values) would leave both targets unreachable. Such conditions are made overdefined.
+  bool resolve_unknown_branches() {
+    bool resolved = false;
+
+    for (Block* block : executable_blocks) {
+      if (const auto cond_branch = cast<CondBranch>(block->last_instruction())) {
+        if (lattice_value(cond_branch->condition()).is_unknown()) {
+          mark_overdefined(cast<Instruction>(cond_branch->condition()));
+          resolved = true;
+        }
+      }
+    }
+
+    return resolved;
+  }
+
+  void propagate() {
+    while (!block_worklist.empty() || !instruction_worklist.empty()) {
+      while (!instruction_worklist.empty()) {
+        const auto instruction = instruction_worklist.back();
+        instruction_worklist.pop_back();
+
+        if (executable_blocks.contains(instruction->block())) {
+          visitor::visit_instruction(instruction, *this);
+        }
+      }
+
+      if (!block_worklist.empty()) {
+        const auto block = block_worklist.back();
+        block_worklist.pop_back();
+
+        for (Instruction& instruction : *block) {
+          visitor::visit_instruction(&instruction, *this);
+        }
+      }
+    }
+  }
+
+ public:
+  explicit Solver(Function* function)
+      : function(function),
+        values(function->value_index_capacity()),
+        executable_blocks(function) {}
+
+  void solve() {
+    executable_blocks.insert(function->entry_block());
+    block_worklist.push_back(function->entry_block());
+
+    do {
+      propagate();
+    } while (resolve_unknown_branches());
+  }
+
+  LatticeValue lattice_value(const Value* value) const {
+    if (const auto constant = cast<Constant>(value)) {
+      return LatticeValue::constant(constant->value_u());
+    }
+
+    if (const auto instruction = cast<Instruction>(value)) {
+      return values[instruction->dense_index()];
+    }
+
+    // Parameters and undefined values can have any value.
+    return LatticeValue::overdefined();
+  }
+
+  bool is_executable(const Block* block) const { return executable_blocks.contains(block); }
+
+  void visit_unary_instr(Argument<UnaryInstr> unary) {
+    const auto value = lattice_value(unary->value());
+
+    if (value.is_constant()) {
+      update(unary, LatticeValue::constant(utils::evaluate_unary_instr(
+                      unary->type(), unary->op(), value.constant_value())));
+    } else if (value.is_overdefined()) {
+      mark_overdefined(unary);
+    }
+  }
+
+  void visit_binary_instr(Argument<BinaryInstr> binary) {
+    const auto lhs = lattice_value(binary->lhs());
+    const auto rhs = lattice_value(binary->rhs());
+
+    if (lhs.is_overdefined() || rhs.is_overdefined()) {
+      return mark_overdefined(binary);
+    }
+    if (lhs.is_unknown() || rhs.is_unknown()) {
+      return;
+    }
+
+    // Don't fold divisions which would trap (they can be in executable blocks even if they are
+    // never executed).
+    const auto type = binary->type();
+    const auto divisor = rhs.constant_value() & type->bit_mask();
+
+    switch (binary->op()) {
+      case BinaryOp::DivS:
+      case BinaryOp::ModS:
+        if (divisor == type->bit_mask()) {
+          return mark_overdefined(binary);
+        }
+        [[fallthrough]];
+
+      case BinaryOp::DivU:
+      case BinaryOp::ModU:
+        if (divisor == 0) {
+          return mark_overdefined(binary);
+        }
+        break;
+
+      default:
+        break;
+    }
+
+    update(binary, LatticeValue::constant(utils::evaluate_binary_instr(
+                     type, lhs.constant_value(), binary->op(), rhs.constant_value())));
+  }
+
+  void visit_int_compare(Argument<IntCompare> int_compare) {
+    const auto lhs = lattice_value(int_compare->lhs());
+    const auto rhs = lattice_value(int_compare->rhs());
+
+    if (lhs.is_overdefined() || rhs.is_overdefined()) {
+      mark_overdefined(int_compare);
+    } else if (lhs.is_constant() && rhs.is_constant()) {
+      update(int_compare,
+             LatticeValue::constant(utils::evaluate_int_compare(
+               int_compare->lhs()->type(), lhs.constant_value(), int_compare->predicate(),
+               rhs.constant_value())));
+    }
+  }
+
+  void visit_cast(Argument<Cast> cast) {
+    const auto value = lattice_value(cast->casted_value());
+
+    if (value.is_constant()) {
+      update(cast, LatticeValue::constant(utils::evaluate_cast(value.constant_value(),
+                                                               cast->casted_value()->type(),
+                                                               cast->type(), cast->cast_kind())));
+    } else if (value.is_overdefined()) {
+      mark_overdefined(cast);
+    }
+  }
+
+  void visit_select(Argument<Select> select) {
+    const auto condition = lattice_value(select->condition());
+
+    if (condition.is_constant()) {
+      update(select, lattice_value(select->select_value(condition.constant_value())));
+    } else if (condition.is_overdefined()) {
+      // Select is still constant if both values are the same constant.
+      update(select, lattice_value(select->true_value()));
+      update(select, lattice_value(select->false_value()));
+    }
+  }
+
+  void visit_offset(Argument<Offset> offset) {
+    const auto index = lattice_value(offset->index());
+
+    if (index.is_constant() && index.constant_value() == 0) {
+      update(offset, lattice_value(offset->base()));
+    } else if (!index.is_unknown()) {
+      mark_overdefined(offset);
+    }
+  }
+
+  void visit_phi(Argument<Phi> phi) {
+    LatticeValue result;
+    bool has_defined_incoming = false;
+    bool has_executable_incoming = false;
+
+    for (const auto incoming : *phi) {
+      if (!executable_edges.contains(edge_key(incoming.block, phi->block()))) {
+        continue;
+      }
+
+      has_executable_incoming = true;
+
+      // Undefined incoming value can be assumed to be equal to all other incoming values.
+      if (!incoming.value->is_undef()) {
+        has_defined_incoming = true;
+        result.meet(lattice_value(incoming.value));
+      }
+    }
+
+    if (has_executable_incoming && !has_defined_incoming) {
+      mark_overdefined(phi);
+    } else {
+      update(phi, result);
+    }
+  }
+
+  void visit_branch(Argument<Branch> branch) {
+    mark_edge_executable(branch->block(), branch->target());
+  }
+
+  void visit_cond_branch(Argument<CondBranch> cond_branch) {
+    const auto condition = lattice_value(cond_branch->condition());
+    const auto block = cond_branch->block();
+
+    if (condition.is_constant()) {
+      mark_edge_executable(block, cond_branch->select_target(condition.constant_value()));
+    } else if (condition.is_overdefined()) {
+      mark_edge_executable(block, cond_branch->true_target());
+      mark_edge_executable(block, cond_branch->false_target());
+    }
+  }
+
+  void visit_load(Argument<Load> load) { mark_overdefined(load); }
+  void visit_call(Argument<Call> call) { mark_overdefined(call); }
+  void visit_stackalloc(Argument<StackAlloc> stackalloc) { mark_overdefined(stackalloc); }
+  void visit_store(Argument<Store>) {}
+  void visit_ret(Argument<Ret>) {}
+};
+
+static void destroy_dead_block(const Solver& solver, Block* block) {
+  block->clear();
+
+  // Remaining branches to this block are in other dead blocks.
+  for (Instruction& instruction : advance_early(block->users<Instruction>())) {
+    if (instruction.is_branching()) {
+      verify(!solver.is_executable(instruction.block()),
+             "Executable block still branches to dead block");
+      instruction.destroy();
+    }
+  }
+
+  block->destroy();
+}
+
+bool opt::SparseConditionalConstPropagation::run(Function* function) {
+  Solver solver(function);
+  solver.solve();
+
+  bool did_something = false;
+  bool cfg_changed = false;
+
+  for (Block& block : *function) {
+    if (!solver.is_executable(&block)) {
+      continue;
+    }
+
+    for (Instruction& instruction : advance_early(block)) {
+      if (instruction.is_void()) {
+        continue;
+      }
+
+      const auto value = solver.lattice_value(&instruction);
+      if (value.is_constant()) {
+        instruction.replace_uses_with(instruction.type()->constant(value.constant_value()));
+        instruction.destroy();
+        did_something = true;
+      }
+    }
+
+    // Condition can be defined in a block which comes later in the function so it may not be
+    // replaced yet. Take its value from the solver instead.
+    const auto cond_branch = cast<CondBranch>(block.last_instruction());
+    const auto condition =
+      cond_branch ? solver.lattice_value(cond_branch->condition()) : LatticeValue{};
+    if (condition.is_constant()) {
+      const auto actual_target = cond_branch->select_target(condition.constant_value());
+      const auto removed_target = cond_branch->select_target(!condition.constant_value());
+
+      cond_branch->replace_with_instruction_and_destroy(
+        new Branch(cond_branch->context(), actual_target));
+
+      const bool destroy_empty_phis = removed_target != &block;
+      block.on_removed_branch_to(removed_target, destroy_empty_phis);
+
+      did_something = true;
+      cfg_changed = true;
+    }
+  }
+
+  // Edges from executable blocks to non-executable ones were removed above so all remaining
+  // non-executable blocks are unreachable.
+  for (Block& block : advance_early(*function)) {
+    if (!solver.is_executable(&block)) {
+      destroy_dead_block(solver, &block);
+      did_something = true;
+      cfg_changed = true;
+    }
+  }
+
+  if (cfg_changed) {
+    for (Block& block : *function) {
+      if (block.is_entry_block()) {
+        continue;
+      }
+
+      for (Phi& phi : advance_early(block.instructions<Phi>())) {
+        utils::simplify_phi(&phi, true);
+      }
+    }
+  }
+
+  return did_something;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include "Pass.hpp"
+
+namespace flugzeug::opt {
+
+/// Wegman-Zadeck sparse conditional constant propagation. Values are assumed to be constant
+/// until proven otherwise and only CFG edges which can be taken are followed, so constants are
+/// found through Phis and loops and unreachable blocks are removed in a single run.
+class SparseConditionalConstPropagation : public Pass<"SparseConditionalConstPropagation"> {
+ public:
+  static bool run(Function* function);
+};
+
+}  // namespace flugzeug::opt
\ No newline at end of file
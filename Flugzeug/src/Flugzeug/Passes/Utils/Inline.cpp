@@ -92,6 +92,8 @@ void flugzeug::utils::inline_call(Call* call) {
   }
 
   // Copy all blocks and instructions from callee to caller.
+  std::lock_guard callee_lock(callee->copy_mutex());
+
   for (Block& callee_block : *callee) {
     const auto caller_block = caller->create_block();
 
@@ -7,8 +7,7 @@
 
 using namespace flugzeug;
 
-static Block* add_intermediate_block_between_edges(const std::unordered_set<Block*>& from,
-                                                   Block* to) {
+static Block* add_intermediate_block_between_edges(const BlockSet& from, Block* to) {
   const auto function = to->function();
 
   // Create an intermediate block and make it branch to the `to` block.
@@ -45,7 +44,7 @@ static Block* add_intermediate_block_between_edges(const std::unordered_set<Bloc
 flugzeug::Block* utils::get_or_create_loop_preheader(Function* function,
                                                      const analysis::Loop* loop,
                                                      bool allow_conditional) {
-  std::unordered_set<Block*> entering_blocks;
+  BlockSet entering_blocks(function);
 
   for (const auto predecessor : loop->header()->predecessors()) {
     if (!loop->contains_block(predecessor)) {
@@ -73,7 +72,7 @@ Block* utils::get_or_create_loop_dedicated_exit(Function* function, const analys
   }
 
   // Get all loop blocks that branch to the exit target.
-  std::unordered_set<Block*> exiting_blocks;
+  BlockSet exiting_blocks(function);
   for (const auto predecessor : exit_target->predecessors()) {
     if (loop->contains_block(predecessor)) {
       exiting_blocks.insert(predecessor);
@@ -0,0 +1,33 @@
+// C implementations of extern functions used by the frontends. Linked with modules compiled to
+// native code, must behave the same as host functions registered in `src/main.cpp`.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Must match `bf::Compiler::buffer_size`.
+#define BRAINFUCK_BUFFER_SIZE 30000
+
+// Programs can define functions with the same names themselves, their definitions take precedence.
+#define RUNTIME_FUNCTION __attribute__((weak))
+
+RUNTIME_FUNCTION uint8_t get_char(void) {
+  const int c = getchar();
+  return c == EOF ? 0 : (uint8_t)c;
+}
+
+RUNTIME_FUNCTION void put_char(uint8_t c) {
+  putchar(c);
+}
+
+RUNTIME_FUNCTION void zero_buffer(uint8_t* buffer) {
+  memset(buffer, 0, BRAINFUCK_BUFFER_SIZE);
+}
+
+RUNTIME_FUNCTION void print(const uint8_t* string) {
+  puts((const char*)string);
+}
+
+RUNTIME_FUNCTION void print_num(int32_t x) {
+  printf("%d\n", x);
+}
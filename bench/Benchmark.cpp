@@ -0,0 +1,56 @@
+#include "Benchmark.hpp"
+
+#include <Flugzeug/Core/Error.hpp>
+#include <Flugzeug/Core/Log.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using namespace flugzeug;
+
+/// Growth exponents above this are reported as superlinear.
+constexpr double superlinear_exponent = 1.5;
+/// Shorter times are too noisy to estimate growth from.
+constexpr double min_scaling_time = 0.0001;
+
+double bench::Stopwatch::elapsed() const {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+double bench::median(std::vector<double> samples) {
+  verify(!samples.empty(), "Cannot calculate median of empty sample set");
+
+  const auto middle = samples.begin() + std::ptrdiff_t(samples.size() / 2);
+  std::nth_element(samples.begin(), middle, samples.end());
+
+  return *middle;
+}
+
+void bench::report_scaling(std::string_view name,
+                           std::span<const size_t> sizes,
+                           std::span<const double> times) {
+  verify(sizes.size() == times.size(), "Every size must have a measured time");
+
+  std::string line = fmt::format("{:<40}", name);
+
+  double max_exponent = 0.0;
+
+  for (size_t i = 0; i < times.size(); ++i) {
+    line += fmt::format(" | {:>6}: {:>10.3f}ms", sizes[i], times[i] * 1000.0);
+
+    if (i > 0 && times[i - 1] >= min_scaling_time) {
+      const auto exponent = std::log(times[i] / times[i - 1]) /
+                            std::log(double(sizes[i]) / double(sizes[i - 1]));
+      max_exponent = std::max(max_exponent, exponent);
+    }
+  }
+
+  line += fmt::format(" | exponent {:.2f}", max_exponent);
+
+  if (max_exponent > superlinear_exponent) {
+    log_warn("{} (superlinear)", line);
+  } else {
+    log_info("{}", line);
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+class Stopwatch {
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+ public:
+  /// Elapsed time in seconds.
+  double elapsed() const;
+};
+
+double median(std::vector<double> samples);
+
+/// Runs `setup` and then times `run` `repetitions` times. Setup isn't included in the measured
+/// time. Returns the median time in seconds.
+template <typename Setup, typename Run>
+double measure(size_t repetitions, Setup&& setup, Run&& run) {
+  std::vector<double> samples;
+  samples.reserve(repetitions);
+
+  for (size_t i = 0; i < repetitions; ++i) {
+    auto state = setup();
+
+    const Stopwatch stopwatch;
+    run(state);
+    samples.push_back(stopwatch.elapsed());
+  }
+
+  return median(samples);
+}
+
+/// Logs times measured for increasing input sizes together with the largest growth exponent
+/// between consecutive sizes, so superlinear behaviour stands out (1 means linear scaling,
+/// 2 quadratic).
+void report_scaling(std::string_view name,
+                    std::span<const size_t> sizes,
+                    std::span<const double> times);
+
+}  // namespace bench
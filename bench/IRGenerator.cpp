@@ -0,0 +1,222 @@
+#include "IRGenerator.hpp"
+
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionInserter.hpp>
+
+#include <random>
+
+using namespace flugzeug;
+
+namespace {
+
+class IRGenerator {
+  const bench::IRGeneratorParameters& parameters;
+
+  Type* i64;
+  Function* function;
+  Function* sink;
+
+  InstructionInserter ins;
+  std::mt19937_64 rng;
+
+  /// Values which dominate the current insertion point.
+  std::vector<Value*> values;
+  std::vector<StackAlloc*> stackallocs;
+  Value* loop_bound = nullptr;
+
+  size_t remaining_blocks;
+
+  size_t random(size_t max) { return std::uniform_int_distribution<size_t>(0, max - 1)(rng); }
+
+  Value* random_value() {
+    if (random(8) == 0) {
+      return i64->constant(random(64) + 1);
+    }
+
+    // Prefer recently computed values to get realistic live ranges.
+    const auto recent = std::min<size_t>(values.size(), 16);
+    if (random(4) != 0) {
+      return values[values.size() - 1 - random(recent)];
+    }
+
+    return values[random(values.size())];
+  }
+
+  Block* create_block() {
+    remaining_blocks = remaining_blocks > 0 ? remaining_blocks - 1 : 0;
+    return function->create_block();
+  }
+
+  size_t carried_value_count() const {
+    return parameters.phi_density == bench::PhiDensity::Dense ? 8 : 0;
+  }
+
+  void emit_straight_line() {
+    for (size_t i = 0; i < parameters.block_length; ++i) {
+      const auto kind = random(8);
+
+      if (kind == 6 && !stackallocs.empty()) {
+        values.push_back(ins.load(stackallocs[random(stackallocs.size())]));
+      } else if (kind == 7 && !stackallocs.empty()) {
+        ins.store(stackallocs[random(stackallocs.size())], random_value());
+      } else if (kind == 5) {
+        values.push_back(ins.shl(random_value(), i64->constant(random(7) + 1)));
+      } else {
+        constexpr BinaryOp ops[] = {
+          BinaryOp::Add, BinaryOp::Sub, BinaryOp::Mul,
+          BinaryOp::Xor, BinaryOp::And, BinaryOp::Or,
+        };
+
+        values.push_back(
+          ins.binary_instr(random_value(), ops[random(std::size(ops))], random_value()));
+      }
+    }
+
+    ins.call(sink, {values.back()});
+  }
+
+  void emit_loop(size_t depth) {
+    const auto preheader = ins.insertion_block();
+    const auto header = create_block();
+    const auto body = create_block();
+    const auto exit = create_block();
+
+    ins.branch(header);
+    ins.set_insertion_block(header);
+
+    const auto induction = ins.phi(i64);
+    induction->add_incoming(preheader, i64->zero());
+
+    std::vector<Phi*> carried;
+    for (size_t i = 0; i < carried_value_count(); ++i) {
+      const auto phi = ins.phi(i64);
+      phi->add_incoming(preheader, random_value());
+      carried.push_back(phi);
+    }
+
+    values.push_back(induction);
+    values.insert(values.end(), carried.begin(), carried.end());
+
+    ins.cond_branch(ins.compare_slt(induction, loop_bound), body, exit);
+
+    // Only values from the header dominate the loop exit.
+    const auto header_scope = values.size();
+
+    ins.set_insertion_block(body);
+    emit_region(depth + 1, 1 + random(2));
+
+    const auto latch = ins.insertion_block();
+    induction->add_incoming(latch, ins.add(induction, i64->one()));
+    for (Phi* phi : carried) {
+      phi->add_incoming(latch, random_value());
+    }
+    ins.branch(header);
+
+    values.resize(header_scope);
+    ins.set_insertion_block(exit);
+  }
+
+  void emit_diamond() {
+    const auto then_block = create_block();
+    const auto else_block = create_block();
+    const auto merge_block = create_block();
+
+    const auto condition =
+      ins.compare_ne(ins.and_(random_value(), i64->constant(1 << random(8))), i64->zero());
+    ins.cond_branch(condition, then_block, else_block);
+
+    const auto scope = values.size();
+    const auto merged_count = std::max<size_t>(carried_value_count() / 2, 1);
+
+    const auto emit_side = [&](Block* block) {
+      ins.set_insertion_block(block);
+      emit_straight_line();
+
+      std::vector<Value*> side_values;
+      for (size_t i = 0; i < merged_count; ++i) {
+        side_values.push_back(random_value());
+      }
+
+      ins.branch(merge_block);
+      values.resize(scope);
+
+      return std::pair{ins.insertion_block(), side_values};
+    };
+
+    const auto [then_end, then_values] = emit_side(then_block);
+    const auto [else_end, else_values] = emit_side(else_block);
+
+    ins.set_insertion_block(merge_block);
+    for (size_t i = 0; i < merged_count; ++i) {
+      values.push_back(ins.phi({{then_end, then_values[i]}, {else_end, else_values[i]}}));
+    }
+  }
+
+  void emit_region(size_t depth, size_t construct_count) {
+    emit_straight_line();
+
+    for (size_t i = 0; i < construct_count && remaining_blocks > 0; ++i) {
+      // Always nest the first construct so that the requested depth is reached.
+      const bool loop = depth < parameters.nesting_depth && (i == 0 || random(2) == 0);
+      if (loop) {
+        emit_loop(depth);
+      } else {
+        emit_diamond();
+      }
+
+      emit_straight_line();
+    }
+  }
+
+ public:
+  IRGenerator(Module* module,
+              const std::string& name,
+              const bench::IRGeneratorParameters& parameters)
+      : parameters(parameters),
+        i64(module->context()->i64_ty()),
+        rng(parameters.seed),
+        remaining_blocks(parameters.block_count) {
+    const auto context = module->context();
+
+    sink = module->find_function("sink");
+    if (!sink) {
+      sink = module->create_function(context->void_ty(), "sink", {i64});
+    }
+
+    function = module->create_function(i64, name, {i64, i64, i64});
+  }
+
+  Function* generate() {
+    ins.set_insertion_block(create_block());
+
+    values.push_back(function->parameter(0));
+    values.push_back(function->parameter(1));
+    loop_bound = function->parameter(2);
+
+    for (size_t i = 0; i < parameters.stackalloc_count; ++i) {
+      const auto stackalloc = ins.stack_alloc(i64);
+      ins.store(stackalloc, random_value());
+      stackallocs.push_back(stackalloc);
+    }
+
+    while (remaining_blocks > 0) {
+      emit_region(0, 1);
+    }
+
+    Value* result = values.back();
+    for (StackAlloc* stackalloc : stackallocs) {
+      result = ins.add(result, ins.load(stackalloc));
+    }
+    ins.ret(result);
+
+    return function;
+  }
+};
+
+}  // namespace
+
+Function* bench::generate_function(Module* module,
+                                   const std::string& name,
+                                   const IRGeneratorParameters& parameters) {
+  return IRGenerator(module, name, parameters).generate();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <Flugzeug/IR/Module.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bench {
+
+enum class PhiDensity {
+  /// Loops carry only the induction variable, merges produce a single value.
+  Sparse,
+  /// Loops and merges carry many values.
+  Dense,
+};
+
+struct IRGeneratorParameters {
+  /// Approximate number of blocks in the generated function.
+  size_t block_count = 256;
+  /// Maximum depth of nested loops.
+  size_t nesting_depth = 3;
+  /// Number of stack variables which are loaded and stored throughout the function.
+  size_t stackalloc_count = 4;
+  PhiDensity phi_density = PhiDensity::Sparse;
+  /// Number of arithmetic and memory instructions in each straight-line block.
+  size_t block_length = 8;
+  uint64_t seed = 0;
+};
+
+/// Generates a function `i64 name(i64, i64, i64)` with structured control flow (nested loops and
+/// diamonds). Computed values are passed to an external `sink` function so optimizations cannot
+/// remove them. The same parameters always produce the same function.
+flugzeug::Function* generate_function(flugzeug::Module* module,
+                                      const std::string& name,
+                                      const IRGeneratorParameters& parameters);
+
+}  // namespace bench
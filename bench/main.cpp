@@ -0,0 +1,821 @@
+#include "Benchmark.hpp"
+#include "IRGenerator.hpp"
+
+#include <Flugzeug/Core/Error.hpp>
+#include <Flugzeug/Core/FlatHashMap.hpp>
+#include <Flugzeug/Core/HashCombine.hpp>
+#include <Flugzeug/Core/Log.hpp>
+
+#include <Flugzeug/IR/Context.hpp>
+#include <Flugzeug/IR/DominatorTree.hpp>
+#include <Flugzeug/IR/FileIRPrinter.hpp>
+#include <Flugzeug/IR/Function.hpp>
+#include <Flugzeug/IR/InstructionInserter.hpp>
+#include <Flugzeug/IR/Module.hpp>
+
+#include <Flugzeug/Passes/BlockInvariantPropagation.hpp>
+#include <Flugzeug/Passes/CFGSimplification.hpp>
+#include <Flugzeug/Passes/CallInlining.hpp>
+#include <Flugzeug/Passes/ConditionalCommonOperationExtraction.hpp>
+#include <Flugzeug/Passes/ConditionalFlattening.hpp>
+#include <Flugzeug/Passes/ConstPropagation.hpp>
+#include <Flugzeug/Passes/DeadBlockElimination.hpp>
+#include <Flugzeug/Passes/DeadCodeElimination.hpp>
+#include <Flugzeug/Passes/GlobalValueNumbering.hpp>
+#include <Flugzeug/Passes/GlobalReordering.hpp>
+#include <Flugzeug/Passes/InstructionDeduplication.hpp>
+#include <Flugzeug/Passes/InstructionSimplification.hpp>
+#include <Flugzeug/Passes/KnownBitsOptimization.hpp>
+#include <Flugzeug/Passes/LocalReordering.hpp>
+#include <Flugzeug/Passes/LoopInvariantOptimization.hpp>
+#include <Flugzeug/Passes/LoopMemoryExtraction.hpp>
+#include <Flugzeug/Passes/LoopRotation.hpp>
+#include <Flugzeug/Passes/LoopUnrolling.hpp>
+#include <Flugzeug/Passes/MemoryOptimization.hpp>
+#include <Flugzeug/Passes/MemoryToSSA.hpp>
+#include <Flugzeug/Passes/PassRunner.hpp>
+#include <Flugzeug/Passes/PhiMinimization.hpp>
+#include <Flugzeug/Passes/SparseConditionalConstPropagation.hpp>
+
+#include <Flugzeug/Interpreter/BytecodeInterpreter.hpp>
+
+#include <Flugzeug/CodeGeneration/C/CSourceEmitter.hpp>
+#include <Flugzeug/CodeGeneration/RegAlloc/RegisterAllocation.hpp>
+#include <Flugzeug/CodeGeneration/X86/X86CodeGenerator.hpp>
+#include <Flugzeug/CodeGeneration/X86/X86Jit.hpp>
+
+#include <bf/BrainfuckBufferSplitting.hpp>
+#include <bf/BrainfuckLoopOptimization.hpp>
+#include <bf/Compiler.hpp>
+
+#include <turboc/Compiler.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using namespace flugzeug;
+
+namespace {
+
+struct ModuleDeleter {
+  void operator()(Module* module) const { module->destroy(); }
+};
+
+using ModulePtr = std::unique_ptr<Module, ModuleDeleter>;
+
+struct GeneratedFunction {
+  ModulePtr module;
+  Function* function;
+};
+
+struct PassBenchmark {
+  std::string_view name;
+  std::function<void(FunctionPassRunner&)> run;
+  /// Most passes expect SSA form, so by default memory is promoted before the pass is timed.
+  bool requires_ssa = true;
+};
+
+struct PipelineVariant {
+  std::string_view name;
+  bench::IRGeneratorParameters parameters;
+};
+
+struct PipelineConfiguration {
+  bool loop_optimizations = true;
+  bool brainfuck_optimizations = false;
+  opt::InliningStrategy inlining = opt::InliningStrategy::InlineEverything;
+};
+
+struct NamedPipeline {
+  std::string_view name;
+  /// Program isn't optimized at all if there is no configuration.
+  std::optional<PipelineConfiguration> configuration;
+};
+
+const NamedPipeline named_pipelines[] = {
+  {"none", std::nullopt},
+  {"basic", PipelineConfiguration{.loop_optimizations = false, .brainfuck_optimizations = true}},
+  {"full", PipelineConfiguration{.brainfuck_optimizations = true}},
+  {"cost-model",
+   PipelineConfiguration{.brainfuck_optimizations = true,
+                         .inlining = opt::InliningStrategy::CostModel}},
+};
+
+struct Options {
+  size_t repetitions = 3;
+  std::vector<size_t> block_counts = {100, 400, 1600};
+  std::vector<size_t> instruction_counts = {25'000, 50'000, 100'000};
+  std::string program_path = "TestsBF/mandel.bf";
+};
+
+/// Output of the executed Brainfuck program. All execution engines must produce the same output.
+std::string program_output;
+
+/// Benchmarked programs don't read any input.
+uint8_t host_get_char() {
+  return 0;
+}
+
+void host_put_char(uint8_t c) {
+  program_output.push_back(char(c));
+}
+
+void host_zero_buffer(uint8_t* buffer) {
+  std::memset(buffer, 0, bf::Compiler::buffer_size);
+}
+
+GeneratedFunction generate(Context* context,
+                           bench::IRGeneratorParameters parameters,
+                           size_t block_count,
+                           bool promote_memory) {
+  parameters.block_count = block_count;
+
+  ModulePtr module(context->create_module());
+  const auto function = bench::generate_function(module.get(), "generated", parameters);
+
+  function->validate(ValidationBehaviour::ErrorsAreFatal);
+
+  if (promote_memory) {
+    FunctionPassRunner runner(function);
+    runner.run<opt::CFGSimplification>();
+    runner.run<opt::MemoryToSSA>();
+  }
+
+  return GeneratedFunction{std::move(module), function};
+}
+
+void optimize_function(Function* function, const PipelineConfiguration& configuration = {}) {
+  FunctionPassRunner::enter_optimization_loop(function, [&](FunctionPassRunner& runner) {
+    runner.run<opt::CallInlining>(configuration.inlining);
+    runner.run<opt::CFGSimplification>();
+    runner.run<opt::MemoryToSSA>();
+    runner.run<opt::PhiMinimization>();
+    runner.run<opt::DeadCodeElimination>();
+    runner.run<opt::SparseConditionalConstPropagation>();
+    runner.run<opt::ConstPropagation>();
+    runner.run<opt::InstructionSimplification>();
+    runner.run<opt::ConditionalCommonOperationExtraction>();
+    runner.run<opt::DeadBlockElimination>();
+    runner.run<opt::LocalReordering>();
+    if (configuration.loop_optimizations) {
+      runner.run<opt::LoopRotation>();
+      runner.run<opt::LoopUnrolling>();
+      runner.run<opt::LoopInvariantOptimization>();
+      runner.run<opt::LoopMemoryExtraction>();
+      runner.run<opt::CFGSimplification>();
+    }
+    runner.run<opt::BlockInvariantPropagation>();
+    runner.run<opt::ConditionalFlattening>();
+    runner.run<opt::KnownBitsOptimization>();
+    runner.run<opt::GlobalValueNumbering>();
+    runner.run<opt::MemoryOptimization>(opt::OptimizationLocality::Global);
+    runner.run<opt::GlobalReordering>();
+    if (configuration.brainfuck_optimizations) {
+      if (configuration.loop_optimizations) {
+        runner.run<bf::BrainfuckLoopOptimization>();
+      }
+      runner.run<bf::BrainfuckBufferSplitting>();
+    }
+  });
+}
+
+template <typename T, typename... Args>
+PassBenchmark pass_benchmark(Args... args) {
+  return PassBenchmark{
+    .name = T::pass_name(),
+    .run = [=](FunctionPassRunner& runner) { runner.run<T>(args...); },
+  };
+}
+
+/// Compiles TurboC or Brainfuck program and optimizes it if the configuration is given.
+ModulePtr compile_program(Context* context,
+                          const std::string& source_path,
+                          const std::optional<PipelineConfiguration>& configuration) {
+  ModulePtr module(source_path.ends_with(".bf")
+                     ? bf::Compiler::compile_from_file(context, source_path)
+                     : turboc::Compiler::compile_from_file(context, source_path));
+
+  if (configuration) {
+    for (Function& function : module->local_functions()) {
+      optimize_function(&function, *configuration);
+    }
+  }
+
+  return module;
+}
+
+void benchmark_passes(Context* context, const Options& options) {
+  log_info("Timing individual passes (block counts):");
+
+  auto memory_to_ssa = pass_benchmark<opt::MemoryToSSA>();
+  memory_to_ssa.requires_ssa = false;
+
+  const PassBenchmark passes[] = {
+    pass_benchmark<opt::CFGSimplification>(),
+    memory_to_ssa,
+    pass_benchmark<opt::PhiMinimization>(),
+    pass_benchmark<opt::DeadCodeElimination>(),
+    pass_benchmark<opt::ConstPropagation>(),
+    pass_benchmark<opt::SparseConditionalConstPropagation>(),
+    pass_benchmark<opt::InstructionSimplification>(),
+    pass_benchmark<opt::ConditionalCommonOperationExtraction>(),
+    pass_benchmark<opt::DeadBlockElimination>(),
+    pass_benchmark<opt::LocalReordering>(),
+    pass_benchmark<opt::LoopRotation>(),
+    pass_benchmark<opt::LoopUnrolling>(),
+    pass_benchmark<opt::LoopInvariantOptimization>(),
+    pass_benchmark<opt::LoopMemoryExtraction>(),
+    pass_benchmark<opt::BlockInvariantPropagation>(),
+    pass_benchmark<opt::ConditionalFlattening>(),
+    pass_benchmark<opt::KnownBitsOptimization>(),
+    pass_benchmark<opt::InstructionDeduplication>(opt::OptimizationLocality::Global),
+    pass_benchmark<opt::GlobalValueNumbering>(),
+    pass_benchmark<opt::MemoryOptimization>(opt::OptimizationLocality::Global),
+    pass_benchmark<opt::GlobalReordering>(),
+  };
+
+  for (const auto& pass : passes) {
+    std::vector<double> times;
+
+    for (const auto block_count : options.block_counts) {
+      times.push_back(bench::measure(
+        options.repetitions,
+        [&] { return generate(context, {}, block_count, pass.requires_ssa); },
+        [&](GeneratedFunction& generated) {
+          FunctionPassRunner runner(generated.function);
+          pass.run(runner);
+        }));
+    }
+
+    bench::report_scaling(pass.name, options.block_counts, times);
+  }
+}
+
+void benchmark_pipeline(Context* context, const Options& options) {
+  log_info("Timing full optimization pipeline (block counts):");
+
+  const PipelineVariant variants[] = {
+    {"default", {}},
+    {"deep nesting", {.nesting_depth = 8}},
+    {"dense phis", {.phi_density = bench::PhiDensity::Dense}},
+    {"many stackallocs", {.stackalloc_count = 64}},
+    {"long blocks", {.block_length = 256}},
+  };
+
+  for (const auto& variant : variants) {
+    std::vector<double> times;
+
+    for (const auto block_count : options.block_counts) {
+      times.push_back(bench::measure(
+        options.repetitions,
+        [&] { return generate(context, variant.parameters, block_count, false); },
+        [&](GeneratedFunction& generated) { optimize_function(generated.function); }));
+    }
+
+    bench::report_scaling(variant.name, options.block_counts, times);
+  }
+}
+
+struct DominanceQueries {
+  GeneratedFunction generated;
+  std::unique_ptr<DominatorTree> dominator_tree;
+  std::vector<std::pair<const Block*, const Block*>> queries;
+};
+
+/// Answers dominance query by walking up the immediate dominators. Queries were answered this way
+/// before the tree was DFS numbered, so it serves as the baseline.
+bool dominates_by_walk(const DominatorTree& dominator_tree,
+                       const Block* dominator,
+                       const Block* block) {
+  for (; block; block = dominator_tree.immediate_dominator(block)) {
+    if (block == dominator) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void benchmark_dominance(Context* context, const Options& options) {
+  log_info("Timing dominance queries on deeply nested loops (block counts):");
+
+  constexpr size_t queries_per_block = 256;
+
+  const auto setup = [&](size_t block_count) {
+    auto generated = generate(context, {.nesting_depth = 24}, block_count, false);
+    auto dominator_tree = std::make_unique<DominatorTree>(generated.function);
+
+    std::vector<const Block*> blocks;
+    for (const Block& block : *generated.function) {
+      blocks.push_back(&block);
+    }
+
+    // Queries have a fixed seed so both methods answer the same ones.
+    std::mt19937_64 rng(0);
+    std::uniform_int_distribution<size_t> distribution(0, blocks.size() - 1);
+
+    std::vector<std::pair<const Block*, const Block*>> queries;
+    queries.reserve(blocks.size() * queries_per_block);
+    for (size_t i = 0; i < blocks.size() * queries_per_block; ++i) {
+      queries.emplace_back(blocks[distribution(rng)], blocks[distribution(rng)]);
+    }
+
+    return DominanceQueries{std::move(generated), std::move(dominator_tree), std::move(queries)};
+  };
+
+  std::vector<double> tree_times;
+  std::vector<double> walk_times;
+
+  for (const auto block_count : options.block_counts) {
+    size_t tree_dominated = 0;
+    size_t walk_dominated = 0;
+
+    tree_times.push_back(bench::measure(
+      options.repetitions, [&] { return setup(block_count); },
+      [&](DominanceQueries& state) {
+        tree_dominated = 0;
+        for (const auto& [dominator, block] : state.queries) {
+          tree_dominated += dominator->dominates(block, *state.dominator_tree);
+        }
+      }));
+
+    walk_times.push_back(bench::measure(
+      options.repetitions, [&] { return setup(block_count); },
+      [&](DominanceQueries& state) {
+        walk_dominated = 0;
+        for (const auto& [dominator, block] : state.queries) {
+          walk_dominated += dominates_by_walk(*state.dominator_tree, dominator, block);
+        }
+      }));
+
+    verify(tree_dominated == walk_dominated, "Dominance queries gave different results");
+  }
+
+  bench::report_scaling("DFS intervals", options.block_counts, tree_times);
+  bench::report_scaling("immediate dominator walk", options.block_counts, walk_times);
+}
+
+struct LongBlock {
+  ModulePtr module;
+  std::vector<Instruction*> instructions;
+};
+
+/// Times `is_before` queries interleaved with insertions into a single long block. Every step
+/// inserts one instruction and asks for the order of two instructions. Renumbering the whole block
+/// after every insertion would make each step linear in the block length.
+void benchmark_ordering(Context* context, const Options& options) {
+  log_info("Timing instruction ordering in long blocks (instruction counts):");
+
+  constexpr size_t step_count = 20'000;
+
+  const auto setup = [&](size_t instruction_count) {
+    ModulePtr module(context->create_module());
+
+    const auto i64 = context->i64_ty();
+    const auto function = module->create_function(i64, "long_block", {i64});
+
+    InstructionInserter ins(function->create_block());
+
+    std::vector<Instruction*> instructions;
+    instructions.reserve(instruction_count + step_count);
+
+    Value* value = function->parameter(0);
+    for (size_t i = 0; i < instruction_count; ++i) {
+      value = ins.add(value, i64->one());
+      instructions.push_back(cast<Instruction>(value));
+    }
+    ins.ret(value);
+
+    return LongBlock{std::move(module), std::move(instructions)};
+  };
+
+  const auto insert_before = [&](Instruction* position) {
+    const auto instruction =
+      new BinaryInstr(context, position->operand(0), BinaryOp::Add, context->i64_ty()->one());
+    instruction->insert_before(position);
+    return instruction;
+  };
+
+  // Leaves an instruction without assigned order next to the position and then inserts queried
+  // instructions before the position, so renumbering has to grow over the unassigned one.
+  const auto insert_mixed = [&](LongBlock& block) {
+    std::mt19937_64 rng(0);
+    constexpr size_t burst_size = 64;
+
+    for (size_t i = 0; i < step_count / burst_size; ++i) {
+      const auto unassigned = insert_before(block.instructions[rng() % block.instructions.size()]);
+      block.instructions.push_back(unassigned);
+
+      const auto position = unassigned->previous();
+      if (!position) {
+        continue;
+      }
+
+      for (size_t j = 0; j < burst_size; ++j) {
+        const auto instruction = insert_before(position);
+        verify(instruction->is_before(position), "Invalid instruction order");
+        block.instructions.push_back(instruction);
+      }
+    }
+  };
+
+  std::vector<double> random_times;
+  std::vector<double> fixed_times;
+  std::vector<double> mixed_times;
+
+  for (const auto instruction_count : options.instruction_counts) {
+    random_times.push_back(bench::measure(
+      options.repetitions, [&] { return setup(instruction_count); },
+      [&](LongBlock& block) {
+        std::mt19937_64 rng(0);
+        const auto random_instruction = [&] {
+          return block.instructions[rng() % block.instructions.size()];
+        };
+
+        for (size_t i = 0; i < step_count; ++i) {
+          block.instructions.push_back(insert_before(random_instruction()));
+          (void)random_instruction()->is_before(random_instruction());
+        }
+      }));
+
+    // Inserting at one position repeatedly exhausts the gap between two order numbers.
+    fixed_times.push_back(bench::measure(
+      options.repetitions, [&] { return setup(instruction_count); },
+      [&](LongBlock& block) {
+        const auto position = block.instructions[block.instructions.size() / 2];
+        for (size_t i = 0; i < step_count; ++i) {
+          verify(insert_before(position)->is_before(position), "Invalid instruction order");
+        }
+      }));
+
+    mixed_times.push_back(bench::measure(
+      options.repetitions, [&] { return setup(instruction_count); }, insert_mixed));
+
+    // Order of every adjacent pair must be strictly increasing after mixing assigned and
+    // unassigned instructions.
+    {
+      auto block = setup(instruction_count);
+      insert_mixed(block);
+
+      for (const Instruction& instruction : *block.instructions.front()->block()) {
+        const auto next = instruction.next();
+        verify(!next || instruction.is_before(next), "Invalid instruction order");
+      }
+    }
+  }
+
+  bench::report_scaling("random insertions", options.instruction_counts, random_times);
+  bench::report_scaling("insertions at fixed position", options.instruction_counts, fixed_times);
+  bench::report_scaling("mixed assigned and unassigned", options.instruction_counts, mixed_times);
+}
+
+/// Same key as the one used for constant interning in `Context`.
+struct ConstantKey {
+  const Type* type;
+  uint64_t constant;
+
+  bool operator==(const ConstantKey& other) const {
+    return constant == other.constant && type == other.type;
+  }
+};
+
+struct ConstantKeyHash {
+  size_t operator()(const ConstantKey& key) const { return combine_hash(key.constant, key.type); }
+};
+
+/// Interns a stream of constants like `Context` does: mostly small values of few types with
+/// occasional large ones.
+template <typename Map>
+void intern_constants(const std::vector<ConstantKey>& keys) {
+  Map constants;
+
+  size_t created = 0;
+  for (const auto& key : keys) {
+    const auto [it, inserted] = constants.try_emplace(key, created);
+    created += inserted;
+  }
+
+  verify(created == constants.size(), "Invalid number of interned constants");
+}
+
+/// Walks the function like per-pass analyses do: every instruction looks up information about its
+/// operands and records its own.
+template <typename Map>
+void map_instructions(Function* function) {
+  Map values;
+  size_t instruction_count = 0;
+
+  for (Instruction& instruction : function->instructions()) {
+    uint64_t value = 0;
+    for (const Value& operand : instruction.operands()) {
+      const auto it = values.find(&operand);
+      if (it != values.end()) {
+        value ^= it->second;
+      }
+    }
+
+    values.insert({&instruction, value + 1});
+    instruction_count++;
+  }
+
+  verify(values.size() == instruction_count, "Invalid number of mapped instructions");
+}
+
+void benchmark_hash_maps(Context* context, const Options& options) {
+  log_info("Comparing FlatHashMap with std::unordered_map (block counts):");
+
+  constexpr size_t constants_per_block = 256;
+
+  const auto generate_constant_keys = [&](size_t block_count) {
+    const Type* types[] = {context->i1_ty(), context->i8_ty(), context->i32_ty(),
+                           context->i64_ty()};
+
+    std::mt19937_64 rng(0);
+
+    std::vector<ConstantKey> keys;
+    keys.reserve(block_count * constants_per_block);
+    for (size_t i = 0; i < block_count * constants_per_block; ++i) {
+      const auto constant = rng() % 8 == 0 ? rng() : rng() % 256;
+      keys.push_back({types[rng() % std::size(types)], constant});
+    }
+
+    return keys;
+  };
+
+  using FlatConstantMap = FlatHashMap<ConstantKey, size_t, ConstantKeyHash>;
+  using StdConstantMap = std::unordered_map<ConstantKey, size_t, ConstantKeyHash>;
+  using FlatValueMap = FlatHashMap<const Value*, uint64_t>;
+  using StdValueMap = std::unordered_map<const Value*, uint64_t>;
+
+  std::vector<double> flat_interning_times;
+  std::vector<double> std_interning_times;
+  std::vector<double> flat_pass_times;
+  std::vector<double> std_pass_times;
+
+  for (const auto block_count : options.block_counts) {
+    const auto constant_keys = generate_constant_keys(block_count);
+    const auto generated = generate(context, {}, block_count, true);
+
+    const auto time = [&](auto&& run) {
+      return bench::measure(options.repetitions, [] { return 0; }, [&](int) { run(); });
+    };
+
+    flat_interning_times.push_back(
+      time([&] { intern_constants<FlatConstantMap>(constant_keys); }));
+    std_interning_times.push_back(time([&] { intern_constants<StdConstantMap>(constant_keys); }));
+    flat_pass_times.push_back(time([&] { map_instructions<FlatValueMap>(generated.function); }));
+    std_pass_times.push_back(time([&] { map_instructions<StdValueMap>(generated.function); }));
+  }
+
+  bench::report_scaling("constant interning (FlatHashMap)", options.block_counts,
+                        flat_interning_times);
+  bench::report_scaling("constant interning (std::unordered_map)", options.block_counts,
+                        std_interning_times);
+  bench::report_scaling("instruction map (FlatHashMap)", options.block_counts, flat_pass_times);
+  bench::report_scaling("instruction map (std::unordered_map)", options.block_counts,
+                        std_pass_times);
+}
+
+void benchmark_execution(Context* context, const Options& options) {
+  log_info("Timing execution of `{}`:", options.program_path);
+
+  // Lowering modifies the IR so every engine gets its own module.
+  const auto compile_program = [&](bool optimize) {
+    ModulePtr module(bf::Compiler::compile_from_file(context, options.program_path));
+
+    if (optimize) {
+      const bench::Stopwatch stopwatch;
+      for (Function& function : module->local_functions()) {
+        optimize_function(&function, {.brainfuck_optimizations = true});
+      }
+      log_info("Optimized program in {:.3f}ms.", stopwatch.elapsed() * 1000.0);
+    }
+
+    return module;
+  };
+
+  const auto clear_output = [] {
+    program_output.clear();
+    return 0;
+  };
+
+  std::string reference_output;
+  double reference_time = 0.0;
+
+  const auto report = [&](std::string_view name, double compile_time, double run_time) {
+    if (reference_time == 0.0) {
+      reference_output = program_output;
+      reference_time = run_time;
+    } else {
+      verify(program_output == reference_output, "`{}` produced different output", name);
+    }
+
+    log_info("{:<40} | compile: {:>10.3f}ms | run: {:>10.3f}ms | {:>6.2f}x", name,
+             compile_time * 1000.0, run_time * 1000.0, reference_time / run_time);
+  };
+
+  {
+    const auto module = compile_program(false);
+
+    const bench::Stopwatch stopwatch;
+    const auto bytecode = lower_to_bytecode(module.get());
+    const auto compile_time = stopwatch.elapsed();
+
+    using Arguments = std::span<const uint64_t>;
+
+    const auto run_time = bench::measure(options.repetitions, clear_output, [&](int) {
+      BytecodeInterpreter interpreter(bytecode);
+      interpreter.register_host_function("get_char", [](BytecodeInterpreter&, Arguments) {
+        return uint64_t(host_get_char());
+      });
+      interpreter.register_host_function("put_char", [](BytecodeInterpreter&, Arguments args) {
+        host_put_char(uint8_t(args[0]));
+        return uint64_t(0);
+      });
+      interpreter.register_host_function(
+        "zero_buffer", [](BytecodeInterpreter& interpreter, Arguments args) {
+          host_zero_buffer(interpreter.memory(args[0], bf::Compiler::buffer_size));
+          return uint64_t(0);
+        });
+      interpreter.run("main");
+    });
+
+    report("bytecode interpreter (unoptimized)", compile_time, run_time);
+  }
+
+  const std::unordered_map<std::string, void*> host_functions = {
+    {"get_char", reinterpret_cast<void*>(&host_get_char)},
+    {"put_char", reinterpret_cast<void*>(&host_put_char)},
+    {"zero_buffer", reinterpret_cast<void*>(&host_zero_buffer)},
+  };
+
+  for (const bool optimize : {false, true}) {
+    const auto module = compile_program(optimize);
+
+    const bench::Stopwatch stopwatch;
+    const X86JitCode jit(generate_x86_code(module.get()), host_functions);
+    const auto compile_time = stopwatch.elapsed();
+
+    const auto main = jit.function<void()>("main");
+    const auto run_time = bench::measure(options.repetitions, clear_output, [&](int) { main(); });
+
+    report(optimize ? "JIT (optimized)" : "JIT (unoptimized)", compile_time, run_time);
+  }
+}
+
+/// Reports spill code caused by register allocation with bounded register files after every
+/// pipeline. Allocation modifies the IR so the program is compiled again for every register file.
+void benchmark_spills(Context* context, const Options& options) {
+  log_info("Spill code of `{}`:", options.program_path);
+
+  for (const auto& pipeline : named_pipelines) {
+    for (const uint32_t register_count : {4u, 8u, 16u}) {
+      const auto module = compile_program(context, options.program_path, pipeline.configuration);
+
+      SpillStatistics total;
+
+      const bench::Stopwatch stopwatch;
+      for (Function& function : module->local_functions()) {
+        const auto registers = allocate_registers(&function, {.register_count = register_count});
+        const auto& statistics = registers.spill_statistics();
+
+        total.spilled_values += statistics.spilled_values;
+        total.spill_stores += statistics.spill_stores;
+        total.reloads += statistics.reloads;
+      }
+      const auto allocation_time = stopwatch.elapsed();
+
+      log_info("{:<6} | {:>2} registers | spilled values: {:>6} | stores: {:>6} | reloads: {:>6} | "
+               "allocation: {:>8.3f}ms",
+               pipeline.name, register_count, total.spilled_values, total.spill_stores,
+               total.reloads, allocation_time * 1000.0);
+    }
+  }
+}
+
+/// Compiles TurboC or Brainfuck program, optimizes it using the named pipeline and writes it as
+/// C source.
+int emit_c(Context* context,
+           std::string_view pipeline,
+           const std::string& source_path,
+           const std::string& output_path) {
+  const auto named_pipeline =
+    std::find_if(std::begin(named_pipelines), std::end(named_pipelines),
+                 [&](const NamedPipeline& named) { return named.name == pipeline; });
+  if (named_pipeline == std::end(named_pipelines)) {
+    log_error("Unknown pipeline `{}`.", pipeline);
+    return 1;
+  }
+
+  const auto module = compile_program(context, source_path, named_pipeline->configuration);
+
+  module->validate(ValidationBehaviour::ErrorsAreFatal);
+
+  FileIRPrinter printer(output_path);
+  emit_c_source(module.get(), printer);
+
+  return 0;
+}
+
+}  // namespace
+
+/// Usage: Benchmark [--quick] [--program <path>] [passes] [pipeline] [dominance] [ordering]
+///                  [hash-maps] [execution] [spills]
+///        Benchmark emit-c <none|basic|full|cost-model> <source> <output>
+/// Without suite names `passes` and `pipeline` suites are run. `dominance` compares dominator tree
+/// queries against walking up the immediate dominators. `ordering` times `is_before` with
+/// insertions into long blocks. `hash-maps` compares FlatHashMap with `std::unordered_map` on
+/// constant interning and per-pass instruction maps. `execution` compares Brainfuck program
+/// (TestsBF/mandel.bf by default) run times across the bytecode interpreter and the JIT.
+/// `spills` reports spill code of the program (Brainfuck or TurboC) after every pipeline.
+/// `emit-c` writes the optimized program as C source (used by bench/runtime.sh).
+int main(int argc, char** argv) {
+  if (argc == 5 && std::string_view(argv[1]) == "emit-c") {
+    Context context;
+    return emit_c(&context, argv[2], argv[3], argv[4]);
+  }
+
+  Options options;
+
+  bool run_passes = false;
+  bool run_pipeline = false;
+  bool run_dominance = false;
+  bool run_ordering = false;
+  bool run_hash_maps = false;
+  bool run_execution = false;
+  bool run_spills = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view argument = argv[i];
+
+    if (argument == "--quick") {
+      options.repetitions = 1;
+      options.block_counts = {50, 200};
+      options.instruction_counts = {25'000, 100'000};
+    } else if (argument == "passes") {
+      run_passes = true;
+    } else if (argument == "pipeline") {
+      run_pipeline = true;
+    } else if (argument == "dominance") {
+      run_dominance = true;
+    } else if (argument == "ordering") {
+      run_ordering = true;
+    } else if (argument == "hash-maps") {
+      run_hash_maps = true;
+    } else if (argument == "execution") {
+      run_execution = true;
+    } else if (argument == "spills") {
+      run_spills = true;
+    } else if (argument == "--program" && i + 1 < argc) {
+      options.program_path = argv[++i];
+    } else {
+      log_error("Unknown argument `{}`.", argument);
+      return 1;
+    }
+  }
+
+  if (!run_passes && !run_pipeline && !run_dominance && !run_ordering && !run_hash_maps &&
+      !run_execution && !run_spills) {
+    run_passes = true;
+    run_pipeline = true;
+  }
+
+  Context context;
+
+  if (run_passes) {
+    benchmark_passes(&context, options);
+  }
+
+  if (run_pipeline) {
+    benchmark_pipeline(&context, options);
+  }
+
+  if (run_dominance) {
+    benchmark_dominance(&context, options);
+  }
+
+  if (run_ordering) {
+    benchmark_ordering(&context, options);
+  }
+
+  if (run_hash_maps) {
+    benchmark_hash_maps(&context, options);
+  }
+
+  if (run_execution) {
+    benchmark_execution(&context, options);
+  }
+
+  if (run_spills) {
+    benchmark_spills(&context, options);
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+#!/usr/bin/env bash
+# Compiles every TurboC and Brainfuck test program to C with each pipeline configuration, builds
+# it with the system C compiler and times the resulting executable. Outputs of all configurations
+# are compared with the first one.
+#
+# Usage (from the repository root): bench/runtime.sh <Benchmark executable> [pipeline...]
+# Pipelines are `none`, `basic` (without loop optimizations), `full` and `cost-model` (`full` with
+# cost model based inlining), all by default.
+# CC, CFLAGS and TIMEOUT (in seconds, per step) can be overridden from the environment.
+
+set -uo pipefail
+
+if [ $# -lt 1 ]; then
+  echo "Usage: $0 <Benchmark executable> [pipeline...]" >&2
+  exit 1
+fi
+
+benchmark=$1
+shift
+
+pipelines=("$@")
+if [ ${#pipelines[@]} -eq 0 ]; then
+  pipelines=(none basic full cost-model)
+fi
+
+CC=${CC:-cc}
+# IR memory is untyped, so emitted code may access the same memory through different types.
+CFLAGS=${CFLAGS:-"-O2 -fno-strict-aliasing -w"}
+TIMEOUT=${TIMEOUT:-600}
+
+output_dir=TestResults/runtime
+mkdir -p "$output_dir"
+
+now_ms() {
+  echo $(($(date +%s%N) / 1000000))
+}
+
+printf "%-28s %-6s %12s %12s %12s  %s\n" "program" "config" "flugzeug ms" "cc ms" "run ms" "status"
+
+for source in TestsTC/*.tc TestsBF/*.bf; do
+  name=$(basename "$source")
+  reference=""
+
+  for pipeline in "${pipelines[@]}"; do
+    base="$output_dir/${name%.*}.$pipeline"
+    emit_time="-"
+    cc_time="-"
+    run_time="-"
+
+    start=$(now_ms)
+    if ! timeout "$TIMEOUT" "$benchmark" emit-c "$pipeline" "$source" "$base.c" \
+      > "$base.log" 2>&1; then
+      status="compilation failed"
+    else
+      emit_time=$(($(now_ms) - start))
+
+      start=$(now_ms)
+      if ! grep -q "^int main(void)" "$base.c"; then
+        status="no main"
+      # shellcheck disable=SC2086
+      elif ! $CC $CFLAGS -o "$base" "$base.c" Runtime/Runtime.c >> "$base.log" 2>&1; then
+        status="C compilation failed"
+      else
+        cc_time=$(($(now_ms) - start))
+
+        start=$(now_ms)
+        if ! timeout "$TIMEOUT" "./$base" < /dev/null > "$base.out" 2>&1; then
+          status="execution failed"
+        else
+          run_time=$(($(now_ms) - start))
+
+          if [ -z "$reference" ]; then
+            reference="$base.out"
+            status="ok"
+          elif cmp -s "$reference" "$base.out"; then
+            status="ok"
+          else
+            status="output differs from $(basename "$reference")"
+          fi
+        fi
+      fi
+    fi
+
+    printf "%-28s %-6s %12s %12s %12s  %s\n" "$name" "$pipeline" "$emit_time" "$cc_time" \
+      "$run_time" "$status"
+  done
+done
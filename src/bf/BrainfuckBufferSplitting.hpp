@@ -9,6 +9,10 @@ namespace bf {
 
 class BrainfuckBufferSplitting : public flugzeug::Pass<"BrainfuckBufferSplitting"> {
  public:
+  consteval static flugzeug::PreservedAnalyses preserved_analyses() {
+    return flugzeug::PreservedAnalyses::control_flow();
+  }
+
   static bool run(flugzeug::Function* function);
 };
 
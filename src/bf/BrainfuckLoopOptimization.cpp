@@ -5,6 +5,7 @@
 #include <Flugzeug/IR/Patterns.hpp>
 
 #include <Flugzeug/Passes/Analysis/Loops.hpp>
+#include <Flugzeug/Passes/AnalysisManager.hpp>
 #include <Flugzeug/Passes/Utils/SimplifyPhi.hpp>
 
 using namespace flugzeug;
@@ -39,7 +40,8 @@ static bool get_brainfuck_loop(Block* block, BrainfuckLoop& loop) {
     return false;
   }
 
-  if (loop.compare->block() != block || loop.iteration_count->block() != block) {
+  if (loop.compare->block() != block || loop.iteration_count->block() != block ||
+      !loop.compare->is_used_only_by(loop.branch)) {
     return false;
   }
 
@@ -82,6 +84,10 @@ static bool get_brainfuck_loop(Block* block, BrainfuckLoop& loop) {
       }
     }
 
+    if (is_foreign(normal)) {
+      return false;
+    }
+
     loop.adds.push_back(BrainfuckAdd{
       .instruction = cast<BinaryInstr>(instruction),
       .normal_operand = normal,
@@ -89,6 +95,30 @@ static bool get_brainfuck_loop(Block* block, BrainfuckLoop& loop) {
     });
   }
 
+  // After the transformation only values which are Phi incomings from the loop block are correct
+  // at the loop exit. Make sure that nothing else is used outside of the loop.
+  const auto is_used_only_in_loop = [&](Instruction* instruction) {
+    return all_of(instruction->users<Instruction>(),
+                  [&](const Instruction& user) { return user.block() == block; });
+  };
+
+  std::unordered_set<Value*> final_values;
+  for (const auto phi : loop.phis) {
+    final_values.insert(phi->incoming_for_block(block));
+  }
+
+  for (const auto phi : loop.phis) {
+    if (!final_values.contains(phi) && !is_used_only_in_loop(phi)) {
+      return false;
+    }
+  }
+
+  for (const auto& add : loop.adds) {
+    if (!final_values.contains(add.instruction) && !is_used_only_in_loop(add.instruction)) {
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -136,8 +166,8 @@ static bool optimize_loop_or_sub_loops(const analysis::Loop* loop) {
   return optimized_sub_loop;
 }
 
-bool bf::BrainfuckLoopOptimization::run(Function* function) {
-  const auto loops = analysis::analyze_function_loops(function);
+bool bf::BrainfuckLoopOptimization::run(Function*, AnalysisManager& analysis_manager) {
+  const auto& loops = analysis_manager.loops();
 
   bool did_something = false;
 
@@ -9,7 +9,7 @@ namespace bf {
 
 class BrainfuckLoopOptimization : public flugzeug::Pass<"BrainfuckLoopOptimization"> {
  public:
-  static bool run(flugzeug::Function* function);
+  static bool run(flugzeug::Function* function, flugzeug::AnalysisManager& analysis_manager);
 };
 
 }  // namespace bf
\ No newline at end of file
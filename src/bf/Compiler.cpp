@@ -22,7 +22,7 @@ Module* bf::Compiler::compile_from_file(Context* context, const std::string& sou
 
   InstructionInserter ins(main_func->create_block());
 
-  const auto buffer = ins.stack_alloc(i8, 30'000);
+  const auto buffer = ins.stack_alloc(i8, buffer_size);
   const auto index = ins.stack_alloc(i64);
   ins.store(index, i64->zero());
   ins.call(zero_buffer, {buffer});
@@ -5,6 +5,9 @@ namespace bf {
 
 class Compiler {
  public:
+  /// Size of the memory buffer (in bytes) which is passed to `zero_buffer`.
+  constexpr static size_t buffer_size = 30'000;
+
   static flugzeug::Module* compile_from_file(flugzeug::Context* context,
                                              const std::string& source_path);
 };
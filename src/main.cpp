@@ -1,5 +1,7 @@
+#include <Flugzeug/Core/Files.hpp>
 #include <Flugzeug/Core/Iterator.hpp>
 #include <Flugzeug/Core/Log.hpp>
+#include <Flugzeug/Core/Process.hpp>
 
 #include <Flugzeug/IR/ConsoleIRPrinter.hpp>
 #include <Flugzeug/IR/Context.hpp>
@@ -8,6 +10,9 @@
 #include <Flugzeug/IR/Function.hpp>
 #include <Flugzeug/IR/Module.hpp>
 
+#include <Flugzeug/Interpreter/BytecodeInterpreter.hpp>
+#include <Flugzeug/Interpreter/Interpreter.hpp>
+
 #include <Flugzeug/Passes/BlockInvariantPropagation.hpp>
 #include <Flugzeug/Passes/CFGSimplification.hpp>
 #include <Flugzeug/Passes/CallInlining.hpp>
@@ -16,8 +21,8 @@
 #include <Flugzeug/Passes/ConstPropagation.hpp>
 #include <Flugzeug/Passes/DeadBlockElimination.hpp>
 #include <Flugzeug/Passes/DeadCodeElimination.hpp>
+#include <Flugzeug/Passes/GlobalValueNumbering.hpp>
 #include <Flugzeug/Passes/GlobalReordering.hpp>
-#include <Flugzeug/Passes/InstructionDeduplication.hpp>
 #include <Flugzeug/Passes/InstructionSimplification.hpp>
 #include <Flugzeug/Passes/KnownBitsOptimization.hpp>
 #include <Flugzeug/Passes/LocalReordering.hpp>
@@ -27,10 +32,16 @@
 #include <Flugzeug/Passes/LoopUnrolling.hpp>
 #include <Flugzeug/Passes/MemoryOptimization.hpp>
 #include <Flugzeug/Passes/MemoryToSSA.hpp>
+#include <Flugzeug/Passes/ModulePassRunner.hpp>
 #include <Flugzeug/Passes/PassRunner.hpp>
 #include <Flugzeug/Passes/PhiMinimization.hpp>
+#include <Flugzeug/Passes/SparseConditionalConstPropagation.hpp>
 
+#include <Flugzeug/CodeGeneration/C/CSourceEmitter.hpp>
 #include <Flugzeug/CodeGeneration/RegAlloc/RegisterAllocation.hpp>
+#include <Flugzeug/CodeGeneration/X86/ElfObject.hpp>
+#include <Flugzeug/CodeGeneration/X86/X86CodeGenerator.hpp>
+#include <Flugzeug/CodeGeneration/X86/X86Jit.hpp>
 
 #include <bf/BrainfuckBufferSplitting.hpp>
 #include <bf/BrainfuckLoopOptimization.hpp>
@@ -38,6 +49,8 @@
 
 #include <turboc/Compiler.hpp>
 
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 
 using namespace flugzeug;
@@ -54,6 +67,119 @@ static Module* compile_source(Context* context, const std::string& source_path)
   fatal_error("Unknown source file extension.");
 }
 
+/// Registers implementations of extern functions used by the frontends. Works with both
+/// `Interpreter` and `BytecodeInterpreter`.
+template <typename TInterpreter>
+static void register_host_functions(TInterpreter& interpreter) {
+  using Arguments = std::span<const uint64_t>;
+
+  interpreter.register_host_function("get_char", [](TInterpreter&, Arguments) -> uint64_t {
+    const auto c = std::getchar();
+    return c == EOF ? 0 : uint64_t(c);
+  });
+  interpreter.register_host_function("put_char", [](TInterpreter&, Arguments arguments) {
+    std::putchar(int(arguments[0]));
+    return uint64_t(0);
+  });
+  interpreter.register_host_function(
+    "zero_buffer", [](TInterpreter& interpreter, Arguments arguments) {
+      constexpr auto size = bf::Compiler::buffer_size;
+      std::memset(interpreter.memory(arguments[0], size), 0, size);
+      return uint64_t(0);
+    });
+  interpreter.register_host_function("print", [](TInterpreter& interpreter, Arguments arguments) {
+    for (auto address = arguments[0]; *interpreter.memory(address, 1) != 0; ++address) {
+      std::putchar(*interpreter.memory(address, 1));
+    }
+    std::putchar('\n');
+    return uint64_t(0);
+  });
+  interpreter.register_host_function("print_num", [](TInterpreter&, Arguments arguments) {
+    fmt::print("{}\n", int32_t(arguments[0]));
+    return uint64_t(0);
+  });
+}
+
+/// Runs `main` of the module and shows how many instructions were executed.
+static void interpret_module(const Module* module) {
+  Interpreter interpreter(module);
+  register_host_functions(interpreter);
+
+  std::fflush(stdout);
+  interpreter.run("main");
+  std::fflush(stdout);
+
+  interpreter.show_statistics();
+}
+
+/// Lowers the module to bytecode (this performs register allocation on the IR) and runs its
+/// `main`.
+static void run_bytecode(Module* module) {
+  const auto bytecode = lower_to_bytecode(module);
+
+  BytecodeInterpreter interpreter(bytecode);
+  register_host_functions(interpreter);
+
+  std::fflush(stdout);
+  const auto start = std::chrono::high_resolution_clock::now();
+  interpreter.run("main");
+  const auto end = std::chrono::high_resolution_clock::now();
+  std::fflush(stdout);
+
+  log_info("Executed bytecode in {}ms.",
+           std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+}
+
+/// Compiles the module to an x86-64 object (this performs register allocation on the IR), links it
+/// with C implementations of extern functions (Runtime/Runtime.c) and runs the executable.
+static void run_native(Module* module) {
+  const auto link_arguments = "-O2 -o TestResults/module TestResults/module.o Runtime/Runtime.c";
+
+  File::write_binary("TestResults/module.o", create_elf_object(generate_x86_code(module)));
+  verify(run_process("cc", link_arguments, "") == 0, "Failed to link native executable");
+
+  std::fflush(stdout);
+  const auto start = std::chrono::high_resolution_clock::now();
+  run_process("./TestResults/module", "", "");
+  const auto end = std::chrono::high_resolution_clock::now();
+
+  log_info("Executed native code in {}ms.",
+           std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+}
+
+/// Implementations of extern functions for JIT compiled code. They are called directly by the
+/// generated code so they must use C calling convention.
+static std::unordered_map<std::string, void*> jit_host_functions() {
+  return {
+    {"get_char", reinterpret_cast<void*>(+[]() -> uint8_t {
+       const auto c = std::getchar();
+       return c == EOF ? 0 : uint8_t(c);
+     })},
+    {"put_char", reinterpret_cast<void*>(+[](uint8_t c) { std::putchar(c); })},
+    {"zero_buffer",
+     reinterpret_cast<void*>(+[](uint8_t* buffer) {
+       std::memset(buffer, 0, bf::Compiler::buffer_size);
+     })},
+    {"print", reinterpret_cast<void*>(+[](const char* string) { std::puts(string); })},
+    {"print_num", reinterpret_cast<void*>(+[](int32_t x) { fmt::print("{}\n", x); })},
+  };
+}
+
+/// Compiles the module to x86-64 code (this performs register allocation on the IR), loads it
+/// into the current process and runs its `main`.
+static void run_jit(Module* module) {
+  const X86JitCode jit(generate_x86_code(module), jit_host_functions());
+
+  std::fflush(stdout);
+  const auto start = std::chrono::high_resolution_clock::now();
+  jit.function<void()>("main")();
+  const auto end = std::chrono::high_resolution_clock::now();
+  std::fflush(stdout);
+
+  log_info("Executed JIT code in {}ms.",
+           std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+}
+
 static void optimize_function(Function* function, OptimizationStatistics* statistics = nullptr) {
   constexpr bool enable_loop_optimizations = true;
   constexpr bool enable_brainfuck_optimizations = true;
@@ -65,6 +191,7 @@ static void optimize_function(Function* function, OptimizationStatistics* statis
       runner.run<opt::MemoryToSSA>();
       runner.run<opt::PhiMinimization>();
       runner.run<opt::DeadCodeElimination>();
+      runner.run<opt::SparseConditionalConstPropagation>();
       runner.run<opt::ConstPropagation>();
       runner.run<opt::InstructionSimplification>();
       runner.run<opt::ConditionalCommonOperationExtraction>();
@@ -80,7 +207,7 @@ static void optimize_function(Function* function, OptimizationStatistics* statis
       runner.run<opt::BlockInvariantPropagation>();
       runner.run<opt::ConditionalFlattening>();
       runner.run<opt::KnownBitsOptimization>();
-      runner.run<opt::InstructionDeduplication>(opt::OptimizationLocality::Global);
+      runner.run<opt::GlobalValueNumbering>();
       runner.run<opt::MemoryOptimization>(opt::OptimizationLocality::Global);
       runner.run<opt::GlobalReordering>();
       if (enable_brainfuck_optimizations) {
@@ -108,11 +235,16 @@ int main() {
 
   const auto module = compile_source(&context, source_path);
 
+  if (false) {
+    interpret_module(module);
+  }
+
   if (true) {
     const auto start = std::chrono::high_resolution_clock::now();
-    for (Function& f : module->local_functions()) {
-      optimize_function(&f, &opt_statistics);
-    }
+    ModulePassRunner(module, &opt_statistics)
+      .run_on_functions([](Function* function, OptimizationStatistics* statistics) {
+        optimize_function(function, statistics);
+      });
     const auto end = std::chrono::high_resolution_clock::now();
 
     log_info("Optimized module in {}ms.",
@@ -123,6 +255,15 @@ int main() {
     opt_statistics.show();
   }
 
+  if (false) {
+    interpret_module(module);
+  }
+
+  if (false) {
+    opt_statistics.export_chrome_trace("OptimizationTrace.json");
+    opt_statistics.export_csv("OptimizationTrace.csv");
+  }
+
   if (true) {
     for (Function& f : module->local_functions()) {
       f.generate_graph(fmt::format("Graphs/{}.svg", f.name()), printing_method);
@@ -133,6 +274,23 @@ int main() {
     allocate_registers(module->find_function("test"));
   }
 
+  if (false) {
+    run_bytecode(module);
+  }
+
+  if (false) {
+    run_native(module);
+  }
+
+  if (false) {
+    run_jit(module);
+  }
+
+  if (false) {
+    FileIRPrinter printer("TestResults/module.c");
+    emit_c_source(module, printer);
+  }
+
   module->validate(ValidationBehaviour::ErrorsAreFatal);
   module->print(printing_method);
 